@@ -4614,9 +4614,9 @@ class V8_EXPORT Exception {
 
 // --- Counters Callbacks ---
 
-/*
 typedef int* (*CounterLookupCallback)(const char* name);
 
+/*
 typedef void* (*CreateHistogramCallback)(const char* name,
                                          int min,
                                          int max,
@@ -5189,9 +5189,7 @@ class V8_EXPORT Isolate {
    * Enables the host application to provide a mechanism for recording
    * statistics counters.
    */
-/*
   void SetCounterFunction(CounterLookupCallback);
-*/
 
   /**
    * Enables the host application to provide a mechanism for recording
@@ -5224,9 +5222,7 @@ class V8_EXPORT Isolate {
    * Optional notification that the system is running low on memory.
    * V8 uses these notifications to attempt to free memory.
    */
-/*
   void LowMemoryNotification();
-*/
 
   /**
    * Optional notification that a context has been disposed. V8 uses
@@ -5234,9 +5230,9 @@ class V8_EXPORT Isolate {
    * of context disposals - including this one - since the last time
    * V8 had a chance to clean up.
    */
-/*
   int ContextDisposedNotification();
 
+/*
  private:
   template<class K, class V, class Traits> friend class PersistentValueMap;
 
@@ -5254,7 +5250,6 @@ class V8_EXPORT Isolate {
 */
 };
 
-/*
 class V8_EXPORT StartupData {
  public:
   enum CompressionAlgorithm {
@@ -5266,7 +5261,6 @@ class V8_EXPORT StartupData {
   int compressed_size;
   int raw_size;
 };
-*/
 
 
 /**
@@ -5531,10 +5525,8 @@ class V8_EXPORT V8 {
    *   handled entirely on the embedders' side.
    * - The call will abort if the data is invalid.
    */
-/*
   static void SetNativesDataBlob(StartupData* startup_blob);
   static void SetSnapshotDataBlob(StartupData* startup_blob);
-*/
 
   /**
    * Adds a message listener.
@@ -5571,18 +5563,14 @@ class V8_EXPORT V8 {
   /**
    * Sets V8 flags from a string.
    */
-/*
   static void SetFlagsFromString(const char* str, int length);
-*/
 
   /**
    * Sets V8 flags from the command line.
    */
-/*
   static void SetFlagsFromCommandLine(int* argc,
                                       char** argv,
                                       bool remove_flags);
-*/
 
   /** Get the version string. */
   static const char* GetVersion();
@@ -0,0 +1,308 @@
+// vector
+#include <vector>
+
+// Class definition
+#include "data_structures/biased_refcount.h"
+
+// Mutex TLSKey
+#include "platform/platform.h"
+
+// V8MONKEY_ASSERT
+#include "utils/V8MonkeyCommon.h"
+
+
+namespace {
+  using namespace v8::V8Platform;
+
+  /*
+   * The low bits of the shared counter. MERGED is set once the object has been unbiased; QUEUED is set once the object
+   * has been placed on its owner's merge queue (which happens at most once).
+   *
+   */
+
+  constexpr int flagBits {2};
+  constexpr int64_t mergedFlag {1};
+  constexpr int64_t queuedFlag {2};
+  constexpr int64_t sharedOne {static_cast<int64_t>(1) << flagBits};
+
+
+  // Arithmetic shift preserves the sign of negative counts
+  inline int64_t countOf(int64_t shared) {
+    return shared >> flagBits;
+  }
+
+
+  extern "C" void ownerThreadExit(void* raw);
+  TLSKey<std::shared_ptr<v8::DataStructures::BiasedOwner>> ownerKey {ownerThreadExit};
+
+
+  // Merges left queued by owners that have exited, awaiting a thread that holds the object's domain
+  Mutex orphanMutex {};
+  std::vector<v8::DataStructures::BiasedRefCounted*> orphans {};
+}
+
+
+namespace v8 {
+  namespace DataStructures {
+
+    /*
+     * Each thread that constructs a BiasedRefCounted object is assigned a BiasedOwner. This identifies the thread for
+     * ownership checks, and holds the queue of objects awaiting an explicit merge. It is shared between the thread's
+     * TLS slot and each of the objects it owns, so that it survives for as long as any of them.
+     *
+     */
+
+    class BiasedOwner {
+      public:
+        static BiasedOwner* ForCurrentThread() {
+          std::shared_ptr<BiasedOwner>* owner {ownerKey.Get()};
+          return owner ? owner->get() : nullptr;
+        }
+
+
+        static std::shared_ptr<BiasedOwner> EnsureForCurrentThread() {
+          std::shared_ptr<BiasedOwner>* owner {ownerKey.Get()};
+
+          if (!owner) {
+            owner = new std::shared_ptr<BiasedOwner> {std::make_shared<BiasedOwner>()};
+            ownerKey.Set(owner);
+          }
+
+          return *owner;
+        }
+
+
+        // Called from a non-owning thread when obj's shared count goes negative for the first time
+        void Enqueue(BiasedRefCounted* obj) {
+          mutex.Lock();
+          bool ownerExited {exited};
+          if (!ownerExited) {
+            queue.push_back(obj);
+          }
+          mutex.Unlock();
+
+          // The owner's biased counts can no longer change, so the merge can be performed right here. Note that this
+          // might delete the last object referencing us, so we must not touch any members afterwards.
+          if (ownerExited) {
+            obj->Merge();
+          }
+        }
+
+
+        // Called on the owning thread, which must hold the given domain
+        void ProcessQueue(const void* domain) {
+          std::vector<BiasedRefCounted*> toMerge;
+
+          mutex.Lock();
+          Extract(queue, toMerge, domain, false);
+          mutex.Unlock();
+
+          MergeAll(toMerge);
+        }
+
+
+        /*
+         * Called on the owning thread as it exits or is retired. Queued objects without a domain are merged there and
+         * then; the rest are left for ProcessOrphans. Later enqueuers will perform their own merges.
+         *
+         */
+
+        void Retire() {
+          std::vector<BiasedRefCounted*> remaining;
+          std::vector<BiasedRefCounted*> toMerge;
+
+          mutex.Lock();
+          exited = true;
+          remaining.swap(queue);
+          mutex.Unlock();
+
+          Extract(remaining, toMerge, nullptr, false);
+
+          orphanMutex.Lock();
+          orphans.insert(orphans.end(), remaining.begin(), remaining.end());
+          orphanMutex.Unlock();
+
+          MergeAll(toMerge);
+        }
+
+
+        // Merge the objects left behind by exited owners that belong to the given domain, or to any domain if all
+        static void ProcessOrphans(const void* domain, bool all) {
+          std::vector<BiasedRefCounted*> toMerge;
+
+          orphanMutex.Lock();
+          Extract(orphans, toMerge, domain, all);
+          orphanMutex.Unlock();
+
+          MergeAll(toMerge);
+        }
+
+      private:
+        // Move the objects belonging to domain (or all of them) from one vector to the other
+        static void Extract(std::vector<BiasedRefCounted*>& from, std::vector<BiasedRefCounted*>& to,
+                            const void* domain, bool all) {
+          size_t kept {0};
+
+          for (auto obj : from) {
+            if (all || obj->domain == domain) {
+              to.push_back(obj);
+            } else {
+              from[kept++] = obj;
+            }
+          }
+
+          from.resize(kept);
+        }
+
+
+        static void MergeAll(const std::vector<BiasedRefCounted*>& toMerge) {
+          for (auto obj : toMerge) {
+            obj->Merge();
+          }
+        }
+
+
+        Mutex mutex {};
+        std::vector<BiasedRefCounted*> queue {};
+        bool exited {false};
+    };
+
+
+    BiasedRefCounted::BiasedRefCounted(const void* d) : owner {BiasedOwner::EnsureForCurrentThread()}, domain {d} {}
+
+
+    bool BiasedRefCounted::IsOwnedByCurrentThread() const {
+      return owner.get() == BiasedOwner::ForCurrentThread();
+    }
+
+
+    void BiasedRefCounted::AddRef() {
+      // Only the owner may read merged, so the order of these tests matters
+      if (IsOwnedByCurrentThread() && !merged) {
+        biased++;
+        return;
+      }
+
+      // A new reference can only be created from an existing one, so ordering is not required here
+      shared.fetch_add(sharedOne, std::memory_order_relaxed);
+    }
+
+
+    void BiasedRefCounted::Release() {
+      if (IsOwnedByCurrentThread() && !merged) {
+        V8MONKEY_ASSERT(biased > 0, "Releasing unreferenced object");
+
+        if (--biased > 0) {
+          return;
+        }
+
+        // Implicit merge. If a merge has been queued, our count will be dealt with when the queue is processed:
+        // merging here would allow another thread to delete the object while it is still in our queue.
+        int64_t old {shared.load(std::memory_order_relaxed)};
+        int64_t desired;
+        do {
+          if (old & queuedFlag) {
+            return;
+          }
+
+          desired = old | mergedFlag;
+        } while (!shared.compare_exchange_weak(old, desired, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+        merged = true;
+        if (countOf(desired) == 0) {
+          delete this;
+        }
+
+        return;
+      }
+
+      int64_t old {shared.load(std::memory_order_relaxed)};
+      int64_t desired;
+      bool shouldQueue;
+      do {
+        desired = old - sharedOne;
+        shouldQueue = countOf(desired) < 0 && !(old & (mergedFlag | queuedFlag));
+
+        if (shouldQueue) {
+          desired |= queuedFlag;
+        }
+      } while (!shared.compare_exchange_weak(old, desired, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+      if (shouldQueue) {
+        owner->Enqueue(this);
+        return;
+      }
+
+      V8MONKEY_ASSERT(!(desired & mergedFlag) || countOf(desired) >= 0, "Releasing unreferenced object");
+
+      if ((desired & mergedFlag) && countOf(desired) == 0) {
+        delete this;
+      }
+    }
+
+
+    void BiasedRefCounted::Merge() {
+      // The object was queued, so cannot have been merged: adding the flag cannot carry into the count
+      int64_t toAdd {static_cast<int64_t>(biased) * sharedOne + mergedFlag};
+      biased = 0;
+      merged = true;
+
+      int64_t result {shared.fetch_add(toAdd, std::memory_order_acq_rel) + toAdd};
+      V8MONKEY_ASSERT(countOf(result) >= 0, "Releasing unreferenced object");
+
+      if (countOf(result) == 0) {
+        delete this;
+      }
+    }
+
+
+    void BiasedRefCounted::ProcessQueuedMerges(const void* d) {
+      BiasedOwner* owner {BiasedOwner::ForCurrentThread()};
+
+      if (owner) {
+        owner->ProcessQueue(d);
+      }
+
+      BiasedOwner::ProcessOrphans(d, false);
+    }
+
+
+    void BiasedRefCounted::RetireCurrentThread() {
+      std::shared_ptr<BiasedOwner>* owner {ownerKey.Get()};
+
+      if (owner) {
+        ownerKey.Set(nullptr);
+        (*owner)->Retire();
+        delete owner;
+      }
+
+      BiasedOwner::ProcessOrphans(nullptr, true);
+    }
+
+
+    #ifdef V8MONKEY_INTERNAL_TEST
+    int64_t BiasedRefCounted::RefCount() const {
+      return static_cast<int64_t>(biased) + countOf(shared.load(std::memory_order_acquire));
+    }
+    #endif
+  }
+}
+
+
+namespace {
+  /*
+   * On thread exit, process outstanding merges that need no domain, and note that the thread is gone, so that later
+   * merges are performed by the releasing thread. The BiasedOwner itself lives on until all the objects it owns are
+   * gone.
+   *
+   */
+
+  extern "C"
+  void ownerThreadExit(void* raw) {
+    std::shared_ptr<v8::DataStructures::BiasedOwner>* owner {
+      reinterpret_cast<std::shared_ptr<v8::DataStructures::BiasedOwner>*>(raw)};
+
+    (*owner)->Retire();
+    delete owner;
+  }
+}
@@ -0,0 +1,120 @@
+#ifndef V8MONKEY_BIASEDREFCOUNT_H
+#define V8MONKEY_BIASEDREFCOUNT_H
+
+// atomic
+#include <atomic>
+
+// int64_t
+#include <cstdint>
+
+// shared_ptr
+#include <memory>
+
+// EXPORT_FOR_TESTING_ONLY
+#include "utils/test.h"
+
+
+/*
+ * Biased reference counting, as described in Choi, Shull and Torrellas, "Biased Reference Counting: Minimizing Atomic
+ * Operations in Garbage Collected Languages" (PACT 2018).
+ *
+ * Almost all reference count traffic for an object comes from the thread that created it, yet a plain atomic counter
+ * makes every AddRef/Release pay for the rare cross-thread case. Instead, each object is biased towards its creating
+ * (owning) thread, and keeps two counters:
+ *
+ *  - a non-atomic biased counter, only ever touched by the owner
+ *  - an atomic shared counter, for every other thread. This can go negative: a reference taken on the owner can be
+ *    released elsewhere (for example, a Persistent handed between threads under a Locker)
+ *
+ * The true count is the sum of the two. When the biased counter drops to zero, the owner merges the counters, after
+ * which the object is unbiased: all threads use the shared counter, and the object is deleted when it reaches zero.
+ *
+ * When a non-owner's release takes the shared counter negative, only the owner can decide whether the object is dead,
+ * so the object is placed on the owner's merge queue. Once the owner has exited, its biased counts can no longer
+ * change, so non-owners perform such merges themselves.
+ *
+ * A merge can delete the object, so it must happen where the object may be used. Each object therefore records the
+ * domain it belongs to (for V8Monkey, the isolate that was current when it was created), and queued merges are only
+ * performed by a thread holding that domain: see ProcessQueuedMerges. When an owner exits with merges still queued,
+ * those belonging to a domain are left for the next thread that processes it.
+ *
+ * This is only staged for now: nothing in the library derives from it yet. It is intended as the base of
+ * internal::Object, which replaces its atomic refCount with this once Object is restored from the reset.
+ *
+ */
+
+namespace v8 {
+  namespace DataStructures {
+    class BiasedOwner;
+
+
+    class EXPORT_FOR_TESTING_ONLY BiasedRefCounted {
+      public:
+        // The constructing thread becomes the owner. The domain may be null, if the object can be used anywhere.
+        explicit BiasedRefCounted(const void* d = nullptr);
+
+        virtual ~BiasedRefCounted() {}
+
+        void AddRef();
+
+        // Deletes the object once the last reference has been released
+        void Release();
+
+
+        /*
+         * Process the merges queued for objects in the given domain: those owned by the calling thread, and those left
+         * behind by owners that have exited. Objects whose true count is zero are deleted. The caller must hold the
+         * domain: for an isolate, that means having entered it.
+         *
+         */
+
+        static void ProcessQueuedMerges(const void* d = nullptr);
+
+
+        /*
+         * Process every merge queued for the calling thread or left behind by exited owners, regardless of domain, and
+         * stop treating the calling thread as an owner. This happens automatically on thread exit; V8::Dispose does it
+         * for the main thread, whose TLS destructors may never run.
+         *
+         */
+
+        static void RetireCurrentThread();
+
+        #ifdef V8MONKEY_INTERNAL_TEST
+        // Only meaningful when no other thread is concurrently modifying the count
+        int64_t RefCount() const;
+
+        bool IsMerged() const { return merged; }
+        #endif
+
+        BiasedRefCounted(const BiasedRefCounted& other) = delete;
+        BiasedRefCounted(BiasedRefCounted&& other) = delete;
+        BiasedRefCounted& operator=(const BiasedRefCounted& other) = delete;
+        BiasedRefCounted& operator=(BiasedRefCounted&& other) = delete;
+
+      private:
+        // Keeps the owner's merge queue alive for as long as the object might need to be placed on it
+        std::shared_ptr<BiasedOwner> owner;
+
+        // Queued merges are only performed by threads holding this
+        const void* domain;
+
+        // Only accessed by the owner (or by a merging thread, once the owner has exited)
+        uint32_t biased {0};
+        bool merged {false};
+
+        // The shared count, shifted left by flagBits, with the flags below in the low bits
+        std::atomic<int64_t> shared {0};
+
+        bool IsOwnedByCurrentThread() const;
+
+        // Add the biased count into the shared count, and delete the object if the result is zero
+        void Merge();
+
+        friend class BiasedOwner;
+    };
+  }
+}
+
+
+#endif
@@ -1,6 +1,9 @@
 // abort exit getenv
 #include <cstdlib>
 
+// BiasedRefCounted
+#include "data_structures/biased_refcount.h"
+
 // internal::Isolate
 #include "runtime/isolate.h"
 
@@ -38,6 +41,8 @@ namespace v8 {
 
 
   bool V8::Dispose() {
+    // The main thread's TLS destructors may never run, so its queued merges must be dealt with here
+    DataStructures::BiasedRefCounted::RetireCurrentThread();
     SpiderMonkey::TearDownSpiderMonkey();
     /*
     using namespace v8::V8Monkey;
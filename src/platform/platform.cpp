@@ -1,19 +1,40 @@
-// fprintf
+// atomic
+#include <atomic>
+
+// fprintf rename
 #include <cstdio>
 
 // exit
 #include <cstdlib>
 
-// memcpy
+// memcpy strcmp strlen
 #include <cstring>
 
 // terminate
 #include <exception>
 
-// pthread_key_(create|delete|get_specific|set_specific|t) pthread_(create|join|t)
-// pthread_mutex_(destroy|init|lock|t|unlock) pthread_once
+// closedir DIR dirent opendir readdir
+#include <dirent.h>
+
+// errno EEXIST EINTR
+#include <errno.h>
+
+// AT_FDCWD open O_CLOEXEC O_CREAT O_EXCL O_RDONLY O_WRONLY
+#include <fcntl.h>
+
+// pthread_cond_(broadcast|destroy|init|t|wait) pthread_key_(create|delete|get_specific|set_specific|t)
+// pthread_(create|join|t) pthread_mutex_(destroy|init|lock|t|unlock) pthread_once
 #include <pthread.h>
 
+// mmap munmap MAP_FAILED MAP_PRIVATE PROT_READ
+#include <sys/mman.h>
+
+// fstat mkdir stat S_ISDIR S_ISREG utimensat
+#include <sys/stat.h>
+
+// close fsync getpid unlink write
+#include <unistd.h>
+
 // Class definition
 #include "platform.h"
 
@@ -251,5 +272,206 @@ namespace v8 {
       fprintf(stderr, "%s\n", message);
       exit(1);
     }
+
+
+    namespace {
+      struct NativeEvent {
+        pthread_mutex_t mutex;
+        pthread_cond_t condition;
+        bool signalled;
+      };
+    }
+
+
+    Event::Event() {
+      NativeEvent* event {new NativeEvent};
+      event->signalled = false;
+
+      // We're not going to be able to do anything useful if we can't create the synchronization primitives
+      if (pthread_mutex_init(&event->mutex, nullptr) || pthread_cond_init(&event->condition, nullptr))
+        std::terminate();
+
+      privateData = reinterpret_cast<void*>(event);
+    }
+
+
+    Event::~Event() {
+      NativeEvent* event {reinterpret_cast<NativeEvent*>(privateData)};
+      V8MONKEY_ASSERT(event, "Native event is a nullptr");
+      pthread_cond_destroy(&event->condition);
+      pthread_mutex_destroy(&event->mutex);
+      delete event;
+    }
+
+
+    void Event::Signal() {
+      NativeEvent* event {reinterpret_cast<NativeEvent*>(privateData)};
+      pthread_mutex_lock(&event->mutex);
+      event->signalled = true;
+      pthread_cond_broadcast(&event->condition);
+      pthread_mutex_unlock(&event->mutex);
+    }
+
+
+    void Event::Wait() {
+      NativeEvent* event {reinterpret_cast<NativeEvent*>(privateData)};
+      pthread_mutex_lock(&event->mutex);
+      while (!event->signalled) {
+        pthread_cond_wait(&event->condition, &event->mutex);
+      }
+      pthread_mutex_unlock(&event->mutex);
+    }
+
+
+    bool Event::IsSignalled() {
+      NativeEvent* event {reinterpret_cast<NativeEvent*>(privateData)};
+      pthread_mutex_lock(&event->mutex);
+      bool signalled {event->signalled};
+      pthread_mutex_unlock(&event->mutex);
+      return signalled;
+    }
+
+
+    MappedFile::MappedFile(const char* path) {
+      int fd {open(path, O_RDONLY | O_CLOEXEC)};
+      if (fd < 0) {
+        return;
+      }
+
+      Map(fd);
+      close(fd);
+    }
+
+
+    MappedFile::MappedFile(int fd) {
+      Map(fd);
+    }
+
+
+    MappedFile::~MappedFile() {
+      if (data) {
+        munmap(data, length);
+      }
+    }
+
+
+    void MappedFile::Map(int fd) {
+      struct stat info;
+      if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        return;
+      }
+
+      // mmap rejects zero-length mappings
+      if (info.st_size == 0) {
+        valid = true;
+        return;
+      }
+
+      size_t size {static_cast<size_t>(info.st_size)};
+      void* mapping {mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0)};
+      if (mapping == MAP_FAILED) {
+        return;
+      }
+
+      data = mapping;
+      length = size;
+      valid = true;
+    }
+
+
+    bool FileSystem::EnsureDirectory(const char* path) {
+      if (mkdir(path, 0755) != 0 && errno != EEXIST) {
+        return false;
+      }
+
+      struct stat info;
+      return stat(path, &info) == 0 && S_ISDIR(info.st_mode);
+    }
+
+
+    bool FileSystem::WriteAtomically(const char* path, const void* data, size_t length) {
+      // Unique across threads and processes, so concurrent writers of the same path never share a temporary
+      static std::atomic<unsigned> tempCount {0};
+      std::string tempPath {std::string(path) + ".tmp." + std::to_string(getpid()) + "." +
+                            std::to_string(tempCount++)};
+
+      int fd {open(tempPath.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644)};
+      if (fd < 0) {
+        return false;
+      }
+
+      const char* remaining {reinterpret_cast<const char*>(data)};
+      size_t toWrite {length};
+      while (toWrite > 0) {
+        ssize_t written {write(fd, remaining, toWrite)};
+        if (written < 0 && errno == EINTR) {
+          continue;
+        }
+
+        if (written <= 0) {
+          close(fd);
+          unlink(tempPath.c_str());
+          return false;
+        }
+
+        remaining += written;
+        toWrite -= static_cast<size_t>(written);
+      }
+
+      // Without the fsync, a crash could leave the rename durable but the contents not
+      bool ok {fsync(fd) == 0};
+      ok = close(fd) == 0 && ok;
+      if (!ok || std::rename(tempPath.c_str(), path) != 0) {
+        unlink(tempPath.c_str());
+        return false;
+      }
+
+      return true;
+    }
+
+
+    bool FileSystem::ListFiles(const char* directory, const char* suffix, std::vector<Entry>& entries) {
+      DIR* dir {opendir(directory)};
+      if (!dir) {
+        return false;
+      }
+
+      size_t suffixLength {std::strlen(suffix)};
+      std::string path {directory};
+      path += '/';
+      size_t directoryLength {path.size()};
+
+      while (dirent* entry = readdir(dir)) {
+        size_t nameLength {std::strlen(entry->d_name)};
+        if (nameLength < suffixLength || std::strcmp(entry->d_name + nameLength - suffixLength, suffix) != 0) {
+          continue;
+        }
+
+        path.resize(directoryLength);
+        path += entry->d_name;
+
+        // The file may have been removed by another process since readdir saw it
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode)) {
+          continue;
+        }
+
+        int64_t modified {static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec};
+        entries.push_back(Entry {entry->d_name, static_cast<size_t>(info.st_size), modified});
+      }
+
+      closedir(dir);
+      return true;
+    }
+
+
+    bool FileSystem::Touch(const char* path) {
+      return utimensat(AT_FDCWD, path, nullptr, 0) == 0;
+    }
+
+
+    bool FileSystem::Remove(const char* path) {
+      return unlink(path) == 0;
+    }
   }
 }
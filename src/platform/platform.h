@@ -1,9 +1,18 @@
 #ifndef V8MONKEY_PLATFORM_H
 #define V8MONKEY_PLATFORM_H
 
-// memcpy
+// int64_t
+#include <cstdint>
+
+// size_t, memcpy
 #include <cstring>
 
+// string
+#include <string>
+
+// vector
+#include <vector>
+
 // EXPORT_FOR_TESTING_ONLY
 #include "utils/test.h"
 
@@ -198,6 +207,94 @@ namespace v8 {
         void* privateData {nullptr};
         bool hasExecuted {false};
     };
+
+
+    // A one-shot signal between threads. Once signalled, it stays signalled, releasing all current and future waiters.
+    class EXPORT_FOR_TESTING_ONLY Event {
+      public:
+        // Construction can invoke std::terminate if the native primitives cannot be created
+        Event();
+
+        ~Event();
+
+        void Signal();
+
+        // Block until the event is signalled
+        void Wait();
+
+        bool IsSignalled();
+
+        Event(const Event& other) = delete;
+        Event(Event&& other) = delete;
+        Event& operator=(const Event& other) = delete;
+        Event& operator=(Event&& other) = delete;
+
+      private:
+        void* privateData {nullptr};
+    };
+
+    // RAII class for read-only memory mappings of files
+    class EXPORT_FOR_TESTING_ONLY MappedFile {
+      public:
+        // Map the file at the given path
+        explicit MappedFile(const char* path);
+
+        // Map the file open on the given descriptor. The descriptor is not closed, and need not outlive the mapping.
+        explicit MappedFile(int fd);
+
+        ~MappedFile();
+
+        // False if the file could not be opened or mapped. Empty files are valid, with a null Data.
+        bool IsValid() const { return valid; }
+
+        const void* Data() const { return data; }
+        size_t Length() const { return length; }
+
+        MappedFile(const MappedFile& other) = delete;
+        MappedFile(MappedFile&& other) = delete;
+        MappedFile& operator=(const MappedFile& other) = delete;
+        MappedFile& operator=(MappedFile&& other) = delete;
+
+      private:
+        void* data {nullptr};
+        size_t length {0};
+        bool valid {false};
+
+        void Map(int fd);
+    };
+
+
+    // The little file system access that we need
+    class EXPORT_FOR_TESTING_ONLY FileSystem {
+      public:
+        struct Entry {
+          std::string name;
+          size_t size;
+
+          // Nanoseconds since the epoch
+          int64_t lastModified;
+        };
+
+        // Create the directory if it does not exist. Returns false if it does not exist afterwards.
+        static bool EnsureDirectory(const char* path);
+
+        /*
+         * Write the file under a temporary name, then rename it in to place. Other processes reading the path see
+         * either the old contents or the new, never a partial write. On failure, returns false and leaves the path
+         * untouched.
+         *
+         */
+
+        static bool WriteAtomically(const char* path, const void* data, size_t length);
+
+        // Lists the regular files in the directory with names ending in suffix. Returns false on failure.
+        static bool ListFiles(const char* directory, const char* suffix, std::vector<Entry>& entries);
+
+        // Set the modification time to now
+        static bool Touch(const char* path);
+
+        static bool Remove(const char* path);
+    };
   }
 }
 
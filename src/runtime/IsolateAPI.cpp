@@ -46,6 +46,21 @@ namespace v8 {
   Isolate* Isolate::GetCurrent() {
     return reinterpret_cast<Isolate*>(internal::Isolate::GetCurrent());
   }
+
+
+  void Isolate::SetCounterFunction(CounterLookupCallback fn) {
+    reinterpret_cast<internal::Isolate*>(this)->SetCounterFunction(fn);
+  }
+
+
+  void Isolate::LowMemoryNotification() {
+    FORWARD_TO_INTERNAL(LowMemoryNotification);
+  }
+
+
+  int Isolate::ContextDisposedNotification() {
+    return reinterpret_cast<internal::Isolate*>(this)->ContextDisposedNotification();
+  }
 }
 
 
@@ -0,0 +1,181 @@
+// sort
+#include <algorithm>
+
+// system_clock
+#include <chrono>
+
+// numeric_limits
+#include <limits>
+
+// move
+#include <utility>
+
+// vector
+#include <vector>
+
+// Class definition
+#include "runtime/code_cache.h"
+
+// FileSystem MappedFile
+#include "platform/platform.h"
+
+// CachedData ScriptSource ScriptWrapper
+#include "types/script_wrapper.h"
+
+
+namespace {
+  using namespace v8::V8Platform;
+
+
+  constexpr const char* entrySuffix {".jsc"};
+
+  // FileSystem::WriteAtomically names its temporaries for our entries <key>.jsc.tmp.<pid>.<n>
+  constexpr const char* temporaryInfix {".jsc.tmp."};
+
+  // A temporary this old belongs to a writer that died before renaming it in to place
+  constexpr int64_t staleTemporaryNanoseconds {static_cast<int64_t>(10) * 60 * 1000000000};
+
+
+  bool olderFirst(const FileSystem::Entry& a, const FileSystem::Entry& b) {
+    return a.lastModified < b.lastModified;
+  }
+
+
+  bool endsWith(const std::string& name, const char* suffix) {
+    size_t length {std::char_traits<char>::length(suffix)};
+    return name.size() >= length && name.compare(name.size() - length, length, suffix) == 0;
+  }
+
+
+  int64_t nanosecondsSinceEpoch() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::system_clock::now().time_since_epoch()).count();
+  }
+}
+
+
+namespace v8 {
+  namespace internal {
+    DiskCodeCache::DiskCodeCache(const std::string& dir, size_t budget) : directory {dir}, maxBytes {budget} {
+      // If the directory cannot be created, every compilation will simply miss
+      FileSystem::EnsureDirectory(directory.c_str());
+      Trim();
+    }
+
+
+    ScriptWrapper* DiskCodeCache::Compile(JSContext* cx, ScriptSource& source) {
+      std::string path {entryPath(source.CacheKey())};
+
+      {
+        MappedFile mapped {path.c_str()};
+        if (mapped.IsValid() && mapped.Length() <= static_cast<size_t>(std::numeric_limits<int>::max())) {
+          source.SetCachedData(new CachedData(reinterpret_cast<const uint8_t*>(mapped.Data()),
+                                              static_cast<int>(mapped.Length())));
+          ScriptWrapper* script {ScriptWrapper::Compile(cx, source, ScriptWrapper::kConsumeCodeCache)};
+
+          // The data points in to the mapping, which is about to go away
+          bool rejected {source.GetCachedData()->rejected};
+          source.SetCachedData(nullptr);
+
+          if (!rejected) {
+            if (script) {
+              hits++;
+              FileSystem::Touch(path.c_str());
+            }
+
+            return script;
+          }
+
+          // Most likely a file damaged outside our control. The source has been compiled in its place, so unless
+          // that failed, encode the result to replace the entry.
+          rejects++;
+          if (script && script->CreateCodeCache(cx, source)) {
+            write(path, source);
+          }
+
+          return script;
+        } else {
+          misses++;
+        }
+      }
+
+      ScriptWrapper* script {ScriptWrapper::Compile(cx, source, ScriptWrapper::kProduceCodeCache)};
+      if (script) {
+        write(path, source);
+      }
+
+      return script;
+    }
+
+
+    void DiskCodeCache::Trim() {
+      std::vector<FileSystem::Entry> files;
+      if (!FileSystem::ListFiles(directory.c_str(), "", files)) {
+        return;
+      }
+
+      int64_t staleBefore {nanosecondsSinceEpoch() - staleTemporaryNanoseconds};
+      std::vector<FileSystem::Entry> entries;
+      bytesInUse = 0;
+
+      for (auto& file : files) {
+        if (endsWith(file.name, entrySuffix)) {
+          bytesInUse += file.size;
+          entries.push_back(std::move(file));
+        } else if (file.name.find(temporaryInfix) != std::string::npos && file.lastModified < staleBefore) {
+          FileSystem::Remove((directory + '/' + file.name).c_str());
+        }
+      }
+
+      if (bytesInUse <= maxBytes) {
+        return;
+      }
+
+      // Leave room for the next few entries, so that writes don't each trigger another scan of the directory
+      size_t target {maxBytes - maxBytes / 4};
+
+      std::sort(entries.begin(), entries.end(), olderFirst);
+      for (const auto& entry : entries) {
+        if (bytesInUse <= target) {
+          break;
+        }
+
+        // Another process may have got there first, in which case the space is freed all the same
+        FileSystem::Remove((directory + '/' + entry.name).c_str());
+        bytesInUse -= entry.size;
+      }
+    }
+
+
+    std::string DiskCodeCache::entryPath(uint64_t key) const {
+      static const char hexDigits[] {"0123456789abcdef"};
+
+      std::string path {directory};
+      path += '/';
+      for (int shift = 60; shift >= 0; shift -= 4) {
+        path += hexDigits[(key >> shift) & 0xf];
+      }
+
+      return path + entrySuffix;
+    }
+
+
+    void DiskCodeCache::write(const std::string& path, ScriptSource& source) {
+      const CachedData* cache {source.GetCachedData()};
+      if (!cache) {
+        return;
+      }
+
+      size_t length {static_cast<size_t>(cache->length)};
+      if (FileSystem::WriteAtomically(path.c_str(), cache->data, length)) {
+        bytesInUse += length;
+        if (bytesInUse > maxBytes) {
+          Trim();
+        }
+      }
+
+      // Callers did not ask for cached data, so do not hang on to it
+      source.SetCachedData(nullptr);
+    }
+  }
+}
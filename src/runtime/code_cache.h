@@ -0,0 +1,91 @@
+#ifndef V8MONKEY_CODECACHE_H
+#define V8MONKEY_CODECACHE_H
+
+// size_t
+#include <cstddef>
+
+// uint64_t
+#include <cstdint>
+
+// string
+#include <string>
+
+// JSContext
+#include "jsapi.h"
+
+// EXPORT_FOR_TESTING_ONLY
+#include "utils/test.h"
+
+
+namespace v8 {
+  namespace internal {
+    class ScriptSource;
+    class ScriptWrapper;
+
+
+    /*
+     * A directory of code caches, shared by every process pointed at it, and surviving restarts.
+     *
+     * Each entry is named for the source's cache key, which covers the source text, its origin and the engine build,
+     * so an engine upgrade simply stops hitting old entries, which then age out. Entries are written atomically, so
+     * processes racing to fill the same entry are harmless. They are read through a memory mapping, which SpiderMonkey
+     * decodes in place.
+     *
+     * Reading an entry updates its modification time. Once the directory exceeds its budget, the entries used least
+     * recently are removed until it is three quarters full. Trimming also removes the temporaries of writers that died
+     * mid-write.
+     *
+     * Not thread-safe: each isolate should have its own instance, though any number may share a directory.
+     *
+     */
+
+    class EXPORT_FOR_TESTING_ONLY DiskCodeCache {
+      public:
+        DiskCodeCache(const std::string& dir, size_t budget);
+        ~DiskCodeCache() = default;
+
+        /*
+         * Compile the source, from its cache entry if there is a usable one. Otherwise, the source is compiled, and an
+         * entry written for next time. The source must not already have cached data. Returns nullptr if SpiderMonkey
+         * reported an error, which will be pending on the context.
+         *
+         */
+
+        ScriptWrapper* Compile(JSContext* cx, ScriptSource& source);
+
+        // Remove stale temporaries, and if over budget, least recently used entries until there is room to spare
+        void Trim();
+
+        // Compilations satisfied from the cache
+        size_t Hits() const { return hits; }
+
+        // Compilations with no entry in the cache
+        size_t Misses() const { return misses; }
+
+        // Compilations whose entry was unusable. It is replaced unless the source fails to compile.
+        size_t Rejects() const { return rejects; }
+
+        DiskCodeCache(const DiskCodeCache& other) = delete;
+        DiskCodeCache(DiskCodeCache&& other) = delete;
+        DiskCodeCache& operator=(const DiskCodeCache& other) = delete;
+        DiskCodeCache& operator=(DiskCodeCache&& other) = delete;
+
+      private:
+        std::string directory;
+        size_t maxBytes;
+
+        // Other processes write to the directory too, so this is only an estimate, corrected whenever we trim
+        size_t bytesInUse {0};
+
+        size_t hits {0};
+        size_t misses {0};
+        size_t rejects {0};
+
+        std::string entryPath(uint64_t key) const;
+        void write(const std::string& path, ScriptSource& source);
+    };
+  }
+}
+
+
+#endif
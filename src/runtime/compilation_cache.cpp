@@ -0,0 +1,267 @@
+// memcmp
+#include <cstring>
+
+// next prev
+#include <iterator>
+
+// move
+#include <utility>
+
+// Class definition
+#include "runtime/compilation_cache.h"
+
+// AddRuntimeTearDownCallback RemoveRuntimeTearDownCallback
+#include "utils/SpiderMonkeyUtils.h"
+
+
+namespace {
+  using namespace v8::internal;
+
+
+  // The source's text as raw bytes, whatever its encoding
+  const char* textOf(const ScriptSource& source) {
+    return source.Chars() ? reinterpret_cast<const char*>(source.Chars()) : source.Bytes();
+  }
+
+
+  size_t textSize(const ScriptSource& source) {
+    return source.Length() * (source.Chars() ? sizeof(char16_t) : 1);
+  }
+}
+
+
+namespace v8 {
+  namespace internal {
+    CompilationCache::~CompilationCache() {
+      Clear();
+    }
+
+
+    ScriptWrapper* CompilationCache::Compile(JSContext* cx, ScriptSource& source) {
+      if (disposedContexts) {
+        Clear();
+      }
+
+      if (!maxBytes) {
+        return ScriptWrapper::Compile(cx, source);
+      }
+
+      if (runtimeTornDown.load(std::memory_order_acquire)) {
+        forgetBound();
+      }
+
+      JSObject* global {JS::CurrentGlobalOrNull(cx)};
+      uint64_t key {source.CacheKey()};
+      std::list<Entry>::iterator entry {entries.end()};
+
+      auto found = index.find(key);
+      if (found != index.end()) {
+        entry = found->second;
+        if (entry->Holds(source)) {
+          entries.splice(entries.begin(), entries, entry);
+        } else {
+          // The newcomer takes the key over
+          remove(entry);
+          entry = entries.end();
+        }
+      }
+
+      if (entry != entries.end()) {
+        for (const auto& bound : entry->bound) {
+          if (bound.global.getPtr() == global) {
+            hits++;
+            CompileStatistics stats;
+            stats.sourceLength = source.Length();
+            stats.cached = true;
+            stats.Record();
+            return new ScriptWrapper(bound.script, stats);
+          }
+        }
+
+        if (entry->unbound) {
+          ScriptWrapper* script {entry->unbound->BindToCurrentContext(cx)};
+          if (script) {
+            hits++;
+            keep(cx, entry, script);
+            return script;
+          }
+
+          // Most likely out of memory: compile afresh
+          JS_ClearPendingException(cx);
+        }
+      }
+
+      misses++;
+      ScriptWrapper* script {nullptr};
+      std::unique_ptr<UnboundScriptWrapper> unbound {};
+
+      if (entry == entries.end() ? canKeepBound(cx) : static_cast<bool>(entry->unbound)) {
+        // The first global to ask, or decoding failed: compile-and-go scripts run fastest
+        script = ScriptWrapper::Compile(cx, source);
+      } else {
+        // Either this is a second global, or this runtime's scripts cannot be kept: other globals will need the
+        // context-independent form
+        unbound.reset(UnboundScriptWrapper::Compile(cx, source));
+        script = unbound ? unbound->BindToCurrentContext(cx) : nullptr;
+      }
+
+      if (!script) {
+        return nullptr;
+      }
+
+      if (entry == entries.end()) {
+        entries.push_front(Entry {key, std::string(textOf(source), textSize(source)), source.GetEncoding(),
+                                  source.Origin(), source.Length(), {}, nullptr, 0});
+        index[key] = entries.begin();
+        entry = entries.begin();
+      }
+
+      if (unbound) {
+        entry->unbound = std::move(unbound);
+      }
+
+      keep(cx, entry, script);
+      return script;
+    }
+
+
+    void CompilationCache::SetBudget(size_t budget) {
+      maxBytes = budget;
+      evictTo(maxBytes);
+    }
+
+
+    void CompilationCache::Clear() {
+      entries.clear();
+      index.clear();
+      bytesInUse = 0;
+      disposedContexts = 0;
+      unregister();
+    }
+
+
+    bool CompilationCache::canKeepBound(JSContext* cx) {
+      JSRuntime* rt {JS_GetRuntime(cx)};
+      if (runtime) {
+        return runtime == rt;
+      }
+
+      if (!JS_AddExtraGCRootsTracer(rt, Trace, this)) {
+        return false;
+      }
+
+      runtime = rt;
+      SpiderMonkey::AddRuntimeTearDownCallback(rt, RuntimeTornDown, this);
+      return true;
+    }
+
+
+    void CompilationCache::keep(JSContext* cx, std::list<Entry>::iterator entry, ScriptWrapper* script) {
+      if (canKeepBound(cx)) {
+        JS::TenuredHeap<JSObject*> global {JS::CurrentGlobalOrNull(cx)};
+        entry->bound.push_back(BoundScript {global, JS::Heap<JSScript*> {script->Script()}});
+      }
+
+      resize(entry);
+    }
+
+
+    void CompilationCache::forgetBound() {
+      for (auto entry = entries.begin(); entry != entries.end();) {
+        auto next = std::next(entry);
+        if (entry->unbound) {
+          size_t size {entry->text.size() + entry->unbound->Length()};
+          entry->bound.clear();
+          bytesInUse -= entry->size - size;
+          entry->size = size;
+        } else {
+          remove(entry);
+        }
+
+        entry = next;
+      }
+
+      // The tracer went with the runtime
+      runtime = nullptr;
+      runtimeTornDown.store(false, std::memory_order_relaxed);
+    }
+
+
+    /*
+     * The tracer can only be removed from a live runtime. The runtime's teardown callback is removed first: once it
+     * has been, the flag cannot change. Like the rest of the cache, this is not safe while the runtime is collecting
+     * on another thread.
+     *
+     */
+
+    void CompilationCache::unregister() {
+      if (!runtime) {
+        return;
+      }
+
+      SpiderMonkey::RemoveRuntimeTearDownCallback(runtime, RuntimeTornDown, this);
+      if (!runtimeTornDown.load(std::memory_order_acquire)) {
+        JS_RemoveExtraGCRootsTracer(runtime, Trace, this);
+      }
+
+      runtime = nullptr;
+      runtimeTornDown.store(false, std::memory_order_relaxed);
+    }
+
+
+    void CompilationCache::Trace(JSTracer* tracer, void* data) {
+      CompilationCache* cache {reinterpret_cast<CompilationCache*>(data)};
+      for (auto& entry : cache->entries) {
+        for (auto& bound : entry.bound) {
+          JS_CallTenuredObjectTracer(tracer, &bound.global, "V8Monkey compilation cache global");
+          JS_CallScriptTracer(tracer, &bound.script, "V8Monkey compilation cache script");
+        }
+      }
+    }
+
+
+    void CompilationCache::RuntimeTornDown(JSRuntime*, void* data) {
+      CompilationCache* cache {reinterpret_cast<CompilationCache*>(data)};
+      cache->runtimeTornDown.store(true, std::memory_order_release);
+    }
+
+
+    void CompilationCache::resize(std::list<Entry>::iterator entry) {
+      // SpiderMonkey keeps each bound script's source text as UTF-16
+      size_t size {entry->text.size() + (entry->unbound ? entry->unbound->Length() : 0)};
+      size += entry->bound.size() * entry->sourceLength * sizeof(char16_t);
+
+      bytesInUse = bytesInUse - entry->size + size;
+      entry->size = size;
+
+      if (size > maxBytes) {
+        remove(entry);
+        return;
+      }
+
+      evictTo(maxBytes);
+    }
+
+
+    void CompilationCache::evictTo(size_t limit) {
+      while (bytesInUse > limit) {
+        remove(std::prev(entries.end()));
+      }
+    }
+
+
+    void CompilationCache::remove(std::list<Entry>::iterator entry) {
+      bytesInUse -= entry->size;
+      index.erase(entry->key);
+      entries.erase(entry);
+    }
+
+
+    bool CompilationCache::Entry::Holds(const ScriptSource& source) const {
+      size_t bytes {textSize(source)};
+      return encoding == source.GetEncoding() && origin.resourceName == source.Origin().resourceName &&
+             origin.lineOffset == source.Origin().lineOffset && text.size() == bytes &&
+             std::memcmp(text.data(), textOf(source), bytes) == 0;
+    }
+  }
+}
@@ -0,0 +1,185 @@
+#ifndef V8MONKEY_COMPILATIONCACHE_H
+#define V8MONKEY_COMPILATIONCACHE_H
+
+// atomic
+#include <atomic>
+
+// size_t
+#include <cstddef>
+
+// uint64_t
+#include <cstdint>
+
+// list
+#include <list>
+
+// unique_ptr
+#include <memory>
+
+// string
+#include <string>
+
+// unordered_map
+#include <unordered_map>
+
+// vector
+#include <vector>
+
+// JS::Heap JS::TenuredHeap JSContext JSObject JSRuntime JSScript JSTracer
+#include "jsapi.h"
+
+// ScriptOrigin ScriptSource ScriptWrapper UnboundScriptWrapper
+#include "types/script_wrapper.h"
+
+// EXPORT_FOR_TESTING_ONLY
+#include "utils/test.h"
+
+
+namespace v8 {
+  namespace internal {
+
+    /*
+     * An isolate's cache of compiled scripts, for embedders that compile the same snippets over and over. Disabled
+     * until given a budget.
+     *
+     * Entries are keyed on the source's cache key, which covers the text, the origin and the engine build. Each entry
+     * keeps a copy of the text, which is compared on every hit, so a key collision cannot run the wrong script.
+     * SpiderMonkey
+     * binds a compile-and-go script to its global for good, so each entry holds the scripts it has handed out, one per
+     * global: a hit in a global the script has already been compiled for costs a hash lookup and nothing more. Only
+     * when a second global asks for the script is it compiled again, in its context-independent form, and kept in XDR
+     * form; later globals decode their copy from that, with no parse.
+     *
+     * The bound scripts, and their globals, are traced by the cache, so are kept alive until evicted: embedders should
+     * signal disposed contexts (see Isolate::ContextDisposedNotification), so the cache is cleared. They belong to the
+     * runtime that first used the cache; other threads' runtimes only use the XDR form. When that runtime is torn down,
+     * the bound scripts are forgotten before the cache is next used.
+     *
+     * The budget counts the copies of the text, the encoded size of the XDR forms, and the source text retained by each
+     * bound script (which SpiderMonkey offers no way to measure directly, but which is comparable). Once it is
+     * exceeded, the entries used least recently are evicted.
+     *
+     * Isolates are only used by one thread at a time, so no locking is required. The one exception is the runtime's
+     * tear down, which can happen on its own thread at any time; it only sets a flag.
+     *
+     */
+
+    class EXPORT_FOR_TESTING_ONLY CompilationCache {
+      public:
+        CompilationCache() = default;
+        ~CompilationCache();
+
+        /*
+         * Compile the source, from the cache if it holds the script. Otherwise the script is compiled, and kept if it
+         * fits in the budget. Returns nullptr if SpiderMonkey reported an error, which will be pending on the context;
+         * scripts that fail to compile are not cached.
+         *
+         * Any cached data the source carries is ignored. Without a budget, this is simply ScriptWrapper::Compile.
+         *
+         */
+
+        ScriptWrapper* Compile(JSContext* cx, ScriptSource& source);
+
+        // Set the budget in bytes, evicting entries until the cache fits. A budget of zero disables the cache.
+        void SetBudget(size_t budget);
+
+        size_t Budget() const { return maxBytes; }
+
+        // Drop every entry, for example in response to a low memory notification
+        void Clear();
+
+        /*
+         * Note that a context has been disposed, returning the number of disposals since the cache was last cleared.
+         * Rather than clearing the cache for each disposal, it is cleared when next used.
+         *
+         */
+
+        int ContextDisposed() { return ++disposedContexts; }
+
+        size_t Size() const { return entries.size(); }
+        size_t BytesInUse() const { return bytesInUse; }
+
+        // Compilations satisfied from the cache, whether already bound to the global or decoded from XDR
+        size_t Hits() const { return hits; }
+
+        // Compilations the cache could not satisfy without compiling, including those where decoding failed
+        size_t Misses() const { return misses; }
+
+        CompilationCache(const CompilationCache& other) = delete;
+        CompilationCache(CompilationCache&& other) = delete;
+        CompilationCache& operator=(const CompilationCache& other) = delete;
+        CompilationCache& operator=(CompilationCache&& other) = delete;
+
+      private:
+        // A script handed out for a particular global. Globals are never allocated in the nursery.
+        struct BoundScript {
+          JS::TenuredHeap<JSObject*> global;
+          JS::Heap<JSScript*> script;
+        };
+
+        struct Entry {
+          uint64_t key;
+
+          // Compared on lookup, as a key collision would otherwise run the wrong script. The text is kept as raw bytes.
+          std::string text;
+          ScriptSource::Encoding encoding;
+          ScriptOrigin origin;
+
+          // In code units of the source's encoding
+          size_t sourceLength;
+
+          std::vector<BoundScript> bound;
+
+          // Only produced once a second global asks for the script
+          std::unique_ptr<UnboundScriptWrapper> unbound;
+
+          size_t size;
+
+          bool Holds(const ScriptSource& source) const;
+        };
+
+        // Most recently used first
+        std::list<Entry> entries {};
+        std::unordered_map<uint64_t, std::list<Entry>::iterator> index {};
+
+        size_t maxBytes {0};
+        size_t bytesInUse {0};
+
+        size_t hits {0};
+        size_t misses {0};
+
+        // Since the cache was last cleared
+        int disposedContexts {0};
+
+        // The runtime the bound scripts belong to, and whether it has since been torn down
+        JSRuntime* runtime {nullptr};
+        std::atomic<bool> runtimeTornDown {false};
+
+        // Returns whether scripts bound in the given context may be kept, registering to trace them if need be
+        bool canKeepBound(JSContext* cx);
+
+        // Forget the bound scripts without touching them, as their runtime is gone
+        void forgetBound();
+
+        void unregister();
+
+        static void Trace(JSTracer* tracer, void* data);
+        static void RuntimeTornDown(JSRuntime* rt, void* data);
+
+        // Hand out the script for the current global, keeping it if possible
+        void keep(JSContext* cx, std::list<Entry>::iterator entry, ScriptWrapper* script);
+
+        // Recompute the size of the most recently used entry, evicting others to fit. An entry that alone exceeds the
+        // budget is itself removed.
+        void resize(std::list<Entry>::iterator entry);
+
+        // Evict the least recently used entries until no more than the given number of bytes are in use
+        void evictTo(size_t limit);
+
+        void remove(std::list<Entry>::iterator entry);
+    };
+  }
+}
+
+
+#endif
@@ -0,0 +1,219 @@
+// atomic
+#include <atomic>
+
+// isspace
+#include <cctype>
+
+// strtoull
+#include <cstdlib>
+
+// numeric_limits
+#include <limits>
+
+// V8::SetFlagsFromCommandLine V8::SetFlagsFromString
+#include "v8.h"
+
+// Class definition
+#include "runtime/flags.h"
+
+
+namespace {
+  constexpr bool defaultLazy {true};
+  constexpr bool defaultMaxLazy {false};
+  constexpr size_t defaultMinPreparseLength {1024};
+
+  std::atomic<bool> lazy {defaultLazy};
+  std::atomic<bool> maxLazy {defaultMaxLazy};
+  std::atomic<size_t> minPreparseLength {defaultMinPreparseLength};
+
+
+  std::atomic<bool>* booleanFlag(const std::string& name) {
+    if (name == "lazy") {
+      return &lazy;
+    }
+
+    if (name == "max_lazy") {
+      return &maxLazy;
+    }
+
+    return nullptr;
+  }
+
+
+  std::atomic<size_t>* numericFlag(const std::string& name) {
+    return name == "min_preparse_length" ? &minPreparseLength : nullptr;
+  }
+
+
+  // Returns false unless the whole of text is a number that fits
+  bool parseNumber(const std::string& text, size_t& result) {
+    if (text.empty() || text[0] < '0' || text[0] > '9') {
+      return false;
+    }
+
+    char* end;
+    unsigned long long value {std::strtoull(text.c_str(), &end, 10)};
+    if (*end || value > std::numeric_limits<size_t>::max()) {
+      return false;
+    }
+
+    result = static_cast<size_t>(value);
+    return true;
+  }
+}
+
+
+namespace v8 {
+  namespace internal {
+    bool Flags::Lazy() {
+      return lazy.load(std::memory_order_relaxed) || MaxLazy();
+    }
+
+
+    bool Flags::MaxLazy() {
+      return maxLazy.load(std::memory_order_relaxed);
+    }
+
+
+    size_t Flags::MinPreparseLength() {
+      return minPreparseLength.load(std::memory_order_relaxed);
+    }
+
+
+    bool Flags::ParseLazily(size_t sourceLength) {
+      return MaxLazy() || (Lazy() && sourceLength >= MinPreparseLength());
+    }
+
+
+    void Flags::Apply(JS::CompileOptions& options, size_t sourceLength) {
+      options.setCanLazilyParse(ParseLazily(sourceLength));
+    }
+
+
+    std::vector<size_t> Flags::SetFromArguments(const std::vector<std::string>& arguments, size_t first) {
+      std::vector<size_t> consumed;
+
+      for (size_t i = first; i < arguments.size(); i++) {
+        const std::string& argument = arguments[i];
+        if (argument == "--") {
+          break;
+        }
+
+        if (argument.size() < 2 || argument[0] != '-') {
+          continue;
+        }
+
+        std::string name {argument.substr(argument[1] == '-' ? 2 : 1)};
+        std::string value;
+        bool hasValue {false};
+
+        size_t equals {name.find('=')};
+        if (equals != std::string::npos) {
+          value = name.substr(equals + 1);
+          name.resize(equals);
+          hasValue = true;
+        }
+
+        for (char& c : name) {
+          if (c == '-') {
+            c = '_';
+          }
+        }
+
+        std::atomic<bool>* boolean {booleanFlag(name)};
+        bool setting {true};
+        if (!boolean && name.compare(0, 2, "no") == 0) {
+          boolean = booleanFlag(name.substr(name.compare(0, 3, "no_") == 0 ? 3 : 2));
+          setting = false;
+        }
+
+        if (boolean) {
+          // V8 does not accept values for boolean flags
+          if (!hasValue) {
+            boolean->store(setting, std::memory_order_relaxed);
+            consumed.push_back(i);
+          }
+
+          continue;
+        }
+
+        std::atomic<size_t>* numeric {numericFlag(name)};
+        if (!numeric) {
+          continue;
+        }
+
+        bool valueFollows {!hasValue && i + 1 < arguments.size()};
+        size_t number;
+        if (!parseNumber(valueFollows ? arguments[i + 1] : value, number)) {
+          continue;
+        }
+
+        numeric->store(number, std::memory_order_relaxed);
+        consumed.push_back(i);
+        if (valueFollows) {
+          consumed.push_back(++i);
+        }
+      }
+
+      return consumed;
+    }
+
+
+    #ifdef V8MONKEY_INTERNAL_TEST
+    void Flags::Reset() {
+      lazy.store(defaultLazy, std::memory_order_relaxed);
+      maxLazy.store(defaultMaxLazy, std::memory_order_relaxed);
+      minPreparseLength.store(defaultMinPreparseLength, std::memory_order_relaxed);
+    }
+    #endif
+  }
+
+
+  void V8::SetFlagsFromString(const char* str, int length) {
+    std::vector<std::string> arguments;
+    std::string argument;
+
+    for (int i = 0; i < length; i++) {
+      if (!std::isspace(static_cast<unsigned char>(str[i]))) {
+        argument += str[i];
+        continue;
+      }
+
+      if (!argument.empty()) {
+        arguments.push_back(argument);
+        argument.clear();
+      }
+    }
+
+    if (!argument.empty()) {
+      arguments.push_back(argument);
+    }
+
+    internal::Flags::SetFromArguments(arguments);
+  }
+
+
+  void V8::SetFlagsFromCommandLine(int* argc, char** argv, bool remove_flags) {
+    size_t count {static_cast<size_t>(*argc)};
+    std::vector<std::string> arguments(argv, argv + count);
+
+    // As in V8, the first argument is the program name
+    std::vector<size_t> consumed {internal::Flags::SetFromArguments(arguments, 1)};
+    if (!remove_flags || consumed.empty()) {
+      return;
+    }
+
+    size_t kept {0};
+    size_t next {0};
+    for (size_t i = 0; i < count; i++) {
+      if (next < consumed.size() && consumed[next] == i) {
+        next++;
+        continue;
+      }
+
+      argv[kept++] = argv[i];
+    }
+
+    *argc = static_cast<int>(kept);
+  }
+}
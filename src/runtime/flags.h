@@ -0,0 +1,75 @@
+#ifndef V8MONKEY_FLAGS_H
+#define V8MONKEY_FLAGS_H
+
+// size_t
+#include <cstddef>
+
+// string
+#include <string>
+
+// vector
+#include <vector>
+
+// JS::CompileOptions
+#include "jsapi.h"
+
+// EXPORT_FOR_TESTING_ONLY
+#include "utils/test.h"
+
+
+namespace v8 {
+  namespace internal {
+
+    /*
+     * Backs V8::SetFlagsFromString and V8::SetFlagsFromCommandLine.
+     *
+     * Only the V8 flags with a SpiderMonkey counterpart are understood; others are ignored. The syntax is V8's: a flag
+     * is written --name or -name, with dashes and underscores interchangeable. A boolean flag is turned off by
+     * --noname or --no-name. A numeric flag takes its value as --name=value, or as the following argument.
+     *
+     * Flags apply to scripts compiled after they are set, on any thread.
+     *
+     */
+
+    class EXPORT_FOR_TESTING_ONLY Flags {
+      public:
+        /*
+         * --lazy (default true): let SpiderMonkey syntax-parse inner functions, and compile them on their first call.
+         * SpiderMonkey can only do so for compile-and-go scripts, so code cache and unbound compiles are always eager.
+         *
+         */
+
+        static bool Lazy();
+
+        // --max_lazy (default false): V8 then ignores its eager compilation hints. SpiderMonkey has none, so this
+        // implies --lazy, as in V8, and overrides --min_preparse_length.
+        static bool MaxLazy();
+
+        // --min_preparse_length (default 1024): scripts with fewer characters are compiled eagerly, as parsing their
+        // functions twice would cost more than it saves
+        static size_t MinPreparseLength();
+
+        // Whether a script of the given length is to be parsed lazily
+        static bool ParseLazily(size_t sourceLength);
+
+        // Set the compile options the flags control
+        static void Apply(JS::CompileOptions& options, size_t sourceLength);
+
+        /*
+         * Set flags from the given arguments, starting at first. Returns the indices of the arguments consumed, in
+         * order. Processing stops at an argument of "--", which V8 treats as the start of the script's arguments.
+         *
+         */
+
+        static std::vector<size_t> SetFromArguments(const std::vector<std::string>& arguments, size_t first = 0);
+
+        #ifdef V8MONKEY_INTERNAL_TEST
+        // Restore the defaults
+        static void Reset();
+        #endif
+    };
+  }
+}
+
+
+#endif
@@ -1,3 +1,12 @@
+// fill_n
+#include <algorithm>
+
+// begin
+#include <iterator>
+
+// BiasedRefCounted
+#include "data_structures/biased_refcount.h"
+
 // TLSKey
 #include "platform/platform.h"
 
@@ -22,6 +31,25 @@ namespace {
 
   // When a thread enters an isolate, we store that isolate in TLS to enable Isolate::GetCurrent to work
   TLSKey<v8::internal::Isolate> currentIsolateKey {};
+
+  // The names passed to the embedder's counter function, indexed by Isolate::Counter
+  const char* const counterNames[] {
+    "c:V8Monkey.StringConcats",
+    "c:V8Monkey.StringFlattens",
+    "c:V8Monkey.MaxRopeDepth",
+    "c:V8Monkey.ScriptsCompiled",
+    "c:V8Monkey.ScriptsDecoded",
+    "c:V8Monkey.ScriptsCached",
+    "c:V8Monkey.ScriptsParsedLazily",
+    "c:V8Monkey.ScriptsCompiledOffThread",
+    "c:V8Monkey.ScriptCompileMicroseconds",
+    "c:V8Monkey.ScriptSourceLength",
+    "c:V8Monkey.ScriptBytecodeSize"
+  };
+
+
+  static_assert(sizeof(counterNames) / sizeof(counterNames[0]) ==
+                static_cast<size_t>(v8::internal::Isolate::Counter::NumberOfCounters), "Missing counter names");
 }
 
 
@@ -56,6 +84,9 @@ namespace v8 {
 
 
   namespace internal {
+    std::atomic<bool> Isolate::anyCreated {false};
+
+
     void Isolate::Enter() {
       using namespace ::v8;
 
@@ -99,6 +130,10 @@ namespace v8 {
     void Isolate::Exit() {
       Isolate* i {RecordThreadExit()};
       currentIsolateKey.Set(i);
+
+      // Threads that used our objects under a Locker while we were away may have released references we took: now is a
+      // good time to reconcile those counts
+      DataStructures::BiasedRefCounted::ProcessQueuedMerges(this);
     }
 
 
@@ -108,6 +143,8 @@ namespace v8 {
          return;
       }
 
+      DataStructures::BiasedRefCounted::ProcessQueuedMerges(this);
+      internedStrings.Trim();
       delete this;
     }
 
@@ -131,6 +168,26 @@ namespace v8 {
     }
 
 
+    void Isolate::SetCounterFunction(CounterLookupCallback fn) {
+      counterFunction = fn;
+      std::fill_n(std::begin(counters), numberOfCounters, nullptr);
+      std::fill_n(std::begin(countersLookedUp), numberOfCounters, false);
+    }
+
+
+    int* Isolate::GetCounter(Counter counter) {
+      size_t index {static_cast<size_t>(counter)};
+      V8MONKEY_ASSERT(index < numberOfCounters, "Invalid counter");
+
+      if (!countersLookedUp[index]) {
+        counters[index] = counterFunction ? counterFunction(counterNames[index]) : nullptr;
+        countersLookedUp[index] = true;
+      }
+
+      return counters[index];
+    }
+
+
 #ifdef V8MONKEY_INTERNAL_TEST
   }
 
@@ -8,6 +8,12 @@
 // begin
 #include <iterator>
 
+// CompilationCache
+#include "runtime/compilation_cache.h"
+
+// InternedStringTable
+#include "types/string_table.h"
+
 // FatalErrorCallback, SetFatalErrorHandler
 #include "v8.h"
 
@@ -22,6 +28,7 @@ namespace v8 {
       public:
         Isolate() : embedderData {}, previousIsolates {}, hasFatalError {false}, fatalErrorHandler {nullptr} {
           std::fill_n(std::begin(embedderData), Internals::kNumIsolateDataSlots, nullptr);
+          anyCreated = true;
         }
 
 
@@ -60,6 +67,15 @@ namespace v8 {
         static Isolate* GetCurrent();
 
 
+        /*
+         * Reports whether any isolate has been created in this process. Process-wide startup state (such as the
+         * snapshot blob) may only be configured before this becomes true.
+         *
+         */
+
+        static bool AnyCreated() { return anyCreated.load(); }
+
+
         /*
          * API Isolates are all air: this function casts to a pointer to the real underlying internal::Isolate.
          *
@@ -107,6 +123,85 @@ namespace v8 {
         //     friend?
         FatalErrorCallback GetFatalErrorHandler() const { return fatalErrorHandler; }
 
+
+        /*
+         * The table of strings internalized through this isolate.
+         *
+         */
+
+        InternedStringTable& GetInternedStrings() { return internedStrings; }
+
+
+        /*
+         * The cache of scripts compiled through this isolate. Disabled until the embedder gives it a budget.
+         *
+         */
+
+        CompilationCache& GetCompilationCache() { return compilationCache; }
+
+
+        /*
+         * V8 API: release memory that can be recreated on demand.
+         *
+         */
+
+        void LowMemoryNotification() {
+          internedStrings.Trim();
+          compilationCache.Clear();
+        }
+
+
+        /*
+         * V8 API: a context has been disposed, so scripts compiled for it are unlikely to be wanted again. Returns the
+         * number of disposals since the compilation cache was last cleaned up: it is cleared the next time it is used,
+         * or on a low memory notification, rather than once per disposal.
+         *
+         */
+
+        int ContextDisposedNotification() {
+          return compilationCache.ContextDisposed();
+        }
+
+
+        /*
+         * The statistics V8Monkey reports through the embedder's counter function. The script counters sum the
+         * CompileStatistics of every script compiled, decoded or bound in the isolate, or handed out again by its
+         * compilation cache; bytecode sizes are only known for scripts that were encoded or decoded.
+         *
+         */
+
+        enum class Counter {
+          StringConcats,
+          StringFlattens,
+          MaxRopeDepth,
+          ScriptsCompiled,
+          ScriptsDecoded,
+          ScriptsCached,
+          ScriptsParsedLazily,
+          ScriptsCompiledOffThread,
+          ScriptCompileMicroseconds,
+          ScriptSourceLength,
+          ScriptBytecodeSize,
+          NumberOfCounters
+        };
+
+
+        /*
+         * V8 API: Set the client callback used to find the storage for a named counter.
+         *
+         */
+
+        void SetCounterFunction(CounterLookupCallback fn);
+
+
+        /*
+         * Returns the embedder's storage for the given counter, or nullptr if the embedder isn't interested in it. The
+         * counter function is only consulted on the first request for each counter.
+         *
+         */
+
+        int* GetCounter(Counter counter);
+
         // XXX Do we want to allow moving/copying isolates? My gut feeling is that because of rooting etc, we don't want
         // to copy
 
@@ -144,6 +239,22 @@ namespace v8 {
 
         bool hasFatalError;
         FatalErrorCallback fatalErrorHandler;
+
+        InternedStringTable internedStrings {};
+        CompilationCache compilationCache {};
+
+        /*
+         * Counters
+         *
+         */
+
+        static constexpr size_t numberOfCounters {static_cast<size_t>(Counter::NumberOfCounters)};
+
+        CounterLookupCallback counterFunction {nullptr};
+        int* counters[numberOfCounters] {};
+        bool countersLookedUp[numberOfCounters] {};
+
+        static std::atomic<bool> anyCreated;
     };
   }
 }
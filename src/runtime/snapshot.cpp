@@ -0,0 +1,196 @@
+// memcmp memcpy strlen
+#include <cstring>
+
+// unique_ptr
+#include <memory>
+
+// V8::GetVersion V8::SetNativesDataBlob V8::SetSnapshotDataBlob StartupData
+#include "v8.h"
+
+// Isolate::AnyCreated
+#include "runtime/isolate.h"
+
+// Class definition
+#include "runtime/snapshot.h"
+
+// ScriptOrigin ScriptSource ScriptWrapper UnboundScriptWrapper
+#include "types/script_wrapper.h"
+
+// Abort TriggerFatalError
+#include "utils/V8MonkeyCommon.h"
+
+
+namespace {
+  using namespace v8::internal;
+
+
+  // 'V8MS'
+  constexpr uint32_t snapshotMagic {0x56384d53u};
+
+
+  // Every snapshot registered with V8::SetSnapshotDataBlob. The current snapshot is the last; replaced snapshots are
+  // kept, as pointers returned by Snapshot::Current may still be in use.
+  std::vector<std::unique_ptr<Snapshot>> registeredSnapshots {};
+  const Snapshot* currentSnapshot {nullptr};
+
+
+  void appendWord(std::vector<uint8_t>& blob, uint32_t word) {
+    const uint8_t* bytes {reinterpret_cast<const uint8_t*>(&word)};
+    blob.insert(blob.end(), bytes, bytes + sizeof(uint32_t));
+  }
+
+
+  void appendBytes(std::vector<uint8_t>& blob, const uint8_t* data, size_t length) {
+    appendWord(blob, static_cast<uint32_t>(length));
+    blob.insert(blob.end(), data, data + length);
+  }
+
+
+  // Reads a length-prefixed run of bytes, advancing the cursor. Returns false if the blob is too short.
+  bool readBytes(const char*& cursor, const char* end, const uint8_t*& data, uint32_t& length) {
+    if (static_cast<size_t>(end - cursor) < sizeof(uint32_t)) {
+      return false;
+    }
+
+    std::memcpy(&length, cursor, sizeof(uint32_t));
+    cursor += sizeof(uint32_t);
+    if (static_cast<size_t>(end - cursor) < length) {
+      return false;
+    }
+
+    data = reinterpret_cast<const uint8_t*>(cursor);
+    cursor += length;
+    return true;
+  }
+}
+
+
+namespace v8 {
+  namespace internal {
+    bool Snapshot::Create(JSContext* cx, const std::vector<BootstrapScript>& scripts, std::vector<uint8_t>& blob) {
+      const char* version {V8::GetVersion()};
+      blob.clear();
+      appendWord(blob, snapshotMagic);
+      appendBytes(blob, reinterpret_cast<const uint8_t*>(version), std::strlen(version));
+      appendWord(blob, static_cast<uint32_t>(scripts.size()));
+
+      // Later scripts may well depend on the work of earlier ones, so each must run before the next is compiled
+      for (const auto& script : scripts) {
+        ScriptSource source {script.source.data(), script.source.size(), ScriptOrigin {script.name, 0}};
+        std::unique_ptr<UnboundScriptWrapper> unbound {UnboundScriptWrapper::Compile(cx, source)};
+        if (!unbound) {
+          return false;
+        }
+
+        std::unique_ptr<ScriptWrapper> bound {unbound->BindToCurrentContext(cx)};
+        JS::RootedValue result(cx);
+        if (!bound || !bound->Run(cx, &result)) {
+          return false;
+        }
+
+        appendBytes(blob, unbound->Data(), unbound->Length());
+      }
+
+      return true;
+    }
+
+
+    Snapshot* Snapshot::FromBlob(const char* data, size_t length) {
+      const char* cursor {data};
+      const char* end {data + length};
+
+      uint32_t magic;
+      if (length < sizeof(uint32_t)) {
+        return nullptr;
+      }
+
+      std::memcpy(&magic, cursor, sizeof(uint32_t));
+      cursor += sizeof(uint32_t);
+
+      const uint8_t* version;
+      uint32_t versionLength;
+      const char* expectedVersion {V8::GetVersion()};
+      if (magic != snapshotMagic || !readBytes(cursor, end, version, versionLength) ||
+          versionLength != std::strlen(expectedVersion) || std::memcmp(version, expectedVersion, versionLength) != 0) {
+        return nullptr;
+      }
+
+      uint32_t count;
+      if (static_cast<size_t>(end - cursor) < sizeof(uint32_t)) {
+        return nullptr;
+      }
+
+      std::memcpy(&count, cursor, sizeof(uint32_t));
+      cursor += sizeof(uint32_t);
+
+      std::unique_ptr<Snapshot> snapshot {new Snapshot};
+      for (uint32_t i = 0; i < count; i++) {
+        Script script;
+        if (!readBytes(cursor, end, script.data, script.length)) {
+          return nullptr;
+        }
+
+        snapshot->scripts.push_back(script);
+      }
+
+      return cursor == end ? snapshot.release() : nullptr;
+    }
+
+
+    bool Snapshot::Apply(JSContext* cx) const {
+      JS::RootedObject global(cx, JS::CurrentGlobalOrNull(cx));
+      JS::RootedScript script(cx);
+      JS::RootedValue result(cx);
+
+      for (const auto& s : scripts) {
+        script = JS_DecodeScript(cx, s.data, s.length, nullptr);
+        if (!script || !JS_ExecuteScript(cx, global, script, &result)) {
+          return false;
+        }
+      }
+
+      return true;
+    }
+
+
+    const Snapshot* Snapshot::Current() {
+      return currentSnapshot;
+    }
+  }
+
+
+  /*
+   * V8's natives are its builtins, written in JavaScript. SpiderMonkey's self-hosted builtins are compiled in to the
+   * library, so there is nothing to do here.
+   *
+   */
+
+  void V8::SetNativesDataBlob(StartupData*) {}
+
+
+  /*
+   * As with V8, the blob is not copied, must outlive its use, and invalid data is fatal. The snapshot may not be
+   * changed once an isolate has been created.
+   *
+   */
+
+  void V8::SetSnapshotDataBlob(StartupData* startup_blob) {
+    if (internal::Isolate::AnyCreated()) {
+      V8Monkey::TriggerFatalError("V8::SetSnapshotDataBlob", "Snapshot set after an isolate was created");
+      return;
+    }
+
+    internal::Snapshot* snapshot {nullptr};
+    if (startup_blob && startup_blob->data) {
+      snapshot = internal::Snapshot::FromBlob(startup_blob->data, static_cast<size_t>(startup_blob->raw_size));
+      if (!snapshot) {
+        V8Monkey::Abort("V8::SetSnapshotDataBlob", "Invalid snapshot data", false);
+        return;
+      }
+
+      registeredSnapshots.emplace_back(snapshot);
+    }
+
+    currentSnapshot = snapshot;
+  }
+}
@@ -0,0 +1,86 @@
+#ifndef V8MONKEY_SNAPSHOT_H
+#define V8MONKEY_SNAPSHOT_H
+
+// size_t
+#include <cstddef>
+
+// uint8_t, uint32_t
+#include <cstdint>
+
+// string, u16string
+#include <string>
+
+// vector
+#include <vector>
+
+// JSContext
+#include "jsapi.h"
+
+// EXPORT_FOR_TESTING_ONLY
+#include "utils/test.h"
+
+
+namespace v8 {
+  namespace internal {
+
+    /*
+     * Backs V8::SetSnapshotDataBlob.
+     *
+     * V8 snapshots are images of a heap after the bootstrap scripts have run. SpiderMonkey offers no way to serialize
+     * a heap, so the nearest equivalent is used instead: the bootstrap scripts, compiled ahead of time and stored in
+     * XDR form. Applying a snapshot to a new global still runs the scripts in order, so their top-level code costs
+     * as much as ever; only parsing and compilation are saved. SpiderMonkey::NewGlobal applies the registered snapshot
+     * to every global it creates.
+     *
+     * A blob records the engine version that produced it, and is refused by any other.
+     *
+     */
+
+    class EXPORT_FOR_TESTING_ONLY Snapshot {
+      public:
+        struct BootstrapScript {
+          std::string name;
+          std::u16string source;
+        };
+
+        ~Snapshot() = default;
+
+        /*
+         * Compile and run the given scripts in order in the current global, writing a blob to the given vector.
+         * Returns false if a script failed to compile or threw; the exception will be pending on the context.
+         *
+         */
+
+        static bool Create(JSContext* cx, const std::vector<BootstrapScript>& scripts, std::vector<uint8_t>& blob);
+
+        // Returns nullptr if the blob is malformed, or was produced by a different engine. The blob is not copied.
+        static Snapshot* FromBlob(const char* data, size_t length);
+
+        // Run the scripts in the current global. Returns false if a script threw; the exception will be pending.
+        bool Apply(JSContext* cx) const;
+
+        size_t ScriptCount() const { return scripts.size(); }
+
+        // The snapshot registered with V8::SetSnapshotDataBlob, if any. Registered snapshots live until exit.
+        static const Snapshot* Current();
+
+        Snapshot(const Snapshot& other) = delete;
+        Snapshot(Snapshot&& other) = delete;
+        Snapshot& operator=(const Snapshot& other) = delete;
+        Snapshot& operator=(Snapshot&& other) = delete;
+
+      private:
+        Snapshot() = default;
+
+        struct Script {
+          const uint8_t* data;
+          uint32_t length;
+        };
+
+        std::vector<Script> scripts {};
+    };
+  }
+}
+
+
+#endif
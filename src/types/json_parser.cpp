@@ -0,0 +1,633 @@
+// int32_t uint8_t uint16_t uint32_t
+#include <cstdint>
+
+// u16string
+#include <string>
+
+// vector
+#include <vector>
+
+// Class definition
+#include "types/json_parser.h"
+
+// StringWrapper
+#include "types/string_wrapper.h"
+
+// IndexStructurals
+#include "utils/JSONIndex.h"
+
+// StringToDouble
+#include "utils/StringToNumber.h"
+
+
+namespace {
+  using namespace v8::internal;
+  using namespace v8::V8Monkey;
+
+  using Outcome = JSONParser::Outcome;
+
+
+  // SpiderMonkey's parser checks the native stack as it recurses, which we cannot; deeper nesting is left to it
+  constexpr size_t maxDepth {512};
+
+  // Numbers longer than this are left to SpiderMonkey. StringToDouble declines more than 19 significant digits anyway.
+  constexpr size_t maxNumberLength {64};
+
+  // Strings shorter than this are copied before parsing: see JSONParser::Parse
+  constexpr size_t inlineCapacity {32};
+
+
+  template <typename T>
+  inline bool isWhitespace(T c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+  }
+
+
+  // The code units that end a number, true, false or null
+  template <typename T>
+  inline bool isDelimiter(T c) {
+    return isWhitespace(c) || c == ',' || c == ':' || c == '[' || c == ']' || c == '{' || c == '}' || c == '"';
+  }
+
+
+  template <typename T>
+  inline bool isDigit(T c) {
+    return c >= '0' && c <= '9';
+  }
+
+
+  template <typename T>
+  inline int hexValue(T c) {
+    if (isDigit(c)) {
+      return static_cast<int>(c - '0');
+    }
+
+    if (c >= 'a' && c <= 'f') {
+      return static_cast<int>(c - 'a') + 10;
+    }
+
+    if (c >= 'A' && c <= 'F') {
+      return static_cast<int>(c - 'A') + 10;
+    }
+
+    return -1;
+  }
+
+
+  template <typename T>
+  bool matches(const T* chars, size_t length, const char* literal, size_t literalLength) {
+    if (length != literalLength) {
+      return false;
+    }
+
+    for (size_t i = 0; i < length; i++) {
+      if (chars[i] != static_cast<unsigned char>(literal[i])) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+
+  JSString* newString(JSContext* cx, const JS::Latin1Char* chars, size_t length) {
+    return JS_NewStringCopyN(cx, reinterpret_cast<const char*>(chars), length);
+  }
+
+
+  JSString* newString(JSContext* cx, const char16_t* chars, size_t length) {
+    return JS_NewUCStringCopyN(cx, chars, length);
+  }
+
+
+  JSString* newAtom(JSContext* cx, const JS::Latin1Char* chars, size_t length) {
+    return JS_AtomizeStringN(cx, reinterpret_cast<const char*>(chars), length);
+  }
+
+
+  JSString* newAtom(JSContext* cx, const char16_t* chars, size_t length) {
+    return JS_AtomizeUCStringN(cx, chars, length);
+  }
+
+
+  /*
+   * A recursive descent over the structural index. Each token is checked as it is consumed, as the index of malformed
+   * text may be nonsense: any surprise abandons the fast path.
+   *
+   */
+
+  template <typename T>
+  class Parser {
+    public:
+      Parser(JSContext* context, const T* chars, size_t count) : cx {context}, text {chars}, length {count} {}
+
+      Outcome Run(JS::MutableHandleValue result) {
+        if (!JSONIndex::IndexStructurals(text, length, index)) {
+          return JSONParser::kFallback;
+        }
+
+        Outcome outcome {parseValue(result, 0)};
+
+        // Trailing tokens
+        if (outcome == JSONParser::kParsed && cursor != index.size()) {
+          return JSONParser::kFallback;
+        }
+
+        return outcome;
+      }
+
+    private:
+      JSContext* cx;
+      const T* text;
+      size_t length;
+
+      std::vector<uint32_t> index {};
+      size_t cursor {0};
+
+      // Decoded string contents, when a string contains escapes
+      std::u16string decoded {};
+
+      // Consume the next token if it is the given operator
+      bool consume(char op) {
+        if (cursor < index.size() && text[index[cursor]] == static_cast<unsigned char>(op)) {
+          cursor++;
+          return true;
+        }
+
+        return false;
+      }
+
+
+      Outcome parseValue(JS::MutableHandleValue result, size_t depth) {
+        if (cursor == index.size()) {
+          return JSONParser::kFallback;
+        }
+
+        size_t position {index[cursor++]};
+        switch (text[position]) {
+          case '{':
+            return parseObject(result, depth);
+
+          case '[':
+            return parseArray(result, depth);
+
+          case '"':
+            return parseString(position, result);
+
+          default:
+            return parseScalar(position, result);
+        }
+      }
+
+
+      Outcome parseObject(JS::MutableHandleValue result, size_t depth) {
+        if (depth == maxDepth) {
+          return JSONParser::kFallback;
+        }
+
+        JS::RootedObject object(cx, JS_NewObject(cx, nullptr, JS::NullPtr(), JS::NullPtr()));
+        if (!object) {
+          return JSONParser::kFailed;
+        }
+
+        if (!consume('}')) {
+          JS::RootedId key(cx);
+          JS::RootedValue value(cx);
+
+          do {
+            if (cursor == index.size() || text[index[cursor]] != '"') {
+              return JSONParser::kFallback;
+            }
+
+            Outcome outcome {parseKey(index[cursor++], &key)};
+            if (outcome != JSONParser::kParsed) {
+              return outcome;
+            }
+
+            if (!consume(':')) {
+              return JSONParser::kFallback;
+            }
+
+            outcome = parseValue(&value, depth + 1);
+            if (outcome != JSONParser::kParsed) {
+              return outcome;
+            }
+
+            // As JSON.parse, define rather than set, so that keys such as __proto__ become ordinary own properties
+            if (!JS_DefinePropertyById(cx, object, key, value, JSPROP_ENUMERATE)) {
+              return JSONParser::kFailed;
+            }
+          } while (consume(','));
+
+          if (!consume('}')) {
+            return JSONParser::kFallback;
+          }
+        }
+
+        result.setObject(*object);
+        return JSONParser::kParsed;
+      }
+
+
+      Outcome parseArray(JS::MutableHandleValue result, size_t depth) {
+        if (depth == maxDepth) {
+          return JSONParser::kFallback;
+        }
+
+        // Collecting the elements first lets SpiderMonkey allocate the array's elements at their final size
+        JS::AutoValueVector elements(cx);
+        if (!consume(']')) {
+          JS::RootedValue element(cx);
+
+          do {
+            Outcome outcome {parseValue(&element, depth + 1)};
+            if (outcome != JSONParser::kParsed) {
+              return outcome;
+            }
+
+            if (!elements.append(element)) {
+              return JSONParser::kFailed;
+            }
+          } while (consume(','));
+
+          if (!consume(']')) {
+            return JSONParser::kFallback;
+          }
+        }
+
+        JSObject* array {JS_NewArrayObject(cx, elements)};
+        if (!array) {
+          return JSONParser::kFailed;
+        }
+
+        result.setObject(*array);
+        return JSONParser::kParsed;
+      }
+
+
+      /*
+       * Find the contents of the string opened at the given position, decoding any escapes. On success, chars and
+       * count describe the contents: either in place in the text, or in the decoded buffer.
+       *
+       */
+
+      Outcome stringContents(size_t open, const T*& chars, const char16_t*& decodedChars, size_t& count) {
+        if (cursor == index.size()) {
+          return JSONParser::kFallback;
+        }
+
+        size_t close {index[cursor++]};
+        if (text[close] != '"') {
+          return JSONParser::kFallback;
+        }
+
+        size_t start {open + 1};
+        size_t i {start};
+        for (; i < close; i++) {
+          T c {text[i]};
+          if (c == '\\') {
+            break;
+          }
+
+          if (c < 0x20 || c == '"') {
+            return JSONParser::kFallback;
+          }
+        }
+
+        if (i == close) {
+          chars = text + start;
+          decodedChars = nullptr;
+          count = close - start;
+          return JSONParser::kParsed;
+        }
+
+        decoded.assign(text + start, text + i);
+        while (i < close) {
+          T c {text[i++]};
+          if (c != '\\') {
+            if (c < 0x20 || c == '"') {
+              return JSONParser::kFallback;
+            }
+
+            decoded += static_cast<char16_t>(c);
+            continue;
+          }
+
+          if (i == close) {
+            return JSONParser::kFallback;
+          }
+
+          switch (text[i++]) {
+            case '"':
+              decoded += u'"';
+              break;
+
+            case '\\':
+              decoded += u'\\';
+              break;
+
+            case '/':
+              decoded += u'/';
+              break;
+
+            case 'b':
+              decoded += u'\b';
+              break;
+
+            case 'f':
+              decoded += u'\f';
+              break;
+
+            case 'n':
+              decoded += u'\n';
+              break;
+
+            case 'r':
+              decoded += u'\r';
+              break;
+
+            case 't':
+              decoded += u'\t';
+              break;
+
+            case 'u': {
+              if (close - i < 4) {
+                return JSONParser::kFallback;
+              }
+
+              int unit {0};
+              for (size_t j = 0; j < 4; j++) {
+                int digit {hexValue(text[i++])};
+                if (digit < 0) {
+                  return JSONParser::kFallback;
+                }
+
+                unit = (unit << 4) | digit;
+              }
+
+              // Lone surrogates are permitted, as in JSON.parse
+              decoded += static_cast<char16_t>(unit);
+              break;
+            }
+
+            default:
+              return JSONParser::kFallback;
+          }
+        }
+
+        chars = nullptr;
+        decodedChars = decoded.data();
+        count = decoded.size();
+        return JSONParser::kParsed;
+      }
+
+
+      Outcome parseString(size_t open, JS::MutableHandleValue result) {
+        const T* chars;
+        const char16_t* decodedChars;
+        size_t count;
+
+        Outcome outcome {stringContents(open, chars, decodedChars, count)};
+        if (outcome != JSONParser::kParsed) {
+          return outcome;
+        }
+
+        JSString* str {chars ? newString(cx, chars, count) : newString(cx, decodedChars, count)};
+        if (!str) {
+          return JSONParser::kFailed;
+        }
+
+        result.setString(str);
+        return JSONParser::kParsed;
+      }
+
+
+      Outcome parseKey(size_t open, JS::MutableHandleId key) {
+        const T* chars;
+        const char16_t* decodedChars;
+        size_t count;
+
+        Outcome outcome {stringContents(open, chars, decodedChars, count)};
+        if (outcome != JSONParser::kParsed) {
+          return outcome;
+        }
+
+        // Objects parsed from the same source tend to share their keys, so atomizing saves both memory and lookups
+        JS::RootedString atom(cx, chars ? newAtom(cx, chars, count) : newAtom(cx, decodedChars, count));
+
+        // Index-like keys such as "0" must become integer ids, which JS_StringToId takes care of
+        if (!atom || !JS_StringToId(cx, atom, key)) {
+          return JSONParser::kFailed;
+        }
+
+        return JSONParser::kParsed;
+      }
+
+
+      Outcome parseScalar(size_t position, JS::MutableHandleValue result) {
+        size_t end {position};
+        while (end < length && !isDelimiter(text[end])) {
+          end++;
+        }
+
+        // Only whitespace may separate the token from the next one. Were there anything else, the index is nonsense.
+        size_t next {end};
+        while (next < length && isWhitespace(text[next])) {
+          next++;
+        }
+
+        if (next != (cursor < index.size() ? index[cursor] : length)) {
+          return JSONParser::kFallback;
+        }
+
+        const T* token {text + position};
+        size_t tokenLength {end - position};
+
+        switch (*token) {
+          case 't':
+            if (!matches(token, tokenLength, "true", 4)) {
+              return JSONParser::kFallback;
+            }
+
+            result.setBoolean(true);
+            return JSONParser::kParsed;
+
+          case 'f':
+            if (!matches(token, tokenLength, "false", 5)) {
+              return JSONParser::kFallback;
+            }
+
+            result.setBoolean(false);
+            return JSONParser::kParsed;
+
+          case 'n':
+            if (!matches(token, tokenLength, "null", 4)) {
+              return JSONParser::kFallback;
+            }
+
+            result.setNull();
+            return JSONParser::kParsed;
+
+          default:
+            return parseNumber(token, tokenLength, result);
+        }
+      }
+
+
+      /*
+       * JSON's number grammar is stricter than that of JavaScript: no leading '+' or zeros, and digits are required on
+       * both sides of a decimal point. Small integers are converted directly; anything else is checked against the
+       * grammar and handed to StringToDouble.
+       *
+       */
+
+      Outcome parseNumber(const T* token, size_t tokenLength, JS::MutableHandleValue result) {
+        if (tokenLength == 0 || tokenLength > maxNumberLength) {
+          return JSONParser::kFallback;
+        }
+
+        size_t i {0};
+        bool negative {token[0] == '-'};
+        if (negative) {
+          i++;
+        }
+
+        size_t integerStart {i};
+        while (i < tokenLength && isDigit(token[i])) {
+          i++;
+        }
+
+        size_t integerDigits {i - integerStart};
+        if (integerDigits == 0 || (token[integerStart] == '0' && integerDigits > 1)) {
+          return JSONParser::kFallback;
+        }
+
+        // Nine digits always fit in an int32. Negative zero does not.
+        if (i == tokenLength && integerDigits <= 9) {
+          int32_t integer {0};
+          for (size_t j = integerStart; j < i; j++) {
+            integer = integer * 10 + static_cast<int32_t>(token[j] - '0');
+          }
+
+          if (!negative || integer != 0) {
+            result.setInt32(negative ? -integer : integer);
+            return JSONParser::kParsed;
+          }
+        }
+
+        if (i < tokenLength && token[i] == '.') {
+          size_t fractionStart {++i};
+          while (i < tokenLength && isDigit(token[i])) {
+            i++;
+          }
+
+          if (i == fractionStart) {
+            return JSONParser::kFallback;
+          }
+        }
+
+        if (i < tokenLength && (token[i] == 'e' || token[i] == 'E')) {
+          i++;
+          if (i < tokenLength && (token[i] == '+' || token[i] == '-')) {
+            i++;
+          }
+
+          size_t exponentStart {i};
+          while (i < tokenLength && isDigit(token[i])) {
+            i++;
+          }
+
+          if (i == exponentStart) {
+            return JSONParser::kFallback;
+          }
+        }
+
+        if (i != tokenLength) {
+          return JSONParser::kFallback;
+        }
+
+        // The grammar admits only ASCII, so narrowing is lossless
+        char narrow[maxNumberLength];
+        for (size_t j = 0; j < tokenLength; j++) {
+          narrow[j] = static_cast<char>(token[j]);
+        }
+
+        double value;
+        if (!Conversions::StringToDouble(narrow, tokenLength, &value)) {
+          return JSONParser::kFallback;
+        }
+
+        result.setNumber(value);
+        return JSONParser::kParsed;
+      }
+  };
+}
+
+
+namespace v8 {
+  namespace internal {
+    bool JSONParser::Parse(JSContext* cx, StringWrapper& json, JS::MutableHandleValue result) {
+      JSFlatString* flat {json.Flatten(cx)};
+      if (!flat) {
+        return false;
+      }
+
+      /*
+       * The characters are read in place. SpiderMonkey does not move strings or their characters, so rooting the
+       * string keeps them valid while the parser allocates. Short strings may keep their characters within the string
+       * itself, so, as with the string views, they are copied instead.
+       *
+       */
+
+      JS::RootedString pinned(cx, json.Get());
+      size_t length {JS_GetStringLength(pinned)};
+      Outcome outcome;
+
+      if (length < inlineCapacity) {
+        if (json.IsOneByte()) {
+          uint8_t chars[inlineCapacity];
+          json.WriteOneByte(cx, chars, 0, -1, StringWrapper::NO_NULL_TERMINATION);
+          outcome = TryParse(cx, chars, length, result);
+        } else {
+          uint16_t chars[inlineCapacity];
+          json.Write(cx, chars, 0, -1, StringWrapper::NO_NULL_TERMINATION);
+          outcome = TryParse(cx, reinterpret_cast<const char16_t*>(chars), length, result);
+        }
+      } else if (JS_StringHasLatin1Chars(pinned)) {
+        const JS::Latin1Char* chars;
+        {
+          JS::AutoCheckCannotGC nogc;
+          chars = JS_GetLatin1FlatStringChars(nogc, flat);
+        }
+
+        outcome = TryParse(cx, chars, length, result);
+      } else {
+        const char16_t* chars;
+        {
+          JS::AutoCheckCannotGC nogc;
+          chars = JS_GetTwoByteFlatStringChars(nogc, flat);
+        }
+
+        outcome = TryParse(cx, chars, length, result);
+      }
+
+      if (outcome == kFallback) {
+        return JS_ParseJSON(cx, pinned, result);
+      }
+
+      return outcome == kParsed;
+    }
+
+
+    JSONParser::Outcome JSONParser::TryParse(JSContext* cx, const JS::Latin1Char* chars, size_t length,
+                                             JS::MutableHandleValue result) {
+      return Parser<JS::Latin1Char>(cx, chars, length).Run(result);
+    }
+
+
+    JSONParser::Outcome JSONParser::TryParse(JSContext* cx, const char16_t* chars, size_t length,
+                                             JS::MutableHandleValue result) {
+      return Parser<char16_t>(cx, chars, length).Run(result);
+    }
+  }
+}
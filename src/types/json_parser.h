@@ -0,0 +1,58 @@
+#ifndef V8MONKEY_JSONPARSER_H
+#define V8MONKEY_JSONPARSER_H
+
+// size_t
+#include <cstddef>
+
+// JSContext JS::Latin1Char JS::MutableHandleValue
+#include "jsapi.h"
+
+// EXPORT_FOR_TESTING_ONLY
+#include "utils/test.h"
+
+
+namespace v8 {
+  namespace internal {
+    class StringWrapper;
+
+
+    /*
+     * Backs JSON::Parse.
+     *
+     * The text is read in place, in whichever of Latin1 or UTF-16 SpiderMonkey holds it. JSONIndex finds every token
+     * up front, and the parser then walks the index, building SpiderMonkey objects, arrays and strings directly:
+     * arrays are created at their final length from their elements, and strings without escapes are copied straight
+     * from the text.
+     *
+     * Anything the fast path cannot handle with certainty is left to JS_ParseJSON. That covers malformed text, so that
+     * SpiderMonkey reports the error exactly as JSON.parse would, and a few rare cases: numbers StringToDouble does not
+     * handle, and nesting too deep to recurse safely.
+     *
+     */
+
+    class EXPORT_FOR_TESTING_ONLY JSONParser {
+      public:
+        enum Outcome {
+          // The result is set
+          kParsed,
+
+          // The text must be left to JS_ParseJSON. No exception is pending.
+          kFallback,
+
+          // SpiderMonkey reported an error, most likely running out of memory, which is pending on the context
+          kFailed
+        };
+
+        // As JSON::Parse. Returns false if the text is not valid JSON, in which case a SyntaxError is pending.
+        static bool Parse(JSContext* cx, StringWrapper& json, JS::MutableHandleValue result);
+
+        // The fast path alone
+        static Outcome TryParse(JSContext* cx, const JS::Latin1Char* chars, size_t length,
+                                JS::MutableHandleValue result);
+        static Outcome TryParse(JSContext* cx, const char16_t* chars, size_t length, JS::MutableHandleValue result);
+    };
+  }
+}
+
+
+#endif
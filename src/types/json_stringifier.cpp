@@ -0,0 +1,619 @@
+// max, min
+#include <algorithm>
+
+// isfinite
+#include <cmath>
+
+// int16_t uint32_t
+#include <cstdint>
+
+// memcpy, strcmp
+#include <cstring>
+
+// vector
+#include <vector>
+
+// Class definition
+#include "types/json_stringifier.h"
+
+// NarrowASCII
+#include "utils/Encoding.h"
+
+// DoubleToString Int32ToString NumberToStringBufferSize Uint32ToString
+#include "utils/NumberToString.h"
+
+
+namespace {
+  using namespace v8::internal;
+  using namespace v8::V8Monkey;
+
+  using Outcome = JSONStringifier::Outcome;
+
+
+  // Large enough for any single escape, UTF-8 sequence or number
+  constexpr size_t minimumChunkSize {32};
+
+
+  // JSON.stringify reports cycles as a TypeError, with the same message as SpiderMonkey
+  const JSErrorFormatString cyclicValueFormat {"cyclic object value", 0, static_cast<int16_t>(JSEXN_TYPEERR)};
+
+
+  const JSErrorFormatString* cyclicValueError(void*, const unsigned) {
+    return &cyclicValueFormat;
+  }
+
+
+  // The ASCII code units that must be escaped within a string
+  inline bool needsEscape(unsigned int c) {
+    return c < 0x20u || c == '"' || c == '\\';
+  }
+
+
+  inline bool isPlainASCII(unsigned int c) {
+    return c < 0x80u && !needsEscape(c);
+  }
+
+
+  inline bool isHighSurrogate(unsigned int c) {
+    return c >= 0xd800u && c <= 0xdbffu;
+  }
+
+
+  inline bool isLowSurrogate(unsigned int c) {
+    return c >= 0xdc00u && c <= 0xdfffu;
+  }
+
+
+  /*
+   * A depth-first walk, with the stack held in frames rather than on the native stack. Each frame is an array or
+   * object whose opening bracket has been written, and whose members are still being serialised. The object itself is
+   * rooted in holders, at the same depth; the keys of object frames are collected, in order, in keys.
+   *
+   */
+
+  class Stringifier {
+    public:
+      Stringifier(JSContext* context, JSONOutputStream& output) : cx {context}, stream(output), holders(context),
+                                                                  keys(context),
+                                                                  buffer(std::max(output.GetChunkSize(),
+                                                                                  minimumChunkSize)) {}
+
+      Outcome Run(JS::HandleValue value) {
+        JS::RootedValue current(cx, value);
+        bool serializable;
+
+        if (!prepare(&current, serializable)) {
+          return JSONStringifier::kFailed;
+        }
+
+        if (!serializable) {
+          return JSONStringifier::kUndefined;
+        }
+
+        if (!emit(current)) {
+          return JSONStringifier::kFailed;
+        }
+
+        while (!frames.empty() && !aborted) {
+          if (!advance(&current)) {
+            return JSONStringifier::kFailed;
+          }
+        }
+
+        flush();
+        if (aborted) {
+          return JSONStringifier::kAborted;
+        }
+
+        stream.EndOfStream();
+        return JSONStringifier::kSerialized;
+      }
+
+      Stringifier(const Stringifier& other) = delete;
+      Stringifier(Stringifier&& other) = delete;
+      Stringifier& operator=(const Stringifier& other) = delete;
+      Stringifier& operator=(Stringifier&& other) = delete;
+
+    private:
+      struct Frame {
+        bool isArray;
+
+        // Arrays: the next index, and the length
+        uint32_t nextIndex;
+        uint32_t length;
+
+        // Objects: the position in keys of the first and next key. The frame's keys run to the end of keys.
+        size_t firstKey;
+        size_t nextKey;
+
+        // Objects: whether any member has been written, and so whether the next needs a comma
+        bool hasMembers;
+      };
+
+      JSContext* cx;
+      JSONOutputStream& stream;
+
+      std::vector<Frame> frames {};
+      JS::AutoObjectVector holders;
+      JS::AutoIdVector keys;
+
+      std::vector<char> buffer;
+      size_t used {0};
+      bool aborted {false};
+
+
+      // Serialise the next member of the innermost array or object, or close it
+      bool advance(JS::MutableHandleValue current) {
+        Frame& frame = frames.back();
+        JS::RootedObject holder(cx, holders.back());
+        bool serializable;
+
+        if (frame.isArray) {
+          if (frame.nextIndex == frame.length) {
+            put(']');
+            pop();
+            return true;
+          }
+
+          if (frame.nextIndex) {
+            put(',');
+          }
+
+          if (!JS_GetElement(cx, holder, frame.nextIndex++, current) || !prepare(current, serializable)) {
+            return false;
+          }
+
+          if (!serializable) {
+            write("null", 4);
+            return true;
+          }
+
+          return emit(current);
+        }
+
+        while (frame.nextKey < keys.length()) {
+          JS::RootedId id(cx, keys[frame.nextKey++]);
+          if (!JS_GetPropertyById(cx, holder, id, current) || !prepare(current, serializable)) {
+            return false;
+          }
+
+          if (!serializable) {
+            continue;
+          }
+
+          if (frame.hasMembers) {
+            put(',');
+          }
+
+          frame.hasMembers = true;
+          if (!writeKey(id)) {
+            return false;
+          }
+
+          put(':');
+          return emit(current);
+        }
+
+        put('}');
+        pop();
+        return true;
+      }
+
+
+      void pop() {
+        if (!frames.back().isArray) {
+          keys.resize(frames.back().firstKey);
+        }
+
+        frames.pop_back();
+        holders.popBack();
+      }
+
+
+      // The key under which the value being serialised is held, as a string, for toJSON
+      bool currentKey(JS::MutableHandleValue key) {
+        if (frames.empty()) {
+          key.set(JS_GetEmptyStringValue(cx));
+          return true;
+        }
+
+        const Frame& frame = frames.back();
+        if (frame.isArray) {
+          char digits[Conversions::NumberToStringBufferSize];
+          size_t length {Conversions::Uint32ToString(frame.nextIndex - 1, digits)};
+          JSString* str {JS_NewStringCopyN(cx, digits, length)};
+          if (!str) {
+            return false;
+          }
+
+          key.setString(str);
+          return true;
+        }
+
+        JS::RootedId id(cx, keys[frame.nextKey - 1]);
+        if (!JS_IdToValue(cx, id, key)) {
+          return false;
+        }
+
+        if (key.isString()) {
+          return true;
+        }
+
+        JSString* str {JS::ToString(cx, key)};
+        if (!str) {
+          return false;
+        }
+
+        key.setString(str);
+        return true;
+      }
+
+
+      /*
+       * Apply toJSON, and unwrap Number, String and Boolean objects, leaving the value to be written. serializable is
+       * set false if the value has no JSON representation: undefined, functions and symbols.
+       *
+       */
+
+      bool prepare(JS::MutableHandleValue value, bool& serializable) {
+        if (value.isObject()) {
+          JS::RootedObject obj(cx, &value.toObject());
+          JS::RootedValue toJSON(cx);
+          if (!JS_GetProperty(cx, obj, "toJSON", &toJSON)) {
+            return false;
+          }
+
+          if (toJSON.isObject() && JS_ObjectIsCallable(cx, &toJSON.toObject())) {
+            JS::RootedValue key(cx);
+            if (!currentKey(&key) || !JS_CallFunctionValue(cx, obj, toJSON, JS::HandleValueArray(key), value)) {
+              return false;
+            }
+          }
+        }
+
+        if (value.isObject() && !unwrap(value)) {
+          return false;
+        }
+
+        if (value.isObject()) {
+          serializable = !JS_ObjectIsCallable(cx, &value.toObject());
+        } else {
+          serializable = value.isNull() || value.isBoolean() || value.isNumber() || value.isString();
+        }
+
+        return true;
+      }
+
+
+      bool unwrap(JS::MutableHandleValue value) {
+        // The fast path: plain data needs no further checks
+        const char* className {JS_GetClass(&value.toObject())->name};
+        if (!std::strcmp(className, "Object") || !std::strcmp(className, "Array")) {
+          return true;
+        }
+
+        if (!std::strcmp(className, "Number")) {
+          double d;
+          if (!JS::ToNumber(cx, value, &d)) {
+            return false;
+          }
+
+          value.setNumber(d);
+        } else if (!std::strcmp(className, "String")) {
+          JSString* str {JS::ToString(cx, value)};
+          if (!str) {
+            return false;
+          }
+
+          value.setString(str);
+        } else if (!std::strcmp(className, "Boolean")) {
+          // The primitive value is the Boolean object's only reserved slot
+          value.set(JS_GetReservedSlot(&value.toObject(), 0));
+        }
+
+        return true;
+      }
+
+
+      // Write a prepared value. Arrays and objects are opened, and pushed for advance to fill.
+      bool emit(JS::HandleValue value) {
+        if (value.isNull()) {
+          write("null", 4);
+          return true;
+        }
+
+        if (value.isBoolean()) {
+          if (value.toBoolean()) {
+            write("true", 4);
+          } else {
+            write("false", 5);
+          }
+
+          return true;
+        }
+
+        if (value.isInt32()) {
+          char* dest {reserve(Conversions::NumberToStringBufferSize)};
+          used += Conversions::Int32ToString(value.toInt32(), dest);
+          return true;
+        }
+
+        if (value.isNumber()) {
+          double d {value.toNumber()};
+          if (!std::isfinite(d)) {
+            write("null", 4);
+            return true;
+          }
+
+          char* dest {reserve(Conversions::NumberToStringBufferSize)};
+          used += Conversions::DoubleToString(d, dest);
+          return true;
+        }
+
+        if (value.isString()) {
+          return writeString(value.toString());
+        }
+
+        JS::RootedObject obj(cx, &value.toObject());
+        for (size_t i = 0; i < holders.length(); i++) {
+          if (holders[i] == obj) {
+            JS_ReportErrorNumber(cx, cyclicValueError, nullptr, 0);
+            return false;
+          }
+        }
+
+        Frame frame {false, 0, 0, keys.length(), keys.length(), false};
+
+        if (JS_IsArrayObject(cx, obj)) {
+          frame.isArray = true;
+          if (!JS_GetArrayLength(cx, obj, &frame.length)) {
+            return false;
+          }
+        } else {
+          JS::AutoIdArray ids(cx, JS_Enumerate(cx, obj));
+          if (!ids) {
+            return false;
+          }
+
+          for (size_t i = 0; i < ids.length(); i++) {
+            if (!keys.append(ids[i])) {
+              return false;
+            }
+          }
+        }
+
+        if (!holders.append(obj)) {
+          return false;
+        }
+
+        frames.push_back(frame);
+        put(frame.isArray ? '[' : '{');
+        return true;
+      }
+
+
+      bool writeKey(JS::HandleId id) {
+        if (JSID_IS_INT(id)) {
+          put('"');
+          char* dest {reserve(Conversions::NumberToStringBufferSize)};
+          used += Conversions::Int32ToString(JSID_TO_INT(id), dest);
+          put('"');
+          return true;
+        }
+
+        return writeString(JSID_TO_STRING(id));
+      }
+
+
+      bool writeString(JSString* str) {
+        JS::RootedString rooted(cx, str);
+        JSFlatString* flat {JS_FlattenString(cx, rooted)};
+        if (!flat) {
+          return false;
+        }
+
+        size_t length {JS_GetStringLength(rooted)};
+        JS::AutoCheckCannotGC nogc;
+
+        if (JS_StringHasLatin1Chars(rooted)) {
+          writeChars(JS_GetLatin1FlatStringChars(nogc, flat), length);
+        } else {
+          writeChars(JS_GetTwoByteFlatStringChars(nogc, flat), length);
+        }
+
+        return true;
+      }
+
+
+      template <typename T>
+      void writeChars(const T* chars, size_t length) {
+        put('"');
+
+        size_t i {0};
+        while (i < length) {
+          size_t run {i};
+          while (run < length && isPlainASCII(chars[run])) {
+            run++;
+          }
+
+          writeASCII(chars + i, run - i);
+          if (run == length) {
+            break;
+          }
+
+          i = run + writeSpecial(chars + run, length - run);
+        }
+
+        put('"');
+      }
+
+
+      void writeASCII(const JS::Latin1Char* chars, size_t length) {
+        write(reinterpret_cast<const char*>(chars), length);
+      }
+
+
+      void writeASCII(const char16_t* chars, size_t length) {
+        while (length) {
+          if (used == buffer.size()) {
+            flush();
+          }
+
+          size_t count {std::min(length, buffer.size() - used)};
+          UTF8::NarrowASCII(chars, count, reinterpret_cast<unsigned char*>(buffer.data() + used));
+          used += count;
+          chars += count;
+          length -= count;
+        }
+      }
+
+
+      // Write a code unit that needs escaping or encoding, returning the number of code units consumed
+      size_t writeSpecial(const JS::Latin1Char* chars, size_t) {
+        unsigned int c {chars[0]};
+        if (c < 0x80u) {
+          writeEscape(c);
+          return 1;
+        }
+
+        char* dest {reserve(2)};
+        dest[0] = static_cast<char>(0xc0u | (c >> 6));
+        dest[1] = static_cast<char>(0x80u | (c & 0x3fu));
+        used += 2;
+        return 1;
+      }
+
+
+      size_t writeSpecial(const char16_t* chars, size_t length) {
+        unsigned int c {chars[0]};
+        if (c < 0x80u) {
+          writeEscape(c);
+          return 1;
+        }
+
+        if (c < 0x800u) {
+          char* dest {reserve(2)};
+          dest[0] = static_cast<char>(0xc0u | (c >> 6));
+          dest[1] = static_cast<char>(0x80u | (c & 0x3fu));
+          used += 2;
+          return 1;
+        }
+
+        if (isHighSurrogate(c) && length > 1 && isLowSurrogate(chars[1])) {
+          unsigned int codePoint {0x10000u + ((c - 0xd800u) << 10) + (chars[1] - 0xdc00u)};
+          char* dest {reserve(4)};
+          dest[0] = static_cast<char>(0xf0u | (codePoint >> 18));
+          dest[1] = static_cast<char>(0x80u | ((codePoint >> 12) & 0x3fu));
+          dest[2] = static_cast<char>(0x80u | ((codePoint >> 6) & 0x3fu));
+          dest[3] = static_cast<char>(0x80u | (codePoint & 0x3fu));
+          used += 4;
+          return 2;
+        }
+
+        if (isHighSurrogate(c) || isLowSurrogate(c)) {
+          writeUnicodeEscape(c);
+          return 1;
+        }
+
+        char* dest {reserve(3)};
+        dest[0] = static_cast<char>(0xe0u | (c >> 12));
+        dest[1] = static_cast<char>(0x80u | ((c >> 6) & 0x3fu));
+        dest[2] = static_cast<char>(0x80u | (c & 0x3fu));
+        used += 3;
+        return 1;
+      }
+
+
+      void writeEscape(unsigned int c) {
+        char shortForm {0};
+        switch (c) {
+          case '"': shortForm = '"'; break;
+          case '\\': shortForm = '\\'; break;
+          case '\b': shortForm = 'b'; break;
+          case '\f': shortForm = 'f'; break;
+          case '\n': shortForm = 'n'; break;
+          case '\r': shortForm = 'r'; break;
+          case '\t': shortForm = 't'; break;
+          default: break;
+        }
+
+        if (!shortForm) {
+          writeUnicodeEscape(c);
+          return;
+        }
+
+        char* dest {reserve(2)};
+        dest[0] = '\\';
+        dest[1] = shortForm;
+        used += 2;
+      }
+
+
+      void writeUnicodeEscape(unsigned int c) {
+        static const char hexDigits[] {"0123456789abcdef"};
+
+        char* dest {reserve(6)};
+        dest[0] = '\\';
+        dest[1] = 'u';
+        dest[2] = hexDigits[(c >> 12) & 0xfu];
+        dest[3] = hexDigits[(c >> 8) & 0xfu];
+        dest[4] = hexDigits[(c >> 4) & 0xfu];
+        dest[5] = hexDigits[c & 0xfu];
+        used += 6;
+      }
+
+
+      void put(char c) {
+        if (used == buffer.size()) {
+          flush();
+        }
+
+        buffer[used++] = c;
+      }
+
+
+      void write(const char* data, size_t length) {
+        while (length) {
+          if (used == buffer.size()) {
+            flush();
+          }
+
+          size_t count {std::min(length, buffer.size() - used)};
+          std::memcpy(buffer.data() + used, data, count);
+          used += count;
+          data += count;
+          length -= count;
+        }
+      }
+
+
+      // Return space for count contiguous bytes, which the caller then accounts for in used
+      char* reserve(size_t count) {
+        if (buffer.size() - used < count) {
+          flush();
+        }
+
+        return buffer.data() + used;
+      }
+
+
+      // Once the stream has aborted, output is discarded until the walk notices
+      void flush() {
+        if (used && !aborted && stream.WriteChunk(buffer.data(), used) == JSONOutputStream::kAbort) {
+          aborted = true;
+        }
+
+        used = 0;
+      }
+  };
+}
+
+
+namespace v8 {
+  namespace internal {
+    JSONStringifier::Outcome JSONStringifier::Stringify(JSContext* cx, JS::HandleValue value,
+                                                        JSONOutputStream& stream) {
+      return Stringifier(cx, stream).Run(value);
+    }
+  }
+}
@@ -0,0 +1,81 @@
+#ifndef V8MONKEY_JSONSTRINGIFIER_H
+#define V8MONKEY_JSONSTRINGIFIER_H
+
+// size_t
+#include <cstddef>
+
+// JSContext JS::HandleValue
+#include "jsapi.h"
+
+// EXPORT_FOR_TESTING_ONLY
+#include "utils/test.h"
+
+
+namespace v8 {
+  namespace internal {
+    /*
+     * Receives serialised JSON, as UTF-8, in chunks. Modelled on V8's OutputStream.
+     *
+     * The stream must not call back into SpiderMonkey: chunks may be handed over while string characters are being
+     * read in place.
+     *
+     */
+
+    class EXPORT_FOR_TESTING_ONLY JSONOutputStream {
+      public:
+        enum WriteResult {
+          kContinue,
+          kAbort
+        };
+
+        virtual ~JSONOutputStream() {}
+
+        // Called once all output has been written, and only if serialisation succeeded
+        virtual void EndOfStream() = 0;
+
+        // Chunks are at most this many bytes. Sizes below 32 are rounded up.
+        virtual size_t GetChunkSize() { return 1024; }
+
+        // Return kAbort to abandon serialisation
+        virtual WriteResult WriteChunk(const char* data, size_t size) = 0;
+    };
+
+
+    /*
+     * Serialises a value as JSON.stringify(value) would, with no replacer or indentation, streaming the UTF-8 output to
+     * a JSONOutputStream. Unlike stringifying in script and then calling WriteUtf8, the output is never held as a
+     * SpiderMonkey string.
+     *
+     * The walk uses an explicit stack, so the depth of the value is bounded only by memory. Objects currently being
+     * serialised are kept rooted on that stack, which also serves for cycle detection; a cycle raises the same
+     * TypeError JSON.stringify does. Plain objects and arrays go straight to enumeration. Only other classes need
+     * checking for wrapped primitives. Runs of ASCII within strings are copied in bulk.
+     *
+     * Lone surrogates are written as \u escapes, as in ES2019's well-formed JSON.stringify, so that the output is
+     * always valid UTF-8.
+     *
+     */
+
+    class EXPORT_FOR_TESTING_ONLY JSONStringifier {
+      public:
+        enum Outcome {
+          // The output was written, and EndOfStream called
+          kSerialized,
+
+          // The value has no JSON representation (JSON.stringify would return undefined). Nothing was written.
+          kUndefined,
+
+          // The stream abandoned serialisation
+          kAborted,
+
+          // An exception is pending: a cycle was found, toJSON or a getter threw, or SpiderMonkey ran out of memory
+          kFailed
+        };
+
+        static Outcome Stringify(JSContext* cx, JS::HandleValue value, JSONOutputStream& stream);
+    };
+  }
+}
+
+
+#endif
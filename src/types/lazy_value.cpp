@@ -0,0 +1,65 @@
+// signbit
+#include <cmath>
+
+// Class definition
+#include "types/lazy_value.h"
+
+// DoubleToInt32 DoubleToUint32
+#include "utils/Conversions.h"
+
+
+namespace v8 {
+  namespace internal {
+    bool LazyValue::ToJSValue(JSContext* cx, JS::MutableHandleValue result) {
+      if (!materialized) {
+        if (!Materialize(cx, result)) {
+          return false;
+        }
+
+        jsval = result;
+        materialized = true;
+        return true;
+      }
+
+      result.set(jsval);
+      return true;
+    }
+
+
+    // NaN fails the range checks, and -0 is excluded explicitly
+    NativeNumber::NativeNumber(double val) : value {val},
+      isInt32 {val >= -2147483648.0 && val <= 2147483647.0 && static_cast<double>(static_cast<int32_t>(val)) == val &&
+               !(val == 0 && std::signbit(val))},
+      isUint32 {val >= 0.0 && val <= 4294967295.0 && static_cast<double>(static_cast<uint32_t>(val)) == val &&
+                !(val == 0 && std::signbit(val))} {}
+
+
+    NativeNumber::NativeNumber(int32_t val) : value {static_cast<double>(val)}, isInt32 {true}, isUint32 {val >= 0} {}
+
+
+    NativeNumber::NativeNumber(uint32_t val) : value {static_cast<double>(val)}, isInt32 {val <= 2147483647u},
+                                               isUint32 {true} {}
+
+
+    int32_t NativeNumber::Int32Value() const {
+      return isInt32 ? static_cast<int32_t>(value) : V8Monkey::Conversions::DoubleToInt32(value);
+    }
+
+
+    uint32_t NativeNumber::Uint32Value() const {
+      return isUint32 ? static_cast<uint32_t>(value) : V8Monkey::Conversions::DoubleToUint32(value);
+    }
+
+
+    bool NativeNumber::Materialize(JSContext*, JS::MutableHandleValue result) {
+      // Numbers are never GC things, so creating the value cannot fail, and it will never need tracing
+      if (isInt32) {
+        result.setInt32(static_cast<int32_t>(value));
+      } else {
+        result.setNumber(value);
+      }
+
+      return true;
+    }
+  }
+}
@@ -0,0 +1,473 @@
+// copy
+#include <algorithm>
+
+// duration steady_clock
+#include <chrono>
+
+// memcpy, strlen
+#include <cstring>
+
+// numeric_limits
+#include <limits>
+
+// V8::GetVersion
+#include "v8.h"
+
+// Flags
+#include "runtime/flags.h"
+
+// Isolate
+#include "runtime/isolate.h"
+
+// Class definition
+#include "types/script_wrapper.h"
+
+// V8MONKEY_ASSERT
+#include "utils/V8MonkeyCommon.h"
+
+
+namespace {
+  using namespace v8::internal;
+
+
+  constexpr uint64_t hashMultiplier {0x9e3779b97f4a7c15ull};
+
+
+  /*
+   * Scripts run to many kilobytes, and a collision would mean running the wrong code, so unlike the string table's
+   * hash, each word is fully mixed before it is combined.
+   *
+   */
+
+  uint64_t mix(uint64_t word) {
+    word ^= word >> 33;
+    word *= 0xff51afd7ed558ccdull;
+    word ^= word >> 33;
+    word *= 0xc4ceb9fe1a85ec53ull;
+    return word ^ (word >> 33);
+  }
+
+
+  uint64_t hashBytes(const char* data, size_t length) {
+    uint64_t hash {length * hashMultiplier};
+
+    size_t i {0};
+    for (; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t)) {
+      uint64_t word;
+      std::memcpy(&word, data + i, sizeof(uint64_t));
+      hash = (hash ^ mix(word)) * hashMultiplier;
+    }
+
+    uint64_t tail {0};
+    std::memcpy(&tail, data + i, length - i);
+    return mix(hash ^ mix(tail));
+  }
+
+
+  // Identifies the engine build: XDR data is only meaningful to the SpiderMonkey version, and word size, producing it
+  uint64_t buildHash() {
+    static const uint64_t hash {[]() {
+      const char* version {v8::V8::GetVersion()};
+      return hashBytes(version, std::strlen(version)) ^ sizeof(void*);
+    }()};
+
+    return hash;
+  }
+
+
+  struct CacheHeader {
+    uint32_t magic;
+    uint32_t payloadLength;
+    uint64_t buildHash;
+    uint64_t sourceHash;
+    uint64_t sourceLength;
+    uint32_t sourceEncoding;
+    uint32_t reserved;
+  };
+
+  static_assert(sizeof(CacheHeader) == 40, "CacheHeader has unexpected padding");
+
+  // 'V8MC'
+  constexpr uint32_t cacheMagic {0x56384d43u};
+
+
+  // Returns nullptr if the data is not for this build and source, or SpiderMonkey could not decode it
+  JSScript* decodeCache(JSContext* cx, const ScriptSource& source, const CachedData& cache) {
+    if (!cache.data || cache.length < static_cast<int>(sizeof(CacheHeader))) {
+      return nullptr;
+    }
+
+    CacheHeader header;
+    std::memcpy(&header, cache.data, sizeof(CacheHeader));
+    if (header.magic != cacheMagic || header.buildHash != buildHash() || header.sourceLength != source.Length() ||
+        header.sourceEncoding != static_cast<uint32_t>(source.GetEncoding()) || header.sourceHash != source.Hash() ||
+        header.payloadLength != static_cast<size_t>(cache.length) - sizeof(CacheHeader)) {
+      return nullptr;
+    }
+
+    JSScript* script {JS_DecodeScript(cx, cache.data + sizeof(CacheHeader), header.payloadLength, nullptr)};
+    if (!script) {
+      JS_ClearPendingException(cx);
+    }
+
+    return script;
+  }
+
+
+  // Returns nullptr if the script could not be encoded
+  CachedData* encodeCache(JSContext* cx, const ScriptSource& source, JS::HandleScript script) {
+    uint32_t payloadLength {0};
+    void* payload {JS_EncodeScript(cx, script, &payloadLength)};
+    if (!payload) {
+      JS_ClearPendingException(cx);
+      return nullptr;
+    }
+
+    size_t length {sizeof(CacheHeader) + payloadLength};
+    if (length > static_cast<size_t>(std::numeric_limits<int>::max())) {
+      JS_free(cx, payload);
+      return nullptr;
+    }
+
+    CacheHeader header {cacheMagic, payloadLength, buildHash(), source.Hash(), source.Length(),
+                        static_cast<uint32_t>(source.GetEncoding()), 0};
+    uint8_t* buffer {new uint8_t[length]};
+    std::memcpy(buffer, &header, sizeof(CacheHeader));
+    std::memcpy(buffer + sizeof(CacheHeader), payload, payloadLength);
+    JS_free(cx, payload);
+
+    return new CachedData(buffer, static_cast<int>(length), CachedData::BufferOwned);
+  }
+
+
+  // The XDR encoding within cached data that this build produced, or has accepted
+  std::vector<uint8_t> cachePayload(const CachedData& cache) {
+    return std::vector<uint8_t>(cache.data + sizeof(CacheHeader), cache.data + cache.length);
+  }
+
+
+  bool producesCache(ScriptWrapper::CompileOptions options) {
+    return options == ScriptWrapper::kProduceCodeCache || options == ScriptWrapper::kProduceParserCache ||
+           options == ScriptWrapper::kProduceDataToCache;
+  }
+
+
+  bool consumesCache(ScriptWrapper::CompileOptions options) {
+    return options == ScriptWrapper::kConsumeCodeCache || options == ScriptWrapper::kConsumeParserCache;
+  }
+
+
+  void addToCounter(Isolate* isolate, Isolate::Counter counter, size_t amount) {
+    int* value {isolate->GetCounter(counter)};
+    if (value) {
+      *value += static_cast<int>(amount);
+    }
+  }
+
+
+  double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }
+
+
+  void setOrigin(JS::CompileOptions& options, const ScriptOrigin& origin) {
+    unsigned line {origin.lineOffset > 0 ? static_cast<unsigned>(origin.lineOffset) + 1 : 1};
+    options.setFileAndLine(origin.resourceName.empty() ? nullptr : origin.resourceName.c_str(), line);
+  }
+
+
+  /*
+   * Decode the text of a one-byte source to UTF-16, in a null-terminated buffer allocated with JS_malloc, setting
+   * length to its length in characters. Returns nullptr if SpiderMonkey reported an error, such as malformed UTF-8.
+   *
+   */
+
+  char16_t* decodeBytes(JSContext* cx, const ScriptSource& source, size_t& length) {
+    if (source.GetEncoding() == ScriptSource::kUTF8) {
+      return JS::UTF8CharsToNewTwoByteCharsZ(cx, JS::UTF8Chars(source.Bytes(), source.Length()), &length).get();
+    }
+
+    // Latin1 code units are the code points themselves
+    length = source.Length();
+    char16_t* chars {static_cast<char16_t*>(JS_malloc(cx, (length + 1) * sizeof(char16_t)))};
+    if (!chars) {
+      return nullptr;
+    }
+
+    const unsigned char* bytes {reinterpret_cast<const unsigned char*>(source.Bytes())};
+    std::copy(bytes, bytes + length, chars);
+    chars[length] = 0;
+    return chars;
+  }
+
+
+  JSScript* compileSource(JSContext* cx, const ScriptSource& source, bool compileAndGo) {
+    JS::CompileOptions options(cx);
+    setOrigin(options, source.Origin());
+    options.setCompileAndGo(compileAndGo);
+    Flags::Apply(options, source.Length());
+
+    JS::RootedObject global(cx, JS::CurrentGlobalOrNull(cx));
+    if (source.GetEncoding() == ScriptSource::kTwoByte) {
+      JS::SourceBufferHolder buffer(source.Chars(), source.Length(), JS::SourceBufferHolder::NoOwnership);
+      return JS::Compile(cx, global, options, buffer);
+    }
+
+    // Giving SpiderMonkey the decoded text saves it copying the text to keep as the script's source
+    size_t length {0};
+    char16_t* chars {decodeBytes(cx, source, length)};
+    if (!chars) {
+      return nullptr;
+    }
+
+    JS::SourceBufferHolder buffer(chars, length, JS::SourceBufferHolder::GiveOwnership);
+    return JS::Compile(cx, global, options, buffer);
+  }
+}
+
+
+namespace v8 {
+  namespace internal {
+    ScriptSource::~ScriptSource() {
+      if (resource) {
+        resource->Dispose();
+      }
+    }
+
+
+    uint64_t ScriptSource::Hash() const {
+      if (!hashed) {
+        uint64_t text {chars ? hashBytes(reinterpret_cast<const char*>(chars), length * sizeof(char16_t)) :
+                               hashBytes(bytes, length)};
+
+        // The same bytes read as Latin1 and as UTF-8 are different scripts
+        hash = mix(text ^ static_cast<uint64_t>(encoding));
+        hashed = true;
+      }
+
+      return hash;
+    }
+
+
+    uint64_t ScriptSource::CacheKey() const {
+      const uint64_t parts[] {Hash(), hashBytes(origin.resourceName.data(), origin.resourceName.size()),
+                              static_cast<uint64_t>(static_cast<int64_t>(origin.lineOffset)), buildHash()};
+      return hashBytes(reinterpret_cast<const char*>(parts), sizeof(parts));
+    }
+
+
+    void CompileStatistics::Record() const {
+      Isolate* isolate {Isolate::GetCurrent()};
+      if (!isolate) {
+        return;
+      }
+
+      Isolate::Counter produced {cached ? Isolate::Counter::ScriptsCached :
+                                 decoded ? Isolate::Counter::ScriptsDecoded : Isolate::Counter::ScriptsCompiled};
+      addToCounter(isolate, produced, 1);
+      addToCounter(isolate, Isolate::Counter::ScriptsParsedLazily, lazy ? 1 : 0);
+      addToCounter(isolate, Isolate::Counter::ScriptsCompiledOffThread, offThread ? 1 : 0);
+      addToCounter(isolate, Isolate::Counter::ScriptCompileMicroseconds, static_cast<size_t>(milliseconds * 1000));
+      addToCounter(isolate, Isolate::Counter::ScriptSourceLength, sourceLength);
+      addToCounter(isolate, Isolate::Counter::ScriptBytecodeSize, bytecodeSize);
+    }
+
+
+    ScriptWrapper* ScriptWrapper::Compile(JSContext* cx, ScriptSource& source, CompileOptions options) {
+      CompileStatistics stats;
+      JSScript* script {CompileScript(cx, source, options, true, stats)};
+      if (!script) {
+        return nullptr;
+      }
+
+      stats.Record();
+      return new ScriptWrapper(script, stats);
+    }
+
+
+    JSScript* ScriptWrapper::CompileScript(JSContext* cx, ScriptSource& source, CompileOptions options,
+                                           bool compileAndGo, CompileStatistics& stats) {
+      bool produce {producesCache(options)};
+      bool consume {consumesCache(options)};
+
+      stats = CompileStatistics {};
+      stats.sourceLength = source.Length();
+      std::chrono::steady_clock::time_point start {std::chrono::steady_clock::now()};
+
+      JS::RootedScript script(cx);
+      if (consume && source.cachedData) {
+        script = decodeCache(cx, source, *source.cachedData);
+        source.cachedData->rejected = !script;
+
+        if (script) {
+          stats.decoded = true;
+          stats.bytecodeSize = static_cast<size_t>(source.cachedData->length) - sizeof(CacheHeader);
+        }
+      }
+
+      if (!script) {
+        // SpiderMonkey cannot encode compile-and-go scripts, and decoded scripts never are, so only plain compiles
+        // get the benefit
+        bool plainCompile {compileAndGo && !produce && !consume};
+        script = compileSource(cx, source, plainCompile);
+        if (!script) {
+          return nullptr;
+        }
+
+        // SpiderMonkey only parses compile-and-go scripts lazily
+        stats.lazy = plainCompile && Flags::ParseLazily(source.Length());
+      }
+
+      stats.milliseconds = millisecondsSince(start);
+
+      if (produce) {
+        source.cachedData.reset(encodeCache(cx, source, script));
+        if (source.cachedData) {
+          stats.bytecodeSize = static_cast<size_t>(source.cachedData->length) - sizeof(CacheHeader);
+        }
+      }
+
+      return script;
+    }
+
+
+    bool ScriptWrapper::Run(JSContext* cx, JS::MutableHandleValue result) {
+      JS::RootedObject global(cx, JS::CurrentGlobalOrNull(cx));
+      JS::RootedScript s(cx, script);
+      return JS_ExecuteScript(cx, global, s, result);
+    }
+
+
+    bool ScriptWrapper::CreateCodeCache(JSContext* cx, ScriptSource& source) {
+      JS::RootedScript s(cx, script);
+      source.cachedData.reset(encodeCache(cx, source, s));
+      return source.cachedData != nullptr;
+    }
+
+
+    UnboundScriptWrapper* UnboundScriptWrapper::Compile(JSContext* cx, ScriptSource& source,
+                                                        ScriptWrapper::CompileOptions options) {
+      CompileStatistics stats;
+      JS::RootedScript script(cx, ScriptWrapper::CompileScript(cx, source, options, false, stats));
+      if (!script) {
+        return nullptr;
+      }
+
+      // Freshly produced or accepted cached data already holds the encoding
+      const CachedData* cache {source.GetCachedData()};
+      if (cache && (producesCache(options) || (consumesCache(options) && !cache->rejected))) {
+        stats.Record();
+        return new UnboundScriptWrapper(cachePayload(*cache), stats);
+      }
+
+      uint32_t length {0};
+      void* data {JS_EncodeScript(cx, script, &length)};
+      if (!data) {
+        return nullptr;
+      }
+
+      stats.bytecodeSize = length;
+      stats.Record();
+      const uint8_t* bytes {reinterpret_cast<const uint8_t*>(data)};
+      UnboundScriptWrapper* unbound {new UnboundScriptWrapper(std::vector<uint8_t>(bytes, bytes + length), stats)};
+      JS_free(cx, data);
+      return unbound;
+    }
+
+
+    ScriptWrapper* UnboundScriptWrapper::BindToCurrentContext(JSContext* cx) const {
+      std::chrono::steady_clock::time_point start {std::chrono::steady_clock::now()};
+      JSScript* script {JS_DecodeScript(cx, encoded.data(), static_cast<uint32_t>(encoded.size()), nullptr)};
+      if (!script) {
+        return nullptr;
+      }
+
+      CompileStatistics stats;
+      stats.milliseconds = millisecondsSince(start);
+      stats.sourceLength = statistics.sourceLength;
+      stats.bytecodeSize = encoded.size();
+      stats.decoded = true;
+      stats.Record();
+      return new ScriptWrapper(script, stats);
+    }
+
+
+    CompileTask* CompileTask::Start(JSContext* cx, ScriptSource& source) {
+      CompileTask* task {new CompileTask(cx, source)};
+
+      JS::CompileOptions options(cx);
+      setOrigin(options, source.Origin());
+      options.setCompileAndGo(true);
+      Flags::Apply(options, source.Length());
+
+      if (!JS::CanCompileOffThread(cx, options, source.Length())) {
+        return task;
+      }
+
+      const char16_t* chars {source.Chars()};
+      size_t length {source.Length()};
+      if (!chars) {
+        task->decoded = decodeBytes(cx, source, length);
+        if (!task->decoded) {
+          delete task;
+          return nullptr;
+        }
+
+        chars = task->decoded;
+      }
+
+      task->started = std::chrono::steady_clock::now();
+      if (!JS::CompileOffThread(cx, options, chars, length, Completed, task)) {
+        delete task;
+        return nullptr;
+      }
+
+      task->offThread = true;
+      task->statistics.sourceLength = source.Length();
+      task->statistics.lazy = Flags::ParseLazily(source.Length());
+      task->statistics.offThread = true;
+      return task;
+    }
+
+
+    CompileTask::~CompileTask() {
+      if (offThread && !finished) {
+        done.Wait();
+        JS::FinishOffThreadScript(nullptr, runtime, token);
+      }
+
+      js_free(decoded);
+    }
+
+
+    ScriptWrapper* CompileTask::Finish(JSContext* cx) {
+      V8MONKEY_ASSERT(!finished, "Compile task finished twice");
+      finished = true;
+
+      if (!offThread) {
+        JSAutoCompartment ac(cx, global);
+        return ScriptWrapper::Compile(cx, source);
+      }
+
+      done.Wait();
+      JSScript* script {JS::FinishOffThreadScript(cx, runtime, token)};
+      js_free(decoded);
+      decoded = nullptr;
+      if (!script) {
+        return nullptr;
+      }
+
+      statistics.milliseconds = std::chrono::duration<double, std::milli>(completed - started).count();
+      statistics.Record();
+      return new ScriptWrapper(script, statistics);
+    }
+
+
+    void CompileTask::Completed(void* token, void* data) {
+      CompileTask* task {reinterpret_cast<CompileTask*>(data)};
+      task->token = token;
+      task->completed = std::chrono::steady_clock::now();
+      task->done.Signal();
+    }
+  }
+}
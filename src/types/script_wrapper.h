@@ -0,0 +1,397 @@
+#ifndef V8MONKEY_SCRIPTWRAPPER_H
+#define V8MONKEY_SCRIPTWRAPPER_H
+
+// steady_clock
+#include <chrono>
+
+// size_t
+#include <cstddef>
+
+// uint8_t, uint64_t
+#include <cstdint>
+
+// unique_ptr
+#include <memory>
+
+// string
+#include <string>
+
+// move
+#include <utility>
+
+// vector
+#include <vector>
+
+// JS_CallScriptTracer JS::Heap JS::MutableHandleValue JS::PersistentRootedObject JSContext JSRuntime JSScript JSTracer
+#include "jsapi.h"
+
+// Event
+#include "platform/platform.h"
+
+// ExternalAsciiStringResource
+#include "types/string_wrapper.h"
+
+// EXPORT_FOR_TESTING_ONLY
+#include "utils/test.h"
+
+
+namespace v8 {
+  namespace internal {
+
+    /*
+     * Mirrors ScriptCompiler::CachedData, plus the rejected flag from later versions of the API, which is set when
+     * consumed data could not be used.
+     *
+     * The data is opaque to embedders: a header identifying the engine build and the source text (and its encoding) it
+     * was produced from, followed by SpiderMonkey's XDR encoding of the compiled script. Data produced by a different
+     * build, or for different source, is rejected before SpiderMonkey ever sees it.
+     *
+     */
+
+    struct EXPORT_FOR_TESTING_ONLY CachedData {
+      enum BufferPolicy {
+        BufferNotOwned,
+        BufferOwned
+      };
+
+      CachedData() = default;
+
+      // Owned buffers are deleted with delete[]
+      CachedData(const uint8_t* d, int l, BufferPolicy policy = BufferNotOwned) : data {d}, length {l},
+                                                                                 buffer_policy {policy} {}
+
+      ~CachedData() {
+        if (buffer_policy == BufferOwned) {
+          delete[] data;
+        }
+      }
+
+      const uint8_t* data {nullptr};
+      int length {0};
+      bool rejected {false};
+      BufferPolicy buffer_policy {BufferNotOwned};
+
+      CachedData(const CachedData& other) = delete;
+      CachedData(CachedData&& other) = delete;
+      CachedData& operator=(const CachedData& other) = delete;
+      CachedData& operator=(CachedData&& other) = delete;
+    };
+
+
+    // The parts of ScriptOrigin that SpiderMonkey has a use for. V8's line offsets are zero-based.
+    struct EXPORT_FOR_TESTING_ONLY ScriptOrigin {
+      ScriptOrigin() = default;
+      ScriptOrigin(const std::string& name, int offset) : resourceName {name}, lineOffset {offset} {}
+
+      std::string resourceName {};
+      int lineOffset {0};
+    };
+
+
+    /*
+     * Mirrors ScriptCompiler::Source. The characters are not copied, so must outlive any compilation from this source.
+     * The source takes ownership of any cached data it is given.
+     *
+     */
+
+    class EXPORT_FOR_TESTING_ONLY ScriptSource {
+      public:
+        // Mirrors ScriptCompiler::StreamedSource::Encoding, from later versions of the API
+        enum Encoding {
+          kTwoByte,
+          kLatin1,
+          kUTF8
+        };
+
+        ScriptSource(const char16_t* c, size_t l, ScriptOrigin o = ScriptOrigin {}, CachedData* cached = nullptr) :
+          chars {c}, length {l}, origin {o}, cachedData {cached} {}
+
+        /*
+         * A source whose text is the data of a one-byte resource, such as a MappedStringResource, read as Latin1 or
+         * UTF-8. The source takes ownership of the resource, disposing it when destroyed.
+         *
+         * SpiderMonkey only parses UTF-16, so each compile decodes the text straight in to the buffer SpiderMonkey
+         * keeps as the script's source: the resource's data is never copied as it is.
+         *
+         */
+
+        ScriptSource(ExternalAsciiStringResource* r, Encoding e, ScriptOrigin o = ScriptOrigin {},
+                     CachedData* cached = nullptr) :
+          bytes {r->data()}, length {r->length()}, encoding {e}, resource {r}, origin {o}, cachedData {cached} {}
+
+        ~ScriptSource();
+
+        Encoding GetEncoding() const { return encoding; }
+
+        // The text of two-byte sources, and of one-byte sources respectively; nullptr for the other kind
+        const char16_t* Chars() const { return chars; }
+        const char* Bytes() const { return bytes; }
+
+        // In code units of the source's encoding
+        size_t Length() const { return length; }
+
+        const ScriptOrigin& Origin() const { return origin; }
+
+        /*
+         * After compiling with one of the produce options, the newly produced data (or nullptr, if the script could
+         * not be encoded). After compiling with one of the consume options, the data that was supplied, with rejected
+         * set if it could not be used.
+         *
+         */
+
+        const CachedData* GetCachedData() const { return cachedData.get(); }
+
+        // Replace any cached data, taking ownership of the new data
+        void SetCachedData(CachedData* cached) { cachedData.reset(cached); }
+
+        // A hash of the source text as encoded, and its encoding (but not the origin), computed on first use
+        uint64_t Hash() const;
+
+        // Identifies the compiled form of this source: a hash of the text, the origin and the engine build
+        uint64_t CacheKey() const;
+
+        ScriptSource(const ScriptSource& other) = delete;
+        ScriptSource(ScriptSource&& other) = delete;
+        ScriptSource& operator=(const ScriptSource& other) = delete;
+        ScriptSource& operator=(ScriptSource&& other) = delete;
+
+      private:
+        const char16_t* chars {nullptr};
+        const char* bytes {nullptr};
+        size_t length;
+        Encoding encoding {kTwoByte};
+        ExternalAsciiStringResource* resource {nullptr};
+        ScriptOrigin origin;
+        std::unique_ptr<CachedData> cachedData;
+        mutable uint64_t hash {0};
+        mutable bool hashed {false};
+
+        friend class ScriptWrapper;
+    };
+
+
+    /*
+     * What producing a script cost. SpiderMonkey parses and emits bytecode in a single pass, so the time covers both.
+     * Embedders see the totals for each isolate through the counter function: see Isolate::Counter.
+     *
+     */
+
+    struct EXPORT_FOR_TESTING_ONLY CompileStatistics {
+      // Wall-clock time to compile, or decode, the script. Off-thread compiles are timed from start to completion.
+      double milliseconds {0.0};
+
+      size_t sourceLength {0};
+
+      /*
+       * The size of the script's XDR encoding: its bytecode, and that of any functions compiled eagerly. Only known
+       * when the script is encoded or decoded anyway: when producing or consuming cached data, compiling unbound or
+       * binding. It is always zero for plain compiles (ScriptWrapper::Compile without cached data, and CompileTask):
+       * these are compile-and-go, which SpiderMonkey cannot encode, and it offers no other measure. Encoding a copy
+       * compiled without compile-and-go just to measure it would double the cost of every compile.
+       *
+       */
+
+      size_t bytecodeSize {0};
+
+      // Whether SpiderMonkey was allowed to parse inner functions lazily: see Flags::Lazy
+      bool lazy {false};
+
+      // Whether the script was decoded from XDR (cached data, or an unbound script) rather than compiled
+      bool decoded {false};
+
+      // Whether a CompilationCache handed out a script it had already produced for the same global
+      bool cached {false};
+
+      bool offThread {false};
+
+      // Add these statistics to the current isolate's counters, if the embedder asked for them: see Isolate::Counter
+      void Record() const;
+    };
+
+
+    /*
+     * V8Monkey's representation of a compiled script, bound to the global of the compartment it was compiled in.
+     *
+     * The wrapper does not root the script: whoever owns the wrapper must call Trace when tracing roots.
+     *
+     */
+
+    class EXPORT_FOR_TESTING_ONLY ScriptWrapper {
+      public:
+        // Mirrors ScriptCompiler::CompileOptions. SpiderMonkey has no separate parser cache, so the parser cache
+        // options produce and consume code caches.
+        enum CompileOptions {
+          kNoCompileOptions = 0,
+          kProduceParserCache,
+          kConsumeParserCache,
+          kProduceCodeCache,
+          kConsumeCodeCache,
+          kProduceDataToCache
+        };
+
+        explicit ScriptWrapper(JSScript* s) : script {s} {}
+        ScriptWrapper(JSScript* s, const CompileStatistics& stats) : script {s}, statistics {stats} {}
+        ~ScriptWrapper() = default;
+
+        /*
+         * As ScriptCompiler::Compile: compile the source against the global of the current compartment, producing or
+         * consuming cached data as requested. Rejected cached data is not an error: the source is compiled as normal.
+         * Returns nullptr if SpiderMonkey reported an error, which will be pending on the context.
+         *
+         */
+
+        static ScriptWrapper* Compile(JSContext* cx, ScriptSource& source, CompileOptions options = kNoCompileOptions);
+
+        // As Script::Run. Returns false if the script threw, in which case the exception is pending on the context.
+        bool Run(JSContext* cx, JS::MutableHandleValue result);
+
+        /*
+         * As ScriptCompiler::CreateCodeCache in later versions of the API: encode this script as cached data for the
+         * given source, replacing any the source holds, without compiling again. The script must have been compiled
+         * with one of the produce or consume options, as SpiderMonkey cannot encode compile-and-go scripts. Returns
+         * false if the script could not be encoded.
+         *
+         */
+
+        bool CreateCodeCache(JSContext* cx, ScriptSource& source);
+
+        JSScript* Script() const { return script; }
+
+        const CompileStatistics& Statistics() const { return statistics; }
+
+        void Trace(JSTracer* tracer) {
+          JS_CallScriptTracer(tracer, &script, "V8Monkey script");
+        }
+
+        ScriptWrapper(const ScriptWrapper& other) = delete;
+        ScriptWrapper(ScriptWrapper&& other) = delete;
+        ScriptWrapper& operator=(const ScriptWrapper& other) = delete;
+        ScriptWrapper& operator=(ScriptWrapper&& other) = delete;
+
+      private:
+        JS::Heap<JSScript*> script;
+        CompileStatistics statistics {};
+
+        // Compile, or decode, the script. Only compile-and-go if allowed, and cached data is not involved.
+        static JSScript* CompileScript(JSContext* cx, ScriptSource& source, CompileOptions options, bool compileAndGo,
+                                       CompileStatistics& stats);
+
+        friend class UnboundScriptWrapper;
+    };
+
+
+    /*
+     * Mirrors UnboundScript: a script that can be run in any number of contexts, but is compiled just once.
+     *
+     * The script is compiled without compile-and-go, and kept in SpiderMonkey's XDR encoding, which is not tied to any
+     * compartment. Binding decodes a copy in to the current compartment: considerably cheaper than compiling, as there
+     * is no parsing or bytecode emission. As nothing is held in the GC heap, the wrapper needs no tracing, and keeps
+     * no context alive.
+     *
+     */
+
+    class EXPORT_FOR_TESTING_ONLY UnboundScriptWrapper {
+      public:
+        ~UnboundScriptWrapper() = default;
+
+        /*
+         * As ScriptCompiler::CompileUnbound, producing or consuming cached data as requested. Returns nullptr if
+         * SpiderMonkey reported an error, which will be pending on the context.
+         *
+         */
+
+        static UnboundScriptWrapper* Compile(JSContext* cx, ScriptSource& source,
+                                             ScriptWrapper::CompileOptions options = ScriptWrapper::kNoCompileOptions);
+
+        /*
+         * As UnboundScript::BindToCurrentContext: returns a script bound to the global of the current compartment, or
+         * nullptr if SpiderMonkey reported an error, which will be pending on the context.
+         *
+         */
+
+        ScriptWrapper* BindToCurrentContext(JSContext* cx) const;
+
+        // The encoded script, for embedding in snapshots
+        const uint8_t* Data() const { return encoded.data(); }
+        size_t Length() const { return encoded.size(); }
+
+        // For the compile. Each bound script has its own statistics, for decoding.
+        const CompileStatistics& Statistics() const { return statistics; }
+
+        UnboundScriptWrapper(const UnboundScriptWrapper& other) = delete;
+        UnboundScriptWrapper(UnboundScriptWrapper&& other) = delete;
+        UnboundScriptWrapper& operator=(const UnboundScriptWrapper& other) = delete;
+        UnboundScriptWrapper& operator=(UnboundScriptWrapper&& other) = delete;
+
+      private:
+        UnboundScriptWrapper(std::vector<uint8_t>&& bytes, const CompileStatistics& stats) :
+          encoded {std::move(bytes)}, statistics {stats} {}
+
+        std::vector<uint8_t> encoded;
+        CompileStatistics statistics;
+    };
+
+
+    /*
+     * A compilation running on one of SpiderMonkey's helper threads, so that large scripts do not stall the thread
+     * that asked for them. The task is the completion token: poll IsReady, or call Finish to block until the script is
+     * available.
+     *
+     * SpiderMonkey declines to compile short scripts off-thread, as the hand-off would cost more than it saves. Such
+     * scripts are compiled when Finish is called, in the compartment that was current when the task was started: the
+     * task roots that global until it is destroyed.
+     *
+     * Start, Finish and the destructor must be called on the thread owning the context's runtime; IsReady may be
+     * called from any thread. The source must outlive the task. The text of one-byte sources is decoded for the helper
+     * thread, and the copy held until the task is finished.
+     *
+     */
+
+    class EXPORT_FOR_TESTING_ONLY CompileTask {
+      public:
+        // Returns nullptr if SpiderMonkey reported an error, which will be pending on the context
+        static CompileTask* Start(JSContext* cx, ScriptSource& source);
+
+        // An unfinished off-thread compilation is waited for, and the result discarded
+        ~CompileTask();
+
+        bool IsReady() { return !offThread || done.IsSignalled(); }
+
+        /*
+         * Returns the script, bound to the global of the compartment that was current when the task was started, or
+         * nullptr if SpiderMonkey reported an error, which will be pending on the context. May only be called once.
+         *
+         */
+
+        ScriptWrapper* Finish(JSContext* cx);
+
+        CompileTask(const CompileTask& other) = delete;
+        CompileTask(CompileTask&& other) = delete;
+        CompileTask& operator=(const CompileTask& other) = delete;
+        CompileTask& operator=(CompileTask&& other) = delete;
+
+      private:
+        CompileTask(JSContext* cx, ScriptSource& s) : source {s}, runtime {JS_GetRuntime(cx)},
+                                                      global(cx, JS::CurrentGlobalOrNull(cx)) {}
+
+        ScriptSource& source;
+        JSRuntime* runtime;
+        JS::PersistentRootedObject global;
+        char16_t* decoded {nullptr};
+        bool offThread {false};
+        bool finished {false};
+        CompileStatistics statistics {};
+        std::chrono::steady_clock::time_point started {};
+
+        // Written by the helper thread before signalling
+        void* token {nullptr};
+        std::chrono::steady_clock::time_point completed {};
+        V8Platform::Event done {};
+
+        static void Completed(void* token, void* data);
+    };
+  }
+}
+
+
+#endif
@@ -0,0 +1,154 @@
+// memcmp, memcpy
+#include <cstring>
+
+// move
+#include <utility>
+
+// Class definition
+#include "types/string_table.h"
+
+// EncodeToNarrowest
+#include "utils/Encoding.h"
+
+// AddRuntimeTearDownCallback RemoveRuntimeTearDownCallback
+#include "utils/SpiderMonkeyUtils.h"
+
+
+namespace {
+  constexpr size_t initialCapacity {256};
+
+  // Longer strings are rarely repeated property names, and would only bloat the table
+  constexpr size_t maxKeyLength {128};
+
+  constexpr uint64_t hashMultiplier {0x9e3779b97f4a7c15ull};
+
+
+  // A simple multiplicative hash, consuming a word at a time. Property names are short, so speed beats quality.
+  uint64_t hashBytes(const char* data, size_t length) {
+    uint64_t hash {length * hashMultiplier};
+
+    size_t i {0};
+    for (; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t)) {
+      uint64_t word;
+      std::memcpy(&word, data + i, sizeof(uint64_t));
+      hash = (hash ^ word) * hashMultiplier;
+      hash ^= hash >> 32;
+    }
+
+    uint64_t tail {0};
+    std::memcpy(&tail, data + i, length - i);
+    hash = (hash ^ tail) * hashMultiplier;
+    return hash ^ (hash >> 29);
+  }
+
+
+  JSString* internUncached(JSContext* cx, const char* data, size_t length) {
+    using namespace v8::V8Monkey;
+
+    UTF8::NarrowestEncoded encoded {UTF8::EncodeToNarrowest(data, data + length)};
+
+    if (encoded.isOneByte) {
+      return JS_InternStringN(cx, reinterpret_cast<const char*>(encoded.oneByte.data()), encoded.oneByte.size());
+    }
+
+    return JS_InternUCStringN(cx, encoded.twoByte.data(), encoded.twoByte.size());
+  }
+}
+
+
+namespace v8 {
+  namespace internal {
+    InternedStringTable::~InternedStringTable() {
+      Trim();
+    }
+
+
+    JSString* InternedStringTable::Intern(JSContext* cx, const char* data, size_t length) {
+      if (runtimeTornDown.load(std::memory_order_acquire)) {
+        Trim();
+      }
+
+      JSRuntime* rt {JS_GetRuntime(cx)};
+      if (length > maxKeyLength || (runtime && runtime != rt)) {
+        return internUncached(cx, data, length);
+      }
+
+      if (!runtime) {
+        runtime = rt;
+        SpiderMonkey::AddRuntimeTearDownCallback(rt, RuntimeTornDown, this);
+      }
+
+      if (entries.empty()) {
+        entries.resize(initialCapacity);
+      }
+
+      uint64_t hash {hashBytes(data, length)};
+      size_t mask {entries.size() - 1};
+      size_t index {static_cast<size_t>(hash) & mask};
+
+      while (entries[index].atom) {
+        const Entry& entry {entries[index]};
+        if (entry.hash == hash && entry.key.size() == length && std::memcmp(entry.key.data(), data, length) == 0) {
+          return entry.atom;
+        }
+
+        index = (index + 1) & mask;
+      }
+
+      JSString* atom {internUncached(cx, data, length)};
+      if (!atom) {
+        return nullptr;
+      }
+
+      entries[index] = Entry {hash, std::string(data, length), atom};
+      count++;
+
+      // Keep the load factor at most a half, so that probe sequences stay short
+      if (count * 2 > entries.size()) {
+        grow();
+      }
+
+      return atom;
+    }
+
+
+    void InternedStringTable::Trim() {
+      std::vector<Entry>().swap(entries);
+      count = 0;
+
+      // Once unregistered, the flag cannot be set again
+      if (runtime) {
+        SpiderMonkey::RemoveRuntimeTearDownCallback(runtime, RuntimeTornDown, this);
+        runtime = nullptr;
+      }
+
+      runtimeTornDown.store(false, std::memory_order_relaxed);
+    }
+
+
+    void InternedStringTable::RuntimeTornDown(JSRuntime*, void* data) {
+      InternedStringTable* table {reinterpret_cast<InternedStringTable*>(data)};
+      table->runtimeTornDown.store(true, std::memory_order_release);
+    }
+
+
+    void InternedStringTable::grow() {
+      std::vector<Entry> old(entries.size() * 2);
+      old.swap(entries);
+
+      size_t mask {entries.size() - 1};
+      for (auto& entry : old) {
+        if (!entry.atom) {
+          continue;
+        }
+
+        size_t index {static_cast<size_t>(entry.hash) & mask};
+        while (entries[index].atom) {
+          index = (index + 1) & mask;
+        }
+
+        entries[index] = std::move(entry);
+      }
+    }
+  }
+}
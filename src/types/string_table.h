@@ -0,0 +1,86 @@
+#ifndef V8MONKEY_STRINGTABLE_H
+#define V8MONKEY_STRINGTABLE_H
+
+// atomic
+#include <atomic>
+
+// size_t
+#include <cstddef>
+
+// uint64_t
+#include <cstdint>
+
+// string
+#include <string>
+
+// vector
+#include <vector>
+
+// JSContext JSRuntime JSString
+#include "jsapi.h"
+
+// EXPORT_FOR_TESTING_ONLY
+#include "utils/test.h"
+
+
+namespace v8 {
+  namespace internal {
+
+    /*
+     * Backs String::NewFromUtf8(..., kInternalizedString). Embedders tend to internalize the same few hundred property
+     * names over and over; SpiderMonkey would transcode the UTF-8 and take the runtime's atom table lock every time.
+     * Instead, each isolate keeps a table mapping the raw UTF-8 bytes to the atom previously created for them.
+     *
+     * The atoms come from JS_InternStringN, so are pinned for the lifetime of their runtime: the table needs no
+     * tracing. As atoms belong to a single runtime, and runtimes are per-thread, lookups from any runtime other than
+     * the one that filled the table bypass it. When that runtime is torn down, the table is emptied before it is next
+     * used: a later runtime may well be allocated at the same address.
+     *
+     * Isolates are only used by one thread at a time, so no locking is required. The one exception is the runtime's
+     * tear down, which can happen on its own thread at any time; it only sets a flag.
+     *
+     */
+
+    class EXPORT_FOR_TESTING_ONLY InternedStringTable {
+      public:
+        InternedStringTable() = default;
+        ~InternedStringTable();
+
+        // Returns the atom with the given UTF-8 contents, or nullptr if SpiderMonkey reported an error
+        JSString* Intern(JSContext* cx, const char* data, size_t length);
+
+        // Release the table's memory, for example in response to a low memory notification, or when the isolate is
+        // disposed. The atoms are unaffected.
+        void Trim();
+
+        size_t Size() const { return count; }
+
+        InternedStringTable(const InternedStringTable& other) = delete;
+        InternedStringTable(InternedStringTable&& other) = delete;
+        InternedStringTable& operator=(const InternedStringTable& other) = delete;
+        InternedStringTable& operator=(InternedStringTable&& other) = delete;
+
+      private:
+        // An open-addressed table with linear probing. Entries are never removed individually, so no tombstones.
+        struct Entry {
+          uint64_t hash;
+          std::string key;
+          JSString* atom;
+        };
+
+        std::vector<Entry> entries {};
+        size_t count {0};
+
+        // The runtime the atoms belong to, and whether it has since been torn down
+        JSRuntime* runtime {nullptr};
+        std::atomic<bool> runtimeTornDown {false};
+
+        static void RuntimeTornDown(JSRuntime* rt, void* data);
+
+        void grow();
+    };
+  }
+}
+
+
+#endif
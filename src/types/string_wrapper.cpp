@@ -0,0 +1,622 @@
+// copy, max, min
+#include <algorithm>
+
+// memcpy, strlen
+#include <cstring>
+
+// numeric_limits
+#include <limits>
+
+// unordered_set
+#include <unordered_set>
+
+// Mutex
+#include "platform/platform.h"
+
+// Isolate
+#include "runtime/isolate.h"
+
+// InternedStringTable
+#include "types/string_table.h"
+
+// Class definition
+#include "types/string_wrapper.h"
+
+// EncodeToNarrowest EncodeToNarrowestInto EncodeToUTF8 UTF16Encoded UTF8Length
+#include "utils/Encoding.h"
+
+// V8MONKEY_ASSERT
+#include "utils/V8MonkeyCommon.h"
+
+
+namespace v8 {
+  namespace internal {
+
+    /*
+     * The finalizer for external strings. SpiderMonkey hands the finalizer back to us when the string dies, so each
+     * external string gets its own, recording the resource to dispose.
+     *
+     */
+
+    struct ExternalStringFinalizer : public JSStringFinalizer {
+      explicit ExternalStringFinalizer(ExternalStringResource* r) : JSStringFinalizer {Finalize}, resource {r} {}
+
+      static void Finalize(const JSStringFinalizer* fin, char16_t* chars);
+
+      ExternalStringResource* resource;
+    };
+  }
+}
+
+
+namespace {
+  using v8::internal::ExternalStringFinalizer;
+
+
+  /*
+   * The finalizers of all extant external strings, for VisitExternalResources. Strings may be finalized on any thread
+   * with a JSRuntime, so access is guarded by a mutex. The registry is deliberately leaked: SpiderMonkey is torn down
+   * by a static destructor, which may run external string finalizers after this translation unit's statics are gone.
+   *
+   */
+
+  struct ExternalRegistry {
+    v8::V8Platform::Mutex mutex {};
+    std::unordered_set<const ExternalStringFinalizer*> finalizers {};
+  };
+
+
+  ExternalRegistry& externalRegistry() {
+    static ExternalRegistry* registry {new ExternalRegistry};
+    return *registry;
+  }
+
+
+  // Create an external string for the given resource. Does not take ownership of the resource on failure.
+  JSString* newExternalString(JSContext* cx, v8::internal::ExternalStringResource* resource) {
+    ExternalStringFinalizer* fin {new ExternalStringFinalizer(resource)};
+
+    // Register first, so that the finalizer always finds itself in the registry
+    ExternalRegistry& registry {externalRegistry()};
+    registry.mutex.Lock();
+    registry.finalizers.insert(fin);
+    registry.mutex.Unlock();
+
+    const char16_t* chars {reinterpret_cast<const char16_t*>(resource->data())};
+    JSString* s {JS_NewExternalString(cx, chars, resource->length(), fin)};
+
+    if (!s) {
+      registry.mutex.Lock();
+      registry.finalizers.erase(fin);
+      registry.mutex.Unlock();
+
+      delete fin;
+    }
+
+    return s;
+  }
+
+
+  #ifdef DEBUG
+  // Whether the resource holds exactly the characters of the given string
+  bool matchesResource(JSContext* cx, JSString* s, const v8::internal::ExternalStringResource* resource) {
+    if (resource->length() != JS_GetStringLength(s)) {
+      return false;
+    }
+
+    JS::RootedString rooted(cx, s);
+    JSFlatString* flat {JS_FlattenString(cx, rooted)};
+    if (!flat) {
+      return false;
+    }
+
+    const uint16_t* data {resource->data()};
+    for (size_t i = 0; i < resource->length(); i++) {
+      if (JS_GetFlatStringCharAt(flat, i) != data[i]) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+  #endif
+
+
+  size_t twoByteLength(const uint16_t* data) {
+    size_t length {0};
+    while (data[length]) {
+      length++;
+    }
+
+    return length;
+  }
+
+
+  // Copy, widening or truncating as necessary
+  void copyChars(const JS::Latin1Char* source, size_t count, uint8_t* dest) {
+    std::memcpy(dest, source, count);
+  }
+
+
+  void copyChars(const JS::Latin1Char* source, size_t count, uint16_t* dest) {
+    std::copy(source, source + count, dest);
+  }
+
+
+  void copyChars(const char16_t* source, size_t count, uint8_t* dest) {
+    for (size_t i = 0; i < count; i++) {
+      dest[i] = static_cast<uint8_t>(source[i]);
+    }
+  }
+
+
+  void copyChars(const char16_t* source, size_t count, uint16_t* dest) {
+    std::memcpy(dest, source, count * sizeof(char16_t));
+  }
+
+
+  // Returns the current isolate's storage for the given counter, or nullptr if there is none
+  int* currentCounter(v8::internal::Isolate::Counter counter) {
+    v8::internal::Isolate* isolate {v8::internal::Isolate::GetCurrent()};
+    return isolate ? isolate->GetCounter(counter) : nullptr;
+  }
+
+
+  void incrementCounter(v8::internal::Isolate::Counter counter) {
+    int* value {currentCounter(counter)};
+    if (value) {
+      (*value)++;
+    }
+  }
+
+
+  /*
+   * The common implementation of Write and WriteOneByte: copy up to length characters of str starting from start
+   * into buffer, directly from SpiderMonkey's storage. flat is the flattened str, or nullptr if flattening failed.
+   *
+   */
+
+  template <typename T>
+  int writeChars(JSString* str, JSFlatString* flat, T* buffer, int start, int length, bool nullTerminate) {
+    if (!flat) {
+      return 0;
+    }
+
+    size_t stringLength {JS_GetStringLength(str)};
+    size_t from {std::min(static_cast<size_t>(std::max(start, 0)), stringLength)};
+    size_t count {stringLength - from};
+    if (length >= 0) {
+      count = std::min(count, static_cast<size_t>(length));
+    }
+
+    JS::AutoCheckCannotGC nogc;
+    if (JS_StringHasLatin1Chars(str)) {
+      copyChars(JS_GetLatin1FlatStringChars(nogc, flat) + from, count, buffer);
+    } else {
+      copyChars(JS_GetTwoByteFlatStringChars(nogc, flat) + from, count, buffer);
+    }
+
+    // As in V8, there is only room for the terminator if the caller asked for more than was available
+    if (nullTerminate && (length < 0 || count < static_cast<size_t>(length))) {
+      buffer[count] = 0;
+    }
+
+    return static_cast<int>(count);
+  }
+
+
+  JSString* newOneByteString(JSContext* cx, const unsigned char* data, size_t length) {
+    // SpiderMonkey treats the chars passed to JS_NewStringCopyN as Latin1, and stores them as such
+    return JS_NewStringCopyN(cx, reinterpret_cast<const char*>(data), length);
+  }
+
+
+  // Strings of at most this many code units are encoded on the stack. Most strings crossing the API are identifiers.
+  constexpr size_t inlineEncodingLength {64};
+
+
+  template <typename T>
+  JSString* newNarrowestString(JSContext* cx, T begin, T end) {
+    using namespace v8::V8Monkey;
+
+    if (static_cast<size_t>(end - begin) <= inlineEncodingLength) {
+      unsigned char oneByte[inlineEncodingLength];
+      char16_t twoByte[inlineEncodingLength];
+
+      UTF8::NarrowestWritten written {UTF8::EncodeToNarrowestInto(begin, end, oneByte, twoByte)};
+      if (written.isOneByte) {
+        return newOneByteString(cx, oneByte, written.length);
+      }
+
+      return JS_NewUCStringCopyN(cx, twoByte, written.length);
+    }
+
+    UTF8::NarrowestEncoded encoded {UTF8::EncodeToNarrowest(begin, end)};
+
+    if (encoded.isOneByte) {
+      return newOneByteString(cx, encoded.oneByte.data(), encoded.oneByte.size());
+    }
+
+    return JS_NewUCStringCopyN(cx, encoded.twoByte.data(), encoded.twoByte.size());
+  }
+}
+
+
+namespace v8 {
+  namespace internal {
+    void ExternalStringFinalizer::Finalize(const JSStringFinalizer* fin, char16_t*) {
+      const ExternalStringFinalizer* self {static_cast<const ExternalStringFinalizer*>(fin)};
+
+      ExternalRegistry& registry {externalRegistry()};
+      registry.mutex.Lock();
+      registry.finalizers.erase(self);
+      registry.mutex.Unlock();
+
+      self->resource->Dispose();
+      delete self;
+    }
+
+
+    StringWrapper* StringWrapper::NewFromUtf8(JSContext* cx, const char* data, int length) {
+      size_t byteLength {length < 0 ? std::strlen(data) : static_cast<size_t>(length)};
+
+      JSString* s {newNarrowestString(cx, data, data + byteLength)};
+      return s ? new StringWrapper(s) : nullptr;
+    }
+
+
+    StringWrapper* StringWrapper::NewFromOneByte(JSContext* cx, const uint8_t* data, int length) {
+      size_t byteLength {length < 0 ? std::strlen(reinterpret_cast<const char*>(data)) : static_cast<size_t>(length)};
+
+      // One-byte data is Latin1 by definition, so no conversion is needed
+      JSString* s {newOneByteString(cx, data, byteLength)};
+      return s ? new StringWrapper(s) : nullptr;
+    }
+
+
+    StringWrapper* StringWrapper::NewFromTwoByte(JSContext* cx, const uint16_t* data, int length) {
+      size_t charLength {length < 0 ? twoByteLength(data) : static_cast<size_t>(length)};
+
+      JSString* s {newNarrowestString(cx, data, data + charLength)};
+      return s ? new StringWrapper(s) : nullptr;
+    }
+
+
+    StringWrapper* StringWrapper::NewInternalizedFromUtf8(JSContext* cx, InternedStringTable& table, const char* data,
+                                                          int length) {
+      size_t byteLength {length < 0 ? std::strlen(data) : static_cast<size_t>(length)};
+
+      JSString* s {table.Intern(cx, data, byteLength)};
+      return s ? new StringWrapper(s) : nullptr;
+    }
+
+
+    MappedStringResource* MappedStringResource::New(const char* path) {
+      MappedStringResource* resource {new MappedStringResource(path)};
+      if (!resource->file.IsValid()) {
+        delete resource;
+        return nullptr;
+      }
+
+      return resource;
+    }
+
+
+    MappedStringResource* MappedStringResource::New(int fd) {
+      MappedStringResource* resource {new MappedStringResource(fd)};
+      if (!resource->file.IsValid()) {
+        delete resource;
+        return nullptr;
+      }
+
+      return resource;
+    }
+
+
+    StringWrapper* StringWrapper::NewExternal(JSContext* cx, ExternalStringResource* resource) {
+      JSString* s {newExternalString(cx, resource)};
+      return s ? new StringWrapper(s) : nullptr;
+    }
+
+
+    StringWrapper* StringWrapper::NewExternal(JSContext* cx, ExternalAsciiStringResource* resource) {
+      JSString* s {JS_NewStringCopyN(cx, resource->data(), resource->length())};
+      if (!s) {
+        return nullptr;
+      }
+
+      resource->Dispose();
+      return new StringWrapper(s);
+    }
+
+
+    void StringWrapper::VisitExternalResources(ExternalResourceVisitor* visitor) {
+      ExternalRegistry& registry {externalRegistry()};
+      registry.mutex.Lock();
+
+      for (auto fin : registry.finalizers) {
+        visitor->VisitExternalString(fin->resource);
+      }
+
+      registry.mutex.Unlock();
+    }
+
+
+    int StringWrapper::Length() const {
+      return static_cast<int>(JS_GetStringLength(str));
+    }
+
+
+    StringWrapper* StringWrapper::Concat(JSContext* cx, StringWrapper& left, StringWrapper& right) {
+      JS::RootedString leftString(cx, left.str);
+      JS::RootedString rightString(cx, right.str);
+
+      JSString* s {JS_ConcatStrings(cx, leftString, rightString)};
+      if (!s) {
+        return nullptr;
+      }
+
+      StringWrapper* result {new StringWrapper(s)};
+      incrementCounter(Isolate::Counter::StringConcats);
+
+      // Concatenations involving short or empty strings yield flat strings
+      if (!JS_StringIsFlat(s)) {
+        result->ropeDepth = std::max(left.ropeDepth, right.ropeDepth) + 1;
+
+        int* maxDepth {currentCounter(Isolate::Counter::MaxRopeDepth)};
+        if (maxDepth && *maxDepth < result->ropeDepth) {
+          *maxDepth = result->ropeDepth;
+        }
+      }
+
+      return result;
+    }
+
+
+    JSFlatString* StringWrapper::Flatten(JSContext* cx) {
+      if (!JS_StringIsFlat(str)) {
+        incrementCounter(Isolate::Counter::StringFlattens);
+      }
+
+      JSFlatString* flat {JS_FlattenString(cx, str)};
+      if (flat) {
+        ropeDepth = 0;
+      }
+
+      return flat;
+    }
+
+
+    bool StringWrapper::IsOneByte() const {
+      return JS_StringHasLatin1Chars(str);
+    }
+
+
+    bool StringWrapper::Equals(JSContext* cx, StringWrapper& other, bool* result) {
+      if (Get() == other.Get() || Length() != other.Length()) {
+        *result = Get() == other.Get();
+        return true;
+      }
+
+      if (!Flatten(cx) || !other.Flatten(cx)) {
+        return false;
+      }
+
+      int32_t order {0};
+      if (!JS_CompareStrings(cx, str, other.str, &order)) {
+        return false;
+      }
+
+      *result = order == 0;
+      return true;
+    }
+
+
+    bool StringWrapper::StrictEquals(JSContext* cx, StringWrapper& other, bool* result) {
+      return Equals(cx, other, result);
+    }
+
+
+    int StringWrapper::WriteOneByte(JSContext* cx, uint8_t* buffer, int start, int length, int options) {
+      return writeChars(str, Flatten(cx), buffer, start, length, !(options & NO_NULL_TERMINATION));
+    }
+
+
+    int StringWrapper::Write(JSContext* cx, uint16_t* buffer, int start, int length, int options) {
+      return writeChars(str, Flatten(cx), buffer, start, length, !(options & NO_NULL_TERMINATION));
+    }
+
+
+    int StringWrapper::Utf8Length(JSContext* cx) {
+      if (utf8Length >= 0) {
+        return utf8Length;
+      }
+
+      JSFlatString* flat {Flatten(cx)};
+      if (!flat) {
+        return 0;
+      }
+
+      size_t length {JS_GetStringLength(str)};
+      JS::AutoCheckCannotGC nogc;
+      if (JS_StringHasLatin1Chars(str)) {
+        utf8Length = static_cast<int>(V8Monkey::UTF8::UTF8Length(JS_GetLatin1FlatStringChars(nogc, flat), length));
+      } else {
+        utf8Length = static_cast<int>(V8Monkey::UTF8::UTF8Length(JS_GetTwoByteFlatStringChars(nogc, flat), length));
+      }
+
+      return utf8Length;
+    }
+
+
+    int StringWrapper::WriteUtf8(JSContext* cx, char* buffer, int length, int* nchars_ref, int options) {
+      using namespace V8Monkey;
+
+      JSFlatString* flat {Flatten(cx)};
+      if (!flat) {
+        if (nchars_ref) {
+          *nchars_ref = 0;
+        }
+
+        return 0;
+      }
+
+      size_t stringLength {JS_GetStringLength(str)};
+      size_t capacity {length < 0 ? std::numeric_limits<size_t>::max() : static_cast<size_t>(length)};
+
+      JS::AutoCheckCannotGC nogc;
+      UTF8::UTF8Written written;
+      if (JS_StringHasLatin1Chars(str)) {
+        written = UTF8::EncodeToUTF8(JS_GetLatin1FlatStringChars(nogc, flat), stringLength, buffer, capacity);
+      } else {
+        written = UTF8::EncodeToUTF8(JS_GetTwoByteFlatStringChars(nogc, flat), stringLength, buffer, capacity,
+                                     options & REPLACE_INVALID_UTF8);
+      }
+
+      // Having encoded the whole string, we know its length for free. (Replacement doesn't change lengths.)
+      bool complete {written.codeUnits == stringLength};
+      if (complete) {
+        utf8Length = static_cast<int>(written.bytes);
+      }
+
+      if (nchars_ref) {
+        *nchars_ref = static_cast<int>(written.codeUnits);
+      }
+
+      // As in V8, the terminator is only written if the whole string was, and there is room for it
+      if (!(options & NO_NULL_TERMINATION) && complete && written.bytes < capacity) {
+        buffer[written.bytes++] = '\0';
+      }
+
+      return static_cast<int>(written.bytes);
+    }
+
+
+    bool StringWrapper::ToId(JSContext* cx, JS::MutableHandleId result) {
+      if (!JSID_IS_VOID(id.get())) {
+        result.set(id);
+        return true;
+      }
+
+      JS::RootedString s(cx, str);
+      if (!JS_StringToId(cx, s, result)) {
+        return false;
+      }
+
+      id = result;
+      return true;
+    }
+
+
+    bool StringWrapper::IsExternal() const {
+      return GetExternalStringResource() != nullptr;
+    }
+
+
+    ExternalStringResource* StringWrapper::GetExternalStringResource() const {
+      if (!JS_IsExternalString(str)) {
+        return nullptr;
+      }
+
+      // Other embeddings in the same process could create external strings with finalizers of their own
+      const JSStringFinalizer* fin {JS_GetExternalStringFinalizer(str)};
+      if (fin->finalize != ExternalStringFinalizer::Finalize) {
+        return nullptr;
+      }
+
+      return static_cast<const ExternalStringFinalizer*>(fin)->resource;
+    }
+
+
+    bool StringWrapper::MakeExternal(JSContext* cx, ExternalStringResource* resource) {
+      V8MONKEY_ASSERT(matchesResource(cx, str, resource), "External resource does not match string");
+
+      if (IsExternal()) {
+        return false;
+      }
+
+      JSString* s {newExternalString(cx, resource)};
+      if (!s) {
+        return false;
+      }
+
+      str = s;
+      return true;
+    }
+
+
+    bool StringWrapper::MakeExternal(JSContext*, ExternalAsciiStringResource*) {
+      return false;
+    }
+
+
+    StringWrapper* StringBuilder::Finish(JSContext* cx) {
+      decoder.Finish();
+
+      const V8Monkey::UTF8::UTF16Encoded& chars {decoder.Output()};
+      JSString* s {newNarrowestString(cx, chars.data(), chars.data() + chars.size())};
+      decoder.Reset();
+
+      return s ? new StringWrapper(s) : nullptr;
+    }
+
+
+    Utf8View::Utf8View(JSContext* cx, StringWrapper& string) : pinned(cx) {
+      JSFlatString* flat {string.Flatten(cx)};
+      JSString* str {string.Get()};
+      if (!flat) {
+        return;
+      }
+
+      size = string.Utf8Length(cx);
+      size_t byteLength {static_cast<size_t>(size)};
+
+      if (byteLength < inlineCapacity) {
+        string.WriteUtf8(cx, inlineChars, static_cast<int>(inlineCapacity));
+        data = inlineChars;
+        return;
+      }
+
+      // A Latin1 string whose UTF-8 length matches its length is ASCII, and so is already valid UTF-8
+      if (JS_StringHasLatin1Chars(str) && byteLength == JS_GetStringLength(str)) {
+        pinned = str;
+        JS::AutoCheckCannotGC nogc;
+        data = reinterpret_cast<const char*>(JS_GetLatin1FlatStringChars(nogc, flat));
+        return;
+      }
+
+      heap.reset(new char[byteLength + 1]);
+      string.WriteUtf8(cx, heap.get(), size + 1);
+      data = heap.get();
+    }
+
+
+    TwoByteView::TwoByteView(JSContext* cx, StringWrapper& string) : pinned(cx) {
+      JSFlatString* flat {string.Flatten(cx)};
+      JSString* str {string.Get()};
+      if (!flat) {
+        return;
+      }
+
+      size_t length {JS_GetStringLength(str)};
+      size = static_cast<int>(length);
+
+      if (length < inlineCapacity) {
+        string.Write(cx, inlineChars);
+        data = inlineChars;
+        return;
+      }
+
+      if (!JS_StringHasLatin1Chars(str)) {
+        pinned = str;
+        JS::AutoCheckCannotGC nogc;
+        data = reinterpret_cast<const uint16_t*>(JS_GetTwoByteFlatStringChars(nogc, flat));
+        return;
+      }
+
+      heap.reset(new uint16_t[length + 1]);
+      string.Write(cx, heap.get());
+      data = heap.get();
+    }
+  }
+}
@@ -0,0 +1,409 @@
+#ifndef V8MONKEY_STRINGWRAPPER_H
+#define V8MONKEY_STRINGWRAPPER_H
+
+// size_t
+#include <cstddef>
+
+// uint8_t, uint16_t
+#include <cstdint>
+
+// unique_ptr
+#include <memory>
+
+// MappedFile
+#include "platform/platform.h"
+
+// JS_CallIdTracer JS_CallStringTracer JS::Heap jsid JS::MutableHandleId JS::RootedString JSContext JSFlatString
+// JSString JSTracer
+#include "jsapi.h"
+
+// StreamDecoder
+#include "utils/Encoding.h"
+
+// EXPORT_FOR_TESTING_ONLY
+#include "utils/test.h"
+
+
+namespace v8 {
+  namespace internal {
+    struct ExternalStringFinalizer;
+    class InternedStringTable;
+
+
+    /*
+     * Mirrors of String::ExternalStringResourceBase and its subclasses. An embedder implements one of these to hand
+     * string data that it owns to the engine. The engine calls Dispose once the string is no longer referenced.
+     *
+     */
+
+    class EXPORT_FOR_TESTING_ONLY ExternalStringResourceBase {
+      public:
+        virtual ~ExternalStringResourceBase() {}
+
+      protected:
+        ExternalStringResourceBase() {}
+
+        virtual void Dispose() { delete this; }
+
+      private:
+        ExternalStringResourceBase(const ExternalStringResourceBase& other) = delete;
+        ExternalStringResourceBase& operator=(const ExternalStringResourceBase& other) = delete;
+
+        friend struct ExternalStringFinalizer;
+        friend class ScriptSource;
+        friend class StringWrapper;
+    };
+
+
+    class EXPORT_FOR_TESTING_ONLY ExternalStringResource : public ExternalStringResourceBase {
+      public:
+        virtual ~ExternalStringResource() {}
+
+        virtual const uint16_t* data() const = 0;
+        virtual size_t length() const = 0;
+    };
+
+
+    class EXPORT_FOR_TESTING_ONLY ExternalAsciiStringResource : public ExternalStringResourceBase {
+      public:
+        virtual ~ExternalAsciiStringResource() {}
+
+        virtual const char* data() const = 0;
+        virtual size_t length() const = 0;
+    };
+
+
+    /*
+     * A one-byte resource backed by a read-only mapping of a file, so that text on disk reaches the engine without
+     * first being read on to the heap. The data is the file's bytes as they are: a ScriptSource may equally read them
+     * as UTF-8. The mapping is released when the resource is disposed.
+     *
+     */
+
+    class EXPORT_FOR_TESTING_ONLY MappedStringResource : public ExternalAsciiStringResource {
+      public:
+        // Returns nullptr if the file could not be opened or mapped
+        static MappedStringResource* New(const char* path);
+
+        // The descriptor is not closed, and need not outlive the resource. Returns nullptr if it could not be mapped.
+        static MappedStringResource* New(int fd);
+
+        // Empty files have null data
+        const char* data() const override { return static_cast<const char*>(file.Data()); }
+        size_t length() const override { return file.Length(); }
+
+      private:
+        explicit MappedStringResource(const char* path) : file {path} {}
+        explicit MappedStringResource(int fd) : file {fd} {}
+
+        V8Platform::MappedFile file;
+    };
+
+
+    /*
+     * Mirrors ExternalResourceVisitor. V8 hands the visitor a handle to each string; SpiderMonkey offers no way of
+     * finding a string from its finalizer, so we hand over the resource instead, which is what embedders accounting
+     * for external memory are interested in.
+     *
+     */
+
+    class EXPORT_FOR_TESTING_ONLY ExternalResourceVisitor {
+      public:
+        virtual ~ExternalResourceVisitor() {}
+
+        virtual void VisitExternalString(ExternalStringResource* resource) = 0;
+    };
+
+
+    /*
+     * V8Monkey's representation of a string: a SpiderMonkey string, plus whatever book-keeping the V8 API requires.
+     *
+     * SpiderMonkey stores strings whose characters all fit in a byte as Latin1. As the overwhelming majority of strings
+     * crossing the API are ASCII, the factories below always create the narrowest representation possible, and the
+     * one-byte accessors read Latin1 strings without conversion.
+     *
+     * The wrapper does not root the string: whoever owns the wrapper must call Trace when tracing roots.
+     *
+     */
+
+    class EXPORT_FOR_TESTING_ONLY StringWrapper {
+      public:
+        // Mirrors String::WriteOptions
+        enum WriteOptions {
+          NO_OPTIONS = 0,
+          HINT_MANY_WRITES_EXPECTED = 1,
+          NO_NULL_TERMINATION = 2,
+          PRESERVE_ASCII_NULL = 4,
+          REPLACE_INVALID_UTF8 = 8
+        };
+
+        explicit StringWrapper(JSString* s) : str {s} {}
+        ~StringWrapper() = default;
+
+        /*
+         * Factories corresponding to String::NewFromUtf8, String::NewFromOneByte and String::NewFromTwoByte. A length
+         * of -1 denotes null-terminated data. Returns nullptr if SpiderMonkey reported an error.
+         *
+         */
+
+        static StringWrapper* NewFromUtf8(JSContext* cx, const char* data, int length = -1);
+        static StringWrapper* NewFromOneByte(JSContext* cx, const uint8_t* data, int length = -1);
+        static StringWrapper* NewFromTwoByte(JSContext* cx, const uint16_t* data, int length = -1);
+
+        // As String::NewFromUtf8 with kInternalizedString: the string is an atom, looked up through the given table
+        static StringWrapper* NewInternalizedFromUtf8(JSContext* cx, InternedStringTable& table, const char* data,
+                                                      int length = -1);
+
+
+        /*
+         * As String::NewExternal. Two-byte resources become SpiderMonkey external strings, which read the resource's
+         * data in place; the resource is disposed when the string is finalized.
+         *
+         * SpiderMonkey has no one-byte external strings, so the data of one-byte resources is copied into a Latin1
+         * string (one byte per character, so no larger than the resource itself), and the resource is disposed
+         * immediately.
+         *
+         * Returns nullptr if SpiderMonkey reported an error, in which case the resource has not been disposed.
+         *
+         */
+
+        static StringWrapper* NewExternal(JSContext* cx, ExternalStringResource* resource);
+        static StringWrapper* NewExternal(JSContext* cx, ExternalAsciiStringResource* resource);
+
+
+        /*
+         * As String::Concat. SpiderMonkey represents the result as a rope referencing the two halves, so building a
+         * string piece by piece costs O(1) per piece: the characters are only copied when the string is flattened,
+         * which happens the first time its contents are read. Concatenations, flattens and the greatest rope depth
+         * seen are reported to the current isolate's counters. Returns nullptr if SpiderMonkey reported an error.
+         *
+         */
+
+        static StringWrapper* Concat(JSContext* cx, StringWrapper& left, StringWrapper& right);
+
+
+        /*
+         * Invoke the visitor for every extant external string created from an ExternalStringResource. The visitor must
+         * not allocate on the SpiderMonkey heap.
+         *
+         */
+
+        static void VisitExternalResources(ExternalResourceVisitor* visitor);
+
+        JSString* Get() const { return str; }
+
+        // Flatten the string if it is a rope. Returns nullptr if SpiderMonkey reported an error.
+        JSFlatString* Flatten(JSContext* cx);
+
+        // The depth of the rope created by Concat, or 0 if the string is known to be flat
+        int RopeDepth() const { return ropeDepth; }
+
+        int Length() const;
+
+        // True if SpiderMonkey holds the string as Latin1
+        bool IsOneByte() const;
+
+        /*
+         * As Value::Equals and Value::StrictEquals, which coincide when both values are strings. Strings of different
+         * lengths are unequal without reading their characters; otherwise both are flattened, and the flattens
+         * counted as for Concat. Returns false if SpiderMonkey reported an error.
+         *
+         */
+
+        bool Equals(JSContext* cx, StringWrapper& other, bool* result);
+        bool StrictEquals(JSContext* cx, StringWrapper& other, bool* result);
+
+        /*
+         * As String::WriteOneByte and String::Write: copy up to length characters starting from start into buffer,
+         * truncating each to 8 bits for WriteOneByte, and null-terminating unless options includes
+         * NO_NULL_TERMINATION. A length of -1 writes to the end of the string. Returns the number of characters
+         * written, excluding any terminator.
+         *
+         */
+
+        int WriteOneByte(JSContext* cx, uint8_t* buffer, int start = 0, int length = -1, int options = NO_OPTIONS);
+        int Write(JSContext* cx, uint16_t* buffer, int start = 0, int length = -1, int options = NO_OPTIONS);
+
+        /*
+         * As String::Utf8Length. Strings are immutable, so the result is cached: the usual pattern of Utf8Length
+         * followed by WriteUtf8 (or vice versa) only scans the string once.
+         *
+         */
+
+        int Utf8Length(JSContext* cx);
+
+        /*
+         * As String::WriteUtf8: encode as much of the string as fits in length bytes (or all of it, if length is -1)
+         * without splitting a character. The terminator is written if the whole string fits with room to spare,
+         * unless options includes NO_NULL_TERMINATION. Lone surrogates are replaced if options includes
+         * REPLACE_INVALID_UTF8. Returns the number of bytes written including any terminator; nchars_ref, if
+         * supplied, receives the number of UTF-16 code units written.
+         *
+         */
+
+        int WriteUtf8(JSContext* cx, char* buffer, int length = -1, int* nchars_ref = nullptr,
+                      int options = NO_OPTIONS);
+
+        /*
+         * Return the property key for this string, as needed by every property access. Converting a string to a jsid
+         * means atomizing it, and checking whether it is an array index; keys are typically used repeatedly, so the
+         * result is cached, and later calls cost a single load. Returns false if SpiderMonkey reported an error.
+         *
+         */
+
+        bool ToId(JSContext* cx, JS::MutableHandleId result);
+
+        bool IsExternal() const;
+
+        // Returns the resource this string was created from, or nullptr if it is not an external string
+        ExternalStringResource* GetExternalStringResource() const;
+
+        /*
+         * As String::MakeExternal. SpiderMonkey strings cannot change representation, so the wrapper is instead
+         * repointed at a new external string with the same contents; the old string is left for the GC. The resource
+         * must hold the same characters as the string.
+         *
+         * This falls short of V8 in two ways:
+         *  - Only this wrapper is repointed. Anything else referring to the original string, such as a JS variable or
+         *    property, keeps the heap copy reachable, so memory is only saved once those references are gone
+         *  - One-byte resources cannot back SpiderMonkey strings, so the one-byte variant always returns false
+         *
+         * When false is returned, the caller retains responsibility for the resource.
+         *
+         */
+
+        bool MakeExternal(JSContext* cx, ExternalStringResource* resource);
+        bool MakeExternal(JSContext* cx, ExternalAsciiStringResource* resource);
+
+        void Trace(JSTracer* tracer) {
+          JS_CallStringTracer(tracer, &str, "V8Monkey string");
+
+          // The cached key may hold an atom other than str, which only we keep alive
+          if (!JSID_IS_VOID(id.get())) {
+            JS_CallIdTracer(tracer, &id, "V8Monkey string property key");
+          }
+        }
+
+        StringWrapper(const StringWrapper& other) = delete;
+        StringWrapper(StringWrapper&& other) = delete;
+        StringWrapper& operator=(const StringWrapper& other) = delete;
+        StringWrapper& operator=(StringWrapper&& other) = delete;
+
+      private:
+        JS::Heap<JSString*> str;
+
+        // The cached result of Utf8Length, or -1 if not yet known
+        int utf8Length {-1};
+
+        // The cached result of ToId, or JSID_VOID if not yet known
+        JS::Heap<jsid> id {};
+
+        int ropeDepth {0};
+    };
+
+
+    /*
+     * Assembles a string from UTF-8 that arrives in chunks, such as a network body. Each chunk is decoded as it
+     * arrives, rather than the raw bytes being concatenated first. A multi-byte sequence split between chunks is
+     * handled correctly.
+     *
+     */
+
+    class EXPORT_FOR_TESTING_ONLY StringBuilder {
+      public:
+        StringBuilder() = default;
+        ~StringBuilder() = default;
+
+        void Append(const char* data, size_t length) { decoder.Append(data, length); }
+
+        /*
+         * Create a string from everything appended, in the narrowest representation possible, and reset the builder.
+         * Returns nullptr if SpiderMonkey reported an error.
+         *
+         */
+
+        StringWrapper* Finish(JSContext* cx);
+
+        StringBuilder(const StringBuilder& other) = delete;
+        StringBuilder(StringBuilder&& other) = delete;
+        StringBuilder& operator=(const StringBuilder& other) = delete;
+        StringBuilder& operator=(StringBuilder&& other) = delete;
+
+      private:
+        V8Monkey::UTF8::StreamDecoder decoder {};
+    };
+
+
+    /*
+     * Counterparts of String::Utf8Value and String::Value, which avoid V8's unconditional heap allocation.
+     *
+     * Short strings are copied to a buffer within the view. Long strings whose SpiderMonkey representation already
+     * has the desired encoding (ASCII Latin1 strings for UTF-8, two-byte strings for UTF-16) are read in place: the
+     * string is rooted for the lifetime of the view, and as only short strings have their characters stored inline
+     * in the GC cell, the characters of a long flat string never move. Anything else is converted to a heap copy.
+     *
+     * A view read in place is not null-terminated: use length(). A view holds a JS::Rooted, so must be created on
+     * the stack, and destroyed in the reverse order of creation. If the string cannot be flattened, length() is 0
+     * and the data is nullptr.
+     *
+     */
+
+    class EXPORT_FOR_TESTING_ONLY Utf8View {
+      public:
+        Utf8View(JSContext* cx, StringWrapper& string);
+        ~Utf8View() = default;
+
+        const char* operator*() const { return data; }
+        int length() const { return size; }
+
+        // True if the view reads SpiderMonkey's characters in place
+        bool IsDirect() const { return pinned.get() != nullptr; }
+
+        Utf8View(const Utf8View& other) = delete;
+        Utf8View(Utf8View&& other) = delete;
+        Utf8View& operator=(const Utf8View& other) = delete;
+        Utf8View& operator=(Utf8View&& other) = delete;
+
+      private:
+        // Including the terminator. SpiderMonkey's inline strings hold at most 23 Latin1 characters.
+        static constexpr size_t inlineCapacity {64};
+
+        JS::RootedString pinned;
+        std::unique_ptr<char[]> heap {};
+        const char* data {nullptr};
+        int size {0};
+        char inlineChars[inlineCapacity];
+    };
+
+
+    class EXPORT_FOR_TESTING_ONLY TwoByteView {
+      public:
+        TwoByteView(JSContext* cx, StringWrapper& string);
+        ~TwoByteView() = default;
+
+        const uint16_t* operator*() const { return data; }
+        int length() const { return size; }
+
+        // True if the view reads SpiderMonkey's characters in place
+        bool IsDirect() const { return pinned.get() != nullptr; }
+
+        TwoByteView(const TwoByteView& other) = delete;
+        TwoByteView(TwoByteView&& other) = delete;
+        TwoByteView& operator=(const TwoByteView& other) = delete;
+        TwoByteView& operator=(TwoByteView&& other) = delete;
+
+      private:
+        // Including the terminator. SpiderMonkey's inline strings hold at most 11 two-byte characters.
+        static constexpr size_t inlineCapacity {32};
+
+        JS::RootedString pinned;
+        std::unique_ptr<uint16_t[]> heap {};
+        const uint16_t* data {nullptr};
+        int size {0};
+        uint16_t inlineChars[inlineCapacity];
+    };
+  }
+}
+
+
+#endif
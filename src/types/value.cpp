@@ -12,27 +12,30 @@
 
 // CheckDeath
 //#include "utils/V8MonkeyCommon.h"
+
+// DoubleToInt32 DoubleToUint32
+//#include "utils/Conversions.h"
 //
 //
 //namespace {
 //
 //  /*
-//   * ECMA-262 Section 9.5 compliant To(U)Int32 casting
+//   * ECMA-262 Section 9.5 compliant To(U)Int32 casting. The old static_cast implementations were undefined for
+//   * values outside 32 bits: see utils/Conversions.h.
 //   *
 //   */
 //
-//  uint32_t doubleToUint32(double d) {
-//    if (std::isnan(d) || !std::isfinite(d) || d == -0.0) {
-//      return 0;
-//    }
+//  using ::v8::V8Monkey::Conversions::DoubleToInt32;
+//  using ::v8::V8Monkey::Conversions::DoubleToUint32;
+//
 //
-//    return static_cast<uint32_t>(d);
+//  uint32_t doubleToUint32(double d) {
+//    return DoubleToUint32(d);
 //  }
 //
 //
 //  int32_t doubleToInt32(double d) {
-//    // Convert to an unsigned first, to avoid undefined behaviour for uint32s that don't fit in an int32
-//    return static_cast<int32_t>(doubleToUint32(d));
+//    return DoubleToInt32(d);
 //  }
 //}
 //
@@ -0,0 +1,96 @@
+#ifndef V8MONKEY_CONVERSIONS_H
+#define V8MONKEY_CONVERSIONS_H
+
+// int32_t, uint32_t, uint64_t
+#include <cstdint>
+
+// memcpy
+#include <cstring>
+
+
+namespace v8 {
+  namespace V8Monkey {
+    namespace Conversions {
+
+      /*
+       * ECMA-262 Section 9.5 / 9.6 compliant To(U)Int32 conversions.
+       *
+       * Casting a double that does not fit in the target type is undefined behaviour in C++, so we cannot simply
+       * static_cast. Instead, we follow the approach of V8's DoubleToInt32: the common case of a value that truncates
+       * to something in range is handled with a single range check and cast, and everything else (large values,
+       * infinities and NaNs) is handled by picking apart the IEEE 754 bit pattern, and computing the low 32 bits of
+       * the truncated integer directly. We assume doubles are IEEE 754 double-precision, as V8 does.
+       *
+       */
+
+      namespace detail {
+        constexpr int significandBits {52};
+        constexpr int exponentBias {1023 + significandBits};
+        constexpr uint64_t significandMask {0x000fffffffffffffull};
+        constexpr uint64_t hiddenBit {0x0010000000000000ull};
+        constexpr uint64_t signMask {0x8000000000000000ull};
+
+
+        /*
+         * Computes ToUint32 for values where the simple truncation is not possible. Correct for all values, but only
+         * intended to be called when the fast path fails.
+         *
+         */
+
+        inline uint32_t slowDoubleToUint32(double d) {
+          uint64_t bits;
+          std::memcpy(&bits, &d, sizeof(bits));
+
+          int exponent {static_cast<int>((bits >> significandBits) & 0x7ffu) - exponentBias};
+
+          // The integer is a multiple of 2^32 (this also catches infinities and NaNs, which have the maximal exponent)
+          if (exponent > 31) {
+            return 0;
+          }
+
+          // Too small to have an integer part. Note this cannot happen when called from the fast paths below, but
+          // guards against undefined shifts should anyone else call us.
+          if (exponent <= -(significandBits + 1)) {
+            return 0;
+          }
+
+          // Denormals have no hidden bit, but are caught by the check above
+          uint64_t significand {(bits & significandMask) | hiddenBit};
+          uint32_t magnitude {exponent < 0 ? static_cast<uint32_t>(significand >> -exponent) :
+                                             static_cast<uint32_t>(significand << exponent)};
+
+          // Negation modulo 2^32
+          return (bits & signMask) ? 0u - magnitude : magnitude;
+        }
+      }
+
+
+      inline int32_t DoubleToInt32(double d) {
+        // Values that truncate to something in int32 range (NaN fails both comparisons)
+        if (d > -2147483649.0 && d < 2147483648.0) {
+          return static_cast<int32_t>(d);
+        }
+
+        return static_cast<int32_t>(detail::slowDoubleToUint32(d));
+      }
+
+
+      inline uint32_t DoubleToUint32(double d) {
+        // Values that truncate to something in uint32 range (NaN fails both comparisons)
+        if (d > -1.0 && d < 4294967296.0) {
+          return static_cast<uint32_t>(d);
+        }
+
+        // Negative values in int32 range are common (think -1), and much cheaper than the bit-twiddling
+        if (d > -2147483649.0 && d < 0.0) {
+          return static_cast<uint32_t>(static_cast<int32_t>(d));
+        }
+
+        return detail::slowDoubleToUint32(d);
+      }
+    }
+  }
+}
+
+
+#endif
@@ -0,0 +1,711 @@
+// copy, fill_n, min
+#include <algorithm>
+
+// atomic
+#include <atomic>
+
+// uint64_t
+#include <cstdint>
+
+// memcpy
+#include <cstring>
+
+// Function definitions
+#include "utils/Encoding.h"
+
+#if defined(__SSE2__) && (defined(__x86_64__) || defined(__i386__))
+  #define V8MONKEY_X86_SIMD 1
+
+  // SSE2 / AVX2 intrinsics
+  #include <immintrin.h>
+#endif
+
+
+/*
+ * The ASCII widening, copying and narrowing routines. Each loads a block of code units, and checks whether the whole
+ * block is ASCII. If so, the block is stored, converted to the destination width. Otherwise, the remaining code units
+ * of the block are handled one at a time up to the first non-ASCII code unit, which is left for the caller's state
+ * machine to deal with.
+ *
+ * The UTF-8 length routines count the bytes required to encode each code unit, a block at a time.
+ *
+ */
+
+namespace {
+  using namespace v8::V8Monkey::UTF8;
+
+  // The routines for a particular implementation are always chosen together
+  struct EncodingFunctions {
+    size_t (*widen)(const unsigned char*, size_t, char16_t*);
+    size_t (*copy)(const unsigned char*, size_t, unsigned char*);
+    size_t (*narrow)(const char16_t*, size_t, unsigned char*);
+    size_t (*countNonASCII)(const unsigned char*, size_t);
+    size_t (*utf8Length)(const char16_t*, size_t);
+  };
+
+
+  constexpr char16_t leadSurrogateMin {0xd800u};
+  constexpr char16_t trailSurrogateMin {0xdc00u};
+  constexpr char16_t surrogateMask {0xfc00u};
+
+
+  inline bool isLeadSurrogate(char16_t c) {
+    return (c & surrogateMask) == leadSurrogateMin;
+  }
+
+
+  inline bool isTrailSurrogate(char16_t c) {
+    return (c & surrogateMask) == trailSurrogateMin;
+  }
+
+
+  size_t scalarWidenASCII(const unsigned char* source, size_t length, char16_t* dest) {
+    size_t i {0};
+
+    // Check 8 code units at a time, using a word-sized load
+    for (; i + 8 <= length; i += 8) {
+      uint64_t block;
+      std::memcpy(&block, source + i, sizeof(block));
+
+      if (block & 0x8080808080808080u) {
+        break;
+      }
+
+      for (size_t j = i; j < i + 8; j++) {
+        dest[j] = static_cast<char16_t>(source[j]);
+      }
+    }
+
+    for (; i < length && !(source[i] & 0x80u); i++) {
+      dest[i] = static_cast<char16_t>(source[i]);
+    }
+
+    return i;
+  }
+
+
+  size_t scalarCopyASCII(const unsigned char* source, size_t length, unsigned char* dest) {
+    size_t i {0};
+
+    for (; i + 8 <= length; i += 8) {
+      uint64_t block;
+      std::memcpy(&block, source + i, sizeof(block));
+
+      if (block & 0x8080808080808080u) {
+        break;
+      }
+
+      std::memcpy(dest + i, &block, sizeof(block));
+    }
+
+    for (; i < length && !(source[i] & 0x80u); i++) {
+      dest[i] = source[i];
+    }
+
+    return i;
+  }
+
+
+  size_t scalarNarrowASCII(const char16_t* source, size_t length, unsigned char* dest) {
+    size_t i {0};
+
+    for (; i + 4 <= length; i += 4) {
+      uint64_t block;
+      std::memcpy(&block, source + i, sizeof(block));
+
+      if (block & 0xff80ff80ff80ff80u) {
+        break;
+      }
+
+      for (size_t j = i; j < i + 4; j++) {
+        dest[j] = static_cast<unsigned char>(source[j]);
+      }
+    }
+
+    for (; i < length && source[i] < 0x80u; i++) {
+      dest[i] = static_cast<unsigned char>(source[i]);
+    }
+
+    return i;
+  }
+
+
+  size_t scalarCountNonASCII(const unsigned char* source, size_t length) {
+    size_t count {0};
+    size_t i {0};
+
+    for (; i + 8 <= length; i += 8) {
+      uint64_t block;
+      std::memcpy(&block, source + i, sizeof(block));
+      count += static_cast<size_t>(__builtin_popcountll(block & 0x8080808080808080u));
+    }
+
+    for (; i < length; i++) {
+      count += source[i] >> 7;
+    }
+
+    return count;
+  }
+
+
+  // A well-formed surrogate pair encodes to 4 bytes. A lone surrogate encodes to 3, whether or not it is replaced.
+  size_t scalarUTF8Length(const char16_t* source, size_t length) {
+    size_t bytes {0};
+
+    for (size_t i = 0; i < length; i++) {
+      char16_t c {source[i]};
+
+      if (c < 0x80u) {
+        bytes += 1;
+      } else if (c < 0x800u) {
+        bytes += 2;
+      } else if (isLeadSurrogate(c) && i + 1 < length && isTrailSurrogate(source[i + 1])) {
+        bytes += 4;
+        i++;
+      } else {
+        bytes += 3;
+      }
+    }
+
+    return bytes;
+  }
+
+
+  const EncodingFunctions scalarFunctions {scalarWidenASCII, scalarCopyASCII, scalarNarrowASCII, scalarCountNonASCII,
+                                           scalarUTF8Length};
+
+
+  #ifdef V8MONKEY_X86_SIMD
+  size_t sse2WidenASCII(const unsigned char* source, size_t length, char16_t* dest) {
+    const __m128i zero {_mm_setzero_si128()};
+
+    size_t i {0};
+    for (; i + 16 <= length; i += 16) {
+      __m128i block {_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i))};
+
+      if (_mm_movemask_epi8(block)) {
+        break;
+      }
+
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), _mm_unpacklo_epi8(block, zero));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i + 8), _mm_unpackhi_epi8(block, zero));
+    }
+
+    return i + scalarWidenASCII(source + i, length - i, dest + i);
+  }
+
+
+  size_t sse2CopyASCII(const unsigned char* source, size_t length, unsigned char* dest) {
+    size_t i {0};
+    for (; i + 16 <= length; i += 16) {
+      __m128i block {_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i))};
+
+      if (_mm_movemask_epi8(block)) {
+        break;
+      }
+
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), block);
+    }
+
+    return i + scalarCopyASCII(source + i, length - i, dest + i);
+  }
+
+
+  size_t sse2NarrowASCII(const char16_t* source, size_t length, unsigned char* dest) {
+    const __m128i nonASCII {_mm_set1_epi16(static_cast<short>(0xff80))};
+    const __m128i zero {_mm_setzero_si128()};
+
+    size_t i {0};
+    for (; i + 16 <= length; i += 16) {
+      __m128i low {_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i))};
+      __m128i high {_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 8))};
+
+      __m128i bits {_mm_and_si128(_mm_or_si128(low, high), nonASCII)};
+      if (_mm_movemask_epi8(_mm_cmpeq_epi16(bits, zero)) != 0xffff) {
+        break;
+      }
+
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), _mm_packus_epi16(low, high));
+    }
+
+    return i + scalarNarrowASCII(source + i, length - i, dest + i);
+  }
+
+
+  size_t sse2CountNonASCII(const unsigned char* source, size_t length) {
+    size_t count {0};
+    size_t i {0};
+
+    for (; i + 16 <= length; i += 16) {
+      __m128i block {_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i))};
+      count += static_cast<size_t>(__builtin_popcount(static_cast<unsigned int>(_mm_movemask_epi8(block))));
+    }
+
+    return count + scalarCountNonASCII(source + i, length - i);
+  }
+
+
+  /*
+   * Each code unit needs 3 bytes, less one if it is below 0x800, and one more if below 0x80. Comparison results are
+   * -1 in each matching lane, so can be added directly. A lead surrogate whose successor is a trail surrogate starts a
+   * well-formed pair, which needs 4 bytes rather than the 6 counted for its two halves. Pairs cannot overlap, so
+   * comparing each block against the same block shifted along by one code unit finds them all.
+   *
+   * The per-lane counts are accumulated in 16 bits, so are flushed before they can overflow.
+   *
+   */
+
+  size_t sse2UTF8Length(const char16_t* source, size_t length) {
+    const __m128i three {_mm_set1_epi16(3)};
+    const __m128i twoByteMask {_mm_set1_epi16(static_cast<short>(0xff80))};
+    const __m128i threeByteMask {_mm_set1_epi16(static_cast<short>(0xf800))};
+    const __m128i surrogateBits {_mm_set1_epi16(static_cast<short>(surrogateMask))};
+    const __m128i lead {_mm_set1_epi16(static_cast<short>(leadSurrogateMin))};
+    const __m128i trail {_mm_set1_epi16(static_cast<short>(trailSurrogateMin))};
+    const __m128i zero {_mm_setzero_si128()};
+    const __m128i ones {_mm_set1_epi16(1)};
+    constexpr size_t flushInterval {4096};
+
+    size_t bytes {0};
+    size_t i {0};
+
+    // Each block also reads the first code unit of the next
+    while (i + 9 <= length) {
+      __m128i counts {zero};
+
+      for (size_t n = 0; n < flushInterval && i + 9 <= length; n++, i += 8) {
+        __m128i units {_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i))};
+        __m128i next {_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 1))};
+
+        __m128i isASCII {_mm_cmpeq_epi16(_mm_and_si128(units, twoByteMask), zero)};
+        __m128i isTwoByte {_mm_cmpeq_epi16(_mm_and_si128(units, threeByteMask), zero)};
+        __m128i isPair {_mm_and_si128(_mm_cmpeq_epi16(_mm_and_si128(units, surrogateBits), lead),
+                                      _mm_cmpeq_epi16(_mm_and_si128(next, surrogateBits), trail))};
+
+        counts = _mm_add_epi16(counts, _mm_add_epi16(three, _mm_add_epi16(isASCII, isTwoByte)));
+        counts = _mm_add_epi16(counts, _mm_add_epi16(isPair, isPair));
+      }
+
+      // Sum the lanes in 32 bits
+      int32_t sums[4];
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(sums), _mm_madd_epi16(counts, ones));
+      bytes += static_cast<size_t>(sums[0]) + static_cast<size_t>(sums[1]) + static_cast<size_t>(sums[2]) +
+               static_cast<size_t>(sums[3]);
+    }
+
+    // A pair straddling the boundary has already had the 2 byte reduction applied, so the trail still counts 3
+    return bytes + scalarUTF8Length(source + i, length - i);
+  }
+
+
+  __attribute__((target("avx2")))
+  size_t avx2WidenASCII(const unsigned char* source, size_t length, char16_t* dest) {
+    size_t i {0};
+    for (; i + 32 <= length; i += 32) {
+      __m256i block {_mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i))};
+
+      if (_mm256_movemask_epi8(block)) {
+        break;
+      }
+
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i), _mm256_cvtepu8_epi16(_mm256_castsi256_si128(block)));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i + 16),
+                          _mm256_cvtepu8_epi16(_mm256_extracti128_si256(block, 1)));
+    }
+
+    return i + scalarWidenASCII(source + i, length - i, dest + i);
+  }
+
+
+  __attribute__((target("avx2")))
+  size_t avx2CopyASCII(const unsigned char* source, size_t length, unsigned char* dest) {
+    size_t i {0};
+    for (; i + 32 <= length; i += 32) {
+      __m256i block {_mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i))};
+
+      if (_mm256_movemask_epi8(block)) {
+        break;
+      }
+
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i), block);
+    }
+
+    return i + scalarCopyASCII(source + i, length - i, dest + i);
+  }
+
+
+  __attribute__((target("avx2")))
+  size_t avx2NarrowASCII(const char16_t* source, size_t length, unsigned char* dest) {
+    const __m256i nonASCII {_mm256_set1_epi16(static_cast<short>(0xff80))};
+
+    size_t i {0};
+    for (; i + 32 <= length; i += 32) {
+      __m256i low {_mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i))};
+      __m256i high {_mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i + 16))};
+
+      if (!_mm256_testz_si256(_mm256_or_si256(low, high), nonASCII)) {
+        break;
+      }
+
+      // packus works within 128-bit lanes, so the 64-bit quarters need reordering afterwards
+      __m256i packed {_mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0xd8)};
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i), packed);
+    }
+
+    return i + scalarNarrowASCII(source + i, length - i, dest + i);
+  }
+
+
+  __attribute__((target("avx2,popcnt")))
+  size_t avx2CountNonASCII(const unsigned char* source, size_t length) {
+    size_t count {0};
+    size_t i {0};
+
+    for (; i + 32 <= length; i += 32) {
+      __m256i block {_mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i))};
+      count += static_cast<size_t>(__builtin_popcount(static_cast<unsigned int>(_mm256_movemask_epi8(block))));
+    }
+
+    return count + scalarCountNonASCII(source + i, length - i);
+  }
+
+
+  const EncodingFunctions sse2Functions {sse2WidenASCII, sse2CopyASCII, sse2NarrowASCII, sse2CountNonASCII,
+                                         sse2UTF8Length};
+
+
+  // The UTF-16 length computation is dominated by the pair check, and gains little from wider vectors
+  const EncodingFunctions avx2Functions {avx2WidenASCII, avx2CopyASCII, avx2NarrowASCII, avx2CountNonASCII,
+                                         sse2UTF8Length};
+  #endif
+
+
+  bool isSupported(EncodingImplementation impl) {
+    switch (impl) {
+      case EncodingImplementation::Scalar:
+        return true;
+
+      #ifdef V8MONKEY_X86_SIMD
+      case EncodingImplementation::SSE2:
+        return true;
+
+      case EncodingImplementation::AVX2:
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+      #else
+      case EncodingImplementation::SSE2:
+      case EncodingImplementation::AVX2:
+        return false;
+      #endif
+
+      default:
+        return false;
+    }
+  }
+
+
+  const EncodingFunctions* functionsFor(EncodingImplementation impl) {
+    switch (impl) {
+      #ifdef V8MONKEY_X86_SIMD
+      case EncodingImplementation::SSE2:
+        return &sse2Functions;
+
+      case EncodingImplementation::AVX2:
+        return &avx2Functions;
+      #else
+      case EncodingImplementation::SSE2:
+      case EncodingImplementation::AVX2:
+      #endif
+      case EncodingImplementation::Scalar:
+      default:
+        return &scalarFunctions;
+    }
+  }
+
+
+  const EncodingFunctions* bestImplementation() {
+    if (isSupported(EncodingImplementation::AVX2)) {
+      return functionsFor(EncodingImplementation::AVX2);
+    }
+
+    if (isSupported(EncodingImplementation::SSE2)) {
+      return functionsFor(EncodingImplementation::SSE2);
+    }
+
+    return functionsFor(EncodingImplementation::Scalar);
+  }
+
+
+  // The implementation in use, chosen on first use
+  std::atomic<const EncodingFunctions*> encodingImplementation {nullptr};
+
+
+  // The number of code units in a sequence with the given leading code unit, or 0 if it cannot lead a sequence
+  size_t sequenceLength(unsigned char lead) {
+    if (lead < 0xc2u || lead > 0xf4u) {
+      return 0;
+    }
+
+    return lead < 0xe0u ? 2 : (lead < 0xf0u ? 3 : 4);
+  }
+
+
+  // Can c appear at the given position of a well-formed sequence with the given leading code unit?
+  bool continuesSequence(unsigned char lead, size_t position, unsigned char c) {
+    if ((c & 0xc0u) != 0x80u) {
+      return false;
+    }
+
+    // As in EncodeToUTF16, the second code unit rules out overlong forms, surrogates and code points beyond U+10FFFF
+    if (position == 1) {
+      switch (lead) {
+        case 0xe0u:
+          return c >= 0xa0u;
+        case 0xedu:
+          return c < 0xa0u;
+        case 0xf0u:
+          return c >= 0x90u;
+        case 0xf4u:
+          return c < 0x90u;
+        default:
+          return true;
+      }
+    }
+
+    return true;
+  }
+
+
+  /*
+   * Returns the start of a well-formed but incomplete sequence at the end of [begin, end), or end if there is none.
+   * Such a sequence can only begin with one of the last three code units.
+   *
+   */
+
+  const unsigned char* incompleteTail(const unsigned char* begin, const unsigned char* end) {
+    for (size_t back = 1; back <= 3 && back <= static_cast<size_t>(end - begin); back++) {
+      const unsigned char* lead {end - back};
+
+      if ((*lead & 0xc0u) == 0x80u) {
+        continue;
+      }
+
+      // Only the nearest non-continuation code unit can begin the tail
+      if (sequenceLength(*lead) <= back) {
+        return end;
+      }
+
+      for (size_t i = 1; i < back; i++) {
+        if (!continuesSequence(*lead, i, lead[i])) {
+          return end;
+        }
+      }
+
+      return lead;
+    }
+
+    return end;
+  }
+
+
+  const EncodingFunctions* getEncodingImplementation() {
+    const EncodingFunctions* fns {encodingImplementation.load(std::memory_order_relaxed)};
+
+    if (!fns) {
+      fns = bestImplementation();
+      encodingImplementation.store(fns, std::memory_order_relaxed);
+    }
+
+    return fns;
+  }
+
+}
+
+
+namespace v8 {
+  namespace V8Monkey {
+    namespace UTF8 {
+      size_t WidenASCII(const unsigned char* source, size_t length, char16_t* dest) {
+        return getEncodingImplementation()->widen(source, length, dest);
+      }
+
+
+      size_t CopyASCII(const unsigned char* source, size_t length, unsigned char* dest) {
+        return getEncodingImplementation()->copy(source, length, dest);
+      }
+
+
+      size_t NarrowASCII(const char16_t* source, size_t length, unsigned char* dest) {
+        return getEncodingImplementation()->narrow(source, length, dest);
+      }
+
+
+      size_t UTF8Length(const unsigned char* source, size_t length) {
+        // Everything outside ASCII needs 2 bytes
+        return length + getEncodingImplementation()->countNonASCII(source, length);
+      }
+
+
+      size_t UTF8Length(const char16_t* source, size_t length) {
+        return getEncodingImplementation()->utf8Length(source, length);
+      }
+
+
+      UTF8Written EncodeToUTF8(const unsigned char* source, size_t length, char* dest, size_t capacity) {
+        unsigned char* out {reinterpret_cast<unsigned char*>(dest)};
+        size_t read {0};
+        size_t written {0};
+
+        while (read < length && written < capacity) {
+          size_t run {CopyASCII(source + read, std::min(length - read, capacity - written), out + written)};
+          read += run;
+          written += run;
+
+          if (read == length || written == capacity) {
+            break;
+          }
+
+          // The run ended at a non-ASCII code unit
+          if (capacity - written < 2) {
+            break;
+          }
+
+          unsigned char c {source[read++]};
+          out[written++] = static_cast<unsigned char>(0xc0u | (c >> 6));
+          out[written++] = static_cast<unsigned char>(0x80u | (c & 0x3fu));
+        }
+
+        return {written, read};
+      }
+
+
+      UTF8Written EncodeToUTF8(const char16_t* source, size_t length, char* dest, size_t capacity,
+                               bool replaceInvalid) {
+        unsigned char* out {reinterpret_cast<unsigned char*>(dest)};
+        size_t read {0};
+        size_t written {0};
+
+        while (read < length && written < capacity) {
+          size_t run {NarrowASCII(source + read, std::min(length - read, capacity - written), out + written)};
+          read += run;
+          written += run;
+
+          if (read == length || written == capacity) {
+            break;
+          }
+
+          size_t available {capacity - written};
+          char16_t c {source[read]};
+
+          if (c < 0x800u) {
+            if (available < 2) {
+              break;
+            }
+
+            out[written++] = static_cast<unsigned char>(0xc0u | (c >> 6));
+            out[written++] = static_cast<unsigned char>(0x80u | (c & 0x3fu));
+            read++;
+            continue;
+          }
+
+          if (isLeadSurrogate(c) && read + 1 < length && isTrailSurrogate(source[read + 1])) {
+            // Never split a pair
+            if (available < 4) {
+              break;
+            }
+
+            char32_t codePoint {0x10000u + ((static_cast<char32_t>(c) - leadSurrogateMin) << 10) +
+                                (static_cast<char32_t>(source[read + 1]) - trailSurrogateMin)};
+            out[written++] = static_cast<unsigned char>(0xf0u | (codePoint >> 18));
+            out[written++] = static_cast<unsigned char>(0x80u | ((codePoint >> 12) & 0x3fu));
+            out[written++] = static_cast<unsigned char>(0x80u | ((codePoint >> 6) & 0x3fu));
+            out[written++] = static_cast<unsigned char>(0x80u | (codePoint & 0x3fu));
+            read += 2;
+            continue;
+          }
+
+          if (available < 3) {
+            break;
+          }
+
+          // Lone surrogates are encoded as-is unless the caller asked for them to be replaced, as in V8
+          if (replaceInvalid && (c & 0xf800u) == leadSurrogateMin) {
+            c = replacementChar;
+          }
+
+          out[written++] = static_cast<unsigned char>(0xe0u | (c >> 12));
+          out[written++] = static_cast<unsigned char>(0x80u | ((c >> 6) & 0x3fu));
+          out[written++] = static_cast<unsigned char>(0x80u | (c & 0x3fu));
+          read++;
+        }
+
+        return {written, read};
+      }
+
+
+      void StreamDecoder::Append(const char* data, size_t length) {
+        const unsigned char* in {reinterpret_cast<const unsigned char*>(data)};
+        const unsigned char* end {in + length};
+
+        // Each code unit, including those held back, yields at most one UTF-16 code unit
+        size_t used {output.size()};
+        output.resize(used + pendingCount + length);
+        char16_t* out {output.data() + used};
+
+        // Complete or abandon the sequence held back from the last chunk
+        while (pendingCount && in != end) {
+          if (!continuesSequence(pending[0], pendingCount, *in)) {
+            // As in EncodeToUTF16, each code unit of the abandoned sequence is replaced, and *in is considered afresh
+            out = std::fill_n(out, pendingCount, replacementChar);
+            pendingCount = 0;
+            break;
+          }
+
+          pending[pendingCount++] = *in++;
+          if (pendingCount == sequenceLength(pending[0])) {
+            out = UTF16Encoder<const unsigned char*>::encodeInto(pending, pending + pendingCount, out);
+            pendingCount = 0;
+          }
+        }
+
+        if (!pendingCount) {
+          const unsigned char* tail {incompleteTail(in, end)};
+          out = UTF16Encoder<const unsigned char*>::encodeInto(in, tail, out);
+
+          pendingCount = static_cast<size_t>(end - tail);
+          std::copy(tail, end, pending);
+        }
+
+        output.resize(static_cast<UTF16Encoded::size_type>(out - output.data()));
+      }
+
+
+      void StreamDecoder::Finish() {
+        output.insert(output.end(), pendingCount, replacementChar);
+        pendingCount = 0;
+      }
+
+
+      void StreamDecoder::Reset() {
+        output.clear();
+        pendingCount = 0;
+      }
+
+
+      #ifdef V8MONKEY_INTERNAL_TEST
+      bool ForceEncodingImplementation(EncodingImplementation impl) {
+        if (!isSupported(impl)) {
+          return false;
+        }
+
+        encodingImplementation.store(functionsFor(impl), std::memory_order_relaxed);
+        return true;
+      }
+
+
+      void ResetEncodingImplementation() {
+        encodingImplementation.store(bestImplementation(), std::memory_order_relaxed);
+      }
+      #endif
+    }
+  }
+}
@@ -1,30 +1,109 @@
-/*
 #ifndef V8MONKEY_ENCODING_H
 #define V8MONKEY_ENCODING_H
 
 // std::transform
 #include <algorithm>
 
-// begin, end, distance, iterator_traits
+// size_t
+#include <cstddef>
+
+// advance, begin, end, distance, iterator_traits
 #include <iterator>
 
+// string
+#include <string>
+
+// integral_constant, is_pointer, is_same
+#include <type_traits>
+
 // vector
 #include <vector>
 
+// EXPORT_FOR_TESTING_ONLY
+#include "utils/test.h"
+
 
 namespace v8 {
   // XXX Move out of V8Monkey namespace ?
   namespace V8Monkey {
     namespace UTF8 {
       using UTF16Encoded = std::vector<char16_t>;
+      using Latin1Encoded = std::vector<unsigned char>;
 
       constexpr char16_t replacementChar {0xfffdu};
       constexpr unsigned int continuationMask {0x3fu};
 
 
+      /*
+       * Widen the leading run of ASCII code units in source into dest, stopping at the first non-ASCII code unit or
+       * after length code units, whichever comes first. Returns the number of code units widened. dest must have room
+       * for length code units.
+       *
+       * Where the CPU supports it, this uses SSE2 or AVX2 to check and widen 16 or 32 code units at a time.
+       *
+       */
+
+      EXPORT_FOR_TESTING_ONLY size_t WidenASCII(const unsigned char* source, size_t length, char16_t* dest);
+
+
+      // As WidenASCII, but copying the run into a one-byte destination
+      EXPORT_FOR_TESTING_ONLY size_t CopyASCII(const unsigned char* source, size_t length, unsigned char* dest);
+
+
+      // As WidenASCII, but narrowing a run of UTF-16 ASCII code units into a one-byte destination
+      EXPORT_FOR_TESTING_ONLY size_t NarrowASCII(const char16_t* source, size_t length, unsigned char* dest);
+
+
+      /*
+       * Return the number of bytes required to encode the given Latin1 or UTF-16 code units as UTF-8. Well-formed
+       * surrogate pairs need 4 bytes; lone surrogates need 3, whether they are encoded as-is or replaced.
+       *
+       */
+
+      EXPORT_FOR_TESTING_ONLY size_t UTF8Length(const unsigned char* source, size_t length);
+      EXPORT_FOR_TESTING_ONLY size_t UTF8Length(const char16_t* source, size_t length);
+
+
+      struct UTF8Written {
+        size_t bytes;
+        size_t codeUnits;
+      };
+
+
+      /*
+       * Encode the given Latin1 or UTF-16 code units as UTF-8, writing at most capacity bytes. Encoding stops at the
+       * first code-point that would not fit: partial sequences and halves of surrogate pairs are never written.
+       * Returns the number of bytes written, and the number of code units consumed. No terminator is written.
+       *
+       * Lone surrogates are encoded as if they were code-points, unless replaceInvalid is true, in which case they
+       * are replaced by the replacement character.
+       *
+       */
+
+      EXPORT_FOR_TESTING_ONLY UTF8Written EncodeToUTF8(const unsigned char* source, size_t length, char* dest,
+                                                       size_t capacity);
+      EXPORT_FOR_TESTING_ONLY UTF8Written EncodeToUTF8(const char16_t* source, size_t length, char* dest,
+                                                       size_t capacity, bool replaceInvalid);
+
+
+      /*
+       * The implementations available for the vectorised routines above. Tests can force a particular implementation
+       * to ensure each is exercised regardless of the host CPU. Requesting an implementation the CPU does not support
+       * has no effect, and returns false.
+       *
+       */
+
+      enum class EncodingImplementation {Scalar, SSE2, AVX2};
+
+      #ifdef V8MONKEY_INTERNAL_TEST
+      EXPORT_FOR_TESTING_ONLY bool ForceEncodingImplementation(EncodingImplementation impl);
+      EXPORT_FOR_TESTING_ONLY void ResetEncodingImplementation();
+      #endif
+
+
       // TODO: Can we hide this implementation detail from includers?
-      void utf8toSurrogatePair(const unsigned char c1, const unsigned char c2,
-                               const unsigned char c3, const unsigned char c4, UTF16Encoded& dest) {
+      inline char16_t* utf8toSurrogatePair(const unsigned char c1, const unsigned char c2,
+                                           const unsigned char c3, const unsigned char c4, char16_t* dest) {
         auto ls_bottom6 = c4 & continuationMask;
         auto ls_top4 = (c3 & 0x0fu) << 6;
         auto ls_base = ls_bottom6 | ls_top4;
@@ -39,8 +118,9 @@ namespace v8 {
         auto ls_modifier = 0xdc00u;
         auto hs_modifier = 0xd800u;
 
-        dest.emplace_back(static_cast<char16_t>(hs_modifier + hs_base));
-        dest.emplace_back(static_cast<char16_t>(ls_modifier + ls_base));
+        *dest++ = static_cast<char16_t>(hs_modifier + hs_base);
+        *dest++ = static_cast<char16_t>(ls_modifier + ls_base);
+        return dest;
       }
 
 
@@ -56,6 +136,53 @@ namespace v8 {
       }
 
 
+      /*
+       * Iterators over single-byte code units whose storage is known to be contiguous, and hence can be handed to
+       * WidenASCII or CopyASCII as a pointer. C++11 has no way of asking this of an arbitrary iterator, so we recognise pointers,
+       * and the iterators of the standard containers we are likely to be passed.
+       *
+       */
+
+      template <typename T, typename U = typename std::iterator_traits<T>::value_type>
+      struct IsContiguousByteIterator : std::integral_constant<bool, sizeof(U) == 1 &&
+        (std::is_pointer<T>::value ||
+         std::is_same<T, typename std::vector<U>::iterator>::value ||
+         std::is_same<T, typename std::vector<U>::const_iterator>::value ||
+         std::is_same<T, std::string::iterator>::value ||
+         std::is_same<T, std::string::const_iterator>::value)> {};
+
+
+      // Widen the ASCII run starting at it, returning its length. it must not equal end.
+      template <typename T>
+      size_t widenASCIIRun(T it, T end, char16_t* dest, std::true_type) {
+        return WidenASCII(reinterpret_cast<const unsigned char*>(&*it), static_cast<size_t>(std::distance(it, end)),
+                          dest);
+      }
+
+
+      // Iterators that are not known to be contiguous just widen the code unit at it
+      template <typename T>
+      size_t widenASCIIRun(T it, T, char16_t* dest, std::false_type) {
+        *dest = static_cast<char16_t>(static_cast<unsigned char>(*it));
+        return 1;
+      }
+
+
+      // Copy the ASCII run starting at it, returning its length. it must not equal end.
+      template <typename T>
+      size_t copyASCIIRun(T it, T end, unsigned char* dest, std::true_type) {
+        return CopyASCII(reinterpret_cast<const unsigned char*>(&*it), static_cast<size_t>(std::distance(it, end)),
+                         dest);
+      }
+
+
+      template <typename T>
+      size_t copyASCIIRun(T it, T, unsigned char* dest, std::false_type) {
+        *dest = static_cast<unsigned char>(*it);
+        return 1;
+      }
+
+
       // TODO: Can we hide this implementation detail from includers?
       template <typename T, typename U = typename std::iterator_traits<T>::value_type, bool isTwoByte = sizeof(U) == 2>
       struct UTF16Encoder;
@@ -91,30 +218,46 @@ namespace v8 {
 
           bool needsTerminatingZeroAdded { *(end - 1) != 0x00u };
 
-          UTF16Encoded result {};
-          // We have an upper bound on the possible size of the result
+          // We have an upper bound on the possible size of the result, so write directly into a buffer of that size
           UTF16Encoded::size_type numberOfCodeUnits = static_cast<UTF16Encoded::size_type>(std::distance(begin, end));
-          result.reserve(numberOfCodeUnits + (needsTerminatingZeroAdded ? 1 : 0));
+          UTF16Encoded result(numberOfCodeUnits + (needsTerminatingZeroAdded ? 1 : 0));
+          char16_t* out {encodeInto(begin, end, result.data())};
+
+          if (needsTerminatingZeroAdded) {
+            *out++ = 0x0000;
+          }
+
+          // We used the worst-case bound when sizing the buffer
+          result.resize(static_cast<UTF16Encoded::size_type>(out - result.data()));
+          result.shrink_to_fit();
+          return result;
+        }
+
 
+        // Encode [begin, end) into out, which must have room for one code unit per input code unit. Returns a pointer
+        // one past the last code unit written.
+        static char16_t* encodeInto(T begin, T end, char16_t* out) {
           for (auto it = begin; it != end; ++it) {
             unsigned char c {static_cast<unsigned char>(*it)};
 
-            // ASCII can be copied as-is
+            // ASCII can be copied as-is. Text is overwhelmingly likely to be ASCII, so widen the whole run at once.
             if (!(c & 0x80u)) {
-              result.emplace_back(static_cast<char16_t>(c));
+              size_t run {widenASCIIRun(it, end, out, IsContiguousByteIterator<T> {})};
+              out += run;
+              std::advance(it, static_cast<typename std::iterator_traits<T>::difference_type>(run - 1));
               continue;
             }
 
             // At this point, we know that c >= 0x80
             if (!(c & 0x40u)) {
-              result.emplace_back(replacementChar);
+              *out++ = replacementChar;
               continue;
             }
 
             // We have now established that the code-unit is not a continuation code-unit. Next we check for invalid leading
             // values that are independent of later code-units
             if (c < 0xc2u || c > 0xf4u) {
-              result.emplace_back(replacementChar);
+              *out++ = replacementChar;
               continue;
             }
 
@@ -123,7 +266,7 @@ namespace v8 {
             //       valid continuation code-unit: we'll encode it on the next pass
             auto next = it + 1;
             if (next == end || (*next & 0xc0) != 0x80) {
-              result.emplace_back(replacementChar);
+              *out++ = replacementChar;
               continue;
             }
 
@@ -132,20 +275,20 @@ namespace v8 {
             // We can now weed out any ill-formed encodings based on the second code-unit.
             if ((c == 0xe0u && c2 < 0xa0u) || (c == 0xedu && !(c2 < 0xa0u)) ||
                 (c == 0xf0u && c2 < 0x90u) || (c == 0xf4u && !(c2 < 0x90u))) {
-              result.emplace_back(replacementChar);
+              *out++ = replacementChar;
               continue;
             }
 
             if (c < 0xe0u) {
               it = next;
-              result.emplace_back(((c & 0x1fu) << 6) | (c2 & continuationMask));
+              *out++ = static_cast<char16_t>(((c & 0x1fu) << 6) | (c2 & continuationMask));
               continue;
             }
 
             // Having reached this point, we have a code-point encoded in 3 or 4 code-units
             ++next;
             if (next == end || (*next & 0xc0) != 0x80) {
-              result.emplace_back(replacementChar);
+              *out++ = replacementChar;
               continue;
             }
 
@@ -153,14 +296,15 @@ namespace v8 {
 
             if (c < 0xf0u) {
               it = next;
-              result.emplace_back(((c & 0xfu) << 12) | ((c2 & continuationMask) << 6) | (c3 & continuationMask));
+              *out++ = static_cast<char16_t>(((c & 0xfu) << 12) | ((c2 & continuationMask) << 6) |
+                                             (c3 & continuationMask));
               continue;
             }
 
             // We must have a code-point encoded in 4 code-units
             ++next;
             if (next == end || (*next & 0xc0) != 0x80) {
-              result.emplace_back(replacementChar);
+              *out++ = replacementChar;
               continue;
             }
 
@@ -168,28 +312,222 @@ namespace v8 {
             it = next;
 
             // Transform to a surrogate pair
-            utf8toSurrogatePair(c, c2, c3, c4, result);
+            out = utf8toSurrogatePair(c, c2, c3, c4, out);
           }
 
-          if (needsTerminatingZeroAdded) {
-            result.emplace_back(0x0000);
+          return out;
+        }
+      };
+
+
+      /*
+       * The result of encoding a string in the narrowest representation SpiderMonkey supports. Exactly one of the two
+       * encodings is populated, as indicated by isOneByte. Unlike EncodeToUTF16, no terminating zero is added: the
+       * results are intended for length-based consumers.
+       *
+       */
+
+      struct NarrowestEncoded {
+        bool isOneByte;
+        Latin1Encoded oneByte;
+        UTF16Encoded twoByte;
+      };
+
+
+      // The result of encoding into caller-supplied buffers: which buffer was used, and how much of it
+      struct NarrowestWritten {
+        bool isOneByte;
+        size_t length;
+      };
+
+
+      // TODO: Can we hide this implementation detail from includers?
+      template <typename T, typename U = typename std::iterator_traits<T>::value_type, bool isTwoByte = sizeof(U) == 2>
+      struct NarrowestEncoder;
+
+
+      /*
+       * Both specializations split the work in two: encodeLatin1Prefix encodes into out for as long as the input is
+       * representable in Latin1, returning the position at which it stopped, and encodeRemainder encodes the rest as
+       * UTF-16. Each writes at most one code unit per input code unit.
+       *
+       */
+
+      template <typename T, typename U> struct NarrowestEncoder<T, U, true> {
+        static T encodeLatin1Prefix(T begin, T end, unsigned char*& out) {
+          for (auto it = begin; it != end; ++it) {
+            if (*it > 0xffu) {
+              return it;
+            }
+
+            *out++ = static_cast<unsigned char>(*it);
           }
 
-          // We used the worst-case bound when reserving space
-          result.shrink_to_fit();
-          return result;
+          return end;
+        }
+
+
+        static char16_t* encodeRemainder(T begin, T end, char16_t* out) {
+          return std::copy(begin, end, out);
+        }
+      };
+
+
+      template <typename T, typename U> struct NarrowestEncoder<T, U, false> {
+        static T encodeLatin1Prefix(T begin, T end, unsigned char*& out) {
+          for (auto it = begin; it != end; ++it) {
+            unsigned char c {static_cast<unsigned char>(*it)};
+
+            if (!(c & 0x80u)) {
+              size_t run {copyASCIIRun(it, end, out, IsContiguousByteIterator<T> {})};
+              out += run;
+              std::advance(it, static_cast<typename std::iterator_traits<T>::difference_type>(run - 1));
+              continue;
+            }
+
+            // The non-ASCII portion of Latin1 is encoded in 2 code-units, with a leading code-unit of 0xc2 or 0xc3
+            auto next = it + 1;
+            if ((c == 0xc2u || c == 0xc3u) && next != end && (*next & 0xc0) == 0x80) {
+              unsigned char c2 {static_cast<unsigned char>(*next)};
+              *out++ = static_cast<unsigned char>(((c & 0x1fu) << 6) | (c2 & continuationMask));
+              it = next;
+              continue;
+            }
+
+            // Anything else either encodes a code-point outside Latin1, or is ill-formed and so will be replaced by
+            // the replacement character, which is itself outside Latin1
+            return it;
+          }
+
+          return end;
+        }
+
+
+        static char16_t* encodeRemainder(T begin, T end, char16_t* out) {
+          return UTF16Encoder<T>::encodeInto(begin, end, out);
         }
       };
 
 
+      template <typename T>
+      NarrowestEncoded encodeNarrowest(T begin, T end) {
+        NarrowestEncoded result {true, {}, {}};
+        if (isDegenerate(begin, end)) {
+          return result;
+        }
+
+        // The number of code units is an upper bound on the size of either result
+        size_t numberOfCodeUnits {static_cast<size_t>(std::distance(begin, end))};
+        result.oneByte.resize(numberOfCodeUnits);
+        unsigned char* out {result.oneByte.data()};
+
+        T it {NarrowestEncoder<T>::encodeLatin1Prefix(begin, end, out)};
+        size_t written {static_cast<size_t>(out - result.oneByte.data())};
+
+        if (it == end) {
+          result.oneByte.resize(written);
+          result.oneByte.shrink_to_fit();
+          return result;
+        }
+
+        // We need two bytes: widen what we have encoded so far, and encode the remainder. Note that we never revisit
+        // the input already consumed.
+        result.twoByte.resize(written + static_cast<size_t>(std::distance(it, end)));
+        std::copy(result.oneByte.data(), out, result.twoByte.begin());
+
+        char16_t* out16 {NarrowestEncoder<T>::encodeRemainder(it, end, result.twoByte.data() + written)};
+        result.twoByte.resize(static_cast<UTF16Encoded::size_type>(out16 - result.twoByte.data()));
+        result.twoByte.shrink_to_fit();
+
+        result.isOneByte = false;
+        Latin1Encoded {}.swap(result.oneByte);
+        return result;
+      }
+
+
       template <typename T>
       UTF16Encoded EncodeToUTF16(T begin, T end) {
         return UTF16Encoder<T>::encode(begin, end);
       }
+
+
+      /*
+       * Encode the given UTF-8 or UTF-16 code units in a single pass, producing Latin1 if every code-point is
+       * representable in Latin1, and UTF-16 otherwise. Ill-formed UTF-8 is handled as in EncodeToUTF16.
+       *
+       * SpiderMonkey stores Latin1 strings natively, so this avoids doubling the size of the overwhelming majority of
+       * strings, which are ASCII.
+       *
+       */
+
+      template <typename T>
+      NarrowestEncoded EncodeToNarrowest(T begin, T end) {
+        return encodeNarrowest(begin, end);
+      }
+
+
+      /*
+       * As EncodeToNarrowest, but encoding into caller-supplied buffers, each of which must have room for one code unit
+       * per input code unit. Callers with short input can thus avoid allocating at all.
+       *
+       */
+
+      template <typename T>
+      NarrowestWritten EncodeToNarrowestInto(T begin, T end, unsigned char* oneByte, char16_t* twoByte) {
+        if (isDegenerate(begin, end)) {
+          return {true, 0};
+        }
+
+        unsigned char* out {oneByte};
+        T it {NarrowestEncoder<T>::encodeLatin1Prefix(begin, end, out)};
+        if (it == end) {
+          return {true, static_cast<size_t>(out - oneByte)};
+        }
+
+        char16_t* out16 {std::copy(oneByte, out, twoByte)};
+        out16 = NarrowestEncoder<T>::encodeRemainder(it, end, out16);
+        return {false, static_cast<size_t>(out16 - twoByte)};
+      }
+
+
+      /*
+       * Decodes UTF-8 that arrives in arbitrarily split chunks, such as a network body. A multi-byte sequence split
+       * between chunks is held back until the rest of it arrives, so the output is exactly that of EncodeToUTF16 on
+       * the concatenated input (less the terminator), including the treatment of ill-formed input.
+       *
+       */
+
+      class EXPORT_FOR_TESTING_ONLY StreamDecoder {
+        public:
+          StreamDecoder() = default;
+          ~StreamDecoder() = default;
+
+          // Decode the given chunk, appending the result to the output
+          void Append(const char* data, size_t length);
+
+          // Signal the end of the input. An incomplete sequence at the end is replaced, as in EncodeToUTF16.
+          void Finish();
+
+          // Discard the output and any incomplete sequence, ready for new input
+          void Reset();
+
+          const UTF16Encoded& Output() const { return output; }
+
+          StreamDecoder(const StreamDecoder& other) = delete;
+          StreamDecoder(StreamDecoder&& other) = delete;
+          StreamDecoder& operator=(const StreamDecoder& other) = delete;
+          StreamDecoder& operator=(StreamDecoder&& other) = delete;
+
+        private:
+          UTF16Encoded output {};
+
+          // The well-formed prefix of a sequence left incomplete at the end of the last chunk
+          unsigned char pending[4] {};
+          size_t pendingCount {0};
+      };
     }
   }
 }
 
 
 #endif
-*/
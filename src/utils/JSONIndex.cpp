@@ -0,0 +1,438 @@
+// copy, fill_n
+#include <algorithm>
+
+// atomic
+#include <atomic>
+
+// uint64_t
+#include <cstdint>
+
+// numeric_limits
+#include <limits>
+
+// Function definitions
+#include "utils/JSONIndex.h"
+
+#if defined(__SSE2__) && (defined(__x86_64__) || defined(__i386__))
+  #define V8MONKEY_X86_SIMD 1
+
+  // SSE2 / AVX2 intrinsics
+  #include <immintrin.h>
+#endif
+
+
+/*
+ * Each block of 64 code units is first classified, producing a bitmask for each interesting kind of code unit. For
+ * UTF-16 text, the block is first narrowed to bytes: every code unit of interest is ASCII, so anything beyond Latin1
+ * can be saturated to a byte of no interest. The masks are then combined to find the structurals, carrying just enough
+ * state from one block to the next to handle strings and backslash runs that straddle a block boundary.
+ *
+ */
+
+namespace {
+  using namespace v8::V8Monkey;
+
+  constexpr size_t blockSize {64};
+
+
+  // Bit i of each mask describes code unit i of a block
+  struct BlockMasks {
+    uint64_t quote;
+    uint64_t backslash;
+    uint64_t op;
+    uint64_t whitespace;
+  };
+
+
+  // The routines for a particular implementation are always chosen together
+  struct IndexFunctions {
+    void (*classify)(const unsigned char*, BlockMasks&);
+    void (*narrow)(const char16_t*, unsigned char*);
+  };
+
+
+  void scalarClassify(const unsigned char* block, BlockMasks& masks) {
+    masks = BlockMasks {0, 0, 0, 0};
+
+    for (size_t i = 0; i < blockSize; i++) {
+      uint64_t bit {uint64_t {1} << i};
+
+      switch (block[i]) {
+        case '"':
+          masks.quote |= bit;
+          break;
+
+        case '\\':
+          masks.backslash |= bit;
+          break;
+
+        case '{':
+        case '}':
+        case '[':
+        case ']':
+        case ':':
+        case ',':
+          masks.op |= bit;
+          break;
+
+        case ' ':
+        case '\t':
+        case '\n':
+        case '\r':
+          masks.whitespace |= bit;
+          break;
+
+        default:
+          break;
+      }
+    }
+  }
+
+
+  void scalarNarrow(const char16_t* source, unsigned char* dest) {
+    for (size_t i = 0; i < blockSize; i++) {
+      dest[i] = source[i] > 0xffu ? 0xffu : static_cast<unsigned char>(source[i]);
+    }
+  }
+
+
+  const IndexFunctions scalarFunctions {scalarClassify, scalarNarrow};
+
+
+  #ifdef V8MONKEY_X86_SIMD
+  inline uint64_t maskBits(int movemask, size_t shift) {
+    return static_cast<uint64_t>(static_cast<uint32_t>(movemask)) << shift;
+  }
+
+
+  void sse2Classify(const unsigned char* block, BlockMasks& masks) {
+    const __m128i quote {_mm_set1_epi8('"')};
+    const __m128i backslash {_mm_set1_epi8('\\')};
+    const __m128i bit5 {_mm_set1_epi8(0x20)};
+    const __m128i openBrace {_mm_set1_epi8('{')};
+    const __m128i closeBrace {_mm_set1_epi8('}')};
+    const __m128i colon {_mm_set1_epi8(':')};
+    const __m128i comma {_mm_set1_epi8(',')};
+    const __m128i space {_mm_set1_epi8(' ')};
+    const __m128i tab {_mm_set1_epi8('\t')};
+    const __m128i lineFeed {_mm_set1_epi8('\n')};
+    const __m128i carriageReturn {_mm_set1_epi8('\r')};
+
+    masks = BlockMasks {0, 0, 0, 0};
+
+    for (size_t i = 0; i < blockSize; i += 16) {
+      __m128i units {_mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i))};
+
+      // Square brackets are braces with bit 5 clear
+      __m128i braces {_mm_or_si128(units, bit5)};
+      __m128i op {_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(braces, openBrace), _mm_cmpeq_epi8(braces, closeBrace)),
+                               _mm_or_si128(_mm_cmpeq_epi8(units, colon), _mm_cmpeq_epi8(units, comma)))};
+      __m128i whitespace {_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(units, space), _mm_cmpeq_epi8(units, tab)),
+                                       _mm_or_si128(_mm_cmpeq_epi8(units, lineFeed),
+                                                    _mm_cmpeq_epi8(units, carriageReturn)))};
+
+      masks.quote |= maskBits(_mm_movemask_epi8(_mm_cmpeq_epi8(units, quote)), i);
+      masks.backslash |= maskBits(_mm_movemask_epi8(_mm_cmpeq_epi8(units, backslash)), i);
+      masks.op |= maskBits(_mm_movemask_epi8(op), i);
+      masks.whitespace |= maskBits(_mm_movemask_epi8(whitespace), i);
+    }
+  }
+
+
+  // packus saturates code units beyond Latin1 to 0xff, or 0 for those with the top bit set: neither is of interest
+  void sse2Narrow(const char16_t* source, unsigned char* dest) {
+    for (size_t i = 0; i < blockSize; i += 16) {
+      __m128i low {_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i))};
+      __m128i high {_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 8))};
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), _mm_packus_epi16(low, high));
+    }
+  }
+
+
+  __attribute__((target("avx2")))
+  void avx2Classify(const unsigned char* block, BlockMasks& masks) {
+    const __m256i quote {_mm256_set1_epi8('"')};
+    const __m256i backslash {_mm256_set1_epi8('\\')};
+    const __m256i bit5 {_mm256_set1_epi8(0x20)};
+    const __m256i openBrace {_mm256_set1_epi8('{')};
+    const __m256i closeBrace {_mm256_set1_epi8('}')};
+    const __m256i colon {_mm256_set1_epi8(':')};
+    const __m256i comma {_mm256_set1_epi8(',')};
+    const __m256i space {_mm256_set1_epi8(' ')};
+    const __m256i tab {_mm256_set1_epi8('\t')};
+    const __m256i lineFeed {_mm256_set1_epi8('\n')};
+    const __m256i carriageReturn {_mm256_set1_epi8('\r')};
+
+    masks = BlockMasks {0, 0, 0, 0};
+
+    for (size_t i = 0; i < blockSize; i += 32) {
+      __m256i units {_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + i))};
+
+      __m256i braces {_mm256_or_si256(units, bit5)};
+      __m256i op {_mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(braces, openBrace),
+                                                  _mm256_cmpeq_epi8(braces, closeBrace)),
+                                  _mm256_or_si256(_mm256_cmpeq_epi8(units, colon), _mm256_cmpeq_epi8(units, comma)))};
+      __m256i whitespace {_mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(units, space),
+                                                          _mm256_cmpeq_epi8(units, tab)),
+                                          _mm256_or_si256(_mm256_cmpeq_epi8(units, lineFeed),
+                                                          _mm256_cmpeq_epi8(units, carriageReturn)))};
+
+      masks.quote |= maskBits(_mm256_movemask_epi8(_mm256_cmpeq_epi8(units, quote)), i);
+      masks.backslash |= maskBits(_mm256_movemask_epi8(_mm256_cmpeq_epi8(units, backslash)), i);
+      masks.op |= maskBits(_mm256_movemask_epi8(op), i);
+      masks.whitespace |= maskBits(_mm256_movemask_epi8(whitespace), i);
+    }
+  }
+
+
+  __attribute__((target("avx2")))
+  void avx2Narrow(const char16_t* source, unsigned char* dest) {
+    for (size_t i = 0; i < blockSize; i += 32) {
+      __m256i low {_mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i))};
+      __m256i high {_mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i + 16))};
+
+      // packus works within 128-bit lanes, so the 64-bit quarters need reordering afterwards
+      __m256i packed {_mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0xd8)};
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i), packed);
+    }
+  }
+
+
+  const IndexFunctions sse2Functions {sse2Classify, sse2Narrow};
+  const IndexFunctions avx2Functions {avx2Classify, avx2Narrow};
+  #endif
+
+
+  bool isSupported(UTF8::EncodingImplementation impl) {
+    switch (impl) {
+      case UTF8::EncodingImplementation::Scalar:
+        return true;
+
+      #ifdef V8MONKEY_X86_SIMD
+      case UTF8::EncodingImplementation::SSE2:
+        return true;
+
+      case UTF8::EncodingImplementation::AVX2:
+        return __builtin_cpu_supports("avx2");
+      #else
+      case UTF8::EncodingImplementation::SSE2:
+      case UTF8::EncodingImplementation::AVX2:
+        return false;
+      #endif
+
+      default:
+        return false;
+    }
+  }
+
+
+  const IndexFunctions* functionsFor(UTF8::EncodingImplementation impl) {
+    switch (impl) {
+      #ifdef V8MONKEY_X86_SIMD
+      case UTF8::EncodingImplementation::SSE2:
+        return &sse2Functions;
+
+      case UTF8::EncodingImplementation::AVX2:
+        return &avx2Functions;
+      #else
+      case UTF8::EncodingImplementation::SSE2:
+      case UTF8::EncodingImplementation::AVX2:
+      #endif
+      case UTF8::EncodingImplementation::Scalar:
+      default:
+        return &scalarFunctions;
+    }
+  }
+
+
+  const IndexFunctions* bestImplementation() {
+    if (isSupported(UTF8::EncodingImplementation::AVX2)) {
+      return functionsFor(UTF8::EncodingImplementation::AVX2);
+    }
+
+    if (isSupported(UTF8::EncodingImplementation::SSE2)) {
+      return functionsFor(UTF8::EncodingImplementation::SSE2);
+    }
+
+    return functionsFor(UTF8::EncodingImplementation::Scalar);
+  }
+
+
+  // The implementation in use, chosen on first use
+  std::atomic<const IndexFunctions*> indexImplementation {nullptr};
+
+
+  const IndexFunctions* getIndexImplementation() {
+    const IndexFunctions* fns {indexImplementation.load(std::memory_order_relaxed)};
+
+    if (!fns) {
+      fns = bestImplementation();
+      indexImplementation.store(fns, std::memory_order_relaxed);
+    }
+
+    return fns;
+  }
+
+
+  // What must be carried from one block to the next
+  struct ScanState {
+    // 1 if the block ended with an odd-length run of backslashes, escaping the first code unit of the next
+    uint64_t endsOddBackslash;
+
+    // All ones if the block ended inside a string
+    uint64_t inString;
+
+    // 1 if a scalar could begin at the first code unit of the next block
+    uint64_t endsBeforeScalar;
+  };
+
+
+  /*
+   * Find the code units escaped by a backslash: those immediately following an odd-length run of backslashes. Adding
+   * the start of each run to the backslash mask carries a bit to one past the end of the run; whether the run had odd
+   * length follows from the parity of its start and end positions.
+   *
+   */
+
+  uint64_t escapedUnits(uint64_t backslash, uint64_t& endsOddBackslash) {
+    constexpr uint64_t evenBits {0x5555555555555555u};
+    constexpr uint64_t oddBits {~evenBits};
+
+    uint64_t starts {backslash & ~(backslash << 1)};
+
+    // A run continuing from the previous block, whose first backslash here is escaped, has its parity flipped
+    uint64_t evenStartMask {evenBits ^ endsOddBackslash};
+    uint64_t evenStarts {starts & evenStartMask};
+    uint64_t oddStarts {starts & ~evenStartMask};
+
+    uint64_t evenCarries {backslash + evenStarts};
+    uint64_t oddCarries {backslash + oddStarts};
+
+    // Only a run with an odd start can reach bit 63 with odd length, so only its carry out needs recording
+    bool carriedOut {oddCarries < backslash};
+    oddCarries |= endsOddBackslash;
+    endsOddBackslash = carriedOut ? 1 : 0;
+
+    uint64_t evenStartOddEnd {evenCarries & ~backslash & oddBits};
+    uint64_t oddStartEvenEnd {oddCarries & ~backslash & evenBits};
+    return evenStartOddEnd | oddStartEvenEnd;
+  }
+
+
+  // Each bit of the result is the XOR of the corresponding bit of the argument, and all bits below it
+  uint64_t prefixXor(uint64_t bits) {
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+  }
+
+
+  uint64_t structuralsOf(const BlockMasks& masks, ScanState& state) {
+    uint64_t quotes {masks.quote & ~escapedUnits(masks.backslash, state.endsOddBackslash)};
+
+    // Set from each opening quote up to, but excluding, its closing quote
+    uint64_t inString {prefixXor(quotes) ^ state.inString};
+    state.inString = (inString >> 63) ? ~uint64_t {0} : 0;
+
+    uint64_t ops {masks.op & ~inString};
+
+    // Scalars start at any other code unit outside a string that follows an operator, a quote or whitespace
+    uint64_t predecessors {ops | quotes | masks.whitespace};
+    uint64_t follows {(predecessors << 1) | state.endsBeforeScalar};
+    state.endsBeforeScalar = predecessors >> 63;
+    uint64_t scalars {follows & ~(ops | quotes | masks.whitespace | inString)};
+
+    return ops | quotes | scalars;
+  }
+
+
+  void appendBits(std::vector<uint32_t>& index, size_t offset, uint64_t bits) {
+    size_t count {index.size()};
+    index.resize(count + static_cast<size_t>(__builtin_popcountll(bits)));
+
+    uint32_t* out {index.data() + count};
+    while (bits) {
+      *out++ = static_cast<uint32_t>(offset + static_cast<size_t>(__builtin_ctzll(bits)));
+      bits &= bits - 1;
+    }
+  }
+
+
+  const unsigned char* blockBytes(const IndexFunctions&, const unsigned char* block, unsigned char*) {
+    return block;
+  }
+
+
+  const unsigned char* blockBytes(const IndexFunctions& fns, const char16_t* block, unsigned char* scratch) {
+    fns.narrow(block, scratch);
+    return scratch;
+  }
+
+
+  template <typename T>
+  bool indexStructurals(const T* source, size_t length, std::vector<uint32_t>& index) {
+    index.clear();
+    if (length > std::numeric_limits<uint32_t>::max()) {
+      return false;
+    }
+
+    const IndexFunctions* fns {getIndexImplementation()};
+    ScanState state {0, 0, 1};
+    BlockMasks masks;
+    unsigned char scratch[blockSize];
+
+    size_t offset {0};
+    for (; offset + blockSize <= length; offset += blockSize) {
+      fns->classify(blockBytes(*fns, source + offset, scratch), masks);
+      appendBits(index, offset, structuralsOf(masks, state));
+    }
+
+    if (offset < length) {
+      // Whitespace is never structural, so makes ideal padding
+      T padded[blockSize];
+      std::fill_n(padded, blockSize, T {' '});
+      std::copy(source + offset, source + length, padded);
+      fns->classify(blockBytes(*fns, padded, scratch), masks);
+      appendBits(index, offset, structuralsOf(masks, state));
+    }
+
+    return !state.inString;
+  }
+}
+
+
+namespace v8 {
+  namespace V8Monkey {
+    namespace JSONIndex {
+      bool IndexStructurals(const unsigned char* source, size_t length, std::vector<uint32_t>& index) {
+        return indexStructurals(source, length, index);
+      }
+
+
+      bool IndexStructurals(const char16_t* source, size_t length, std::vector<uint32_t>& index) {
+        return indexStructurals(source, length, index);
+      }
+
+
+      #ifdef V8MONKEY_INTERNAL_TEST
+      bool ForceIndexImplementation(UTF8::EncodingImplementation impl) {
+        if (!isSupported(impl)) {
+          return false;
+        }
+
+        indexImplementation.store(functionsFor(impl), std::memory_order_relaxed);
+        return true;
+      }
+
+
+      void ResetIndexImplementation() {
+        indexImplementation.store(bestImplementation(), std::memory_order_relaxed);
+      }
+      #endif
+    }
+  }
+}
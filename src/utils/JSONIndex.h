@@ -0,0 +1,55 @@
+#ifndef V8MONKEY_JSONINDEX_H
+#define V8MONKEY_JSONINDEX_H
+
+// size_t
+#include <cstddef>
+
+// uint32_t
+#include <cstdint>
+
+// vector
+#include <vector>
+
+// EncodingImplementation
+#include "utils/Encoding.h"
+
+// EXPORT_FOR_TESTING_ONLY
+#include "utils/test.h"
+
+
+namespace v8 {
+  namespace V8Monkey {
+    namespace JSONIndex {
+
+      /*
+       * The first stage of a simdjson-style JSON parser: find the offset of every structural code unit of a JSON text,
+       * so that the second stage can walk the tokens without examining the text between them. The structural code
+       * units are the operators {}[]:, outside strings, the opening and closing quotes of each string, and the first
+       * code unit of each number, true, false or null.
+       *
+       * The text is classified 64 code units at a time, with bitmasks for quotes, backslashes, operators and
+       * whitespace built with SSE2 or AVX2 where the CPU supports it. Escaped quotes, and the extent of each string,
+       * are then found with a few bitwise operations per block rather than per code unit.
+       *
+       * The index is only as trustworthy as the text: for malformed JSON it may be nonsense, so the second stage must
+       * check each token as it consumes it. Returns false if the text ends inside a string, or is too long to index.
+       *
+       */
+
+      EXPORT_FOR_TESTING_ONLY bool IndexStructurals(const unsigned char* source, size_t length,
+                                                    std::vector<uint32_t>& index);
+      EXPORT_FOR_TESTING_ONLY bool IndexStructurals(const char16_t* source, size_t length,
+                                                    std::vector<uint32_t>& index);
+
+
+      #ifdef V8MONKEY_INTERNAL_TEST
+      // As UTF8::ForceEncodingImplementation, for the block classification above
+      EXPORT_FOR_TESTING_ONLY bool ForceIndexImplementation(UTF8::EncodingImplementation impl);
+      EXPORT_FOR_TESTING_ONLY void ResetIndexImplementation();
+      #endif
+    }
+  }
+}
+
+
+#endif
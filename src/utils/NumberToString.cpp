@@ -0,0 +1,559 @@
+// ceil
+#include <cmath>
+
+// snprintf
+#include <cstdio>
+
+// strtod
+#include <cstdlib>
+
+// memcpy memset
+#include <cstring>
+
+// Class definition
+#include "utils/NumberToString.h"
+
+// V8MONKEY_ASSERT
+#include "utils/V8MonkeyCommon.h"
+
+
+/*
+ * Grisu3, as described in Florian Loitsch's "Printing Floating-Point Numbers Quickly and Accurately with Integers"
+ * (PLDI 2010), and as implemented in the double-conversion library used by V8 and SpiderMonkey.
+ *
+ * In brief: the double and the boundaries of its rounding interval are represented as "do-it-yourself" floating-point
+ * values (a 64-bit significand and a binary exponent), and scaled by a cached power of ten so that the integral part
+ * fits in 32 bits. Digits are then generated from the upper boundary until the remainder falls within the (slightly
+ * shrunk, to account for the imprecision of the scaling) rounding interval, and the last digit is then "weeded" to get
+ * as close to the original value as possible. Where the imprecision means Grisu3 cannot prove that its answer is both
+ * the shortest and the closest, it reports failure, and we fall back to ShortestDigitsExact.
+ *
+ */
+
+namespace {
+  struct DiyFp {
+    uint64_t f;
+    int e;
+  };
+
+
+  constexpr int diyFpSignificandSize {64};
+  constexpr int doubleSignificandSize {52};
+  constexpr int doubleExponentBias {1023 + doubleSignificandSize};
+  constexpr int denormalExponent {1 - doubleExponentBias};
+  constexpr uint64_t doubleSignificandMask {0x000fffffffffffffull};
+  constexpr uint64_t doubleHiddenBit {0x0010000000000000ull};
+
+
+  /*
+   * Multiply two DiyFps, keeping the (rounded) upper 64 bits of the product.
+   *
+   */
+
+  DiyFp multiply(DiyFp x, DiyFp y) {
+    constexpr uint64_t mask32 {0xffffffffu};
+
+    uint64_t a {x.f >> 32};
+    uint64_t b {x.f & mask32};
+    uint64_t c {y.f >> 32};
+    uint64_t d {y.f & mask32};
+
+    uint64_t ac {a * c};
+    uint64_t bc {b * c};
+    uint64_t ad {a * d};
+    uint64_t bd {b * d};
+
+    uint64_t middle {(bd >> 32) + (ad & mask32) + (bc & mask32)};
+    // Round up
+    middle += 1ull << 31;
+
+    return DiyFp {ac + (ad >> 32) + (bc >> 32) + (middle >> 32), x.e + y.e + diyFpSignificandSize};
+  }
+
+
+  DiyFp normalize(DiyFp x) {
+    int shift {__builtin_clzll(x.f)};
+    return DiyFp {x.f << shift, x.e - shift};
+  }
+
+
+  /*
+   * Cached powers of ten: every eighth power from 10^-348 to 10^340, as normalized DiyFps rounded to nearest.
+   *
+   */
+
+  struct CachedPower {
+    uint64_t significand;
+    int16_t binaryExponent;
+    int16_t decimalExponent;
+  };
+
+
+  constexpr int cachedPowersOffset {348};
+  constexpr int cachedPowersDecimalDistance {8};
+  constexpr double inverseLog2Of10 {0.30102999566398114};
+
+
+  const CachedPower cachedPowers[] {
+    {0xfa8fd5a0081c0288ull, -1220, -348},
+    {0xbaaee17fa23ebf76ull, -1193, -340},
+    {0x8b16fb203055ac76ull, -1166, -332},
+    {0xcf42894a5dce35eaull, -1140, -324},
+    {0x9a6bb0aa55653b2dull, -1113, -316},
+    {0xe61acf033d1a45dfull, -1087, -308},
+    {0xab70fe17c79ac6caull, -1060, -300},
+    {0xff77b1fcbebcdc4full, -1034, -292},
+    {0xbe5691ef416bd60cull, -1007, -284},
+    {0x8dd01fad907ffc3cull, -980, -276},
+    {0xd3515c2831559a83ull, -954, -268},
+    {0x9d71ac8fada6c9b5ull, -927, -260},
+    {0xea9c227723ee8bcbull, -901, -252},
+    {0xaecc49914078536dull, -874, -244},
+    {0x823c12795db6ce57ull, -847, -236},
+    {0xc21094364dfb5637ull, -821, -228},
+    {0x9096ea6f3848984full, -794, -220},
+    {0xd77485cb25823ac7ull, -768, -212},
+    {0xa086cfcd97bf97f4ull, -741, -204},
+    {0xef340a98172aace5ull, -715, -196},
+    {0xb23867fb2a35b28eull, -688, -188},
+    {0x84c8d4dfd2c63f3bull, -661, -180},
+    {0xc5dd44271ad3cdbaull, -635, -172},
+    {0x936b9fcebb25c996ull, -608, -164},
+    {0xdbac6c247d62a584ull, -582, -156},
+    {0xa3ab66580d5fdaf6ull, -555, -148},
+    {0xf3e2f893dec3f126ull, -529, -140},
+    {0xb5b5ada8aaff80b8ull, -502, -132},
+    {0x87625f056c7c4a8bull, -475, -124},
+    {0xc9bcff6034c13053ull, -449, -116},
+    {0x964e858c91ba2655ull, -422, -108},
+    {0xdff9772470297ebdull, -396, -100},
+    {0xa6dfbd9fb8e5b88full, -369, -92},
+    {0xf8a95fcf88747d94ull, -343, -84},
+    {0xb94470938fa89bcfull, -316, -76},
+    {0x8a08f0f8bf0f156bull, -289, -68},
+    {0xcdb02555653131b6ull, -263, -60},
+    {0x993fe2c6d07b7facull, -236, -52},
+    {0xe45c10c42a2b3b06ull, -210, -44},
+    {0xaa242499697392d3ull, -183, -36},
+    {0xfd87b5f28300ca0eull, -157, -28},
+    {0xbce5086492111aebull, -130, -20},
+    {0x8cbccc096f5088ccull, -103, -12},
+    {0xd1b71758e219652cull, -77, -4},
+    {0x9c40000000000000ull, -50, 4},
+    {0xe8d4a51000000000ull, -24, 12},
+    {0xad78ebc5ac620000ull, 3, 20},
+    {0x813f3978f8940984ull, 30, 28},
+    {0xc097ce7bc90715b3ull, 56, 36},
+    {0x8f7e32ce7bea5c70ull, 83, 44},
+    {0xd5d238a4abe98068ull, 109, 52},
+    {0x9f4f2726179a2245ull, 136, 60},
+    {0xed63a231d4c4fb27ull, 162, 68},
+    {0xb0de65388cc8ada8ull, 189, 76},
+    {0x83c7088e1aab65dbull, 216, 84},
+    {0xc45d1df942711d9aull, 242, 92},
+    {0x924d692ca61be758ull, 269, 100},
+    {0xda01ee641a708deaull, 295, 108},
+    {0xa26da3999aef774aull, 322, 116},
+    {0xf209787bb47d6b85ull, 348, 124},
+    {0xb454e4a179dd1877ull, 375, 132},
+    {0x865b86925b9bc5c2ull, 402, 140},
+    {0xc83553c5c8965d3dull, 428, 148},
+    {0x952ab45cfa97a0b3ull, 455, 156},
+    {0xde469fbd99a05fe3ull, 481, 164},
+    {0xa59bc234db398c25ull, 508, 172},
+    {0xf6c69a72a3989f5cull, 534, 180},
+    {0xb7dcbf5354e9beceull, 561, 188},
+    {0x88fcf317f22241e2ull, 588, 196},
+    {0xcc20ce9bd35c78a5ull, 614, 204},
+    {0x98165af37b2153dfull, 641, 212},
+    {0xe2a0b5dc971f303aull, 667, 220},
+    {0xa8d9d1535ce3b396ull, 694, 228},
+    {0xfb9b7cd9a4a7443cull, 720, 236},
+    {0xbb764c4ca7a44410ull, 747, 244},
+    {0x8bab8eefb6409c1aull, 774, 252},
+    {0xd01fef10a657842cull, 800, 260},
+    {0x9b10a4e5e9913129ull, 827, 268},
+    {0xe7109bfba19c0c9dull, 853, 276},
+    {0xac2820d9623bf429ull, 880, 284},
+    {0x80444b5e7aa7cf85ull, 907, 292},
+    {0xbf21e44003acdd2dull, 933, 300},
+    {0x8e679c2f5e44ff8full, 960, 308},
+    {0xd433179d9c8cb841ull, 986, 316},
+    {0x9e19db92b4e31ba9ull, 1013, 324},
+    {0xeb96bf6ebadf77d9ull, 1039, 332},
+    {0xaf87023b9bf0ee6bull, 1066, 340},  };
+
+
+  /*
+   * The digit generation loop requires the scaled values to have a binary exponent within this range.
+   *
+   */
+
+  constexpr int minimalTargetExponent {-60};
+  constexpr int maximalTargetExponent {-32};
+
+
+  /*
+   * Returns a cached power of ten c (and the decimal exponent k, where c ~= 10^k), such that the binary exponent of c
+   * lies within [minExponent, maxExponent].
+   *
+   */
+
+  DiyFp cachedPowerForBinaryExponentRange(int minExponent, int maxExponent, int* decimalExponent) {
+    double k {std::ceil((minExponent + diyFpSignificandSize - 1) * inverseLog2Of10)};
+    int index {(cachedPowersOffset + static_cast<int>(k) - 1) / cachedPowersDecimalDistance + 1};
+    const CachedPower& power = cachedPowers[index];
+
+    V8MONKEY_ASSERT(minExponent <= power.binaryExponent && power.binaryExponent <= maxExponent,
+                    "Cached power out of range");
+    // Only used for the assertion
+    static_cast<void>(maxExponent);
+
+    *decimalExponent = power.decimalExponent;
+    return DiyFp {power.significand, power.binaryExponent};
+  }
+
+
+  /*
+   * Returns the largest power of ten less than or equal to the given (non-zero) number, and one more than its decimal
+   * exponent.
+   *
+   */
+
+  void biggestPowerTen(uint32_t number, uint32_t* power, int* exponentPlusOne) {
+    uint32_t p {1000000000u};
+    int e {10};
+
+    while (p > number) {
+      p /= 10;
+      e--;
+    }
+
+    *power = p;
+    *exponentPlusOne = e;
+  }
+
+
+  /*
+   * Adjust the last generated digit downwards to get closer to the real value, and confirm that the result is
+   * unambiguously inside the rounding interval. See the paper (or double-conversion's RoundWeed) for the derivation.
+   *
+   */
+
+  bool roundWeed(char* buffer, int length, uint64_t distanceTooHighW, uint64_t unsafeInterval, uint64_t rest,
+                 uint64_t tenKappa, uint64_t unit) {
+    uint64_t smallDistance {distanceTooHighW - unit};
+    uint64_t bigDistance {distanceTooHighW + unit};
+
+    while (rest < smallDistance && unsafeInterval - rest >= tenKappa &&
+           (rest + tenKappa < smallDistance || smallDistance - rest >= rest + tenKappa - smallDistance)) {
+      buffer[length - 1]--;
+      rest += tenKappa;
+    }
+
+    // If we could have moved closer to the big distance than the small one, then we can't decide which is right
+    if (rest < bigDistance && unsafeInterval - rest >= tenKappa &&
+        (rest + tenKappa < bigDistance || bigDistance - rest > rest + tenKappa - bigDistance)) {
+      return false;
+    }
+
+    // The result must be comfortably within the safe interval
+    return (2 * unit <= rest) && (rest <= unsafeInterval - 4 * unit);
+  }
+
+
+  bool digitGen(DiyFp low, DiyFp w, DiyFp high, char* buffer, int* length, int* kappa) {
+    // Our scaled values are imprecise by at most one unit in either direction
+    uint64_t unit {1};
+    DiyFp tooLow {low.f - unit, low.e};
+    DiyFp tooHigh {high.f + unit, high.e};
+    uint64_t unsafeInterval {tooHigh.f - tooLow.f};
+
+    int shift {-w.e};
+    uint64_t one {1ull << shift};
+    uint32_t integrals {static_cast<uint32_t>(tooHigh.f >> shift)};
+    uint64_t fractionals {tooHigh.f & (one - 1)};
+
+    uint32_t divisor;
+    int divisorExponentPlusOne;
+    biggestPowerTen(integrals, &divisor, &divisorExponentPlusOne);
+
+    *kappa = divisorExponentPlusOne;
+    *length = 0;
+
+    while (*kappa > 0) {
+      uint32_t digit {integrals / divisor};
+      buffer[(*length)++] = static_cast<char>('0' + digit);
+      integrals %= divisor;
+      (*kappa)--;
+
+      uint64_t rest {(static_cast<uint64_t>(integrals) << shift) + fractionals};
+      if (rest < unsafeInterval) {
+        return roundWeed(buffer, *length, tooHigh.f - w.f, unsafeInterval, rest,
+                         static_cast<uint64_t>(divisor) << shift, unit);
+      }
+
+      divisor /= 10;
+    }
+
+    // The integrals have been exhausted: generate from the fractionals
+    for (;;) {
+      fractionals *= 10;
+      unit *= 10;
+      unsafeInterval *= 10;
+
+      buffer[(*length)++] = static_cast<char>('0' + (fractionals >> shift));
+      fractionals &= one - 1;
+      (*kappa)--;
+
+      if (fractionals < unsafeInterval) {
+        return roundWeed(buffer, *length, (tooHigh.f - w.f) * unit, unsafeInterval, fractionals, one, unit);
+      }
+    }
+  }
+
+
+  /*
+   * Format a null-terminated decimal string for an unsigned 64-bit integer. Returns the length.
+   *
+   */
+
+  const char digitPairs[] {
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899"
+  };
+
+
+  size_t formatUnsigned(uint64_t value, char* buffer) {
+    char temp[20];
+    char* p {temp + sizeof(temp)};
+
+    while (value >= 100) {
+      size_t index {static_cast<size_t>(value % 100) * 2};
+      value /= 100;
+      *--p = digitPairs[index + 1];
+      *--p = digitPairs[index];
+    }
+
+    if (value >= 10) {
+      size_t index {static_cast<size_t>(value) * 2};
+      *--p = digitPairs[index + 1];
+      *--p = digitPairs[index];
+    } else {
+      *--p = static_cast<char>('0' + value);
+    }
+
+    size_t length {static_cast<size_t>(temp + sizeof(temp) - p)};
+    std::memcpy(buffer, p, length);
+    buffer[length] = '\0';
+    return length;
+  }
+
+
+  /*
+   * Does the decimal value mantissa * 10^exponent read back as exactly the given double?
+   *
+   */
+
+  bool roundTrips(uint64_t mantissa, int exponent, double value) {
+    // Deliberately avoid a decimal point: strtod's idea of what that is depends on the locale
+    char buffer[48];
+    std::snprintf(buffer, sizeof(buffer), "%llue%d", static_cast<unsigned long long>(mantissa), exponent);
+    return std::strtod(buffer, nullptr) == value;
+  }
+
+
+  /*
+   * Lay out the digits per ECMA-262 9.8.1 steps 6-10, where k is the number of digits, and n the position of the
+   * decimal point relative to the first digit. Returns the number of characters written.
+   *
+   */
+
+  size_t formatDecimal(const char* digits, int k, int n, char* out) {
+    char* p {out};
+    size_t digitCount {static_cast<size_t>(k)};
+
+    if (k <= n && n <= 21) {
+      // Integers: ddd000
+      std::memcpy(p, digits, digitCount);
+      p += k;
+      std::memset(p, '0', static_cast<size_t>(n - k));
+      p += n - k;
+    } else if (0 < n && n <= 21) {
+      // ddd.ddd
+      std::memcpy(p, digits, static_cast<size_t>(n));
+      p += n;
+      *p++ = '.';
+      std::memcpy(p, digits + n, static_cast<size_t>(k - n));
+      p += k - n;
+    } else if (-6 < n && n <= 0) {
+      // 0.000ddd
+      *p++ = '0';
+      *p++ = '.';
+      std::memset(p, '0', static_cast<size_t>(-n));
+      p += -n;
+      std::memcpy(p, digits, digitCount);
+      p += k;
+    } else {
+      // d.ddde+xx
+      *p++ = digits[0];
+      if (k > 1) {
+        *p++ = '.';
+        std::memcpy(p, digits + 1, digitCount - 1);
+        p += k - 1;
+      }
+
+      *p++ = 'e';
+      int exponent {n - 1};
+      *p++ = exponent < 0 ? '-' : '+';
+      p += formatUnsigned(static_cast<uint64_t>(exponent < 0 ? -exponent : exponent), p);
+    }
+
+    *p = '\0';
+    return static_cast<size_t>(p - out);
+  }
+}
+
+
+namespace v8 {
+  namespace V8Monkey {
+    namespace Conversions {
+      bool ShortestDigitsGrisu3(double value, char* digits, int* length, int* exponent) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        int biasedExponent {static_cast<int>((bits >> doubleSignificandSize) & 0x7ffu)};
+        uint64_t fraction {bits & doubleSignificandMask};
+
+        DiyFp v {biasedExponent ? fraction | doubleHiddenBit : fraction,
+                 biasedExponent ? biasedExponent - doubleExponentBias : denormalExponent};
+
+        // Compute the boundaries of the rounding interval. The lower boundary is closer when the value is a power of
+        // two (excepting the smallest normal, whose predecessor is a denormal with the same spacing).
+        DiyFp plus {normalize(DiyFp {(v.f << 1) + 1, v.e - 1})};
+        DiyFp minus {fraction == 0 && biasedExponent > 1 ? DiyFp {(v.f << 2) - 1, v.e - 2} :
+                                                           DiyFp {(v.f << 1) - 1, v.e - 1}};
+        minus.f <<= minus.e - plus.e;
+        minus.e = plus.e;
+
+        DiyFp w {normalize(v)};
+
+        int minExponent {minimalTargetExponent - (w.e + diyFpSignificandSize)};
+        int maxExponent {maximalTargetExponent - (w.e + diyFpSignificandSize)};
+        int mk;
+        DiyFp tenMk {cachedPowerForBinaryExponentRange(minExponent, maxExponent, &mk)};
+
+        int kappa;
+        bool result {digitGen(multiply(minus, tenMk), multiply(w, tenMk), multiply(plus, tenMk), digits, length,
+                              &kappa)};
+
+        *exponent = -mk + kappa;
+        return result;
+      }
+
+
+      void ShortestDigitsExact(double value, char* digits, int* length, int* exponent) {
+        V8MONKEY_ASSERT(value > 0 && std::isfinite(value), "Value must be finite and positive");
+
+        // For each precision, the correctly rounded representation is the nearest candidate. If it doesn't round-trip
+        // it's still possible for its neighbour to do so when the value is a power of two, as the rounding interval
+        // is asymmetric. 17 significant digits always suffice.
+        for (int precision = 1; precision <= 17; precision++) {
+          char buffer[48];
+          std::snprintf(buffer, sizeof(buffer), "%.*e", precision - 1, value);
+
+          uint64_t mantissa {0};
+          const char* p {buffer};
+          for (; *p != 'e'; p++) {
+            if (*p >= '0' && *p <= '9') {
+              mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+            }
+          }
+
+          int candidateExponent {std::atoi(p + 1) - (precision - 1)};
+
+          const uint64_t candidates[] {mantissa, mantissa - 1, mantissa + 1};
+          for (uint64_t candidate : candidates) {
+            if (candidate == 0 || !roundTrips(candidate, candidateExponent, value)) {
+              continue;
+            }
+
+            // Strip trailing zeros
+            while (candidate % 10 == 0) {
+              candidate /= 10;
+              candidateExponent++;
+            }
+
+            *length = static_cast<int>(formatUnsigned(candidate, digits));
+            *exponent = candidateExponent;
+            return;
+          }
+        }
+
+        V8MONKEY_ASSERT(false, "17 significant digits failed to round-trip");
+      }
+
+
+      size_t DoubleToString(double value, char* buffer) {
+        if (std::isnan(value)) {
+          std::memcpy(buffer, "NaN", 4);
+          return 3;
+        }
+
+        // Integers in 32-bit range: this includes both zeros, which stringify as "0"
+        if (value > -2147483649.0 && value < 4294967296.0) {
+          int64_t asInteger {static_cast<int64_t>(value)};
+          if (static_cast<double>(asInteger) == value) {
+            return asInteger < 0 ? Int32ToString(static_cast<int32_t>(asInteger), buffer) :
+                                   Uint32ToString(static_cast<uint32_t>(asInteger), buffer);
+          }
+        }
+
+        char* out {buffer};
+        if (value < 0) {
+          *out++ = '-';
+          value = -value;
+        }
+
+        if (std::isinf(value)) {
+          std::memcpy(out, "Infinity", 9);
+          return static_cast<size_t>(out - buffer) + 8;
+        }
+
+        // At most 17 digits, plus the null that may be written by ShortestDigitsExact
+        char digits[18];
+        int length;
+        int exponent;
+        if (!ShortestDigitsGrisu3(value, digits, &length, &exponent)) {
+          ShortestDigitsExact(value, digits, &length, &exponent);
+        }
+
+        return static_cast<size_t>(out - buffer) + formatDecimal(digits, length, length + exponent, out);
+      }
+
+
+      size_t Int32ToString(int32_t value, char* buffer) {
+        if (value >= 0) {
+          return Uint32ToString(static_cast<uint32_t>(value), buffer);
+        }
+
+        buffer[0] = '-';
+        // Negate in unsigned arithmetic to avoid overflow for INT32_MIN
+        return 1 + formatUnsigned(0u - static_cast<uint32_t>(value), buffer + 1);
+      }
+
+
+      size_t Uint32ToString(uint32_t value, char* buffer) {
+        return formatUnsigned(value, buffer);
+      }
+    }
+  }
+}
@@ -0,0 +1,66 @@
+#ifndef V8MONKEY_NUMBERTOSTRING_H
+#define V8MONKEY_NUMBERTOSTRING_H
+
+// size_t
+#include <cstddef>
+
+// int32_t, uint32_t
+#include <cstdint>
+
+// EXPORT_FOR_TESTING_ONLY
+#include "utils/test.h"
+
+
+namespace v8 {
+  namespace V8Monkey {
+    namespace Conversions {
+
+      /*
+       * Converting numbers to strings per ECMA-262 9.8.1 requires the shortest sequence of digits that round-trips to
+       * the original double. Rather than round-tripping through SpiderMonkey's dtoa, we produce the digits ourselves
+       * using Grisu3, which succeeds for ~99.5% of doubles, falling back to a slower but exact search for the rest.
+       * Integers (the overwhelmingly common case) skip all that and are formatted directly.
+       *
+       * All functions write to a caller-supplied buffer, which must be at least NumberToStringBufferSize chars, and
+       * return the number of chars written, excluding the terminating null (which is always written).
+       *
+       */
+
+      constexpr size_t NumberToStringBufferSize {32};
+
+
+      /*
+       * Format the given double as ECMAScript's Number.prototype.toString() (radix 10) would.
+       *
+       */
+
+      EXPORT_FOR_TESTING_ONLY size_t DoubleToString(double value, char* buffer);
+
+
+      /*
+       * Integer fast paths, for values already classified as INT32/UINT32.
+       *
+       */
+
+      EXPORT_FOR_TESTING_ONLY size_t Int32ToString(int32_t value, char* buffer);
+      EXPORT_FOR_TESTING_ONLY size_t Uint32ToString(uint32_t value, char* buffer);
+
+
+      #ifdef V8MONKEY_INTERNAL_TEST
+      /*
+       * Expose the two digit-generation strategies, so tests can check them against each other. Both produce the
+       * shortest digit string that round-trips, and the decimal exponent, such that value = digits * 10^exponent.
+       * The value must be finite and strictly positive. ShortestDigitsGrisu3 returns false if Grisu3 could not
+       * guarantee the result, in which case the buffer contents are unspecified.
+       *
+       */
+
+      EXPORT_FOR_TESTING_ONLY bool ShortestDigitsGrisu3(double value, char* digits, int* length, int* exponent);
+      EXPORT_FOR_TESTING_ONLY void ShortestDigitsExact(double value, char* digits, int* length, int* exponent);
+      #endif
+    }
+  }
+}
+
+
+#endif
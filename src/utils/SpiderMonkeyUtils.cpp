@@ -1,7 +1,7 @@
 // atomic_int
 #include <atomic>
 
-// JS_Init
+// JS_Init JS_InitStandardClasses JS_NewGlobalObject
 #include "jsapi.h"
 
 // unique_ptr
@@ -10,9 +10,18 @@
 // OneShot
 #include "platform/platform.h"
 
+// Snapshot
+#include "runtime/snapshot.h"
+
 // SpiderMonkeyUtils definition
 #include "utils/SpiderMonkeyUtils.h"
 
+// StringToDouble
+#include "utils/StringToNumber.h"
+
+// vector
+#include <vector>
+
 
 using namespace v8::V8Platform;
 
@@ -115,10 +124,54 @@ namespace {
   }
 
 
+  /*
+   * Callbacks to be invoked when a particular JSRuntime is destroyed. Ordering requirement: as the static destructor
+   * for SpiderMonkey tears down the last thread's runtime, these must appear before the SpiderMonkeyTearDown
+   * unique_ptr.
+   *
+   */
+
+  struct RuntimeTearDownRegistration {
+    JSRuntime* rt;
+    v8::SpiderMonkey::RuntimeTearDownCallback fn;
+    void* data;
+  };
+
+  Mutex tearDownCallbackMutex {};
+  std::vector<RuntimeTearDownRegistration> tearDownCallbacks {};
+
+
+  // Invoke and unregister the callbacks for the given runtime
+  void runTearDownCallbacks(JSRuntime* rt) {
+    tearDownCallbackMutex.Lock();
+
+    size_t kept {0};
+    for (auto& registration : tearDownCallbacks) {
+      if (registration.rt == rt) {
+        registration.fn(rt, registration.data);
+      } else {
+        tearDownCallbacks[kept++] = registration;
+      }
+    }
+
+    tearDownCallbacks.resize(kept);
+    tearDownCallbackMutex.Unlock();
+  }
+
+
   class SpiderMonkeyTearDown;
   std::unique_ptr<SpiderMonkeyTearDown> tearDown {nullptr};
 
 
+  const JSClass globalClass {
+    "global", JSCLASS_GLOBAL_FLAGS,
+    JS_PropertyStub, JS_DeletePropertyStub, JS_PropertyStub, JS_StrictPropertyStub,
+    JS_EnumerateStub, JS_ResolveStub, JS_ConvertStub,
+    nullptr, nullptr, nullptr, nullptr,
+    JS_GlobalObjectTraceHook
+  };
+
+
   /*
    * This class is used to ensure we always teardown SpiderMonkey after it has been initialized, regardless of whether
    * the client remembers to call V8::Dispose or not. When the client requests V8 init, an instance of this class will
@@ -276,6 +329,7 @@ namespace {
     RemoveRooter(rt);
 */
 
+    runTearDownCallbacks(rt);
     JS_DestroyContext(data->cx);
     JS_DestroyRuntime(rt);
 
@@ -349,6 +403,69 @@ namespace v8{
     JSContext* GetJSContextForThread() {
       return GetJSRuntimeAndJSContext().cx;
     }
+
+
+    JSObject* NewGlobal(JSContext* cx) {
+      JS::RootedObject global(cx, JS_NewGlobalObject(cx, &globalClass, nullptr, JS::FireOnNewGlobalHook));
+      if (!global) {
+        return nullptr;
+      }
+
+      JSAutoCompartment ac(cx, global);
+      if (!JS_InitStandardClasses(cx, global)) {
+        return nullptr;
+      }
+
+      const internal::Snapshot* snapshot {internal::Snapshot::Current()};
+      if (snapshot && !snapshot->Apply(cx)) {
+        return nullptr;
+      }
+
+      return global;
+    }
+
+
+    void AddRuntimeTearDownCallback(JSRuntime* rt, RuntimeTearDownCallback fn, void* data) {
+      tearDownCallbackMutex.Lock();
+      tearDownCallbacks.push_back({rt, fn, data});
+      tearDownCallbackMutex.Unlock();
+    }
+
+
+    void RemoveRuntimeTearDownCallback(JSRuntime* rt, RuntimeTearDownCallback fn, void* data) {
+      tearDownCallbackMutex.Lock();
+
+      for (auto it = tearDownCallbacks.begin(); it != tearDownCallbacks.end(); ++it) {
+        if (it->rt == rt && it->fn == fn && it->data == data) {
+          tearDownCallbacks.erase(it);
+          break;
+        }
+      }
+
+      tearDownCallbackMutex.Unlock();
+    }
+
+
+    bool StringToNumber(JSContext* cx, JS::HandleString str, double* result) {
+      // ToNumber would flatten the string anyway
+      JSFlatString* flat {JS_FlattenString(cx, str)};
+      if (!flat) {
+        return false;
+      }
+
+      if (JS_StringHasLatin1Chars(str)) {
+        JS::AutoCheckCannotGC nogc;
+        const JS::Latin1Char* chars {JS_GetLatin1FlatStringChars(nogc, flat)};
+        size_t length {JS_GetStringLength(str)};
+
+        if (::v8::V8Monkey::Conversions::StringToDouble(chars, length, result)) {
+          return true;
+        }
+      }
+
+      JS::RootedValue value(cx, JS::StringValue(str));
+      return JS::ToNumber(cx, value, result);
+    }
   }
 }
 
@@ -1,8 +1,6 @@
 #ifndef V8MONKEY_SMUTILS_H
 #define V8MONKEY_SMUTILS_H
 
-#endif
-
 
 // JSContext, JSRuntime
 #include "jsapi.h"
@@ -65,6 +63,41 @@ namespace v8 {
     EXPORT_FOR_TESTING_ONLY JSContext* GetJSContextForThread();
 
 
+    /*
+     * Caches that hold GC things belonging to a particular JSRuntime must forget them before the runtime is destroyed.
+     * The callback is invoked with the given data on the runtime's thread, just before the runtime is destroyed, and
+     * is then unregistered. It may not call back in to these functions. A registration that is no longer wanted must
+     * be removed before the data is freed.
+     *
+     */
+
+    using RuntimeTearDownCallback = void (*)(JSRuntime* rt, void* data);
+
+    EXPORT_FOR_TESTING_ONLY void AddRuntimeTearDownCallback(JSRuntime* rt, RuntimeTearDownCallback fn, void* data);
+    EXPORT_FOR_TESTING_ONLY void RemoveRuntimeTearDownCallback(JSRuntime* rt, RuntimeTearDownCallback fn, void* data);
+
+
+    /*
+     * Create a global object with the standard classes defined, and apply the snapshot registered with
+     * V8::SetSnapshotDataBlob (if any) to it. All V8Monkey globals should be created here. Returns nullptr if creating
+     * the global failed, or a snapshot script threw; in the latter case, the exception will be pending.
+     *
+     */
+
+    EXPORT_FOR_TESTING_ONLY JSObject* NewGlobal(JSContext* cx);
+
+
+    /*
+     * Perform ECMA-262 ToNumber on the given string. Flat Latin1 strings that are plain decimal literals (by far the
+     * most common case when parsing query strings, headers and the like) are converted directly, without calling in to
+     * SpiderMonkey; anything else is passed to JS::ToNumber. Returns false if SpiderMonkey reported an error (for
+     * example, running out of memory while flattening a rope).
+     *
+     */
+
+    EXPORT_FOR_TESTING_ONLY bool StringToNumber(JSContext* cx, JS::HandleString str, double* result);
+
+
     /*
      * Checks if SpiderMonkey is initialized, and if not, performs that initialization in a thread-safe fashion
      *
@@ -203,3 +236,6 @@ namespace v8 {
 //    };
 //  }
 //}
+
+
+#endif
@@ -0,0 +1,637 @@
+// FLT_EVAL_METHOD
+#include <cfloat>
+
+// ptrdiff_t
+#include <cstddef>
+
+// uint32_t uint64_t
+#include <cstdint>
+
+// memcpy
+#include <cstring>
+
+// Class definition
+#include "utils/StringToNumber.h"
+
+// V8MONKEY_ASSERT
+#include "utils/V8MonkeyCommon.h"
+
+
+/*
+ * Parsing proceeds in two stages. First, the string is checked against the grammar of a decimal literal, and the
+ * significant digits accumulated into a 64-bit integer w, along with the decimal exponent q, such that the value is
+ * w * 10^q. Runs of eight digits are validated and converted in a handful of 64-bit operations (see
+ * isEightDigits/parseEightDigits), which is where most of the time goes for the long digit strings found in IDs and
+ * timestamps.
+ *
+ * Second, w * 10^q is converted to the nearest double. When w < 2^53 and |q| <= 22, both w and 10^q are exactly
+ * representable, so a single IEEE multiplication or division is correctly rounded (Clinger's fast path). Otherwise, we
+ * use the algorithm from Daniel Lemire's "Number Parsing at a Gigabyte per Second" (2021), originally due to Michael
+ * Eisel: w is multiplied by a 128-bit truncated approximation of 5^q, and the rounded result is read off the top bits
+ * of the product. The approximation is always accurate enough when w has at most 19 digits (Mushtak and Lemire, "Fast
+ * Number Parsing Without Fallback", 2023), but we retain the conservative check from the original paper, and bail out
+ * to SpiderMonkey in the (vanishingly rare) cases it trips.
+ *
+ * Restricting q to [-128, 128] keeps the power table small, and also means the result can be neither subnormal nor
+ * infinite, eliminating those cases from the algorithm.
+ *
+ */
+
+namespace {
+  constexpr int maxSignificantDigits {19};
+  constexpr int maxFractionDigits {1000};
+  constexpr int smallestPowerOfTen {-128};
+  constexpr int largestPowerOfTen {128};
+
+  constexpr int doubleSignificandSize {52};
+  constexpr int doubleExponentBias {1023};
+  constexpr uint64_t maxExactInteger {1ull << 53};
+
+
+  inline bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+  }
+
+
+  inline uint64_t loadEightBytes(const char* chars) {
+    uint64_t value;
+    std::memcpy(&value, chars, sizeof(value));
+
+    #if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap64(value);
+    #endif
+
+    return value;
+  }
+
+
+  /*
+   * Returns true if each of the 8 bytes of value (loaded little-endian) is an ASCII digit. Adding 6 to a byte in the
+   * range 0x30-0x39 leaves the high nibble at 3, while for 0x3a-0x3f it carries into the high nibble.
+   *
+   */
+
+  inline bool isEightDigits(uint64_t value) {
+    return ((value & 0xf0f0f0f0f0f0f0f0ull) | (((value + 0x0606060606060606ull) & 0xf0f0f0f0f0f0f0f0ull) >> 4)) ==
+           0x3333333333333333ull;
+  }
+
+
+  /*
+   * Convert 8 ASCII digits (loaded little-endian, so the first digit is in the lowest byte) to their integer value.
+   * Adjacent digits are combined into pairs, then pairs into groups of four, then the two groups of four combined.
+   *
+   */
+
+  inline uint32_t parseEightDigits(uint64_t value) {
+    constexpr uint64_t mask {0x000000ff000000ffull};
+    constexpr uint64_t multiplier1 {100 + (1000000ull << 32)};
+    constexpr uint64_t multiplier2 {1 + (10000ull << 32)};
+
+    value -= 0x3030303030303030ull;
+    value = (value * 10) + (value >> 8);
+    value = (((value & mask) * multiplier1) + (((value >> 16) & mask) * multiplier2)) >> 32;
+
+    return static_cast<uint32_t>(value);
+  }
+
+
+  /*
+   * Consume a run of digits, accumulating them into value. Overflow is harmless: the caller will reject strings with
+   * too many significant digits.
+   *
+   */
+
+  const char* parseDigits(const char* p, const char* end, uint64_t* value) {
+    uint64_t result {*value};
+
+    while (end - p >= 8) {
+      uint64_t block {loadEightBytes(p)};
+      if (!isEightDigits(block)) {
+        break;
+      }
+
+      result = result * 100000000 + parseEightDigits(block);
+      p += 8;
+    }
+
+    while (p < end && isDigit(*p)) {
+      result = result * 10 + static_cast<uint64_t>(*p - '0');
+      p++;
+    }
+
+    *value = result;
+    return p;
+  }
+
+
+  /*
+   * The 128-bit approximations of 5^q for q in [smallestPowerOfTen, largestPowerOfTen], normalized so that the most
+   * significant bit is set, as {high 64 bits, low 64 bits}. Positive powers are truncated; negative powers are the
+   * reciprocal rounded up, as required by the algorithm. Generated with exact integer arithmetic.
+   *
+   */
+
+  const uint64_t powersOfFive[][2] {
+    {0xddd0467c64bce4a0ull, 0xac7cb3f6d05ddbdeull},
+    {0x8aa22c0dbef60ee4ull, 0x6bcdf07a423aa96bull},
+    {0xad4ab7112eb3929dull, 0x86c16c98d2c953c6ull},
+    {0xd89d64d57a607744ull, 0xe871c7bf077ba8b7ull},
+    {0x87625f056c7c4a8bull, 0x11471cd764ad4972ull},
+    {0xa93af6c6c79b5d2dull, 0xd598e40d3dd89bcfull},
+    {0xd389b47879823479ull, 0x4aff1d108d4ec2c3ull},
+    {0x843610cb4bf160cbull, 0xcedf722a585139baull},
+    {0xa54394fe1eedb8feull, 0xc2974eb4ee658828ull},
+    {0xce947a3da6a9273eull, 0x733d226229feea32ull},
+    {0x811ccc668829b887ull, 0x0806357d5a3f525full},
+    {0xa163ff802a3426a8ull, 0xca07c2dcb0cf26f7ull},
+    {0xc9bcff6034c13052ull, 0xfc89b393dd02f0b5ull},
+    {0xfc2c3f3841f17c67ull, 0xbbac2078d443ace2ull},
+    {0x9d9ba7832936edc0ull, 0xd54b944b84aa4c0dull},
+    {0xc5029163f384a931ull, 0x0a9e795e65d4df11ull},
+    {0xf64335bcf065d37dull, 0x4d4617b5ff4a16d5ull},
+    {0x99ea0196163fa42eull, 0x504bced1bf8e4e45ull},
+    {0xc06481fb9bcf8d39ull, 0xe45ec2862f71e1d6ull},
+    {0xf07da27a82c37088ull, 0x5d767327bb4e5a4cull},
+    {0x964e858c91ba2655ull, 0x3a6a07f8d510f86full},
+    {0xbbe226efb628afeaull, 0x890489f70a55368bull},
+    {0xeadab0aba3b2dbe5ull, 0x2b45ac74ccea842eull},
+    {0x92c8ae6b464fc96full, 0x3b0b8bc90012929dull},
+    {0xb77ada0617e3bbcbull, 0x09ce6ebb40173744ull},
+    {0xe55990879ddcaabdull, 0xcc420a6a101d0515ull},
+    {0x8f57fa54c2a9eab6ull, 0x9fa946824a12232dull},
+    {0xb32df8e9f3546564ull, 0x47939822dc96abf9ull},
+    {0xdff9772470297ebdull, 0x59787e2b93bc56f7ull},
+    {0x8bfbea76c619ef36ull, 0x57eb4edb3c55b65aull},
+    {0xaefae51477a06b03ull, 0xede622920b6b23f1ull},
+    {0xdab99e59958885c4ull, 0xe95fab368e45ecedull},
+    {0x88b402f7fd75539bull, 0x11dbcb0218ebb414ull},
+    {0xaae103b5fcd2a881ull, 0xd652bdc29f26a119ull},
+    {0xd59944a37c0752a2ull, 0x4be76d3346f0495full},
+    {0x857fcae62d8493a5ull, 0x6f70a4400c562ddbull},
+    {0xa6dfbd9fb8e5b88eull, 0xcb4ccd500f6bb952ull},
+    {0xd097ad07a71f26b2ull, 0x7e2000a41346a7a7ull},
+    {0x825ecc24c873782full, 0x8ed400668c0c28c8ull},
+    {0xa2f67f2dfa90563bull, 0x728900802f0f32faull},
+    {0xcbb41ef979346bcaull, 0x4f2b40a03ad2ffb9ull},
+    {0xfea126b7d78186bcull, 0xe2f610c84987bfa8ull},
+    {0x9f24b832e6b0f436ull, 0x0dd9ca7d2df4d7c9ull},
+    {0xc6ede63fa05d3143ull, 0x91503d1c79720dbbull},
+    {0xf8a95fcf88747d94ull, 0x75a44c6397ce912aull},
+    {0x9b69dbe1b548ce7cull, 0xc986afbe3ee11abaull},
+    {0xc24452da229b021bull, 0xfbe85badce996168ull},
+    {0xf2d56790ab41c2a2ull, 0xfae27299423fb9c3ull},
+    {0x97c560ba6b0919a5ull, 0xdccd879fc967d41aull},
+    {0xbdb6b8e905cb600full, 0x5400e987bbc1c920ull},
+    {0xed246723473e3813ull, 0x290123e9aab23b68ull},
+    {0x9436c0760c86e30bull, 0xf9a0b6720aaf6521ull},
+    {0xb94470938fa89bceull, 0xf808e40e8d5b3e69ull},
+    {0xe7958cb87392c2c2ull, 0xb60b1d1230b20e04ull},
+    {0x90bd77f3483bb9b9ull, 0xb1c6f22b5e6f48c2ull},
+    {0xb4ecd5f01a4aa828ull, 0x1e38aeb6360b1af3ull},
+    {0xe2280b6c20dd5232ull, 0x25c6da63c38de1b0ull},
+    {0x8d590723948a535full, 0x579c487e5a38ad0eull},
+    {0xb0af48ec79ace837ull, 0x2d835a9df0c6d851ull},
+    {0xdcdb1b2798182244ull, 0xf8e431456cf88e65ull},
+    {0x8a08f0f8bf0f156bull, 0x1b8e9ecb641b58ffull},
+    {0xac8b2d36eed2dac5ull, 0xe272467e3d222f3full},
+    {0xd7adf884aa879177ull, 0x5b0ed81dcc6abb0full},
+    {0x86ccbb52ea94baeaull, 0x98e947129fc2b4e9ull},
+    {0xa87fea27a539e9a5ull, 0x3f2398d747b36224ull},
+    {0xd29fe4b18e88640eull, 0x8eec7f0d19a03aadull},
+    {0x83a3eeeef9153e89ull, 0x1953cf68300424acull},
+    {0xa48ceaaab75a8e2bull, 0x5fa8c3423c052dd7ull},
+    {0xcdb02555653131b6ull, 0x3792f412cb06794dull},
+    {0x808e17555f3ebf11ull, 0xe2bbd88bbee40bd0ull},
+    {0xa0b19d2ab70e6ed6ull, 0x5b6aceaeae9d0ec4ull},
+    {0xc8de047564d20a8bull, 0xf245825a5a445275ull},
+    {0xfb158592be068d2eull, 0xeed6e2f0f0d56712ull},
+    {0x9ced737bb6c4183dull, 0x55464dd69685606bull},
+    {0xc428d05aa4751e4cull, 0xaa97e14c3c26b886ull},
+    {0xf53304714d9265dfull, 0xd53dd99f4b3066a8ull},
+    {0x993fe2c6d07b7fabull, 0xe546a8038efe4029ull},
+    {0xbf8fdb78849a5f96ull, 0xde98520472bdd033ull},
+    {0xef73d256a5c0f77cull, 0x963e66858f6d4440ull},
+    {0x95a8637627989aadull, 0xdde7001379a44aa8ull},
+    {0xbb127c53b17ec159ull, 0x5560c018580d5d52ull},
+    {0xe9d71b689dde71afull, 0xaab8f01e6e10b4a6ull},
+    {0x9226712162ab070dull, 0xcab3961304ca70e8ull},
+    {0xb6b00d69bb55c8d1ull, 0x3d607b97c5fd0d22ull},
+    {0xe45c10c42a2b3b05ull, 0x8cb89a7db77c506aull},
+    {0x8eb98a7a9a5b04e3ull, 0x77f3608e92adb242ull},
+    {0xb267ed1940f1c61cull, 0x55f038b237591ed3ull},
+    {0xdf01e85f912e37a3ull, 0x6b6c46dec52f6688ull},
+    {0x8b61313bbabce2c6ull, 0x2323ac4b3b3da015ull},
+    {0xae397d8aa96c1b77ull, 0xabec975e0a0d081aull},
+    {0xd9c7dced53c72255ull, 0x96e7bd358c904a21ull},
+    {0x881cea14545c7575ull, 0x7e50d64177da2e54ull},
+    {0xaa242499697392d2ull, 0xdde50bd1d5d0b9e9ull},
+    {0xd4ad2dbfc3d07787ull, 0x955e4ec64b44e864ull},
+    {0x84ec3c97da624ab4ull, 0xbd5af13bef0b113eull},
+    {0xa6274bbdd0fadd61ull, 0xecb1ad8aeacdd58eull},
+    {0xcfb11ead453994baull, 0x67de18eda5814af2ull},
+    {0x81ceb32c4b43fcf4ull, 0x80eacf948770ced7ull},
+    {0xa2425ff75e14fc31ull, 0xa1258379a94d028dull},
+    {0xcad2f7f5359a3b3eull, 0x096ee45813a04330ull},
+    {0xfd87b5f28300ca0dull, 0x8bca9d6e188853fcull},
+    {0x9e74d1b791e07e48ull, 0x775ea264cf55347eull},
+    {0xc612062576589ddaull, 0x95364afe032a819eull},
+    {0xf79687aed3eec551ull, 0x3a83ddbd83f52205ull},
+    {0x9abe14cd44753b52ull, 0xc4926a9672793543ull},
+    {0xc16d9a0095928a27ull, 0x75b7053c0f178294ull},
+    {0xf1c90080baf72cb1ull, 0x5324c68b12dd6339ull},
+    {0x971da05074da7beeull, 0xd3f6fc16ebca5e04ull},
+    {0xbce5086492111aeaull, 0x88f4bb1ca6bcf585ull},
+    {0xec1e4a7db69561a5ull, 0x2b31e9e3d06c32e6ull},
+    {0x9392ee8e921d5d07ull, 0x3aff322e62439fd0ull},
+    {0xb877aa3236a4b449ull, 0x09befeb9fad487c3ull},
+    {0xe69594bec44de15bull, 0x4c2ebe687989a9b4ull},
+    {0x901d7cf73ab0acd9ull, 0x0f9d37014bf60a11ull},
+    {0xb424dc35095cd80full, 0x538484c19ef38c95ull},
+    {0xe12e13424bb40e13ull, 0x2865a5f206b06fbaull},
+    {0x8cbccc096f5088cbull, 0xf93f87b7442e45d4ull},
+    {0xafebff0bcb24aafeull, 0xf78f69a51539d749ull},
+    {0xdbe6fecebdedd5beull, 0xb573440e5a884d1cull},
+    {0x89705f4136b4a597ull, 0x31680a88f8953031ull},
+    {0xabcc77118461cefcull, 0xfdc20d2b36ba7c3eull},
+    {0xd6bf94d5e57a42bcull, 0x3d32907604691b4dull},
+    {0x8637bd05af6c69b5ull, 0xa63f9a49c2c1b110ull},
+    {0xa7c5ac471b478423ull, 0x0fcf80dc33721d54ull},
+    {0xd1b71758e219652bull, 0xd3c36113404ea4a9ull},
+    {0x83126e978d4fdf3bull, 0x645a1cac083126eaull},
+    {0xa3d70a3d70a3d70aull, 0x3d70a3d70a3d70a4ull},
+    {0xccccccccccccccccull, 0xcccccccccccccccdull},
+    {0x8000000000000000ull, 0x0000000000000000ull},
+    {0xa000000000000000ull, 0x0000000000000000ull},
+    {0xc800000000000000ull, 0x0000000000000000ull},
+    {0xfa00000000000000ull, 0x0000000000000000ull},
+    {0x9c40000000000000ull, 0x0000000000000000ull},
+    {0xc350000000000000ull, 0x0000000000000000ull},
+    {0xf424000000000000ull, 0x0000000000000000ull},
+    {0x9896800000000000ull, 0x0000000000000000ull},
+    {0xbebc200000000000ull, 0x0000000000000000ull},
+    {0xee6b280000000000ull, 0x0000000000000000ull},
+    {0x9502f90000000000ull, 0x0000000000000000ull},
+    {0xba43b74000000000ull, 0x0000000000000000ull},
+    {0xe8d4a51000000000ull, 0x0000000000000000ull},
+    {0x9184e72a00000000ull, 0x0000000000000000ull},
+    {0xb5e620f480000000ull, 0x0000000000000000ull},
+    {0xe35fa931a0000000ull, 0x0000000000000000ull},
+    {0x8e1bc9bf04000000ull, 0x0000000000000000ull},
+    {0xb1a2bc2ec5000000ull, 0x0000000000000000ull},
+    {0xde0b6b3a76400000ull, 0x0000000000000000ull},
+    {0x8ac7230489e80000ull, 0x0000000000000000ull},
+    {0xad78ebc5ac620000ull, 0x0000000000000000ull},
+    {0xd8d726b7177a8000ull, 0x0000000000000000ull},
+    {0x878678326eac9000ull, 0x0000000000000000ull},
+    {0xa968163f0a57b400ull, 0x0000000000000000ull},
+    {0xd3c21bcecceda100ull, 0x0000000000000000ull},
+    {0x84595161401484a0ull, 0x0000000000000000ull},
+    {0xa56fa5b99019a5c8ull, 0x0000000000000000ull},
+    {0xcecb8f27f4200f3aull, 0x0000000000000000ull},
+    {0x813f3978f8940984ull, 0x4000000000000000ull},
+    {0xa18f07d736b90be5ull, 0x5000000000000000ull},
+    {0xc9f2c9cd04674edeull, 0xa400000000000000ull},
+    {0xfc6f7c4045812296ull, 0x4d00000000000000ull},
+    {0x9dc5ada82b70b59dull, 0xf020000000000000ull},
+    {0xc5371912364ce305ull, 0x6c28000000000000ull},
+    {0xf684df56c3e01bc6ull, 0xc732000000000000ull},
+    {0x9a130b963a6c115cull, 0x3c7f400000000000ull},
+    {0xc097ce7bc90715b3ull, 0x4b9f100000000000ull},
+    {0xf0bdc21abb48db20ull, 0x1e86d40000000000ull},
+    {0x96769950b50d88f4ull, 0x1314448000000000ull},
+    {0xbc143fa4e250eb31ull, 0x17d955a000000000ull},
+    {0xeb194f8e1ae525fdull, 0x5dcfab0800000000ull},
+    {0x92efd1b8d0cf37beull, 0x5aa1cae500000000ull},
+    {0xb7abc627050305adull, 0xf14a3d9e40000000ull},
+    {0xe596b7b0c643c719ull, 0x6d9ccd05d0000000ull},
+    {0x8f7e32ce7bea5c6full, 0xe4820023a2000000ull},
+    {0xb35dbf821ae4f38bull, 0xdda2802c8a800000ull},
+    {0xe0352f62a19e306eull, 0xd50b2037ad200000ull},
+    {0x8c213d9da502de45ull, 0x4526f422cc340000ull},
+    {0xaf298d050e4395d6ull, 0x9670b12b7f410000ull},
+    {0xdaf3f04651d47b4cull, 0x3c0cdd765f114000ull},
+    {0x88d8762bf324cd0full, 0xa5880a69fb6ac800ull},
+    {0xab0e93b6efee0053ull, 0x8eea0d047a457a00ull},
+    {0xd5d238a4abe98068ull, 0x72a4904598d6d880ull},
+    {0x85a36366eb71f041ull, 0x47a6da2b7f864750ull},
+    {0xa70c3c40a64e6c51ull, 0x999090b65f67d924ull},
+    {0xd0cf4b50cfe20765ull, 0xfff4b4e3f741cf6dull},
+    {0x82818f1281ed449full, 0xbff8f10e7a8921a4ull},
+    {0xa321f2d7226895c7ull, 0xaff72d52192b6a0dull},
+    {0xcbea6f8ceb02bb39ull, 0x9bf4f8a69f764490ull},
+    {0xfee50b7025c36a08ull, 0x02f236d04753d5b4ull},
+    {0x9f4f2726179a2245ull, 0x01d762422c946590ull},
+    {0xc722f0ef9d80aad6ull, 0x424d3ad2b7b97ef5ull},
+    {0xf8ebad2b84e0d58bull, 0xd2e0898765a7deb2ull},
+    {0x9b934c3b330c8577ull, 0x63cc55f49f88eb2full},
+    {0xc2781f49ffcfa6d5ull, 0x3cbf6b71c76b25fbull},
+    {0xf316271c7fc3908aull, 0x8bef464e3945ef7aull},
+    {0x97edd871cfda3a56ull, 0x97758bf0e3cbb5acull},
+    {0xbde94e8e43d0c8ecull, 0x3d52eeed1cbea317ull},
+    {0xed63a231d4c4fb27ull, 0x4ca7aaa863ee4bddull},
+    {0x945e455f24fb1cf8ull, 0x8fe8caa93e74ef6aull},
+    {0xb975d6b6ee39e436ull, 0xb3e2fd538e122b44ull},
+    {0xe7d34c64a9c85d44ull, 0x60dbbca87196b616ull},
+    {0x90e40fbeea1d3a4aull, 0xbc8955e946fe31cdull},
+    {0xb51d13aea4a488ddull, 0x6babab6398bdbe41ull},
+    {0xe264589a4dcdab14ull, 0xc696963c7eed2dd1ull},
+    {0x8d7eb76070a08aecull, 0xfc1e1de5cf543ca2ull},
+    {0xb0de65388cc8ada8ull, 0x3b25a55f43294bcbull},
+    {0xdd15fe86affad912ull, 0x49ef0eb713f39ebeull},
+    {0x8a2dbf142dfcc7abull, 0x6e3569326c784337ull},
+    {0xacb92ed9397bf996ull, 0x49c2c37f07965404ull},
+    {0xd7e77a8f87daf7fbull, 0xdc33745ec97be906ull},
+    {0x86f0ac99b4e8dafdull, 0x69a028bb3ded71a3ull},
+    {0xa8acd7c0222311bcull, 0xc40832ea0d68ce0cull},
+    {0xd2d80db02aabd62bull, 0xf50a3fa490c30190ull},
+    {0x83c7088e1aab65dbull, 0x792667c6da79e0faull},
+    {0xa4b8cab1a1563f52ull, 0x577001b891185938ull},
+    {0xcde6fd5e09abcf26ull, 0xed4c0226b55e6f86ull},
+    {0x80b05e5ac60b6178ull, 0x544f8158315b05b4ull},
+    {0xa0dc75f1778e39d6ull, 0x696361ae3db1c721ull},
+    {0xc913936dd571c84cull, 0x03bc3a19cd1e38e9ull},
+    {0xfb5878494ace3a5full, 0x04ab48a04065c723ull},
+    {0x9d174b2dcec0e47bull, 0x62eb0d64283f9c76ull},
+    {0xc45d1df942711d9aull, 0x3ba5d0bd324f8394ull},
+    {0xf5746577930d6500ull, 0xca8f44ec7ee36479ull},
+    {0x9968bf6abbe85f20ull, 0x7e998b13cf4e1ecbull},
+    {0xbfc2ef456ae276e8ull, 0x9e3fedd8c321a67eull},
+    {0xefb3ab16c59b14a2ull, 0xc5cfe94ef3ea101eull},
+    {0x95d04aee3b80ece5ull, 0xbba1f1d158724a12ull},
+    {0xbb445da9ca61281full, 0x2a8a6e45ae8edc97ull},
+    {0xea1575143cf97226ull, 0xf52d09d71a3293bdull},
+    {0x924d692ca61be758ull, 0x593c2626705f9c56ull},
+    {0xb6e0c377cfa2e12eull, 0x6f8b2fb00c77836cull},
+    {0xe498f455c38b997aull, 0x0b6dfb9c0f956447ull},
+    {0x8edf98b59a373fecull, 0x4724bd4189bd5eacull},
+    {0xb2977ee300c50fe7ull, 0x58edec91ec2cb657ull},
+    {0xdf3d5e9bc0f653e1ull, 0x2f2967b66737e3edull},
+    {0x8b865b215899f46cull, 0xbd79e0d20082ee74ull},
+    {0xae67f1e9aec07187ull, 0xecd8590680a3aa11ull},
+    {0xda01ee641a708de9ull, 0xe80e6f4820cc9495ull},
+    {0x884134fe908658b2ull, 0x3109058d147fdcddull},
+    {0xaa51823e34a7eedeull, 0xbd4b46f0599fd415ull},
+    {0xd4e5e2cdc1d1ea96ull, 0x6c9e18ac7007c91aull},
+    {0x850fadc09923329eull, 0x03e2cf6bc604ddb0ull},
+    {0xa6539930bf6bff45ull, 0x84db8346b786151cull},
+    {0xcfe87f7cef46ff16ull, 0xe612641865679a63ull},
+    {0x81f14fae158c5f6eull, 0x4fcb7e8f3f60c07eull},
+    {0xa26da3999aef7749ull, 0xe3be5e330f38f09dull},
+    {0xcb090c8001ab551cull, 0x5cadf5bfd3072cc5ull},
+    {0xfdcb4fa002162a63ull, 0x73d9732fc7c8f7f6ull},
+    {0x9e9f11c4014dda7eull, 0x2867e7fddcdd9afaull},
+    {0xc646d63501a1511dull, 0xb281e1fd541501b8ull},
+    {0xf7d88bc24209a565ull, 0x1f225a7ca91a4226ull},
+    {0x9ae757596946075full, 0x3375788de9b06958ull},
+    {0xc1a12d2fc3978937ull, 0x0052d6b1641c83aeull},
+    {0xf209787bb47d6b84ull, 0xc0678c5dbd23a49aull},
+    {0x9745eb4d50ce6332ull, 0xf840b7ba963646e0ull},
+    {0xbd176620a501fbffull, 0xb650e5a93bc3d898ull},
+    {0xec5d3fa8ce427affull, 0xa3e51f138ab4cebeull},
+    {0x93ba47c980e98cdfull, 0xc66f336c36b10137ull},
+  };
+
+
+  /*
+   * Multiply two 64-bit values, returning the low 64 bits of the product, and storing the high 64 bits in high.
+   *
+   */
+
+  uint64_t fullMultiply(uint64_t x, uint64_t y, uint64_t* high) {
+    constexpr uint64_t mask32 {0xffffffffu};
+
+    uint64_t a {x >> 32};
+    uint64_t b {x & mask32};
+    uint64_t c {y >> 32};
+    uint64_t d {y & mask32};
+
+    uint64_t ac {a * c};
+    uint64_t bc {b * c};
+    uint64_t ad {a * d};
+    uint64_t bd {b * d};
+
+    uint64_t middle {(bd >> 32) + (ad & mask32) + (bc & mask32)};
+    *high = ac + (ad >> 32) + (bc >> 32) + (middle >> 32);
+
+    return (middle << 32) | (bd & mask32);
+  }
+
+
+  /*
+   * floor(log2(10^q)) + 63, computed without floating-point. Valid for |q| < 1233.
+   *
+   */
+
+  inline int binaryExponentFor(int q) {
+    return (((152170 + 65536) * q) >> 16) + 63;
+  }
+
+
+  /*
+   * Compute the double nearest to w * 10^q, for non-zero w and q within the table. Returns false if the result cannot
+   * be determined.
+   *
+   */
+
+  bool eiselLemire(uint64_t w, int q, double* result) {
+    V8MONKEY_ASSERT(w != 0, "Zero significand");
+    V8MONKEY_ASSERT(q >= smallestPowerOfTen && q <= largestPowerOfTen, "Power of ten out of range");
+
+    int leadingZeros {__builtin_clzll(w)};
+    w <<= leadingZeros;
+
+    const uint64_t* power {powersOfFive[q - smallestPowerOfTen]};
+
+    // We need the top 55 bits of the product to be exact: 53 for the significand, one to detect the leading bit's
+    // position, and one for rounding. If the remaining bits of the high word are all ones, the truncated low
+    // part of the power might matter, so take it into account.
+    constexpr uint64_t precisionMask {0xffffffffffffffffull >> (doubleSignificandSize + 3)};
+
+    uint64_t productHigh;
+    uint64_t productLow {fullMultiply(w, power[0], &productHigh)};
+
+    if ((productHigh & precisionMask) == precisionMask) {
+      uint64_t secondHigh;
+      fullMultiply(w, power[1], &secondHigh);
+
+      productLow += secondHigh;
+      if (secondHigh > productLow) {
+        productHigh++;
+      }
+
+      // The conservative check from the original algorithm: the product might still be inexact
+      if (productLow == 0xffffffffffffffffull && (q < -27 || q > 55)) {
+        return false;
+      }
+    }
+
+    int upperBit {static_cast<int>(productHigh >> 63)};
+    int shift {upperBit + 64 - doubleSignificandSize - 3};
+    uint64_t significand {productHigh >> shift};
+
+    int biasedExponent {binaryExponentFor(q) + upperBit - leadingZeros + doubleExponentBias};
+
+    // The restricted power range means the result is always a finite normal double
+    V8MONKEY_ASSERT(biasedExponent > 0 && biasedExponent < 0x7fe, "Result out of normal range");
+
+    // The product might be exactly halfway between two doubles, in which case we must round to even. This is only
+    // possible for powers where 5^q fits in 64 bits (q in [0, 23]), or 2^64 / 5^-q is an integer (q in [-4, 0]).
+    if (productLow <= 1 && q >= -4 && q <= 23 && (significand & 3) == 1 && (significand << shift) == productHigh) {
+      significand &= ~static_cast<uint64_t>(1);
+    }
+
+    // Round to nearest
+    significand += significand & 1;
+    significand >>= 1;
+
+    // Rounding up might have carried into a new bit
+    if (significand >= (2ull << doubleSignificandSize)) {
+      significand = 1ull << doubleSignificandSize;
+      biasedExponent++;
+    }
+
+    significand &= ~(1ull << doubleSignificandSize);
+
+    uint64_t bits {significand | (static_cast<uint64_t>(biasedExponent) << doubleSignificandSize)};
+    std::memcpy(result, &bits, sizeof(*result));
+    return true;
+  }
+
+
+  /*
+   * Clinger's fast path. Only valid when intermediate results are not held at extended precision.
+   *
+   */
+
+  bool clinger(uint64_t w, int q, double* result) {
+    #if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+    static const double exactPowersOfTen[] {
+      1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    if (w > maxExactInteger || q < -22 || q > 22) {
+      return false;
+    }
+
+    double value {static_cast<double>(w)};
+    *result = q < 0 ? value / exactPowersOfTen[-q] : value * exactPowersOfTen[q];
+    return true;
+    #else
+    static_cast<void>(w);
+    static_cast<void>(q);
+    static_cast<void>(result);
+    return false;
+    #endif
+  }
+}
+
+
+namespace v8 {
+  namespace V8Monkey {
+    namespace Conversions {
+      bool StringToDouble(const char* chars, size_t length, double* result) {
+        // ECMA-262 9.3.1: the empty string converts to zero
+        if (length == 0) {
+          *result = 0.0;
+          return true;
+        }
+
+        const char* p {chars};
+        const char* end {chars + length};
+
+        bool negative {false};
+        if (*p == '-' || *p == '+') {
+          negative = *p == '-';
+          p++;
+        }
+
+        const char* digitsStart {p};
+        uint64_t w {0};
+
+        p = parseDigits(p, end, &w);
+        ptrdiff_t digitCount {p - digitsStart};
+
+        int fractionDigits {0};
+        if (p < end && *p == '.') {
+          p++;
+          const char* fractionStart {p};
+          p = parseDigits(p, end, &w);
+
+          ptrdiff_t fractionLength {p - fractionStart};
+          if (fractionLength > maxFractionDigits) {
+            return false;
+          }
+
+          digitCount += fractionLength;
+          fractionDigits = static_cast<int>(fractionLength);
+        }
+
+        // Rejects ".", "+", "Infinity", "0x1f" etc.
+        if (digitCount == 0) {
+          return false;
+        }
+
+        int exponent {0};
+        if (p < end && (*p == 'e' || *p == 'E')) {
+          p++;
+
+          bool negativeExponent {false};
+          if (p < end && (*p == '-' || *p == '+')) {
+            negativeExponent = *p == '-';
+            p++;
+          }
+
+          if (p == end || !isDigit(*p)) {
+            return false;
+          }
+
+          while (p < end && isDigit(*p)) {
+            // Saturate: anything this large is out of range anyway
+            if (exponent < 100000) {
+              exponent = exponent * 10 + (*p - '0');
+            }
+            p++;
+          }
+
+          exponent = negativeExponent ? -exponent : exponent;
+        }
+
+        // Trailing garbage or whitespace
+        if (p != end) {
+          return false;
+        }
+
+        // Leading zeros, and the decimal point, do not count towards the significant digits
+        if (digitCount > maxSignificantDigits) {
+          for (const char* c = digitsStart; c < end && (*c == '0' || *c == '.'); c++) {
+            if (*c == '0') {
+              digitCount--;
+            }
+          }
+
+          if (digitCount > maxSignificantDigits) {
+            return false;
+          }
+        }
+
+        double value;
+        int q {exponent - fractionDigits};
+
+        if (w == 0) {
+          value = 0.0;
+        } else if (q == 0 && w <= maxExactInteger) {
+          value = static_cast<double>(w);
+        } else if (!clinger(w, q, &value)) {
+          if (q < smallestPowerOfTen || q > largestPowerOfTen || !eiselLemire(w, q, &value)) {
+            return false;
+          }
+        }
+
+        *result = negative ? -value : value;
+        return true;
+      }
+    }
+  }
+}
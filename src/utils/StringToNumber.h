@@ -0,0 +1,43 @@
+#ifndef V8MONKEY_STRINGTONUMBER_H
+#define V8MONKEY_STRINGTONUMBER_H
+
+// size_t
+#include <cstddef>
+
+// EXPORT_FOR_TESTING_ONLY
+#include "utils/test.h"
+
+
+namespace v8 {
+  namespace V8Monkey {
+    namespace Conversions {
+
+      /*
+       * A fast path for ECMA-262 9.3.1 ToNumber applied to strings, for the common case of a plain decimal literal:
+       * an optional sign, digits with an optional decimal point, and an optional exponent. Integers are parsed eight
+       * digits at a time using SWAR arithmetic, and the conversion to a correctly rounded double uses either Clinger's
+       * fast path (when the value and power of ten are both exactly representable) or the Eisel-Lemire algorithm.
+       *
+       * Returns false for any input the fast path does not handle, without modifying result. Callers must then fall
+       * back to SpiderMonkey's full ToNumber. This covers anything that is not a decimal literal (including
+       * "Infinity", hex/octal/binary literals and strings that would convert to NaN), strings with leading or trailing
+       * whitespace, strings with more than 19 significant digits, and values whose decimal exponent is outside
+       * [-128, 128].
+       *
+       * The characters are expected to be Latin1 (of which ASCII is a subset); no character outside ASCII can appear in
+       * a string accepted by the fast path.
+       *
+       */
+
+      EXPORT_FOR_TESTING_ONLY bool StringToDouble(const char* chars, size_t length, double* result);
+
+
+      inline bool StringToDouble(const unsigned char* chars, size_t length, double* result) {
+        return StringToDouble(reinterpret_cast<const char*>(chars), length, result);
+      }
+    }
+  }
+}
+
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef V8MONKEY_SPIDERMONKEYTESTUTILS_H
+#define V8MONKEY_SPIDERMONKEYTESTUTILS_H
+
+// size_t
+#include <cstddef>
+
+// string
+#include <string>
+
+// JSAutoCompartment JSAutoRequest JSContext JS::RootedObject
+#include "jsapi.h"
+
+// ExternalAsciiStringResource
+#include "types/string_wrapper.h"
+
+// EnsureRuntimeAndContext GetJSContextForThread NewGlobal
+#include "utils/SpiderMonkeyUtils.h"
+
+
+/*
+ * Scaffolding for the internal tests that work with SpiderMonkey directly, rather than through the API.
+ *
+ */
+
+namespace v8 {
+  namespace TestUtils {
+    inline JSContext* EnsureContext() {
+      SpiderMonkey::EnsureRuntimeAndContext();
+      return SpiderMonkey::GetJSContextForThread();
+    }
+
+
+    // Most of the JSAPI can only be used within a compartment: this enters a new global for its lifetime
+    struct InCompartment {
+      JSContext* cx;
+      JSAutoRequest ar;
+      JS::RootedObject global;
+      JSAutoCompartment ac;
+
+      InCompartment() : cx {EnsureContext()}, ar(cx), global(cx, SpiderMonkey::NewGlobal(cx)), ac(cx, global) {}
+    };
+
+
+    // A one-byte resource over a copy of the given bytes
+    struct BytesResource : public internal::ExternalAsciiStringResource {
+      explicit BytesResource(const std::string& b) : bytes {b} {}
+
+      const char* data() const override { return bytes.data(); }
+      size_t length() const override { return bytes.size(); }
+
+      std::string bytes;
+    };
+  }
+}
+
+
+#endif
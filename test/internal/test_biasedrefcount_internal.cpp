@@ -0,0 +1,559 @@
+// atomic
+#include <atomic>
+
+// this_thread thread::id
+#include <thread>
+
+// vector
+#include <vector>
+
+// The class under test
+#include "data_structures/biased_refcount.h"
+
+// Thread
+#include "platform/platform.h"
+
+// internal::Isolate::FromAPIIsolate
+#include "runtime/isolate.h"
+
+// Isolate Isolate::Scope
+#include "v8.h"
+
+// Unit-testing support
+#include "V8MonkeyTest.h"
+
+
+using namespace v8;
+using namespace v8::DataStructures;
+using namespace v8::V8Platform;
+
+
+namespace {
+  std::atomic<int> deletionCount {0};
+
+
+  class Counted : public BiasedRefCounted {
+    public:
+      Counted() = default;
+
+      ~Counted() {
+        deletionCount++;
+      }
+  };
+
+
+  // Take and release a reference from a thread that does not own the object
+  extern "C"
+  void* addRefAndRelease(void* arg) {
+    Counted* obj {reinterpret_cast<Counted*>(arg)};
+    obj->AddRef();
+    obj->Release();
+    return nullptr;
+  }
+
+
+  // Release a reference that was taken on the owning thread
+  extern "C"
+  void* releaseOnly(void* arg) {
+    Counted* obj {reinterpret_cast<Counted*>(arg)};
+    obj->Release();
+    return nullptr;
+  }
+
+
+  // Take a reference from a thread that does not own the object, and keep it
+  extern "C"
+  void* addRefOnly(void* arg) {
+    Counted* obj {reinterpret_cast<Counted*>(arg)};
+    obj->AddRef();
+    return nullptr;
+  }
+
+
+  // Create an object, take a reference, and hand it back to the spawning thread
+  extern "C"
+  void* createAndReturn(void*) {
+    Counted* obj {new Counted};
+    obj->AddRef();
+    return obj;
+  }
+
+
+  struct HandOff {
+    std::atomic<Counted*> obj {nullptr};
+    std::atomic<bool> released {false};
+  };
+
+
+  // As above, but the owning thread stays alive until the spawning thread has released the reference
+  extern "C"
+  void* createAndWait(void* arg) {
+    HandOff* handOff {reinterpret_cast<HandOff*>(arg)};
+    Counted* obj {new Counted};
+    obj->AddRef();
+    handOff->obj = obj;
+
+    while (!handOff->released) {
+    }
+
+    return nullptr;
+  }
+
+
+  constexpr int stressThreads {4};
+  constexpr int stressObjects {16};
+  constexpr int stressIterations {20000};
+
+
+  // Hammer the reference counts of objects owned by another thread
+  extern "C"
+  void* stress(void* arg) {
+    std::vector<Counted*>* objects {reinterpret_cast<std::vector<Counted*>*>(arg)};
+
+    for (int i = 0; i < stressIterations; i++) {
+      for (auto obj : *objects) {
+        obj->AddRef();
+      }
+
+      for (auto obj : *objects) {
+        obj->Release();
+      }
+    }
+
+    return nullptr;
+  }
+
+
+  // Release one owner-taken reference to each object, simulating handles passed between threads
+  extern "C"
+  void* releaseAll(void* arg) {
+    std::vector<Counted*>* objects {reinterpret_cast<std::vector<Counted*>*>(arg)};
+
+    for (auto obj : *objects) {
+      obj->Release();
+    }
+
+    return nullptr;
+  }
+
+
+  /*
+   * Objects belonging to an isolate. Each records how often it was deleted, and whether it was deleted on a thread
+   * other than the expected one.
+   *
+   */
+
+  constexpr int isolateObjects {16};
+  std::atomic<int> isolateDeletions[isolateObjects] {};
+  std::atomic<int> deletionsElsewhere {0};
+
+
+  class IsolateCounted : public BiasedRefCounted {
+    public:
+      IsolateCounted(Isolate* i, int n, std::thread::id t) : BiasedRefCounted {internal::Isolate::FromAPIIsolate(i)},
+                                                             index {n}, deleter {t} {}
+
+      ~IsolateCounted() {
+        isolateDeletions[index]++;
+
+        if (std::this_thread::get_id() != deleter) {
+          deletionsElsewhere++;
+        }
+      }
+
+    private:
+      int index;
+      std::thread::id deleter;
+  };
+
+
+  void resetIsolateDeletions() {
+    for (auto& deletions : isolateDeletions) {
+      deletions = 0;
+    }
+
+    deletionsElsewhere = 0;
+  }
+
+
+  bool allDeletedOnce() {
+    for (auto& deletions : isolateDeletions) {
+      if (deletions != 1) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+
+  bool noneDeleted() {
+    for (auto& deletions : isolateDeletions) {
+      if (deletions != 0) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+
+  /*
+   * Without Lockers, an isolate may only be used by one thread at a time, so the threads below take turns: each enters
+   * the isolate only while the others are waiting.
+   *
+   */
+
+  struct IsolateHandOff {
+    Isolate* isolate {nullptr};
+    std::vector<IsolateCounted*> objects {};
+    std::thread::id expectedDeleter {};
+    std::atomic<bool> created {false};
+    std::atomic<bool> released {false};
+    bool deletedBeforeReentry {false};
+  };
+
+
+  constexpr int releasers {4};
+
+
+  // Create objects in the isolate with one reference for each releasing thread, then wait for them to be released
+  extern "C"
+  void* createInIsolateAndWait(void* arg) {
+    IsolateHandOff* handOff {reinterpret_cast<IsolateHandOff*>(arg)};
+    handOff->expectedDeleter = std::this_thread::get_id();
+
+    {
+      Isolate::Scope scope {handOff->isolate};
+
+      for (int i = 0; i < isolateObjects; i++) {
+        handOff->objects.push_back(new IsolateCounted {handOff->isolate, i, handOff->expectedDeleter});
+
+        for (int j = 0; j < releasers; j++) {
+          handOff->objects.back()->AddRef();
+        }
+      }
+    }
+
+    handOff->created = true;
+    while (!handOff->released) {
+    }
+
+    // The releases are queued for us: they should only be merged once we have been back in the isolate
+    handOff->deletedBeforeReentry = !noneDeleted();
+
+    {
+      Isolate::Scope scope {handOff->isolate};
+    }
+
+    return nullptr;
+  }
+
+
+  // As above, but exit without re-entering the isolate, leaving the merges behind for the main thread
+  extern "C"
+  void* createInIsolateAndExit(void* arg) {
+    IsolateHandOff* handOff {reinterpret_cast<IsolateHandOff*>(arg)};
+
+    {
+      Isolate::Scope scope {handOff->isolate};
+
+      for (int i = 0; i < isolateObjects; i++) {
+        handOff->objects.push_back(new IsolateCounted {handOff->isolate, i, handOff->expectedDeleter});
+        handOff->objects.back()->AddRef();
+      }
+    }
+
+    handOff->created = true;
+    while (!handOff->released) {
+    }
+
+    return nullptr;
+  }
+
+
+  // Within the isolate, take and release a reference to each object, then release one of the owner's
+  extern "C"
+  void* releaseInIsolate(void* arg) {
+    IsolateHandOff* handOff {reinterpret_cast<IsolateHandOff*>(arg)};
+    Isolate::Scope scope {handOff->isolate};
+
+    for (auto obj : handOff->objects) {
+      obj->AddRef();
+      obj->Release();
+      obj->Release();
+    }
+
+    return nullptr;
+  }
+}
+
+
+V8MONKEY_TEST(IntBiasedRefCount001, "Object initially has zero refcount") {
+  Counted* obj {new Counted};
+  V8MONKEY_CHECK(obj->RefCount() == 0, "Refcount is zero");
+  delete obj;
+}
+
+
+V8MONKEY_TEST(IntBiasedRefCount002, "Owner AddRef increments refcount") {
+  Counted* obj {new Counted};
+  obj->AddRef();
+  obj->AddRef();
+  V8MONKEY_CHECK(obj->RefCount() == 2, "Refcount is correct");
+  V8MONKEY_CHECK(!obj->IsMerged(), "Object still biased");
+  delete obj;
+}
+
+
+V8MONKEY_TEST(IntBiasedRefCount003, "Owner Release deletes when refcount reaches zero") {
+  deletionCount = 0;
+  Counted* obj {new Counted};
+  obj->AddRef();
+  obj->AddRef();
+  obj->Release();
+  V8MONKEY_CHECK(deletionCount == 0, "Object not deleted while referenced");
+  obj->Release();
+  V8MONKEY_CHECK(deletionCount == 1, "Object deleted");
+}
+
+
+V8MONKEY_TEST(IntBiasedRefCount004, "Non-owner references are counted") {
+  deletionCount = 0;
+  Counted* obj {new Counted};
+  obj->AddRef();
+
+  Thread t {addRefAndRelease};
+  t.Run(obj);
+  t.Join();
+
+  V8MONKEY_CHECK(obj->RefCount() == 1, "Refcount is correct");
+  V8MONKEY_CHECK(deletionCount == 0, "Object not deleted");
+  obj->Release();
+  V8MONKEY_CHECK(deletionCount == 1, "Object deleted");
+}
+
+
+V8MONKEY_TEST(IntBiasedRefCount005, "Non-owner release of owner reference is merged by owner") {
+  deletionCount = 0;
+  Counted* obj {new Counted};
+  obj->AddRef();
+
+  Thread t {releaseOnly};
+  t.Run(obj);
+  t.Join();
+
+  V8MONKEY_CHECK(deletionCount == 0, "Object not deleted before merge");
+  BiasedRefCounted::ProcessQueuedMerges();
+  V8MONKEY_CHECK(deletionCount == 1, "Object deleted on merge");
+}
+
+
+V8MONKEY_TEST(IntBiasedRefCount006, "Owner dropping to zero unbiases object while still referenced") {
+  deletionCount = 0;
+  Counted* obj {new Counted};
+  obj->AddRef();
+
+  Thread t {addRefOnly};
+  t.Run(obj);
+  t.Join();
+
+  obj->Release();
+  V8MONKEY_CHECK(obj->IsMerged(), "Object was merged");
+  V8MONKEY_CHECK(obj->RefCount() == 1, "Refcount is correct");
+  V8MONKEY_CHECK(deletionCount == 0, "Object not deleted");
+
+  // Now unbiased, so the owner uses the shared counter
+  obj->AddRef();
+  obj->Release();
+  V8MONKEY_CHECK(deletionCount == 0, "Object not deleted");
+  obj->Release();
+  V8MONKEY_CHECK(deletionCount == 1, "Object deleted");
+}
+
+
+V8MONKEY_TEST(IntBiasedRefCount007, "Releasing thread performs merge once owner has exited") {
+  deletionCount = 0;
+  Thread t {createAndReturn};
+  t.Run();
+  Counted* obj {reinterpret_cast<Counted*>(t.Join())};
+
+  V8MONKEY_CHECK(obj->RefCount() == 1, "Refcount is correct");
+  obj->AddRef();
+  obj->Release();
+  V8MONKEY_CHECK(deletionCount == 0, "Object not deleted");
+  obj->Release();
+  V8MONKEY_CHECK(deletionCount == 1, "Object deleted");
+}
+
+
+V8MONKEY_TEST(IntBiasedRefCount008, "Owner thread exit processes queued merges") {
+  deletionCount = 0;
+  HandOff handOff {};
+  Thread t {createAndWait};
+  t.Run(&handOff);
+
+  Counted* obj {nullptr};
+  while (!(obj = handOff.obj.load())) {
+  }
+
+  // The owner is still alive, so must perform the merge
+  obj->Release();
+  V8MONKEY_CHECK(deletionCount == 0, "Object not deleted while owner alive");
+
+  handOff.released = true;
+  t.Join();
+  V8MONKEY_CHECK(deletionCount == 1, "Object deleted");
+}
+
+
+V8MONKEY_TEST(IntBiasedRefCount009, "Refcounts are correct under contention") {
+  deletionCount = 0;
+  std::vector<Counted*> objects;
+  for (int i = 0; i < stressObjects; i++) {
+    objects.push_back(new Counted);
+    objects.back()->AddRef();
+  }
+
+  // While the other threads contend on the shared counter, the owner keeps using the biased counter
+  std::vector<Thread> threads;
+  threads.reserve(stressThreads);
+  for (int i = 0; i < stressThreads; i++) {
+    threads.emplace_back(stress);
+    threads.back().Run(&objects);
+  }
+
+  for (int i = 0; i < stressIterations; i++) {
+    for (auto obj : objects) {
+      obj->AddRef();
+      obj->Release();
+    }
+  }
+
+  for (auto& t : threads) {
+    t.Join();
+  }
+
+  V8MONKEY_CHECK(deletionCount == 0, "No objects deleted");
+  for (auto obj : objects) {
+    V8MONKEY_CHECK(obj->RefCount() == 1, "Refcount is correct");
+    obj->Release();
+  }
+
+  V8MONKEY_CHECK(deletionCount == stressObjects, "All objects deleted");
+}
+
+
+V8MONKEY_TEST(IntBiasedRefCount010, "Cross-thread releases are correct under contention") {
+  deletionCount = 0;
+  std::vector<Counted*> objects;
+  for (int i = 0; i < stressObjects; i++) {
+    objects.push_back(new Counted);
+
+    // One reference for each releasing thread, and one for the owner
+    for (int j = 0; j <= stressThreads; j++) {
+      objects.back()->AddRef();
+    }
+  }
+
+  std::vector<Thread> threads;
+  threads.reserve(stressThreads);
+  for (int i = 0; i < stressThreads; i++) {
+    threads.emplace_back(releaseAll);
+    threads.back().Run(&objects);
+  }
+
+  for (auto& t : threads) {
+    t.Join();
+  }
+
+  BiasedRefCounted::ProcessQueuedMerges();
+  V8MONKEY_CHECK(deletionCount == 0, "No objects deleted");
+
+  for (auto obj : objects) {
+    V8MONKEY_CHECK(obj->RefCount() == 1, "Refcount is correct");
+    obj->Release();
+  }
+
+  V8MONKEY_CHECK(deletionCount == stressObjects, "All objects deleted");
+}
+
+
+V8MONKEY_TEST(IntBiasedRefCount011, "Merges queued by other threads are performed once, by the owner") {
+  resetIsolateDeletions();
+  IsolateHandOff handOff {};
+  handOff.isolate = Isolate::New();
+
+  Thread owner {createInIsolateAndWait};
+  owner.Run(&handOff);
+  while (!handOff.created) {
+  }
+
+  for (int i = 0; i < releasers; i++) {
+    Thread releaser {releaseInIsolate};
+    releaser.Run(&handOff);
+    releaser.Join();
+  }
+
+  handOff.released = true;
+  owner.Join();
+
+  V8MONKEY_CHECK(!handOff.deletedBeforeReentry, "Objects not deleted before the owner re-entered the isolate");
+  V8MONKEY_CHECK(allDeletedOnce(), "Each object deleted exactly once");
+  V8MONKEY_CHECK(deletionsElsewhere == 0, "Objects only deleted by their owner");
+
+  handOff.isolate->Dispose();
+}
+
+
+V8MONKEY_TEST(IntBiasedRefCount012, "Merges left by an exited owner are performed by the next thread in the isolate") {
+  resetIsolateDeletions();
+  IsolateHandOff handOff {};
+  handOff.isolate = Isolate::New();
+  handOff.expectedDeleter = std::this_thread::get_id();
+
+  Thread owner {createInIsolateAndExit};
+  owner.Run(&handOff);
+  while (!handOff.created) {
+  }
+
+  // Release the owner's references while it is still alive, so the merges are queued for it
+  Thread releaser {releaseInIsolate};
+  releaser.Run(&handOff);
+  releaser.Join();
+
+  handOff.released = true;
+  owner.Join();
+  V8MONKEY_CHECK(noneDeleted(), "Objects not deleted by the exiting owner");
+
+  {
+    Isolate::Scope scope {handOff.isolate};
+  }
+
+  V8MONKEY_CHECK(allDeletedOnce(), "Each object deleted exactly once");
+  V8MONKEY_CHECK(deletionsElsewhere == 0, "Objects only deleted by the thread that took them over");
+
+  handOff.isolate->Dispose();
+}
+
+
+V8MONKEY_TEST(IntBiasedRefCount013, "Retiring a thread processes its queued merges") {
+  deletionCount = 0;
+  Counted* obj {new Counted};
+  obj->AddRef();
+
+  Thread t {releaseOnly};
+  t.Run(obj);
+  t.Join();
+
+  V8MONKEY_CHECK(deletionCount == 0, "Object not deleted before merge");
+  BiasedRefCounted::RetireCurrentThread();
+  V8MONKEY_CHECK(deletionCount == 1, "Object deleted when thread retired");
+
+  // Objects created afterwards are owned by the thread once more
+  obj = new Counted;
+  obj->AddRef();
+  V8MONKEY_CHECK(!obj->IsMerged(), "Object biased towards new owner");
+  obj->Release();
+  V8MONKEY_CHECK(deletionCount == 2, "Object deleted");
+}
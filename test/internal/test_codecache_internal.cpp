@@ -0,0 +1,288 @@
+// mkdtemp
+#include <cstdlib>
+
+// unique_ptr
+#include <memory>
+
+// string, u16string
+#include <string>
+
+// vector
+#include <vector>
+
+// AT_FDCWD
+#include <fcntl.h>
+
+// timespec utimensat
+#include <sys/stat.h>
+
+// rmdir
+#include <unistd.h>
+
+// JS_ClearPendingException, JS_IsExceptionPending, JS::RootedValue
+#include "jsapi.h"
+
+// FileSystem
+#include "platform/platform.h"
+
+// The class under test
+#include "runtime/code_cache.h"
+
+// ScriptOrigin ScriptSource ScriptWrapper
+#include "types/script_wrapper.h"
+
+// BytesResource InCompartment
+#include "SpiderMonkeyTestUtils.h"
+
+// Unit-testing support
+#include "V8MonkeyTest.h"
+
+
+using namespace v8::internal;
+using namespace v8::TestUtils;
+using namespace v8::V8Platform;
+
+
+namespace {
+  // A scratch directory, removed along with its contents when the test completes
+  struct TempDirectory {
+    std::string path;
+
+    TempDirectory() {
+      char name[] {"/tmp/v8monkey_test_XXXXXX"};
+      path = mkdtemp(name);
+    }
+
+    ~TempDirectory() {
+      for (const auto& entry : list()) {
+        FileSystem::Remove((path + '/' + entry.name).c_str());
+      }
+
+      rmdir(path.c_str());
+    }
+
+    std::vector<FileSystem::Entry> list() const {
+      std::vector<FileSystem::Entry> entries;
+      FileSystem::ListFiles(path.c_str(), "", entries);
+      return entries;
+    }
+
+    size_t bytes() const {
+      size_t total {0};
+      for (const auto& entry : list()) {
+        total += entry.size;
+      }
+
+      return total;
+    }
+
+    // Make the entry appear to have last been used the given number of seconds after the epoch
+    void setLastUsed(const std::string& name, time_t seconds) const {
+      const timespec times[2] {{seconds, 0}, {seconds, 0}};
+      utimensat(AT_FDCWD, (path + '/' + name).c_str(), times, 0);
+    }
+  };
+
+
+  const std::u16string answerSource {u"var x = 6; x * 7"};
+
+
+  bool runsToAnswer(JSContext* cx, ScriptWrapper* script) {
+    JS::RootedValue value(cx);
+    return script && script->Run(cx, &value) && value.isInt32() && value.toInt32() == 42;
+  }
+
+
+  // The name the cache gives the entry for the given key
+  std::string entryName(uint64_t key) {
+    static const char hexDigits[] {"0123456789abcdef"};
+
+    std::string name;
+    for (int shift = 60; shift >= 0; shift -= 4) {
+      name += hexDigits[(key >> shift) & 0xf];
+    }
+
+    return name + ".jsc";
+  }
+
+
+  // Compile the given text through the cache, returning whether the result ran correctly
+  bool compileAndRun(JSContext* cx, DiskCodeCache& cache, const std::u16string& text,
+                     const ScriptOrigin& origin = ScriptOrigin {}) {
+    ScriptSource source {text.data(), text.size(), origin};
+    std::unique_ptr<ScriptWrapper> script {cache.Compile(cx, source)};
+    return runsToAnswer(cx, script.get()) && !source.GetCachedData();
+  }
+
+
+  // U+00E9 in UTF-8: one character when read as UTF-8, but two when read as Latin1
+  const std::string nonASCIISource {"'\xc3\xa9'.length"};
+
+
+  // Compile nonASCIISource through the cache, read with the given encoding, and run it, returning the integer result,
+  // or -1 on failure
+  int compileBytes(JSContext* cx, DiskCodeCache& cache, ScriptSource::Encoding encoding) {
+    ScriptSource source {new BytesResource {nonASCIISource}, encoding};
+    std::unique_ptr<ScriptWrapper> script {cache.Compile(cx, source)};
+
+    JS::RootedValue value(cx);
+    return script && script->Run(cx, &value) && value.isInt32() ? value.toInt32() : -1;
+  }
+}
+
+
+V8MONKEY_TEST(IntCodeCache001, "Entries are written on a miss, and hit by later instances") {
+  InCompartment c;
+  TempDirectory dir;
+
+  {
+    DiskCodeCache cache {dir.path, 1 << 20};
+    V8MONKEY_CHECK(compileAndRun(c.cx, cache, answerSource), "Script ran correctly");
+    V8MONKEY_CHECK(cache.Misses() == 1 && cache.Hits() == 0, "Compilation missed");
+    V8MONKEY_CHECK(dir.list().size() == 1, "Entry written");
+  }
+
+  // As if after a restart
+  DiskCodeCache cache {dir.path, 1 << 20};
+  V8MONKEY_CHECK(compileAndRun(c.cx, cache, answerSource), "Script ran correctly");
+  V8MONKEY_CHECK(cache.Hits() == 1 && cache.Misses() == 0, "Compilation hit");
+  V8MONKEY_CHECK(compileAndRun(c.cx, cache, answerSource), "Script ran correctly");
+  V8MONKEY_CHECK(cache.Hits() == 2, "Compilation hit");
+}
+
+
+V8MONKEY_TEST(IntCodeCache002, "Entries are keyed by origin as well as source") {
+  InCompartment c;
+  TempDirectory dir;
+  DiskCodeCache cache {dir.path, 1 << 20};
+
+  V8MONKEY_CHECK(compileAndRun(c.cx, cache, answerSource, ScriptOrigin {"a.js", 0}), "Script ran correctly");
+  V8MONKEY_CHECK(compileAndRun(c.cx, cache, answerSource, ScriptOrigin {"b.js", 0}), "Script ran correctly");
+  V8MONKEY_CHECK(compileAndRun(c.cx, cache, answerSource, ScriptOrigin {"a.js", 3}), "Script ran correctly");
+  V8MONKEY_CHECK(cache.Misses() == 3 && cache.Hits() == 0, "Each origin missed");
+  V8MONKEY_CHECK(dir.list().size() == 3, "Entry written for each origin");
+}
+
+
+V8MONKEY_TEST(IntCodeCache003, "Damaged entries are rejected and replaced") {
+  InCompartment c;
+  TempDirectory dir;
+  DiskCodeCache cache {dir.path, 1 << 20};
+  V8MONKEY_CHECK(compileAndRun(c.cx, cache, answerSource), "Script ran correctly");
+
+  std::string entry {dir.path + '/' + dir.list()[0].name};
+  V8MONKEY_CHECK(FileSystem::WriteAtomically(entry.c_str(), "garbage", 7), "Entry damaged");
+
+  V8MONKEY_CHECK(compileAndRun(c.cx, cache, answerSource), "Script ran correctly");
+  V8MONKEY_CHECK(cache.Rejects() == 1 && cache.Hits() == 0, "Entry rejected");
+  V8MONKEY_CHECK(compileAndRun(c.cx, cache, answerSource), "Script ran correctly");
+  V8MONKEY_CHECK(cache.Hits() == 1, "Replacement entry hit");
+}
+
+
+V8MONKEY_TEST(IntCodeCache004, "The least recently used entries are evicted") {
+  InCompartment c;
+  TempDirectory dir;
+  const std::u16string first {u"var a = 6; a * 7"};
+  const std::u16string second {u"var b = 6; b * 7"};
+  const std::u16string third {u"var c = 6; c * 7"};
+
+  {
+    DiskCodeCache cache {dir.path, 1 << 20};
+    compileAndRun(c.cx, cache, first);
+    compileAndRun(c.cx, cache, second);
+    compileAndRun(c.cx, cache, third);
+  }
+
+  // Entries are named by hash, so rather than work out which is which, age them all equally
+  std::vector<FileSystem::Entry> entries {dir.list()};
+  V8MONKEY_CHECK(entries.size() == 3, "Entries written");
+  for (const auto& entry : entries) {
+    dir.setLastUsed(entry.name, 1000);
+  }
+
+  // Using the first entry makes the others older, so one of them is evicted when the budget shrinks
+  DiskCodeCache cache {dir.path, 1 << 20};
+  compileAndRun(c.cx, cache, first);
+  V8MONKEY_CHECK(cache.Hits() == 1, "First entry hit");
+
+  size_t budget {dir.bytes() - 1};
+  DiskCodeCache small {dir.path, budget};
+  V8MONKEY_CHECK(dir.list().size() == 2, "One entry evicted");
+  V8MONKEY_CHECK(dir.bytes() <= budget, "Directory within budget");
+
+  V8MONKEY_CHECK(compileAndRun(c.cx, small, first), "Script ran correctly");
+  V8MONKEY_CHECK(small.Hits() == 1, "Recently used entry survived");
+}
+
+
+V8MONKEY_TEST(IntCodeCache005, "Stale temporaries are removed") {
+  TempDirectory dir;
+  std::string stale {entryName(1) + ".tmp.123.0"};
+  std::string fresh {entryName(2) + ".tmp.456.0"};
+  V8MONKEY_CHECK(FileSystem::WriteAtomically((dir.path + '/' + stale).c_str(), "partial", 7), "Temporary written");
+  V8MONKEY_CHECK(FileSystem::WriteAtomically((dir.path + '/' + fresh).c_str(), "partial", 7), "Temporary written");
+  dir.setLastUsed(stale, 1000);
+
+  DiskCodeCache cache {dir.path, 1 << 20};
+  std::vector<FileSystem::Entry> entries {dir.list()};
+  V8MONKEY_CHECK(entries.size() == 1, "One temporary removed");
+  V8MONKEY_CHECK(entries.size() == 1 && entries[0].name == fresh, "Temporary still being written survived");
+}
+
+
+V8MONKEY_TEST(IntCodeCache006, "Damaged entries are counted as rejects even if the source fails to compile") {
+  InCompartment c;
+  TempDirectory dir;
+  DiskCodeCache cache {dir.path, 1 << 20};
+
+  const std::u16string text {u"var = ;"};
+  ScriptSource source {text.data(), text.size()};
+  std::string entry {dir.path + '/' + entryName(source.CacheKey())};
+  V8MONKEY_CHECK(FileSystem::WriteAtomically(entry.c_str(), "garbage", 7), "Damaged entry written");
+
+  std::unique_ptr<ScriptWrapper> script {cache.Compile(c.cx, source)};
+  V8MONKEY_CHECK(!script, "Compilation failed");
+  V8MONKEY_CHECK(JS_IsExceptionPending(c.cx), "Exception pending");
+  JS_ClearPendingException(c.cx);
+
+  V8MONKEY_CHECK(cache.Rejects() == 1, "Entry rejected");
+  V8MONKEY_CHECK(cache.Misses() == 0 && cache.Hits() == 0, "Neither a hit nor a miss");
+}
+
+
+V8MONKEY_TEST(IntCodeCache007, "Trimming leaves room for further entries") {
+  InCompartment c;
+  TempDirectory dir;
+  const std::u16string sources[] {u"var a = 6; a * 7", u"var b = 6; b * 7", u"var c = 6; c * 7", u"var d = 6; d * 7"};
+
+  {
+    DiskCodeCache cache {dir.path, 1 << 20};
+    for (const auto& text : sources) {
+      compileAndRun(c.cx, cache, text);
+    }
+  }
+
+  size_t budget {dir.bytes() - 1};
+  DiskCodeCache cache {dir.path, budget};
+  V8MONKEY_CHECK(dir.bytes() <= budget - budget / 4, "Directory trimmed with room to spare");
+
+  size_t remaining {dir.list().size()};
+  V8MONKEY_CHECK(compileAndRun(c.cx, cache, u"var e = 6; e * 7"), "Script ran correctly");
+  V8MONKEY_CHECK(dir.list().size() == remaining + 1, "Next entry written without eviction");
+}
+
+
+V8MONKEY_TEST(IntCodeCache008, "The same bytes read as Latin1 and as UTF-8 are cached separately") {
+  InCompartment c;
+  TempDirectory dir;
+  DiskCodeCache cache {dir.path, 1 << 20};
+
+  for (int i = 0; i < 2; i++) {
+    V8MONKEY_CHECK(compileBytes(c.cx, cache, ScriptSource::kUTF8) == 1, "Bytes read as UTF-8");
+    V8MONKEY_CHECK(compileBytes(c.cx, cache, ScriptSource::kLatin1) == 2, "Bytes read as Latin1");
+  }
+
+  V8MONKEY_CHECK(cache.Misses() == 2 && cache.Hits() == 2 && cache.Rejects() == 0, "Each encoding missed, then hit");
+  V8MONKEY_CHECK(dir.list().size() == 2, "Entry written for each encoding");
+}
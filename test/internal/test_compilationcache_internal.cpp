@@ -0,0 +1,317 @@
+// min
+#include <algorithm>
+
+// duration steady_clock
+#include <chrono>
+
+// strcmp
+#include <cstring>
+
+// numeric_limits
+#include <limits>
+
+// unique_ptr
+#include <memory>
+
+// string u16string
+#include <string>
+
+// JS_ClearPendingException, JS_IsExceptionPending, JS::RootedValue
+#include "jsapi.h"
+
+// The class under test
+#include "runtime/compilation_cache.h"
+
+// Isolate
+#include "runtime/isolate.h"
+
+// ScriptOrigin ScriptSource ScriptWrapper
+#include "types/script_wrapper.h"
+
+
+// NewGlobal
+#include "utils/SpiderMonkeyUtils.h"
+
+// BytesResource InCompartment
+#include "SpiderMonkeyTestUtils.h"
+
+// Unit-testing support
+#include "V8MonkeyTest.h"
+
+
+using namespace v8::internal;
+using namespace v8::SpiderMonkey;
+using namespace v8::TestUtils;
+
+
+namespace {
+  // Counts how many times it has been run in the current global
+  const std::u16string countingSource {u"var count = typeof count == 'undefined' ? 1 : count + 1; count"};
+
+
+  // Compile the text through the cache, and run it, returning the integer result, or -1 on failure
+  int compileAndRun(JSContext* cx, CompilationCache& cache, const std::u16string& text,
+                    ScriptOrigin origin = ScriptOrigin {}) {
+    ScriptSource source {text.data(), text.size(), origin};
+    std::unique_ptr<ScriptWrapper> script {cache.Compile(cx, source)};
+
+    JS::RootedValue value(cx);
+    return script && script->Run(cx, &value) && value.isInt32() ? value.toInt32() : -1;
+  }
+
+
+  // U+00E9 in UTF-8: one character when read as UTF-8, but two when read as Latin1
+  const std::string nonASCIISource {"'\xc3\xa9'.length"};
+
+
+  double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+
+
+  // As compileAndRun, for nonASCIISource read with the given encoding
+  int compileBytes(JSContext* cx, CompilationCache& cache, ScriptSource::Encoding encoding) {
+    ScriptSource source {new BytesResource {nonASCIISource}, encoding};
+    std::unique_ptr<ScriptWrapper> script {cache.Compile(cx, source)};
+
+    JS::RootedValue value(cx);
+    return script && script->Run(cx, &value) && value.isInt32() ? value.toInt32() : -1;
+  }
+}
+
+
+V8MONKEY_TEST(IntCompilationCache001, "Without a budget, nothing is cached") {
+  InCompartment c;
+  CompilationCache cache;
+
+  V8MONKEY_CHECK(compileAndRun(c.cx, cache, countingSource) == 1, "Script ran correctly");
+  V8MONKEY_CHECK(compileAndRun(c.cx, cache, countingSource) == 2, "Script ran correctly again");
+  V8MONKEY_CHECK(cache.Size() == 0 && cache.BytesInUse() == 0, "Nothing cached");
+  V8MONKEY_CHECK(cache.Hits() == 0 && cache.Misses() == 0, "Cache not consulted");
+}
+
+
+V8MONKEY_TEST(IntCompilationCache002, "Repeated compiles of the same source hit") {
+  InCompartment c;
+  CompilationCache cache;
+  cache.SetBudget(1 << 20);
+
+  V8MONKEY_CHECK(compileAndRun(c.cx, cache, countingSource) == 1, "Script ran correctly");
+  V8MONKEY_CHECK(cache.Misses() == 1 && cache.Size() == 1 && cache.BytesInUse() > 0, "Script cached");
+
+  std::u16string text {countingSource};
+  ScriptSource source {text.data(), text.size()};
+  std::unique_ptr<ScriptWrapper> script {cache.Compile(c.cx, source)};
+  V8MONKEY_CHECK(cache.Hits() == 1 && cache.Size() == 1, "Cached script used");
+  V8MONKEY_CHECK(script && script->Statistics().cached, "Script handed out again rather than compiled");
+
+  JS::RootedValue value(c.cx);
+  V8MONKEY_CHECK(script->Run(c.cx, &value) && value.isInt32() && value.toInt32() == 2, "Script ran in the global");
+
+  V8MONKEY_CHECK(compileAndRun(c.cx, cache, countingSource, ScriptOrigin {"counting.js", 0}) == 3,
+                 "Script with a different origin ran");
+  V8MONKEY_CHECK(cache.Misses() == 2 && cache.Size() == 2, "Different origin compiled afresh");
+}
+
+
+V8MONKEY_TEST(IntCompilationCache003, "Cached scripts can be used from any context") {
+  InCompartment c;
+  CompilationCache cache;
+  cache.SetBudget(1 << 20);
+  V8MONKEY_CHECK(compileAndRun(c.cx, cache, countingSource) == 1, "Script ran correctly");
+  size_t boundBytes {cache.BytesInUse()};
+
+  // The second global needs the context-independent form compiling, but later ones decode it
+  JS::RootedObject other(c.cx, NewGlobal(c.cx));
+  {
+    JSAutoCompartment ac(c.cx, other);
+    V8MONKEY_CHECK(compileAndRun(c.cx, cache, countingSource) == 1, "Script ran in the new global");
+    V8MONKEY_CHECK(cache.Misses() == 2 && cache.BytesInUse() > 2 * boundBytes, "Encoded form compiled and kept");
+  }
+
+  JS::RootedObject third(c.cx, NewGlobal(c.cx));
+  {
+    JSAutoCompartment ac(c.cx, third);
+    V8MONKEY_CHECK(compileAndRun(c.cx, cache, countingSource) == 1, "Script ran in the third global");
+    V8MONKEY_CHECK(cache.Hits() == 1 && cache.Misses() == 2, "Encoded form decoded");
+  }
+
+  V8MONKEY_CHECK(compileAndRun(c.cx, cache, countingSource) == 2, "Script ran in the original global");
+  {
+    JSAutoCompartment ac(c.cx, other);
+    V8MONKEY_CHECK(compileAndRun(c.cx, cache, countingSource) == 2, "Script ran in the second global");
+  }
+
+  V8MONKEY_CHECK(cache.Hits() == 3 && cache.Misses() == 2 && cache.Size() == 1, "Each global's script kept");
+}
+
+
+V8MONKEY_TEST(IntCompilationCache004, "The least recently used entries are evicted to fit the budget") {
+  InCompartment c;
+  CompilationCache cache;
+  cache.SetBudget(1 << 20);
+
+  const std::u16string a {u"var a = 6; a * 7"};
+  const std::u16string b {u"var b = 6; b * 7"};
+  const std::u16string d {u"var d = 6; d * 7"};
+  compileAndRun(c.cx, cache, a);
+  compileAndRun(c.cx, cache, b);
+
+  // Room for two entries: b is now least recently used, so makes way for d
+  cache.SetBudget(cache.BytesInUse());
+  V8MONKEY_CHECK(cache.Size() == 2, "Nothing evicted");
+  V8MONKEY_CHECK(compileAndRun(c.cx, cache, a) == 42 && cache.Hits() == 1, "a hit");
+  V8MONKEY_CHECK(compileAndRun(c.cx, cache, d) == 42 && cache.Misses() == 3, "d missed");
+  V8MONKEY_CHECK(cache.Size() == 2 && cache.BytesInUse() <= cache.Budget(), "Cache within budget");
+
+  V8MONKEY_CHECK(compileAndRun(c.cx, cache, a) == 42 && cache.Hits() == 2, "a kept");
+  V8MONKEY_CHECK(compileAndRun(c.cx, cache, b) == 42 && cache.Misses() == 4, "b evicted");
+
+  cache.SetBudget(1);
+  V8MONKEY_CHECK(cache.Size() == 0 && cache.BytesInUse() == 0, "Shrinking the budget evicts");
+  V8MONKEY_CHECK(compileAndRun(c.cx, cache, a) == 42 && cache.Size() == 0, "Scripts over budget not cached");
+
+  cache.SetBudget(0);
+  V8MONKEY_CHECK(compileAndRun(c.cx, cache, a) == 42 && cache.Misses() == 5, "Cache disabled");
+}
+
+
+V8MONKEY_TEST(IntCompilationCache005, "Compile errors are reported, and not cached") {
+  InCompartment c;
+  CompilationCache cache;
+  cache.SetBudget(1 << 20);
+
+  std::u16string text {u"var = ;"};
+  ScriptSource source {text.data(), text.size()};
+  std::unique_ptr<ScriptWrapper> script {cache.Compile(c.cx, source)};
+  V8MONKEY_CHECK(!script, "Compilation failed");
+  V8MONKEY_CHECK(JS_IsExceptionPending(c.cx), "Exception pending");
+  JS_ClearPendingException(c.cx);
+  V8MONKEY_CHECK(cache.Size() == 0, "Nothing cached");
+}
+
+
+V8MONKEY_TEST(IntCompilationCache006, "Context disposal and low memory notifications clear the isolate's cache") {
+  InCompartment c;
+  Isolate* isolate {new Isolate};
+  CompilationCache& cache {isolate->GetCompilationCache()};
+  V8MONKEY_CHECK(cache.Budget() == 0, "Cache disabled by default");
+
+  cache.SetBudget(1 << 20);
+  compileAndRun(c.cx, cache, countingSource);
+  V8MONKEY_CHECK(cache.Size() == 1, "Script cached");
+  V8MONKEY_CHECK(isolate->ContextDisposedNotification() == 1, "Disposal counted");
+  V8MONKEY_CHECK(isolate->ContextDisposedNotification() == 2, "Disposals since the last clean up counted");
+
+  // The next compile clears the cache first, so compiles afresh
+  V8MONKEY_CHECK(compileAndRun(c.cx, cache, countingSource) == 2, "Script ran");
+  V8MONKEY_CHECK(cache.Misses() == 2 && cache.Hits() == 0 && cache.Size() == 1, "Cache cleared before compiling");
+  V8MONKEY_CHECK(isolate->ContextDisposedNotification() == 1, "Count restarted after clean up");
+
+  isolate->LowMemoryNotification();
+  V8MONKEY_CHECK(cache.Size() == 0 && cache.BytesInUse() == 0, "Cache cleared on low memory");
+  V8MONKEY_CHECK(cache.Budget() == 1 << 20, "Budget kept");
+
+  isolate->Dispose();
+}
+
+
+V8MONKEY_TEST(IntCompilationCache007, "The same bytes read as Latin1 and as UTF-8 are cached separately") {
+  InCompartment c;
+  CompilationCache cache;
+  cache.SetBudget(1 << 20);
+
+  for (int i = 0; i < 2; i++) {
+    V8MONKEY_CHECK(compileBytes(c.cx, cache, ScriptSource::kUTF8) == 1, "Bytes read as UTF-8");
+    V8MONKEY_CHECK(compileBytes(c.cx, cache, ScriptSource::kLatin1) == 2, "Bytes read as Latin1");
+  }
+
+  V8MONKEY_CHECK(cache.Misses() == 2 && cache.Hits() == 2 && cache.Size() == 2, "Each encoding missed, then hit");
+}
+
+
+V8MONKEY_TEST(IntCompilationCache008, "Hits in the global a script was compiled for are cheaper than compiling") {
+  InCompartment c;
+  CompilationCache cache;
+  cache.SetBudget(1 << 24);
+
+  std::u16string text {u"var x = 42;\n"};
+  for (int i = 0; i < 20000; i++) {
+    text += u"x = x + 0;\n";
+  }
+
+  ScriptSource first {text.data(), text.size()};
+  std::unique_ptr<ScriptWrapper> script {cache.Compile(c.cx, first)};
+  V8MONKEY_CHECK(script && !script->Statistics().cached, "Script compiled");
+
+  // Timings are noisy, so compare the best of several attempts
+  double compileTime {std::numeric_limits<double>::max()};
+  double hitTime {std::numeric_limits<double>::max()};
+  for (int i = 0; i < 5; i++) {
+    ScriptSource plain {text.data(), text.size()};
+    std::chrono::steady_clock::time_point start {std::chrono::steady_clock::now()};
+    script.reset(ScriptWrapper::Compile(c.cx, plain));
+    compileTime = std::min(compileTime, secondsSince(start));
+
+    ScriptSource cached {text.data(), text.size()};
+    start = std::chrono::steady_clock::now();
+    script.reset(cache.Compile(c.cx, cached));
+    hitTime = std::min(hitTime, secondsSince(start));
+    V8MONKEY_CHECK(script && script->Statistics().cached, "Cached script used");
+  }
+
+  V8MONKEY_CHECK(hitTime < compileTime, "Hit cheaper than compiling");
+}
+
+
+namespace {
+  int scriptsCompiled {0};
+  int scriptsCached {0};
+
+
+  int* lookupCounter(const char* name) {
+    if (std::strcmp(name, "c:V8Monkey.ScriptsCompiled") == 0) {
+      return &scriptsCompiled;
+    }
+
+    if (std::strcmp(name, "c:V8Monkey.ScriptsCached") == 0) {
+      return &scriptsCached;
+    }
+
+    return nullptr;
+  }
+}
+
+
+V8MONKEY_TEST(IntCompilationCache009, "Hits in the global a script was compiled for are counted") {
+  InCompartment c;
+  Isolate* isolate {new Isolate};
+  isolate->Enter();
+  isolate->SetCounterFunction(lookupCounter);
+
+  CompilationCache& cache {isolate->GetCompilationCache()};
+  cache.SetBudget(1 << 20);
+  compileAndRun(c.cx, cache, countingSource);
+  V8MONKEY_CHECK(scriptsCompiled == 1 && scriptsCached == 0, "Compile counted");
+
+  compileAndRun(c.cx, cache, countingSource);
+  V8MONKEY_CHECK(scriptsCompiled == 1 && scriptsCached == 1, "Hit counted");
+
+  isolate->Exit();
+  isolate->Dispose();
+}
+
+
+V8MONKEY_TEST(IntCompilationCache010, "Sources with the same text and a different origin do not share an entry") {
+  InCompartment c;
+  CompilationCache cache;
+  cache.SetBudget(1 << 20);
+
+  compileAndRun(c.cx, cache, countingSource, ScriptOrigin {"a.js", 0});
+  compileAndRun(c.cx, cache, countingSource, ScriptOrigin {"a.js", 1});
+  compileAndRun(c.cx, cache, countingSource, ScriptOrigin {"b.js", 0});
+  V8MONKEY_CHECK(cache.Misses() == 3 && cache.Size() == 3, "Each origin compiled");
+
+  V8MONKEY_CHECK(compileAndRun(c.cx, cache, countingSource, ScriptOrigin {"a.js", 1}) == 4, "Script ran");
+  V8MONKEY_CHECK(cache.Hits() == 1 && cache.Size() == 3, "Same origin hit");
+}
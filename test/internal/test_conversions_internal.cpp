@@ -0,0 +1,92 @@
+// std::numeric_limits
+#include <limits>
+
+// The functions under test
+#include "utils/Conversions.h"
+
+// Int type definitions
+#include "v8stdint.h"
+
+// Unit-testing support
+#include "V8MonkeyTest.h"
+
+
+using namespace v8::V8Monkey::Conversions;
+
+
+namespace {
+  struct ConversionCase {
+    double input;
+    int32_t asInt32;
+    uint32_t asUint32;
+  };
+
+
+  const double nan {std::numeric_limits<double>::quiet_NaN()};
+  const double infinity {std::numeric_limits<double>::infinity()};
+
+
+  // Expected values computed per ECMA-262 9.5 / 9.6
+  const ConversionCase conversionCases[] {
+    {0.0, 0, 0u},
+    {-0.0, 0, 0u},
+    {1.0, 1, 1u},
+    {-1.0, -1, 0xffffffffu},
+    {1.9, 1, 1u},
+    {-1.9, -1, 0xffffffffu},
+    {0.5, 0, 0u},
+    {-0.5, 0, 0u},
+    {2147483647.0, 2147483647, 2147483647u},
+    {2147483647.5, 2147483647, 2147483647u},
+    {2147483648.0, -2147483647 - 1, 2147483648u},
+    {-2147483648.0, -2147483647 - 1, 2147483648u},
+    {-2147483648.5, -2147483647 - 1, 2147483648u},
+    {-2147483649.0, 2147483647, 2147483647u},
+    {4294967295.0, -1, 4294967295u},
+    {4294967296.0, 0, 0u},
+    {4294967297.0, 1, 1u},
+    {-4294967297.0, -1, 0xffffffffu},
+    {6442450944.0, -2147483647 - 1, 2147483648u},
+    {1e20, 1661992960, 1661992960u},
+    {-1e20, -1661992960, 2632974336u},
+    {9007199254740991.0, -1, 0xffffffffu},
+    {9007199254740993.0, 0, 0u},
+    {1.7e308, 0, 0u},
+    {4.9e-324, 0, 0u},
+    {-4.9e-324, 0, 0u},
+    {nan, 0, 0u},
+    {infinity, 0, 0u},
+    {-infinity, 0, 0u}
+  };
+}
+
+
+V8MONKEY_TEST(IntConversions001, "DoubleToInt32 is ECMA-262 compliant") {
+  for (const auto& c : conversionCases) {
+    V8MONKEY_CHECK(DoubleToInt32(c.input) == c.asInt32, "Conversion correct");
+  }
+}
+
+
+V8MONKEY_TEST(IntConversions002, "DoubleToUint32 is ECMA-262 compliant") {
+  for (const auto& c : conversionCases) {
+    V8MONKEY_CHECK(DoubleToUint32(c.input) == c.asUint32, "Conversion correct");
+  }
+}
+
+
+V8MONKEY_TEST(IntConversions003, "DoubleToInt32 is ToUint32 modulo 2^32 for large integers") {
+  // Walk through a range of exponents, checking against exact 64-bit integer arithmetic
+  for (int shift = 0; shift < 63; shift++) {
+    for (int64_t low = -3; low <= 3; low++) {
+      int64_t value {(static_cast<int64_t>(1) << shift) + low};
+      double d {static_cast<double>(value)};
+      int64_t exact {static_cast<int64_t>(d)};
+
+      V8MONKEY_CHECK(DoubleToUint32(d) == static_cast<uint32_t>(exact), "Unsigned conversion correct");
+      V8MONKEY_CHECK(DoubleToUint32(-d) == static_cast<uint32_t>(-exact), "Unsigned conversion correct (negative)");
+      V8MONKEY_CHECK(DoubleToInt32(d) == static_cast<int32_t>(static_cast<uint32_t>(exact)), "Signed conversion correct");
+    }
+  }
+}
+
@@ -0,0 +1,114 @@
+// size_t
+#include <cstddef>
+
+// string
+#include <string>
+
+// vector
+#include <vector>
+
+// The class under test
+#include "runtime/flags.h"
+
+// V8::SetFlagsFromCommandLine V8::SetFlagsFromString
+#include "v8.h"
+
+// Unit-testing support
+#include "V8MonkeyTest.h"
+
+
+using namespace v8::internal;
+
+
+V8MONKEY_TEST(IntFlags001, "Flags have V8's defaults") {
+  Flags::Reset();
+  V8MONKEY_CHECK(Flags::Lazy(), "Lazy by default");
+  V8MONKEY_CHECK(!Flags::MaxLazy(), "Not maximally lazy by default");
+  V8MONKEY_CHECK(Flags::MinPreparseLength() == 1024, "Minimum preparse length correct");
+  V8MONKEY_CHECK(!Flags::ParseLazily(1023), "Short scripts parsed eagerly");
+  V8MONKEY_CHECK(Flags::ParseLazily(1024), "Long scripts parsed lazily");
+}
+
+
+V8MONKEY_TEST(IntFlags002, "Boolean flags can be negated, in either spelling") {
+  Flags::Reset();
+  std::vector<size_t> consumed {Flags::SetFromArguments({"--nolazy"})};
+  V8MONKEY_CHECK(!Flags::Lazy(), "--nolazy understood");
+  V8MONKEY_CHECK(consumed == std::vector<size_t> {0}, "Argument consumed");
+
+  Flags::SetFromArguments({"-lazy"});
+  V8MONKEY_CHECK(Flags::Lazy(), "-lazy understood");
+
+  Flags::SetFromArguments({"--no-lazy"});
+  V8MONKEY_CHECK(!Flags::Lazy(), "--no-lazy understood");
+
+  Flags::SetFromArguments({"--max-lazy"});
+  V8MONKEY_CHECK(Flags::MaxLazy() && Flags::Lazy(), "--max-lazy understood, and implies --lazy");
+  V8MONKEY_CHECK(Flags::ParseLazily(1), "Maximally lazy parsing ignores the minimum preparse length");
+
+  consumed = Flags::SetFromArguments({"--lazy=false", "--no_max_lazy"});
+  V8MONKEY_CHECK(!Flags::MaxLazy(), "--no_max_lazy understood");
+  V8MONKEY_CHECK(consumed == std::vector<size_t> {1}, "Boolean flag with a value ignored");
+  Flags::Reset();
+}
+
+
+V8MONKEY_TEST(IntFlags003, "Numeric flags take their value inline or from the next argument") {
+  Flags::Reset();
+  std::vector<size_t> consumed {Flags::SetFromArguments({"--min_preparse_length=10"})};
+  V8MONKEY_CHECK(Flags::MinPreparseLength() == 10, "Inline value understood");
+  V8MONKEY_CHECK(consumed == std::vector<size_t> {0}, "Argument consumed");
+
+  consumed = Flags::SetFromArguments({"script.js", "--min-preparse-length", "20", "more"});
+  V8MONKEY_CHECK(Flags::MinPreparseLength() == 20, "Following value understood");
+  V8MONKEY_CHECK((consumed == std::vector<size_t> {1, 2}), "Flag and value consumed");
+
+  consumed = Flags::SetFromArguments({"--min_preparse_length=x", "--min_preparse_length", "-1"});
+  V8MONKEY_CHECK(Flags::MinPreparseLength() == 20, "Invalid values ignored");
+  V8MONKEY_CHECK(consumed.empty(), "Nothing consumed");
+  Flags::Reset();
+}
+
+
+V8MONKEY_TEST(IntFlags004, "Unknown flags and script arguments are left alone") {
+  Flags::Reset();
+  std::vector<size_t> consumed {Flags::SetFromArguments({"--harmony", "--", "--nolazy"})};
+  V8MONKEY_CHECK(consumed.empty(), "Nothing consumed");
+  V8MONKEY_CHECK(Flags::Lazy(), "Flags after -- ignored");
+}
+
+
+V8MONKEY_TEST(IntFlags005, "Flags can be set from a string") {
+  Flags::Reset();
+  const std::string flags {"  --nolazy\t--min_preparse_length 5 "};
+  v8::V8::SetFlagsFromString(flags.data(), static_cast<int>(flags.size()));
+  V8MONKEY_CHECK(!Flags::Lazy(), "Boolean flag set");
+  V8MONKEY_CHECK(Flags::MinPreparseLength() == 5, "Numeric flag set");
+
+  // Only the given length is read
+  v8::V8::SetFlagsFromString("--lazy --max_lazy", 6);
+  V8MONKEY_CHECK(Flags::Lazy() && !Flags::MaxLazy(), "String truncated");
+  Flags::Reset();
+}
+
+
+V8MONKEY_TEST(IntFlags006, "Flags can be set from, and removed from, the command line") {
+  Flags::Reset();
+  char program[] {"d8"};
+  char nolazy[] {"--nolazy"};
+  char script[] {"script.js"};
+  char length[] {"--min_preparse_length"};
+  char value[] {"7"};
+  char* argv[] {program, nolazy, script, length, value, nullptr};
+  int argc {5};
+
+  v8::V8::SetFlagsFromCommandLine(&argc, argv, false);
+  V8MONKEY_CHECK(!Flags::Lazy() && Flags::MinPreparseLength() == 7, "Flags set");
+  V8MONKEY_CHECK(argc == 5 && argv[1] == nolazy, "Arguments kept");
+
+  Flags::Reset();
+  v8::V8::SetFlagsFromCommandLine(&argc, argv, true);
+  V8MONKEY_CHECK(!Flags::Lazy() && Flags::MinPreparseLength() == 7, "Flags set");
+  V8MONKEY_CHECK(argc == 2 && argv[0] == program && argv[1] == script, "Flags removed");
+  Flags::Reset();
+}
@@ -0,0 +1,238 @@
+// std::mt19937_64
+#include <random>
+
+// std::string, std::u16string
+#include <string>
+
+// std::vector
+#include <vector>
+
+// The functions under test
+#include "utils/JSONIndex.h"
+
+// Unit-testing support
+#include "V8MonkeyTest.h"
+
+
+using namespace v8::V8Monkey;
+
+
+namespace {
+  const UTF8::EncodingImplementation indexImplementations[] {UTF8::EncodingImplementation::Scalar,
+                                                             UTF8::EncodingImplementation::SSE2,
+                                                             UTF8::EncodingImplementation::AVX2};
+
+
+  // A straightforward scan, one code unit at a time. Backslashes are only expected inside strings.
+  std::vector<uint32_t> referenceIndex(const std::string& text, bool& terminated) {
+    std::vector<uint32_t> index;
+    bool inString {false};
+    bool escaped {false};
+    bool inScalar {false};
+
+    for (size_t i = 0; i < text.size(); i++) {
+      char c {text[i]};
+
+      if (inString) {
+        if (escaped) {
+          escaped = false;
+        } else if (c == '\\') {
+          escaped = true;
+        } else if (c == '"') {
+          inString = false;
+          index.push_back(static_cast<uint32_t>(i));
+        }
+
+        continue;
+      }
+
+      if (c == '"') {
+        inString = true;
+        inScalar = false;
+        index.push_back(static_cast<uint32_t>(i));
+        continue;
+      }
+
+      switch (c) {
+        case '{':
+        case '}':
+        case '[':
+        case ']':
+        case ':':
+        case ',':
+          index.push_back(static_cast<uint32_t>(i));
+          inScalar = false;
+          break;
+
+        case ' ':
+        case '\t':
+        case '\n':
+        case '\r':
+          inScalar = false;
+          break;
+
+        default:
+          if (!inScalar) {
+            index.push_back(static_cast<uint32_t>(i));
+          }
+
+          inScalar = true;
+          break;
+      }
+    }
+
+    terminated = !inString;
+    return index;
+  }
+
+
+  // Latin1 code units carry over unchanged; 0xff stands for a code unit beyond Latin1
+  std::u16string toUTF16(const std::string& text) {
+    std::u16string result;
+    for (char c : text) {
+      unsigned char u {static_cast<unsigned char>(c)};
+      result += u == 0xffu ? u'\u4e2d' : static_cast<char16_t>(u);
+    }
+
+    return result;
+  }
+
+
+  bool indexMatches(const std::string& text) {
+    bool terminated;
+    const std::vector<uint32_t> expected {referenceIndex(text, terminated)};
+
+    std::vector<uint32_t> latin1;
+    bool latin1Result {JSONIndex::IndexStructurals(reinterpret_cast<const unsigned char*>(text.data()), text.size(),
+                                                   latin1)};
+
+    std::u16string wide {toUTF16(text)};
+    std::vector<uint32_t> twoByte;
+    bool twoByteResult {JSONIndex::IndexStructurals(wide.data(), wide.size(), twoByte)};
+
+    if (!terminated) {
+      return !latin1Result && !twoByteResult;
+    }
+
+    return latin1Result && twoByteResult && latin1 == expected && twoByte == expected;
+  }
+
+
+  // Token soup: not necessarily valid JSON, but with backslashes only inside strings
+  std::string randomText(std::mt19937_64& generator, size_t tokens) {
+    static const char* const outside[] {"{", "}", "[", "]", ":", ",", " ", "\n\t", "true", "-1.5e3", "null", "\xe9",
+                                        "\xff"};
+    static const char* const inside[] {"a", " ", ",", "{", "\\\\", "\\\"", "\\n", "\\u0041", "\xe9", "\xff"};
+
+    std::string text;
+    for (size_t i = 0; i < tokens; i++) {
+      if (generator() % 4) {
+        text += outside[generator() % (sizeof(outside) / sizeof(outside[0]))];
+        continue;
+      }
+
+      text += '"';
+      size_t length {static_cast<size_t>(generator() % 40)};
+      for (size_t j = 0; j < length; j++) {
+        text += inside[generator() % (sizeof(inside) / sizeof(inside[0]))];
+      }
+
+      text += '"';
+    }
+
+    return text;
+  }
+}
+
+
+V8MONKEY_TEST(IntJSONIndex001, "Structurals are indexed") {
+  const std::string text {"{\"a\": [1, true, null], \"b\":-2.5e3}"};
+  const std::vector<uint32_t> expected {0, 1, 3, 4, 6, 7, 8, 10, 14, 16, 20, 21, 23, 25, 26, 27, 33};
+  std::vector<uint32_t> index;
+
+  for (auto impl : indexImplementations) {
+    if (!JSONIndex::ForceIndexImplementation(impl)) {
+      continue;
+    }
+
+    V8MONKEY_CHECK(JSONIndex::IndexStructurals(reinterpret_cast<const unsigned char*>(text.data()), text.size(),
+                                               index), "Text indexed");
+    V8MONKEY_CHECK(index == expected, "Index correct");
+  }
+
+  JSONIndex::ResetIndexImplementation();
+}
+
+
+V8MONKEY_TEST(IntJSONIndex002, "Operators and escaped quotes within strings are not structural") {
+  const std::string text {"[\"a,b:{c}\\\"d\", \"\\\\\"]"};
+  const std::vector<uint32_t> expected {0, 1, 12, 13, 15, 18, 19};
+  std::vector<uint32_t> index;
+
+  for (auto impl : indexImplementations) {
+    if (!JSONIndex::ForceIndexImplementation(impl)) {
+      continue;
+    }
+
+    V8MONKEY_CHECK(JSONIndex::IndexStructurals(reinterpret_cast<const unsigned char*>(text.data()), text.size(),
+                                               index), "Text indexed");
+    V8MONKEY_CHECK(index == expected, "Index correct");
+  }
+
+  JSONIndex::ResetIndexImplementation();
+}
+
+
+V8MONKEY_TEST(IntJSONIndex003, "Strings and backslash runs may straddle blocks") {
+  for (auto impl : indexImplementations) {
+    if (!JSONIndex::ForceIndexImplementation(impl)) {
+      continue;
+    }
+
+    for (size_t padding = 0; padding < 140; padding++) {
+      for (size_t backslashes = 0; backslashes < 6; backslashes++) {
+        std::string run(backslashes * 2, '\\');
+        V8MONKEY_CHECK(indexMatches("[" + std::string(padding, ' ') + "\"x" + run + "\", 1]"), "Index correct");
+        V8MONKEY_CHECK(indexMatches("[\"" + std::string(padding, 'y') + run + "\\\"" + run + "\", 1]"),
+                       "Index correct");
+      }
+    }
+  }
+
+  JSONIndex::ResetIndexImplementation();
+}
+
+
+V8MONKEY_TEST(IntJSONIndex004, "Unterminated strings are reported") {
+  const std::vector<std::string> texts {"\"", "[\"abc", "[\"abc\\\"]", std::string(100, ' ') + "\"\\\\\\\""};
+
+  for (auto impl : indexImplementations) {
+    if (!JSONIndex::ForceIndexImplementation(impl)) {
+      continue;
+    }
+
+    for (const auto& text : texts) {
+      std::vector<uint32_t> index;
+      V8MONKEY_CHECK(!JSONIndex::IndexStructurals(reinterpret_cast<const unsigned char*>(text.data()), text.size(),
+                                                  index), "Unterminated string reported");
+    }
+  }
+
+  JSONIndex::ResetIndexImplementation();
+}
+
+
+V8MONKEY_TEST(IntJSONIndex005, "Every implementation agrees with a simple scan") {
+  for (auto impl : indexImplementations) {
+    if (!JSONIndex::ForceIndexImplementation(impl)) {
+      continue;
+    }
+
+    std::mt19937_64 generator {0x15011};
+    for (int i = 0; i < 2000; i++) {
+      V8MONKEY_CHECK(indexMatches(randomText(generator, static_cast<size_t>(generator() % 100))), "Index correct");
+    }
+  }
+
+  JSONIndex::ResetIndexImplementation();
+}
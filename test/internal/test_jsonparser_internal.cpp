@@ -0,0 +1,179 @@
+// strlen
+#include <cstring>
+
+// unique_ptr
+#include <memory>
+
+// string, u16string
+#include <string>
+
+// JS_GetArrayLength, JS_GetElement, JS_GetProperty, JS_IsArrayObject, JS_IsExceptionPending,
+// JS_StringEqualsAscii
+#include "jsapi.h"
+
+// The class under test
+#include "types/json_parser.h"
+
+// StringWrapper
+#include "types/string_wrapper.h"
+
+// InCompartment
+#include "SpiderMonkeyTestUtils.h"
+
+// Unit-testing support
+#include "V8MonkeyTest.h"
+
+
+using namespace v8::internal;
+using namespace v8::TestUtils;
+
+
+namespace {
+  JSONParser::Outcome tryParse(JSContext* cx, const char* text, JS::MutableHandleValue result) {
+    return JSONParser::TryParse(cx, reinterpret_cast<const JS::Latin1Char*>(text), std::strlen(text), result);
+  }
+
+
+  bool isString(JSContext* cx, const JS::Value& value, const char* expected) {
+    bool equal {false};
+    return value.isString() && JS_StringEqualsAscii(cx, value.toString(), expected, &equal) && equal;
+  }
+
+
+  // Compare the contents of a string value against the given UTF-16 code units
+  bool hasContents(JSContext* cx, const JS::Value& value, const std::u16string& expected) {
+    if (!value.isString()) {
+      return false;
+    }
+
+    JS::RootedString string(cx, value.toString());
+    JSFlatString* flat {JS_FlattenString(cx, string)};
+    if (!flat || JS_GetStringLength(string) != expected.size()) {
+      return false;
+    }
+
+    for (size_t i = 0; i < expected.size(); i++) {
+      if (JS_GetFlatStringCharAt(flat, i) != expected[i]) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+}
+
+
+V8MONKEY_TEST(IntJSONParser001, "Scalars are parsed") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+  JS::RootedValue result(cx);
+
+  V8MONKEY_CHECK(tryParse(cx, "true", &result) == JSONParser::kParsed && result.isTrue(), "true parsed");
+  V8MONKEY_CHECK(tryParse(cx, " false\n", &result) == JSONParser::kParsed && result.isFalse(), "false parsed");
+  V8MONKEY_CHECK(tryParse(cx, "null", &result) == JSONParser::kParsed && result.isNull(), "null parsed");
+  V8MONKEY_CHECK(tryParse(cx, "42", &result) == JSONParser::kParsed && result.isInt32() && result.toInt32() == 42,
+                 "Integer parsed");
+  V8MONKEY_CHECK(tryParse(cx, "-0", &result) == JSONParser::kParsed && result.isDouble() && result.toDouble() == 0.0,
+                 "Negative zero parsed");
+  V8MONKEY_CHECK(tryParse(cx, "-1.5e3", &result) == JSONParser::kParsed && result.toNumber() == -1500.0,
+                 "Double parsed");
+  V8MONKEY_CHECK(tryParse(cx, "\"abc\"", &result) == JSONParser::kParsed && isString(cx, result, "abc"),
+                 "String parsed");
+}
+
+
+V8MONKEY_TEST(IntJSONParser002, "Objects and arrays are parsed") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+  JS::RootedValue result(cx);
+
+  V8MONKEY_CHECK(tryParse(cx, "{\"a\": [1, \"two\", {}], \"b\": true, \"b\": null}", &result) == JSONParser::kParsed,
+                 "Text parsed");
+  V8MONKEY_CHECK(result.isObject(), "Result is an object");
+
+  JS::RootedObject obj(cx, &result.toObject());
+  JS::RootedValue a(cx);
+  V8MONKEY_CHECK(JS_GetProperty(cx, obj, "a", &a) && a.isObject(), "Property a is an object");
+
+  JS::RootedObject array(cx, &a.toObject());
+  uint32_t length {0};
+  V8MONKEY_CHECK(JS_IsArrayObject(cx, array), "Property a is an array");
+  V8MONKEY_CHECK(JS_GetArrayLength(cx, array, &length) && length == 3, "Array length correct");
+
+  JS::RootedValue element(cx);
+  V8MONKEY_CHECK(JS_GetElement(cx, array, 0, &element) && element.isInt32() && element.toInt32() == 1,
+                 "Element 0 correct");
+  V8MONKEY_CHECK(JS_GetElement(cx, array, 1, &element) && isString(cx, element, "two"), "Element 1 correct");
+  V8MONKEY_CHECK(JS_GetElement(cx, array, 2, &element) && element.isObject(), "Element 2 correct");
+
+  JS::RootedValue b(cx);
+  V8MONKEY_CHECK(JS_GetProperty(cx, obj, "b", &b) && b.isNull(), "Later duplicate keys win");
+}
+
+
+V8MONKEY_TEST(IntJSONParser003, "Escapes are decoded") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+  JS::RootedValue result(cx);
+
+  V8MONKEY_CHECK(tryParse(cx, "\"a\\n\\u0041\\u00e9\\\"\\\\\\/\"", &result) == JSONParser::kParsed, "Text parsed");
+  V8MONKEY_CHECK(hasContents(cx, result, u"a\nA\u00e9\"\\/"), "Contents correct");
+
+  V8MONKEY_CHECK(tryParse(cx, "{\"k\\u0065y\": 1}", &result) == JSONParser::kParsed, "Object parsed");
+  JS::RootedObject obj(cx, &result.toObject());
+  JS::RootedValue value(cx);
+  V8MONKEY_CHECK(JS_GetProperty(cx, obj, "key", &value) && value.isInt32(), "Escaped key decoded");
+}
+
+
+V8MONKEY_TEST(IntJSONParser004, "Malformed text is left to SpiderMonkey") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+  JS::RootedValue result(cx);
+
+  const char* texts[] {"", " ", "[1,]", "{\"a\":1,}", "[01]", "[1.]", "[.5]", "tru", "[1 2]", "{\"a\" 1}", "{1:2}",
+                       "\"abc", "[\"\\x\"]", "[\"\\u12\"]", "[\"a\tb\"]", "[1]]", "{", "[+1]", "1 2"};
+
+  for (const char* text : texts) {
+    V8MONKEY_CHECK(tryParse(cx, text, &result) == JSONParser::kFallback, "Text declined");
+    V8MONKEY_CHECK(!JS_IsExceptionPending(cx), "No exception pending");
+  }
+}
+
+
+V8MONKEY_TEST(IntJSONParser005, "Two-byte text is parsed") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+  JS::RootedValue result(cx);
+
+  const std::u16string text {u"[\"\u4e2d\\u6587\", 7]"};
+  V8MONKEY_CHECK(JSONParser::TryParse(cx, text.data(), text.size(), &result) == JSONParser::kParsed, "Text parsed");
+
+  JS::RootedObject array(cx, &result.toObject());
+  JS::RootedValue element(cx);
+  V8MONKEY_CHECK(JS_GetElement(cx, array, 0, &element) && hasContents(cx, element, u"\u4e2d\u6587"),
+                 "String contents correct");
+  V8MONKEY_CHECK(JS_GetElement(cx, array, 1, &element) && element.isInt32() && element.toInt32() == 7,
+                 "Number correct");
+}
+
+
+V8MONKEY_TEST(IntJSONParser006, "Parse falls back to SpiderMonkey") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+  JS::RootedValue result(cx);
+
+  std::unique_ptr<StringWrapper> large {StringWrapper::NewFromUtf8(cx, "[1e400, \"a long enough string\"]")};
+  V8MONKEY_CHECK(JSONParser::Parse(cx, *large, &result), "Text declined by the fast path parsed");
+  V8MONKEY_CHECK(result.isObject(), "Result is an object");
+
+  std::string deep(1000, '[');
+  deep += std::string(1000, ']');
+  std::unique_ptr<StringWrapper> nested {StringWrapper::NewFromUtf8(cx, deep.c_str())};
+  V8MONKEY_CHECK(JSONParser::Parse(cx, *nested, &result), "Deeply nested text parsed");
+
+  std::unique_ptr<StringWrapper> bad {StringWrapper::NewFromUtf8(cx, "[1,]")};
+  V8MONKEY_CHECK(!JSONParser::Parse(cx, *bad, &result), "Malformed text rejected");
+  V8MONKEY_CHECK(JS_IsExceptionPending(cx), "Exception pending");
+  JS_ClearPendingException(cx);
+}
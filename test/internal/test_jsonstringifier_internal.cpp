@@ -0,0 +1,196 @@
+// size_t
+#include <cstddef>
+
+// unique_ptr
+#include <memory>
+
+// string, u16string
+#include <string>
+
+// vector
+#include <vector>
+
+// JS_ClearPendingException, JS_IsExceptionPending, JS::RootedValue
+#include "jsapi.h"
+
+// The class under test
+#include "types/json_stringifier.h"
+
+// ScriptSource ScriptWrapper
+#include "types/script_wrapper.h"
+
+// InCompartment
+#include "SpiderMonkeyTestUtils.h"
+
+// Unit-testing support
+#include "V8MonkeyTest.h"
+
+
+using namespace v8::internal;
+using namespace v8::TestUtils;
+
+
+namespace {
+  bool evaluate(JSContext* cx, const std::u16string& text, JS::MutableHandleValue result) {
+    ScriptSource source {text.data(), text.size()};
+    std::unique_ptr<ScriptWrapper> script {ScriptWrapper::Compile(cx, source)};
+    return script && script->Run(cx, result);
+  }
+
+
+  class CollectingStream : public JSONOutputStream {
+    public:
+      explicit CollectingStream(size_t size = 1024, size_t limit = 0) : chunkSize {size}, abortAfter {limit} {}
+
+      void EndOfStream() override {
+        ended++;
+      }
+
+      size_t GetChunkSize() override {
+        return chunkSize;
+      }
+
+      WriteResult WriteChunk(const char* data, size_t size) override {
+        chunks.emplace_back(data, size);
+        output.append(data, size);
+        return abortAfter && chunks.size() >= abortAfter ? kAbort : kContinue;
+      }
+
+      std::string output {};
+      std::vector<std::string> chunks {};
+      int ended {0};
+
+    private:
+      size_t chunkSize;
+      size_t abortAfter;
+  };
+
+
+  // Serialise the value of the given expression, returning the output, or "<outcome N>" if serialisation failed
+  std::string stringify(JSContext* cx, const std::u16string& expression) {
+    JS::RootedValue value(cx);
+    if (!evaluate(cx, expression, &value)) {
+      return "<evaluation failed>";
+    }
+
+    CollectingStream stream;
+    JSONStringifier::Outcome outcome {JSONStringifier::Stringify(cx, value, stream)};
+    if (outcome != JSONStringifier::kSerialized || stream.ended != 1) {
+      return "<outcome " + std::to_string(outcome) + ">";
+    }
+
+    return stream.output;
+  }
+}
+
+
+V8MONKEY_TEST(IntJSONStringifier001, "Plain data is serialised") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+
+  V8MONKEY_CHECK(stringify(cx, u"({b: [1, 2.5, -0, true, null, 'x'], a: {c: 'd'}, 1: 1e21})") ==
+                 "{\"1\":1e+21,\"b\":[1,2.5,0,true,null,\"x\"],\"a\":{\"c\":\"d\"}}", "Object serialised");
+  V8MONKEY_CHECK(stringify(cx, u"[[], {}, [[]]]") == "[[],{},[[]]]", "Empty containers serialised");
+  V8MONKEY_CHECK(stringify(cx, u"'top'") == "\"top\"", "Top-level string serialised");
+  V8MONKEY_CHECK(stringify(cx, u"-12") == "-12", "Top-level number serialised");
+}
+
+
+V8MONKEY_TEST(IntJSONStringifier002, "Values without a JSON representation are omitted") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+
+  V8MONKEY_CHECK(stringify(cx, u"[undefined, function() {}, NaN, -Infinity]") == "[null,null,null,null]",
+                 "Array elements replaced by null");
+  V8MONKEY_CHECK(stringify(cx, u"({a: undefined, f: function() {}, n: NaN, b: 1})") == "{\"n\":null,\"b\":1}",
+                 "Object members skipped");
+
+  JS::RootedValue value(cx);
+  CollectingStream stream;
+  V8MONKEY_CHECK(JSONStringifier::Stringify(cx, value, stream) == JSONStringifier::kUndefined, "Undefined reported");
+  V8MONKEY_CHECK(stream.output.empty() && !stream.ended, "Nothing written");
+}
+
+
+V8MONKEY_TEST(IntJSONStringifier003, "toJSON is called, and wrapped primitives are unwrapped") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+
+  V8MONKEY_CHECK(stringify(cx, u"({d: {toJSON: function(key) { return key + '!'; }}, "
+                               u"n: new Number(3), s: new String('s'), b: new Boolean(false)})") ==
+                 "{\"d\":\"d!\",\"n\":3,\"s\":\"s\",\"b\":false}", "Object serialised");
+  V8MONKEY_CHECK(stringify(cx, u"[0, {toJSON: function(key) { return typeof key + key; }}]") == "[0,\"string1\"]",
+                 "Array index passed to toJSON as a string");
+  V8MONKEY_CHECK(stringify(cx, u"new Date(0)") == "\"1970-01-01T00:00:00.000Z\"", "Date serialised");
+}
+
+
+V8MONKEY_TEST(IntJSONStringifier004, "Strings are escaped and encoded as UTF-8") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+
+  V8MONKEY_CHECK(stringify(cx, u"'a\"b\\\\c\\n\\t\\u0001/'") == "\"a\\\"b\\\\c\\n\\t\\u0001/\"", "ASCII escaped");
+  V8MONKEY_CHECK(stringify(cx, u"'\\u00e9\\u4e2d\\ud83d\\ude00'") == "\"\xc3\xa9\xe4\xb8\xad\xf0\x9f\x98\x80\"",
+                 "Non-ASCII encoded");
+  V8MONKEY_CHECK(stringify(cx, u"'\\ud800x\\udc00'") == "\"\\ud800x\\udc00\"", "Lone surrogates escaped");
+  V8MONKEY_CHECK(stringify(cx, u"({'\\u00e9': 1})") == "{\"\xc3\xa9\":1}", "Keys encoded");
+}
+
+
+V8MONKEY_TEST(IntJSONStringifier005, "Cycles are reported") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+
+  JS::RootedValue value(cx);
+  V8MONKEY_CHECK(evaluate(cx, u"var a = {b: [1]}; a.b.push(a); a", &value), "Value created");
+
+  CollectingStream stream;
+  V8MONKEY_CHECK(JSONStringifier::Stringify(cx, value, stream) == JSONStringifier::kFailed, "Failure reported");
+  V8MONKEY_CHECK(JS_IsExceptionPending(cx), "Exception pending");
+  V8MONKEY_CHECK(!stream.ended, "Stream not ended");
+  JS_ClearPendingException(cx);
+
+  V8MONKEY_CHECK(stringify(cx, u"var shared = {}; [shared, shared]") == "[{},{}]", "Repeated values are not cycles");
+}
+
+
+V8MONKEY_TEST(IntJSONStringifier006, "Output is delivered in chunks, and may be abandoned") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+
+  JS::RootedValue value(cx);
+  V8MONKEY_CHECK(evaluate(cx, u"var a = []; for (var i = 0; i < 1000; i++) a.push('\\u4e2d' + i); a", &value),
+                 "Value created");
+
+  CollectingStream whole;
+  V8MONKEY_CHECK(JSONStringifier::Stringify(cx, value, whole) == JSONStringifier::kSerialized, "Serialised");
+
+  CollectingStream chunked {40};
+  V8MONKEY_CHECK(JSONStringifier::Stringify(cx, value, chunked) == JSONStringifier::kSerialized, "Serialised");
+  V8MONKEY_CHECK(chunked.output == whole.output, "Chunked output matches");
+  V8MONKEY_CHECK(chunked.chunks.size() > 1, "Output chunked");
+
+  bool withinSize {true};
+  for (const auto& chunk : chunked.chunks) {
+    withinSize = withinSize && !chunk.empty() && chunk.size() <= 40;
+  }
+
+  V8MONKEY_CHECK(withinSize, "Chunks within size");
+
+  CollectingStream abandoned {40, 2};
+  V8MONKEY_CHECK(JSONStringifier::Stringify(cx, value, abandoned) == JSONStringifier::kAborted, "Abort reported");
+  V8MONKEY_CHECK(abandoned.chunks.size() == 2 && !abandoned.ended, "Nothing written after abort");
+}
+
+
+V8MONKEY_TEST(IntJSONStringifier007, "Deep nesting does not exhaust the native stack") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+
+  const size_t depth {100000};
+  std::string expected(depth + 1, '[');
+  expected += std::string(depth + 1, ']');
+
+  V8MONKEY_CHECK(stringify(cx, u"var a = []; for (var i = 0; i < 100000; i++) a = [a]; a") == expected,
+                 "Nested arrays serialised");
+}
@@ -0,0 +1,151 @@
+// std::numeric_limits
+#include <limits>
+
+// JS::RootedValue
+#include "jsapi.h"
+
+// The classes under test
+#include "types/lazy_value.h"
+
+// EnsureRuntimeAndContext GetJSContextForThread
+#include "utils/SpiderMonkeyUtils.h"
+
+// Unit-testing support
+#include "V8MonkeyTest.h"
+
+
+using namespace v8::internal;
+using namespace v8::SpiderMonkey;
+
+
+namespace {
+  // A LazyValue which counts how often it has been asked to materialize
+  class CountingValue : public LazyValue {
+    public:
+      int materializeCount {0};
+      bool shouldFail {false};
+
+    protected:
+      bool Materialize(JSContext*, JS::MutableHandleValue result) override {
+        materializeCount++;
+
+        if (shouldFail) {
+          return false;
+        }
+
+        result.setBoolean(true);
+        return true;
+      }
+  };
+}
+
+
+V8MONKEY_TEST(IntLazyValue001, "Numbers are classified correctly") {
+  const struct {
+    double value;
+    bool isInt32;
+    bool isUint32;
+  } cases[] {
+    {0.0, true, true},
+    {-0.0, false, false},
+    {1.0, true, true},
+    {-1.0, true, false},
+    {1.5, false, false},
+    {2147483647.0, true, true},
+    {2147483648.0, false, true},
+    {-2147483648.0, true, false},
+    {-2147483649.0, false, false},
+    {4294967295.0, false, true},
+    {4294967296.0, false, false},
+    {std::numeric_limits<double>::quiet_NaN(), false, false},
+    {std::numeric_limits<double>::infinity(), false, false}
+  };
+
+  for (const auto& c : cases) {
+    NativeNumber n {c.value};
+    V8MONKEY_CHECK(n.IsInt32() == c.isInt32, "Int32 classification correct");
+    V8MONKEY_CHECK(n.IsUint32() == c.isUint32, "Uint32 classification correct");
+  }
+}
+
+
+V8MONKEY_TEST(IntLazyValue002, "Integer constructors classify correctly") {
+  NativeNumber negative {static_cast<int32_t>(-5)};
+  V8MONKEY_CHECK(negative.IsInt32() && !negative.IsUint32(), "Negative int32 classified correctly");
+  V8MONKEY_CHECK(negative.Value() == -5.0, "Value correct");
+
+  NativeNumber large {static_cast<uint32_t>(4000000000u)};
+  V8MONKEY_CHECK(!large.IsInt32() && large.IsUint32(), "Large uint32 classified correctly");
+  V8MONKEY_CHECK(large.Value() == 4000000000.0, "Value correct");
+}
+
+
+V8MONKEY_TEST(IntLazyValue003, "Int32Value and Uint32Value follow ECMA-262") {
+  NativeNumber n {4294967297.5};
+  V8MONKEY_CHECK(n.Int32Value() == 1, "Int32Value correct");
+  V8MONKEY_CHECK(n.Uint32Value() == 1u, "Uint32Value correct");
+
+  NativeNumber m {-1.0};
+  V8MONKEY_CHECK(m.Int32Value() == -1, "Int32Value correct");
+  V8MONKEY_CHECK(m.Uint32Value() == 0xffffffffu, "Uint32Value correct");
+}
+
+
+V8MONKEY_TEST(IntLazyValue004, "Numbers are not materialized or traced on construction") {
+  NativeNumber n {1.5};
+  V8MONKEY_CHECK(!n.IsMaterialized(), "Number not materialized");
+  V8MONKEY_CHECK(!n.NeedsTrace(), "Number not traced");
+}
+
+
+V8MONKEY_TEST(IntLazyValue005, "Numbers materialize to the correct value") {
+  EnsureRuntimeAndContext();
+  JSContext* cx {GetJSContextForThread()};
+  JSAutoRequest ar(cx);
+
+  NativeNumber d {1.5};
+  JS::RootedValue value(cx);
+  V8MONKEY_CHECK(d.ToJSValue(cx, &value), "Materialization succeeded");
+  V8MONKEY_CHECK(value.isDouble() && value.toDouble() == 1.5, "Double value correct");
+  V8MONKEY_CHECK(d.IsMaterialized(), "Number materialized");
+  V8MONKEY_CHECK(!d.NeedsTrace(), "Number still not traced");
+
+  NativeNumber i {42.0};
+  V8MONKEY_CHECK(i.ToJSValue(cx, &value), "Materialization succeeded");
+  V8MONKEY_CHECK(value.isInt32() && value.toInt32() == 42, "Int32 value correct");
+
+  NativeNumber u {static_cast<uint32_t>(4000000000u)};
+  V8MONKEY_CHECK(u.ToJSValue(cx, &value), "Materialization succeeded");
+  V8MONKEY_CHECK(value.isNumber() && value.toNumber() == 4000000000.0, "Uint32 value correct");
+}
+
+
+V8MONKEY_TEST(IntLazyValue006, "Materialized value is cached") {
+  EnsureRuntimeAndContext();
+  JSContext* cx {GetJSContextForThread()};
+  JSAutoRequest ar(cx);
+
+  CountingValue v;
+  JS::RootedValue value(cx);
+  V8MONKEY_CHECK(v.ToJSValue(cx, &value), "Materialization succeeded");
+  V8MONKEY_CHECK(v.ToJSValue(cx, &value), "Materialization succeeded");
+  V8MONKEY_CHECK(value.isTrue(), "Value correct");
+  V8MONKEY_CHECK(v.materializeCount == 1, "Materialized once");
+}
+
+
+V8MONKEY_TEST(IntLazyValue007, "Failed materialization is not cached") {
+  EnsureRuntimeAndContext();
+  JSContext* cx {GetJSContextForThread()};
+  JSAutoRequest ar(cx);
+
+  CountingValue v;
+  v.shouldFail = true;
+  JS::RootedValue value(cx);
+  V8MONKEY_CHECK(!v.ToJSValue(cx, &value), "Materialization failed");
+  V8MONKEY_CHECK(!v.IsMaterialized(), "Value not materialized");
+
+  v.shouldFail = false;
+  V8MONKEY_CHECK(v.ToJSValue(cx, &value), "Materialization succeeded");
+  V8MONKEY_CHECK(v.materializeCount == 2, "Materialization retried");
+}
@@ -0,0 +1,190 @@
+// std::numeric_limits
+#include <limits>
+
+// std::mt19937_64
+#include <random>
+
+// strtod
+#include <cstdlib>
+
+// memcpy, strcmp, strlen
+#include <cstring>
+
+// string
+#include <string>
+
+// The functions under test
+#include "utils/NumberToString.h"
+
+// Int type definitions
+#include "v8stdint.h"
+
+// Unit-testing support
+#include "V8MonkeyTest.h"
+
+
+using namespace v8::V8Monkey::Conversions;
+
+
+namespace {
+  struct StringCase {
+    double input;
+    const char* expected;
+  };
+
+
+  // Expected values are those produced by Number.prototype.toString in SpiderMonkey and V8
+  const StringCase stringCases[] {
+    {0.0, "0"},
+    {-0.0, "0"},
+    {1.0, "1"},
+    {-1.0, "-1"},
+    {0.1, "0.1"},
+    {-0.1, "-0.1"},
+    {0.5, "0.5"},
+    {1.5, "1.5"},
+    {0.3, "0.3"},
+    {0.1 + 0.2, "0.30000000000000004"},
+    {1.0 / 3.0, "0.3333333333333333"},
+    {2.0 / 3.0, "0.6666666666666666"},
+    {123.456, "123.456"},
+    {2147483647.0, "2147483647"},
+    {2147483648.0, "2147483648"},
+    {-2147483648.0, "-2147483648"},
+    {-2147483649.0, "-2147483649"},
+    {4294967295.0, "4294967295"},
+    {4294967296.0, "4294967296"},
+    {9007199254740991.0, "9007199254740991"},
+    {9007199254740992.0, "9007199254740992"},
+    {1e20, "100000000000000000000"},
+    {123456789012345680000.0, "123456789012345680000"},
+    {1e21, "1e+21"},
+    {1.5e21, "1.5e+21"},
+    {1e-6, "0.000001"},
+    {1.5e-6, "0.0000015"},
+    {1e-7, "1e-7"},
+    {1.5e-7, "1.5e-7"},
+    {1.7976931348623157e308, "1.7976931348623157e+308"},
+    {-1.7976931348623157e308, "-1.7976931348623157e+308"},
+    {2.2250738585072014e-308, "2.2250738585072014e-308"},
+    {4.9406564584124654e-324, "5e-324"},
+    {-4.9406564584124654e-324, "-5e-324"},
+    {9.5367431640625e-7, "9.5367431640625e-7"},
+    {5e-324 * 3, "1.5e-323"},
+    {std::numeric_limits<double>::quiet_NaN(), "NaN"},
+    {std::numeric_limits<double>::infinity(), "Infinity"},
+    {-std::numeric_limits<double>::infinity(), "-Infinity"}
+  };
+
+
+  // Generate "interesting" doubles: random bit patterns, random integers, and random short decimals
+  double randomDouble(std::mt19937_64& generator, int i) {
+    uint64_t bits {generator()};
+
+    switch (i % 3) {
+      case 1:
+        return static_cast<double>(bits >> (generator() % 64));
+
+      case 2:
+        return static_cast<double>(bits % 1000000) / static_cast<double>(1 + generator() % 10000);
+
+      default:
+        double d;
+        std::memcpy(&d, &bits, sizeof(d));
+        return d;
+    }
+  }
+}
+
+
+V8MONKEY_TEST(IntNumberToString001, "DoubleToString produces ECMAScript Number::toString output") {
+  for (const auto& c : stringCases) {
+    char buffer[NumberToStringBufferSize];
+    size_t length {DoubleToString(c.input, buffer)};
+
+    V8MONKEY_CHECK(std::strcmp(buffer, c.expected) == 0, "String correct");
+    V8MONKEY_CHECK(length == std::strlen(c.expected), "Length correct");
+  }
+}
+
+
+V8MONKEY_TEST(IntNumberToString002, "Grisu3 agrees with exact search whenever it succeeds") {
+  std::mt19937_64 generator {0x5eed};
+  int candidates {0};
+  int grisuSuccesses {0};
+
+  for (int i = 0; i < 200000; i++) {
+    double d {randomDouble(generator, i)};
+    if (!(d > 0) || d == std::numeric_limits<double>::infinity()) {
+      continue;
+    }
+
+    candidates++;
+
+    char grisuDigits[18];
+    int grisuLength;
+    int grisuExponent;
+    if (!ShortestDigitsGrisu3(d, grisuDigits, &grisuLength, &grisuExponent)) {
+      continue;
+    }
+
+    grisuSuccesses++;
+
+    char exactDigits[18];
+    int exactLength;
+    int exactExponent;
+    ShortestDigitsExact(d, exactDigits, &exactLength, &exactExponent);
+
+    V8MONKEY_CHECK(grisuLength == exactLength, "Digit count matches");
+    V8MONKEY_CHECK(grisuExponent == exactExponent, "Exponent matches");
+    V8MONKEY_CHECK(std::string(grisuDigits, static_cast<size_t>(grisuLength)) ==
+                   std::string(exactDigits, static_cast<size_t>(exactLength)), "Digits match");
+  }
+
+  // Grisu3 is documented to succeed for ~99.5% of inputs
+  V8MONKEY_CHECK(grisuSuccesses > candidates / 100 * 95, "Grisu3 handled the vast majority of values");
+}
+
+
+V8MONKEY_TEST(IntNumberToString003, "DoubleToString output round-trips") {
+  std::mt19937_64 generator {0xdecaf};
+
+  for (int i = 0; i < 100000; i++) {
+    double d {randomDouble(generator, i)};
+    if (d != d) {
+      continue;
+    }
+
+    char buffer[NumberToStringBufferSize];
+    size_t length {DoubleToString(d, buffer)};
+
+    V8MONKEY_CHECK(length < NumberToStringBufferSize, "Buffer size respected");
+    V8MONKEY_CHECK(std::strtod(buffer, nullptr) == d, "Value round-trips");
+  }
+}
+
+
+V8MONKEY_TEST(IntNumberToString004, "Int32ToString formats correctly") {
+  const int32_t inputs[] {0, 1, -1, 9, 10, -10, 99, 100, 1023, 1024, -1024, 65535, 2147483647, -2147483647 - 1};
+
+  for (int32_t input : inputs) {
+    char buffer[NumberToStringBufferSize];
+    size_t length {Int32ToString(input, buffer)};
+
+    V8MONKEY_CHECK(std::to_string(input) == buffer, "String correct");
+    V8MONKEY_CHECK(length == std::strlen(buffer), "Length correct");
+  }
+}
+
+
+V8MONKEY_TEST(IntNumberToString005, "Uint32ToString formats correctly") {
+  const uint32_t inputs[] {0u, 1u, 9u, 10u, 99u, 100u, 1023u, 1024u, 65535u, 2147483648u, 4294967295u};
+
+  for (uint32_t input : inputs) {
+    char buffer[NumberToStringBufferSize];
+    size_t length {Uint32ToString(input, buffer)};
+
+    V8MONKEY_CHECK(std::to_string(input) == buffer, "String correct");
+    V8MONKEY_CHECK(length == std::strlen(buffer), "Length correct");
+  }
+}
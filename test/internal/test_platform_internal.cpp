@@ -1,9 +1,24 @@
+// atomic
+#include <atomic>
+
 // intptr_t
 #include <cinttypes>
 
-// memcpy
+// mkdtemp
+#include <cstdlib>
+
+// memcmp memcpy
 #include <cstring>
 
+// string
+#include <string>
+
+// vector
+#include <vector>
+
+// rmdir
+#include <unistd.h>
+
 // Class under test
 #include "platform/platform.h"
 
@@ -77,6 +92,37 @@ namespace {
   void oneShot() {
     oneShotVal++;
   }
+
+
+  // Wait for the event passed as argument, recording that the wait completed
+  std::atomic<bool> waitCompleted {false};
+  extern "C"
+  void* eventWaiter(void* arg) {
+    reinterpret_cast<v8::V8Platform::Event*>(arg)->Wait();
+    waitCompleted = true;
+    return nullptr;
+  }
+
+
+  // A scratch directory, removed along with its contents when the test completes
+  struct TempDirectory {
+    std::string path;
+
+    TempDirectory() {
+      char name[] {"/tmp/v8monkey_test_XXXXXX"};
+      path = mkdtemp(name);
+    }
+
+    ~TempDirectory() {
+      std::vector<v8::V8Platform::FileSystem::Entry> entries;
+      v8::V8Platform::FileSystem::ListFiles(path.c_str(), "", entries);
+      for (const auto& entry : entries) {
+        v8::V8Platform::FileSystem::Remove((path + '/' + entry.name).c_str());
+      }
+
+      rmdir(path.c_str());
+    }
+  };
 }
 
 
@@ -181,3 +227,87 @@ V8MONKEY_TEST(Plat012, "OneShot called only once") {
   o.Run();
   V8MONKEY_CHECK(oneShotVal == 1, "One shot function only ran once");
 }
+
+
+V8MONKEY_TEST(Plat013, "Atomically written files can be mapped") {
+  TempDirectory dir;
+  std::string path {dir.path + "/file"};
+  const char contents[] {"Hello, world"};
+  V8MONKEY_CHECK(FileSystem::WriteAtomically(path.c_str(), contents, sizeof(contents)), "Write succeeded");
+
+  MappedFile mapped {path.c_str()};
+  V8MONKEY_CHECK(mapped.IsValid(), "File mapped");
+  V8MONKEY_CHECK(mapped.Length() == sizeof(contents), "Length correct");
+  V8MONKEY_CHECK(std::memcmp(mapped.Data(), contents, sizeof(contents)) == 0, "Contents correct");
+}
+
+
+V8MONKEY_TEST(Plat014, "Atomic writes replace existing files and leave no temporaries") {
+  TempDirectory dir;
+  std::string path {dir.path + "/file"};
+  V8MONKEY_CHECK(FileSystem::WriteAtomically(path.c_str(), "old contents", 12), "First write succeeded");
+
+  MappedFile old {path.c_str()};
+  V8MONKEY_CHECK(FileSystem::WriteAtomically(path.c_str(), "new", 3), "Second write succeeded");
+  V8MONKEY_CHECK(std::memcmp(old.Data(), "old contents", 12) == 0, "Existing mappings unaffected");
+
+  MappedFile replaced {path.c_str()};
+  V8MONKEY_CHECK(replaced.Length() == 3 && std::memcmp(replaced.Data(), "new", 3) == 0, "Contents replaced");
+
+  std::vector<FileSystem::Entry> entries;
+  V8MONKEY_CHECK(FileSystem::ListFiles(dir.path.c_str(), "", entries), "Directory listed");
+  V8MONKEY_CHECK(entries.size() == 1, "No temporaries remain");
+}
+
+
+V8MONKEY_TEST(Plat015, "Mapping missing and empty files") {
+  TempDirectory dir;
+  std::string path {dir.path + "/file"};
+  MappedFile missing {path.c_str()};
+  V8MONKEY_CHECK(!missing.IsValid(), "Missing file not mapped");
+
+  V8MONKEY_CHECK(FileSystem::WriteAtomically(path.c_str(), "", 0), "Write succeeded");
+  MappedFile empty {path.c_str()};
+  V8MONKEY_CHECK(empty.IsValid(), "Empty file valid");
+  V8MONKEY_CHECK(empty.Length() == 0, "Length correct");
+}
+
+
+V8MONKEY_TEST(Plat016, "Directory listings are filtered by suffix") {
+  TempDirectory dir;
+  V8MONKEY_CHECK(FileSystem::WriteAtomically((dir.path + "/a.jsc").c_str(), "abc", 3), "Write succeeded");
+  V8MONKEY_CHECK(FileSystem::WriteAtomically((dir.path + "/b.txt").c_str(), "abcdef", 6), "Write succeeded");
+
+  std::vector<FileSystem::Entry> entries;
+  V8MONKEY_CHECK(FileSystem::ListFiles(dir.path.c_str(), ".jsc", entries), "Directory listed");
+  V8MONKEY_CHECK(entries.size() == 1, "Only matching files listed");
+  V8MONKEY_CHECK(entries[0].name == "a.jsc" && entries[0].size == 3, "Entry correct");
+
+  V8MONKEY_CHECK(FileSystem::Remove((dir.path + "/a.jsc").c_str()), "File removed");
+  entries.clear();
+  FileSystem::ListFiles(dir.path.c_str(), ".jsc", entries);
+  V8MONKEY_CHECK(entries.empty(), "Removed file not listed");
+}
+
+
+V8MONKEY_TEST(Plat017, "Events are initially unsignalled, and stay signalled") {
+  Event e;
+  V8MONKEY_CHECK(!e.IsSignalled(), "Event initially unsignalled");
+  e.Signal();
+  V8MONKEY_CHECK(e.IsSignalled(), "Event signalled");
+  e.Wait();
+  e.Wait();
+  V8MONKEY_CHECK(e.IsSignalled(), "Event still signalled after waits");
+}
+
+
+V8MONKEY_TEST(Plat018, "Signalling an event releases waiting threads") {
+  waitCompleted = false;
+  Event e;
+  Thread t {eventWaiter};
+  t.Run(&e);
+
+  e.Signal();
+  t.Join();
+  V8MONKEY_CHECK(waitCompleted, "Waiting thread was released");
+}
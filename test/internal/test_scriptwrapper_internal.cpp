@@ -0,0 +1,544 @@
+// copy
+#include <algorithm>
+
+// mkdtemp
+#include <cstdlib>
+
+// strcmp
+#include <cstring>
+
+// unique_ptr
+#include <memory>
+
+// string, u16string
+#include <string>
+
+// open O_RDONLY
+#include <fcntl.h>
+
+// close rmdir
+#include <unistd.h>
+
+// JS_ClearPendingException, JS_GetGlobalFromScript, JS_IsExceptionPending, JS::RootedValue
+#include "jsapi.h"
+
+// FileSystem
+#include "platform/platform.h"
+
+// Flags
+#include "runtime/flags.h"
+
+// Isolate
+#include "runtime/isolate.h"
+
+// The classes under test
+#include "types/script_wrapper.h"
+
+// NewGlobal
+#include "utils/SpiderMonkeyUtils.h"
+
+// InCompartment
+#include "SpiderMonkeyTestUtils.h"
+
+// Unit-testing support
+#include "V8MonkeyTest.h"
+
+
+using namespace v8::internal;
+using namespace v8::SpiderMonkey;
+using namespace v8::TestUtils;
+using namespace v8::V8Platform;
+
+
+namespace {
+  const std::u16string answerSource {u"var x = 6; x * 7"};
+
+
+  bool runsToAnswer(JSContext* cx, ScriptWrapper* script) {
+    JS::RootedValue value(cx);
+    return script && script->Run(cx, &value) && value.isInt32() && value.toInt32() == 42;
+  }
+
+
+  // Counts how many times it has been run in the current global
+  const std::u16string countingSource {u"var count = typeof count == 'undefined' ? 1 : count + 1; count"};
+
+
+  int runToInt(JSContext* cx, ScriptWrapper* script) {
+    JS::RootedValue value(cx);
+    return script && script->Run(cx, &value) && value.isInt32() ? value.toInt32() : -1;
+  }
+
+
+  // Large enough that SpiderMonkey will compile it off-thread
+  std::u16string largeSource(const char16_t* last) {
+    std::u16string text {u"var x = 42;\n"};
+    for (int i = 0; i < 20000; i++) {
+      text += u"x = x + 0;\n";
+    }
+
+    return text + last;
+  }
+
+
+  // Produce cached data for the given source
+  CachedData* produceCache(JSContext* cx, const std::u16string& text) {
+    ScriptSource source {text.data(), text.size()};
+    std::unique_ptr<ScriptWrapper> script {ScriptWrapper::Compile(cx, source, ScriptWrapper::kProduceCodeCache)};
+    const CachedData* produced {source.GetCachedData()};
+    if (!script || !produced) {
+      return nullptr;
+    }
+
+    size_t length {static_cast<size_t>(produced->length)};
+    uint8_t* copy {new uint8_t[length]};
+    std::copy(produced->data, produced->data + produced->length, copy);
+    return new CachedData(copy, produced->length, CachedData::BufferOwned);
+  }
+
+
+  // A file with the given contents in a fresh temporary directory, both removed on destruction
+  struct TempFile {
+    std::string directory;
+    std::string path;
+
+    explicit TempFile(const std::string& contents) {
+      char name[] {"/tmp/v8monkey_test_XXXXXX"};
+      directory = mkdtemp(name);
+      path = directory + "/script.js";
+      FileSystem::WriteAtomically(path.c_str(), contents.data(), contents.size());
+    }
+
+    ~TempFile() {
+      FileSystem::Remove(path.c_str());
+      rmdir(directory.c_str());
+    }
+  };
+
+
+  // A mapped source for the file at the given path
+  ScriptSource* mappedSource(const std::string& path, ScriptSource::Encoding encoding = ScriptSource::kUTF8,
+                             CachedData* cached = nullptr) {
+    MappedStringResource* resource {MappedStringResource::New(path.c_str())};
+    return resource ? new ScriptSource(resource, encoding, ScriptOrigin {path, 0}, cached) : nullptr;
+  }
+}
+
+
+V8MONKEY_TEST(IntScriptWrapper001, "Compiled scripts run correctly") {
+  InCompartment c;
+  ScriptSource source {answerSource.data(), answerSource.size(), ScriptOrigin {"answer.js", 10}};
+  std::unique_ptr<ScriptWrapper> script {ScriptWrapper::Compile(c.cx, source)};
+  V8MONKEY_CHECK(runsToAnswer(c.cx, script.get()), "Script ran correctly");
+  V8MONKEY_CHECK(source.GetCachedData() == nullptr, "No cached data produced");
+}
+
+
+V8MONKEY_TEST(IntScriptWrapper002, "Compile errors are reported") {
+  InCompartment c;
+  std::u16string text {u"var = ;"};
+  ScriptSource source {text.data(), text.size()};
+  std::unique_ptr<ScriptWrapper> script {ScriptWrapper::Compile(c.cx, source)};
+  V8MONKEY_CHECK(!script, "Compilation failed");
+  V8MONKEY_CHECK(JS_IsExceptionPending(c.cx), "Exception pending");
+  JS_ClearPendingException(c.cx);
+}
+
+
+V8MONKEY_TEST(IntScriptWrapper003, "Producing a code cache yields owned data") {
+  InCompartment c;
+  ScriptSource source {answerSource.data(), answerSource.size()};
+  std::unique_ptr<ScriptWrapper> script {ScriptWrapper::Compile(c.cx, source, ScriptWrapper::kProduceCodeCache)};
+  V8MONKEY_CHECK(runsToAnswer(c.cx, script.get()), "Script ran correctly");
+
+  const CachedData* cache {source.GetCachedData()};
+  V8MONKEY_CHECK(cache && cache->data && cache->length > 0, "Cached data produced");
+  V8MONKEY_CHECK(cache->buffer_policy == CachedData::BufferOwned, "Cached data owned");
+  V8MONKEY_CHECK(!cache->rejected, "Cached data not rejected");
+}
+
+
+V8MONKEY_TEST(IntScriptWrapper004, "Consuming a code cache yields a working script") {
+  InCompartment c;
+  CachedData* cache {produceCache(c.cx, answerSource)};
+  V8MONKEY_CHECK(cache, "Cached data produced");
+
+  ScriptSource source {answerSource.data(), answerSource.size(), ScriptOrigin {}, cache};
+  std::unique_ptr<ScriptWrapper> script {ScriptWrapper::Compile(c.cx, source, ScriptWrapper::kConsumeCodeCache)};
+  V8MONKEY_CHECK(!source.GetCachedData()->rejected, "Cached data accepted");
+  V8MONKEY_CHECK(runsToAnswer(c.cx, script.get()), "Script ran correctly");
+}
+
+
+V8MONKEY_TEST(IntScriptWrapper005, "Code caches for different source are rejected") {
+  InCompartment c;
+  CachedData* cache {produceCache(c.cx, u"var x = 6; x * 9")};
+  V8MONKEY_CHECK(cache, "Cached data produced");
+
+  ScriptSource source {answerSource.data(), answerSource.size(), ScriptOrigin {}, cache};
+  std::unique_ptr<ScriptWrapper> script {ScriptWrapper::Compile(c.cx, source, ScriptWrapper::kConsumeCodeCache)};
+  V8MONKEY_CHECK(source.GetCachedData()->rejected, "Cached data rejected");
+  V8MONKEY_CHECK(runsToAnswer(c.cx, script.get()), "Script compiled from source");
+}
+
+
+V8MONKEY_TEST(IntScriptWrapper006, "Truncated and corrupt code caches are rejected") {
+  InCompartment c;
+  std::unique_ptr<CachedData> produced {produceCache(c.cx, answerSource)};
+  V8MONKEY_CHECK(produced, "Cached data produced");
+
+  ScriptSource truncated {answerSource.data(), answerSource.size(), ScriptOrigin {},
+                          new CachedData(produced->data, produced->length - 1)};
+  std::unique_ptr<ScriptWrapper> script {ScriptWrapper::Compile(c.cx, truncated, ScriptWrapper::kConsumeCodeCache)};
+  V8MONKEY_CHECK(truncated.GetCachedData()->rejected, "Truncated data rejected");
+  V8MONKEY_CHECK(runsToAnswer(c.cx, script.get()), "Script compiled from source");
+
+  const uint8_t garbage[64] {};
+  ScriptSource corrupt {answerSource.data(), answerSource.size(), ScriptOrigin {},
+                        new CachedData(garbage, sizeof(garbage))};
+  script.reset(ScriptWrapper::Compile(c.cx, corrupt, ScriptWrapper::kConsumeCodeCache));
+  V8MONKEY_CHECK(corrupt.GetCachedData()->rejected, "Corrupt data rejected");
+  V8MONKEY_CHECK(runsToAnswer(c.cx, script.get()), "Script compiled from source");
+}
+
+
+V8MONKEY_TEST(IntScriptWrapper007, "Source hashes depend only on the text") {
+  std::u16string copy {answerSource};
+  ScriptSource first {answerSource.data(), answerSource.size(), ScriptOrigin {"a.js", 0}};
+  ScriptSource second {copy.data(), copy.size(), ScriptOrigin {"b.js", 5}};
+  ScriptSource prefix {answerSource.data(), answerSource.size() - 1};
+  V8MONKEY_CHECK(first.Hash() == second.Hash(), "Equal text hashes equally");
+  V8MONKEY_CHECK(first.Hash() != prefix.Hash(), "Different text hashes differently");
+}
+
+
+V8MONKEY_TEST(IntScriptWrapper008, "Large scripts compile off-thread") {
+  InCompartment c;
+  std::u16string text {largeSource(u"x")};
+  ScriptSource source {text.data(), text.size()};
+  std::unique_ptr<CompileTask> task {CompileTask::Start(c.cx, source)};
+  V8MONKEY_CHECK(task, "Task started");
+
+  std::unique_ptr<ScriptWrapper> script {task->Finish(c.cx)};
+  V8MONKEY_CHECK(task->IsReady(), "Task ready after finishing");
+  V8MONKEY_CHECK(runsToAnswer(c.cx, script.get()), "Script ran correctly");
+}
+
+
+V8MONKEY_TEST(IntScriptWrapper009, "Short scripts are compiled when the task is finished") {
+  InCompartment c;
+  ScriptSource source {answerSource.data(), answerSource.size()};
+  std::unique_ptr<CompileTask> task {CompileTask::Start(c.cx, source)};
+  V8MONKEY_CHECK(task && task->IsReady(), "Task immediately ready");
+
+  std::unique_ptr<ScriptWrapper> script {};
+  {
+    InCompartment other;
+    script.reset(task->Finish(other.cx));
+  }
+
+  V8MONKEY_CHECK(script && JS_GetGlobalFromScript(script->Script()) == c.global, "Script bound to starting global");
+  V8MONKEY_CHECK(runsToAnswer(c.cx, script.get()), "Script ran correctly");
+}
+
+
+V8MONKEY_TEST(IntScriptWrapper010, "Unfinished tasks can be destroyed") {
+  InCompartment c;
+  std::u16string text {largeSource(u"x")};
+  ScriptSource source {text.data(), text.size()};
+  std::unique_ptr<CompileTask> task {CompileTask::Start(c.cx, source)};
+  V8MONKEY_CHECK(task, "Task started");
+  task.reset();
+
+  // The helper thread state must be intact for later compilations
+  task.reset(CompileTask::Start(c.cx, source));
+  std::unique_ptr<ScriptWrapper> script {task->Finish(c.cx)};
+  V8MONKEY_CHECK(runsToAnswer(c.cx, script.get()), "Script ran correctly");
+}
+
+
+V8MONKEY_TEST(IntScriptWrapper011, "Off-thread compile errors are reported when finishing") {
+  InCompartment c;
+  std::u16string text {largeSource(u"var = ;")};
+  ScriptSource source {text.data(), text.size()};
+  std::unique_ptr<CompileTask> task {CompileTask::Start(c.cx, source)};
+  V8MONKEY_CHECK(task, "Task started");
+
+  std::unique_ptr<ScriptWrapper> script {task->Finish(c.cx)};
+  V8MONKEY_CHECK(!script, "Compilation failed");
+  V8MONKEY_CHECK(JS_IsExceptionPending(c.cx), "Exception pending");
+  JS_ClearPendingException(c.cx);
+}
+
+
+V8MONKEY_TEST(IntScriptWrapper012, "Unbound scripts can be bound to many contexts") {
+  InCompartment c;
+  ScriptSource source {countingSource.data(), countingSource.size()};
+  std::unique_ptr<UnboundScriptWrapper> unbound {UnboundScriptWrapper::Compile(c.cx, source)};
+  V8MONKEY_CHECK(unbound, "Script compiled");
+
+  std::unique_ptr<ScriptWrapper> bound {unbound->BindToCurrentContext(c.cx)};
+  V8MONKEY_CHECK(runToInt(c.cx, bound.get()) == 1, "Script ran correctly");
+  V8MONKEY_CHECK(runToInt(c.cx, bound.get()) == 2, "Script ran in the same global");
+
+  for (int i = 0; i < 3; i++) {
+    JS::RootedObject other(c.cx, NewGlobal(c.cx));
+    JSAutoCompartment ac(c.cx, other);
+    std::unique_ptr<ScriptWrapper> rebound {unbound->BindToCurrentContext(c.cx)};
+    V8MONKEY_CHECK(runToInt(c.cx, rebound.get()) == 1, "Script ran in the new global");
+  }
+
+  std::unique_ptr<ScriptWrapper> again {unbound->BindToCurrentContext(c.cx)};
+  V8MONKEY_CHECK(runToInt(c.cx, again.get()) == 3, "Rebinding to the original global sees its state");
+}
+
+
+V8MONKEY_TEST(IntScriptWrapper013, "Unbound compile errors are reported") {
+  InCompartment c;
+  std::u16string text {u"var = ;"};
+  ScriptSource source {text.data(), text.size()};
+  std::unique_ptr<UnboundScriptWrapper> unbound {UnboundScriptWrapper::Compile(c.cx, source)};
+  V8MONKEY_CHECK(!unbound, "Compilation failed");
+  V8MONKEY_CHECK(JS_IsExceptionPending(c.cx), "Exception pending");
+  JS_ClearPendingException(c.cx);
+}
+
+
+V8MONKEY_TEST(IntScriptWrapper014, "Unbound scripts can produce and consume code caches") {
+  InCompartment c;
+  ScriptSource source {answerSource.data(), answerSource.size()};
+  std::unique_ptr<UnboundScriptWrapper> unbound {
+    UnboundScriptWrapper::Compile(c.cx, source, ScriptWrapper::kProduceCodeCache)};
+  V8MONKEY_CHECK(unbound && source.GetCachedData(), "Cached data produced");
+
+  std::unique_ptr<ScriptWrapper> producer {unbound->BindToCurrentContext(c.cx)};
+  V8MONKEY_CHECK(runsToAnswer(c.cx, producer.get()), "Producing script ran correctly");
+
+  CachedData* cache {produceCache(c.cx, answerSource)};
+  ScriptSource consumer {answerSource.data(), answerSource.size(), ScriptOrigin {}, cache};
+  unbound.reset(UnboundScriptWrapper::Compile(c.cx, consumer, ScriptWrapper::kConsumeCodeCache));
+  V8MONKEY_CHECK(!consumer.GetCachedData()->rejected, "Cached data accepted");
+
+  std::unique_ptr<ScriptWrapper> bound {unbound->BindToCurrentContext(c.cx)};
+  V8MONKEY_CHECK(runsToAnswer(c.cx, bound.get()), "Script ran correctly");
+}
+
+
+V8MONKEY_TEST(IntScriptWrapper015, "Compiles record their statistics") {
+  InCompartment c;
+  Flags::Reset();
+
+  std::u16string text {largeSource(u"x")};
+  ScriptSource source {text.data(), text.size()};
+  std::unique_ptr<ScriptWrapper> script {ScriptWrapper::Compile(c.cx, source)};
+  V8MONKEY_CHECK(script, "Script compiled");
+
+  const CompileStatistics& stats {script->Statistics()};
+  V8MONKEY_CHECK(stats.sourceLength == text.size(), "Source length recorded");
+  V8MONKEY_CHECK(stats.milliseconds >= 0.0, "Compile time recorded");
+  V8MONKEY_CHECK(stats.lazy, "Long script parsed lazily");
+  V8MONKEY_CHECK(!stats.decoded && !stats.offThread, "Compiled on this thread from source");
+  V8MONKEY_CHECK(stats.bytecodeSize == 0, "No bytecode size without encoding");
+
+  ScriptSource shortSource {answerSource.data(), answerSource.size()};
+  script.reset(ScriptWrapper::Compile(c.cx, shortSource));
+  V8MONKEY_CHECK(!script->Statistics().lazy, "Short script parsed eagerly");
+}
+
+
+V8MONKEY_TEST(IntScriptWrapper016, "Lazy parsing follows the flags") {
+  InCompartment c;
+  std::u16string text {largeSource(u"x")};
+
+  Flags::SetFromArguments({"--nolazy"});
+  ScriptSource eager {text.data(), text.size()};
+  std::unique_ptr<ScriptWrapper> script {ScriptWrapper::Compile(c.cx, eager)};
+  V8MONKEY_CHECK(runsToAnswer(c.cx, script.get()) && !script->Statistics().lazy, "Laziness disabled");
+
+  Flags::Reset();
+  Flags::SetFromArguments({"--min_preparse_length=1"});
+  ScriptSource shortSource {answerSource.data(), answerSource.size()};
+  script.reset(ScriptWrapper::Compile(c.cx, shortSource));
+  V8MONKEY_CHECK(runsToAnswer(c.cx, script.get()) && script->Statistics().lazy, "Minimum length lowered");
+
+  // Code cache compiles cannot be lazy
+  ScriptSource producer {answerSource.data(), answerSource.size()};
+  script.reset(ScriptWrapper::Compile(c.cx, producer, ScriptWrapper::kProduceCodeCache));
+  V8MONKEY_CHECK(runsToAnswer(c.cx, script.get()) && !script->Statistics().lazy, "Cache producer compiled eagerly");
+  Flags::Reset();
+}
+
+
+V8MONKEY_TEST(IntScriptWrapper017, "Code caches and bound scripts record their bytecode size") {
+  InCompartment c;
+  ScriptSource producer {answerSource.data(), answerSource.size()};
+  std::unique_ptr<ScriptWrapper> script {ScriptWrapper::Compile(c.cx, producer, ScriptWrapper::kProduceCodeCache)};
+  size_t produced {script->Statistics().bytecodeSize};
+  V8MONKEY_CHECK(produced > 0 && !script->Statistics().decoded, "Bytecode size recorded when producing");
+
+  ScriptSource consumer {answerSource.data(), answerSource.size(), ScriptOrigin {}, produceCache(c.cx, answerSource)};
+  script.reset(ScriptWrapper::Compile(c.cx, consumer, ScriptWrapper::kConsumeCodeCache));
+  V8MONKEY_CHECK(script->Statistics().decoded, "Decoding recorded");
+  V8MONKEY_CHECK(script->Statistics().bytecodeSize == produced, "Bytecode size recorded when consuming");
+
+  ScriptSource unboundSource {answerSource.data(), answerSource.size()};
+  std::unique_ptr<UnboundScriptWrapper> unbound {UnboundScriptWrapper::Compile(c.cx, unboundSource)};
+  V8MONKEY_CHECK(unbound->Statistics().bytecodeSize > 0, "Unbound bytecode size recorded");
+  V8MONKEY_CHECK(unbound->Statistics().sourceLength == answerSource.size(), "Unbound source length recorded");
+
+  script.reset(unbound->BindToCurrentContext(c.cx));
+  V8MONKEY_CHECK(script->Statistics().decoded, "Binding recorded as decoding");
+  V8MONKEY_CHECK(script->Statistics().bytecodeSize == unbound->Statistics().bytecodeSize, "Bound size recorded");
+  V8MONKEY_CHECK(script->Statistics().sourceLength == answerSource.size(), "Bound source length recorded");
+}
+
+
+V8MONKEY_TEST(IntScriptWrapper018, "Off-thread compiles record their statistics") {
+  InCompartment c;
+  Flags::Reset();
+
+  std::u16string text {largeSource(u"x")};
+  ScriptSource source {text.data(), text.size()};
+  std::unique_ptr<CompileTask> task {CompileTask::Start(c.cx, source)};
+  V8MONKEY_CHECK(task, "Task started");
+
+  // Whether the task ran off-thread is up to SpiderMonkey, but the statistics are the same shape either way
+  std::unique_ptr<ScriptWrapper> script {task->Finish(c.cx)};
+  const CompileStatistics& stats {script->Statistics()};
+  V8MONKEY_CHECK(stats.lazy && !stats.decoded, "Lazy compile from source recorded");
+  V8MONKEY_CHECK(stats.sourceLength == text.size() && stats.milliseconds >= 0.0, "Length and time recorded");
+}
+
+
+namespace {
+  int scriptsCompiled {0};
+  int scriptsDecoded {0};
+  int sourceLength {0};
+  int bytecodeSize {0};
+
+
+  int* lookupCounter(const char* name) {
+    if (std::strcmp(name, "c:V8Monkey.ScriptsCompiled") == 0) {
+      return &scriptsCompiled;
+    }
+
+    if (std::strcmp(name, "c:V8Monkey.ScriptsDecoded") == 0) {
+      return &scriptsDecoded;
+    }
+
+    if (std::strcmp(name, "c:V8Monkey.ScriptSourceLength") == 0) {
+      return &sourceLength;
+    }
+
+    if (std::strcmp(name, "c:V8Monkey.ScriptBytecodeSize") == 0) {
+      return &bytecodeSize;
+    }
+
+    return nullptr;
+  }
+}
+
+
+V8MONKEY_TEST(IntScriptWrapper019, "Compile statistics are reported through the isolate's counters") {
+  InCompartment c;
+  Isolate* isolate {new Isolate};
+  isolate->Enter();
+  isolate->SetCounterFunction(lookupCounter);
+
+  ScriptSource plain {answerSource.data(), answerSource.size()};
+  std::unique_ptr<ScriptWrapper> script {ScriptWrapper::Compile(c.cx, plain)};
+  V8MONKEY_CHECK(scriptsCompiled == 1 && scriptsDecoded == 0, "Compile counted");
+  V8MONKEY_CHECK(sourceLength == static_cast<int>(answerSource.size()), "Source length counted");
+  V8MONKEY_CHECK(bytecodeSize == 0, "Plain compiles have no bytecode size");
+
+  ScriptSource unboundSource {answerSource.data(), answerSource.size()};
+  std::unique_ptr<UnboundScriptWrapper> unbound {UnboundScriptWrapper::Compile(c.cx, unboundSource)};
+  script.reset(unbound->BindToCurrentContext(c.cx));
+  V8MONKEY_CHECK(scriptsCompiled == 2 && scriptsDecoded == 1, "Unbound compile and bind counted");
+  V8MONKEY_CHECK(bytecodeSize == static_cast<int>(2 * unbound->Length()), "Bytecode sizes counted");
+
+  isolate->Exit();
+  isolate->Dispose();
+}
+
+
+V8MONKEY_TEST(IntScriptWrapper020, "Scripts compile from mapped files") {
+  InCompartment c;
+  TempFile utf8 {"var s = '\xc3\xa9\xe4\xb8\xad'; s.length == 2 && s.charCodeAt(1) == 0x4e2d ? 42 : 0"};
+  std::unique_ptr<ScriptSource> source {mappedSource(utf8.path)};
+  V8MONKEY_CHECK(source && source->GetEncoding() == ScriptSource::kUTF8, "Source mapped");
+  V8MONKEY_CHECK(source->Chars() == nullptr && source->Bytes(), "Source text left as bytes");
+
+  std::unique_ptr<ScriptWrapper> script {ScriptWrapper::Compile(c.cx, *source)};
+  V8MONKEY_CHECK(runsToAnswer(c.cx, script.get()), "UTF-8 script ran correctly");
+
+  TempFile latin1 {"var s = '\xe9'; s.length == 1 && s.charCodeAt(0) == 0xe9 ? 42 : 0"};
+  source.reset(mappedSource(latin1.path, ScriptSource::kLatin1));
+  script.reset(ScriptWrapper::Compile(c.cx, *source));
+  V8MONKEY_CHECK(runsToAnswer(c.cx, script.get()), "Latin1 script ran correctly");
+
+  source.reset(mappedSource(latin1.path, ScriptSource::kUTF8));
+  script.reset(ScriptWrapper::Compile(c.cx, *source));
+  V8MONKEY_CHECK(!script && JS_IsExceptionPending(c.cx), "Malformed UTF-8 reported");
+  JS_ClearPendingException(c.cx);
+}
+
+
+V8MONKEY_TEST(IntScriptWrapper021, "Scripts compile from file descriptors, and missing files are reported") {
+  InCompartment c;
+  TempFile file {"var x = 6; x * 7"};
+  int fd {open(file.path.c_str(), O_RDONLY)};
+  MappedStringResource* resource {MappedStringResource::New(fd)};
+  close(fd);
+  V8MONKEY_CHECK(resource, "Descriptor mapped");
+
+  ScriptSource source {resource, ScriptSource::kLatin1};
+  std::unique_ptr<ScriptWrapper> script {ScriptWrapper::Compile(c.cx, source)};
+  V8MONKEY_CHECK(runsToAnswer(c.cx, script.get()), "Script ran correctly");
+
+  V8MONKEY_CHECK(!MappedStringResource::New((file.directory + "/missing.js").c_str()), "Missing file reported");
+  V8MONKEY_CHECK(!MappedStringResource::New(-1), "Bad descriptor reported");
+}
+
+
+V8MONKEY_TEST(IntScriptWrapper022, "Mapped sources produce and consume code caches") {
+  InCompartment c;
+  TempFile file {"var x = 6; x * 7"};
+  std::unique_ptr<ScriptSource> producer {mappedSource(file.path)};
+  std::unique_ptr<ScriptWrapper> script {ScriptWrapper::Compile(c.cx, *producer, ScriptWrapper::kProduceCodeCache)};
+  const CachedData* produced {producer->GetCachedData()};
+  V8MONKEY_CHECK(runsToAnswer(c.cx, script.get()) && produced, "Cached data produced");
+
+  size_t length {static_cast<size_t>(produced->length)};
+  uint8_t* copy {new uint8_t[length]};
+  std::copy(produced->data, produced->data + produced->length, copy);
+  CachedData* cache {new CachedData(copy, produced->length, CachedData::BufferOwned)};
+  std::unique_ptr<ScriptSource> consumer {mappedSource(file.path, ScriptSource::kUTF8, cache)};
+  V8MONKEY_CHECK(consumer->Hash() == producer->Hash(), "Hashes of the same file agree");
+
+  script.reset(ScriptWrapper::Compile(c.cx, *consumer, ScriptWrapper::kConsumeCodeCache));
+  V8MONKEY_CHECK(!consumer->GetCachedData()->rejected && script->Statistics().decoded, "Cached data accepted");
+  V8MONKEY_CHECK(runsToAnswer(c.cx, script.get()), "Script ran correctly");
+}
+
+
+V8MONKEY_TEST(IntScriptWrapper023, "Mapped sources compile off-thread") {
+  InCompartment c;
+  std::string text {"var x = 42;\n"};
+  for (int i = 0; i < 20000; i++) {
+    text += "x = x + 0;\n";
+  }
+
+  TempFile file {text + "'\xe4\xb8\xad'.length == 1 ? x : 0"};
+  std::unique_ptr<ScriptSource> source {mappedSource(file.path)};
+  std::unique_ptr<CompileTask> task {CompileTask::Start(c.cx, *source)};
+  V8MONKEY_CHECK(task, "Task started");
+
+  std::unique_ptr<ScriptWrapper> script {task->Finish(c.cx)};
+  V8MONKEY_CHECK(runsToAnswer(c.cx, script.get()), "Script ran correctly");
+
+  // Unfinished tasks release their decoded copy too
+  task.reset(CompileTask::Start(c.cx, *source));
+  task.reset();
+}
+
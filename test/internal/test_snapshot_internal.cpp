@@ -0,0 +1,205 @@
+// ptrdiff_t
+#include <cstddef>
+
+// unique_ptr
+#include <memory>
+
+// string, u16string
+#include <string>
+
+// vector
+#include <vector>
+
+// Isolate StartupData V8::SetFatalErrorHandler V8::SetSnapshotDataBlob
+#include "v8.h"
+
+// JS_ClearPendingException, JS_IsExceptionPending, JS::RootedValue
+#include "jsapi.h"
+
+// The class under test
+#include "runtime/snapshot.h"
+
+// ScriptSource ScriptWrapper
+#include "types/script_wrapper.h"
+
+// NewGlobal
+#include "utils/SpiderMonkeyUtils.h"
+
+// InCompartment
+#include "SpiderMonkeyTestUtils.h"
+
+// Unit-testing support
+#include "V8MonkeyTest.h"
+
+
+using namespace v8::internal;
+using namespace v8::SpiderMonkey;
+using namespace v8::TestUtils;
+
+
+namespace {
+  // Evaluate the given expression in the current global, returning -1 if it does not yield an integer
+  int evaluate(JSContext* cx, const std::u16string& text) {
+    ScriptSource source {text.data(), text.size()};
+    std::unique_ptr<ScriptWrapper> script {ScriptWrapper::Compile(cx, source)};
+    JS::RootedValue value(cx);
+    return script && script->Run(cx, &value) && value.isInt32() ? value.toInt32() : -1;
+  }
+
+
+  const std::vector<Snapshot::BootstrapScript> bootstrap {
+    {"first.js", u"var base = 40; function add(a, b) { return a + b; }"},
+    {"second.js", u"var answer = add(base, 2);"}
+  };
+
+
+  std::vector<uint8_t> createBlob(JSContext* cx, const std::vector<Snapshot::BootstrapScript>& scripts) {
+    std::vector<uint8_t> blob;
+    Snapshot::Create(cx, scripts, blob);
+    return blob;
+  }
+
+
+  Snapshot* fromBlob(const std::vector<uint8_t>& blob) {
+    return Snapshot::FromBlob(reinterpret_cast<const char*>(blob.data()), blob.size());
+  }
+}
+
+
+V8MONKEY_TEST(IntSnapshot001, "Applying a snapshot recreates the bootstrap state in a new global") {
+  InCompartment c;
+  std::vector<uint8_t> blob {createBlob(c.cx, bootstrap)};
+  std::unique_ptr<Snapshot> snapshot {fromBlob(blob)};
+  V8MONKEY_CHECK(snapshot && snapshot->ScriptCount() == 2, "Snapshot parsed");
+
+  for (int i = 0; i < 3; i++) {
+    JS::RootedObject other(c.cx, NewGlobal(c.cx));
+    JSAutoCompartment ac(c.cx, other);
+    V8MONKEY_CHECK(evaluate(c.cx, u"typeof answer == 'undefined' ? 0 : 1") == 0, "Global starts empty");
+    V8MONKEY_CHECK(snapshot->Apply(c.cx), "Snapshot applied");
+    V8MONKEY_CHECK(evaluate(c.cx, u"answer") == 42, "Bootstrap variables defined");
+    V8MONKEY_CHECK(evaluate(c.cx, u"add(answer, 1)") == 43, "Bootstrap functions defined");
+  }
+}
+
+
+V8MONKEY_TEST(IntSnapshot002, "Empty snapshots are valid") {
+  InCompartment c;
+  std::vector<uint8_t> blob {createBlob(c.cx, {})};
+  std::unique_ptr<Snapshot> snapshot {fromBlob(blob)};
+  V8MONKEY_CHECK(snapshot && snapshot->ScriptCount() == 0, "Snapshot parsed");
+  V8MONKEY_CHECK(snapshot->Apply(c.cx), "Snapshot applied");
+}
+
+
+V8MONKEY_TEST(IntSnapshot003, "Malformed blobs are rejected") {
+  InCompartment c;
+  std::vector<uint8_t> blob {createBlob(c.cx, bootstrap)};
+
+  for (size_t length = 0; length < blob.size(); length++) {
+    std::vector<uint8_t> truncated {blob.begin(), blob.begin() + static_cast<std::ptrdiff_t>(length)};
+    std::unique_ptr<Snapshot> snapshot {fromBlob(truncated)};
+    V8MONKEY_CHECK(!snapshot, "Truncated blob rejected");
+  }
+
+  std::vector<uint8_t> extended {blob};
+  extended.push_back(0);
+  std::unique_ptr<Snapshot> snapshot {fromBlob(extended)};
+  V8MONKEY_CHECK(!snapshot, "Blob with trailing data rejected");
+
+  // The version string follows the magic number and its length
+  std::vector<uint8_t> otherVersion {blob};
+  otherVersion[8] ^= 0xff;
+  snapshot.reset(fromBlob(otherVersion));
+  V8MONKEY_CHECK(!snapshot, "Blob from another version rejected");
+
+  std::vector<uint8_t> badMagic {blob};
+  badMagic[0] ^= 0xff;
+  snapshot.reset(fromBlob(badMagic));
+  V8MONKEY_CHECK(!snapshot, "Blob with bad magic rejected");
+}
+
+
+V8MONKEY_TEST(IntSnapshot004, "Failing bootstrap scripts are reported") {
+  InCompartment c;
+  std::vector<uint8_t> blob;
+
+  const std::vector<Snapshot::BootstrapScript> syntaxError {{"bad.js", u"var = ;"}};
+  V8MONKEY_CHECK(!Snapshot::Create(c.cx, syntaxError, blob), "Compile error reported");
+  V8MONKEY_CHECK(JS_IsExceptionPending(c.cx), "Exception pending");
+  JS_ClearPendingException(c.cx);
+
+  const std::vector<Snapshot::BootstrapScript> throws {{"throws.js", u"throw 1;"}};
+  V8MONKEY_CHECK(!Snapshot::Create(c.cx, throws, blob), "Exception reported");
+  V8MONKEY_CHECK(JS_IsExceptionPending(c.cx), "Exception pending");
+  JS_ClearPendingException(c.cx);
+}
+
+
+V8MONKEY_TEST(IntSnapshot005, "SetSnapshotDataBlob registers the current snapshot") {
+  InCompartment c;
+  std::vector<uint8_t> blob {createBlob(c.cx, bootstrap)};
+  v8::StartupData data {reinterpret_cast<const char*>(blob.data()), static_cast<int>(blob.size()),
+                        static_cast<int>(blob.size())};
+
+  V8MONKEY_CHECK(!Snapshot::Current(), "No snapshot registered initially");
+  v8::V8::SetSnapshotDataBlob(&data);
+  V8MONKEY_CHECK(Snapshot::Current() && Snapshot::Current()->ScriptCount() == 2, "Snapshot registered");
+
+  v8::V8::SetSnapshotDataBlob(nullptr);
+  V8MONKEY_CHECK(!Snapshot::Current(), "Snapshot unregistered");
+}
+
+
+V8MONKEY_TEST(IntSnapshot006, "New globals have the registered snapshot applied") {
+  InCompartment c;
+  std::vector<uint8_t> blob {createBlob(c.cx, bootstrap)};
+  v8::StartupData data {reinterpret_cast<const char*>(blob.data()), static_cast<int>(blob.size()),
+                        static_cast<int>(blob.size())};
+
+  JS::RootedObject plain(c.cx, NewGlobal(c.cx));
+  V8MONKEY_CHECK(plain, "Global created");
+  {
+    JSAutoCompartment ac(c.cx, plain);
+    V8MONKEY_CHECK(evaluate(c.cx, u"typeof answer == 'undefined' ? 0 : 1") == 0, "No snapshot applied");
+  }
+
+  v8::V8::SetSnapshotDataBlob(&data);
+  JS::RootedObject bootstrapped(c.cx, NewGlobal(c.cx));
+  V8MONKEY_CHECK(bootstrapped, "Global created");
+  JSAutoCompartment ac(c.cx, bootstrapped);
+  V8MONKEY_CHECK(evaluate(c.cx, u"answer") == 42, "Snapshot applied");
+}
+
+
+namespace {
+  bool fatalErrorCalled {false};
+
+
+  void fatalErrorHandler(const char*, const char*) {
+    fatalErrorCalled = true;
+  }
+}
+
+
+V8MONKEY_TEST(IntSnapshot007, "The snapshot cannot be replaced once an isolate exists") {
+  v8::TestUtils::AutoTestCleanup ac {};
+  std::vector<uint8_t> blob;
+  {
+    InCompartment c;
+    blob = createBlob(c.cx, bootstrap);
+  }
+
+  v8::StartupData data {reinterpret_cast<const char*>(blob.data()), static_cast<int>(blob.size()),
+                        static_cast<int>(blob.size())};
+  v8::V8::SetSnapshotDataBlob(&data);
+  const Snapshot* registered {Snapshot::Current()};
+
+  v8::Isolate* i {v8::Isolate::New()};
+  i->Enter();
+  v8::V8::SetFatalErrorHandler(fatalErrorHandler);
+
+  v8::V8::SetSnapshotDataBlob(nullptr);
+  V8MONKEY_CHECK(fatalErrorCalled, "Replacement refused");
+  V8MONKEY_CHECK(Snapshot::Current() == registered && registered->ScriptCount() == 2, "Snapshot unchanged");
+}
@@ -1,6 +1,15 @@
+// memcmp, strlen
+#include <cstring>
+
+// JS::ToNumber
+#include "jsapi.h"
+
 // The class under test
 #include "utils/SpiderMonkeyUtils.h"
 
+// StringToDouble
+#include "utils/StringToNumber.h"
+
 // Unit-testing support
 #include "V8MonkeyTest.h"
 
@@ -8,6 +17,18 @@
 using namespace v8::SpiderMonkey;
 
 
+namespace {
+  // Strings exercising both the fast path, and each of the reasons for declining it
+  const char* numericStrings[] {
+    "", "0", "-0", "+0", "1", "-1", "007", "123456789", "2147483648", "9007199254740993", "1844674407370955161",
+    "0.5", ".5", "5.", "-.5", "0.1", "3.14159", "1e3", "1E-3", "-1.5e-7", "1.7976931348623157e108", "0e500",
+    "0.000000000000000000000000000001", "4503599627370497.5", "12345678901234567890", "1e400", "1e-400",
+    " 1", "1 ", "\t1\n", "0x10", "0o7", "0b1", "Infinity", "-Infinity", "NaN", "abc", "1a", ".", "+", "e5", "1e",
+    "1..2", "--1", "1,000", "\xa0" "1"
+  };
+}
+
+
 V8MONKEY_TEST(IntSMUtils001, "JSRuntime initially null") {
   JSRuntime* rt {GetJSRuntimeForThread()};
   V8MONKEY_CHECK(!rt, "Runtime initially null");
@@ -36,3 +57,36 @@ V8MONKEY_TEST(IntSMUtils004, "JSContext non-null after assignment") {
   cx = GetJSContextForThread();
   V8MONKEY_CHECK(cx, "Context not null");
 }
+
+
+V8MONKEY_TEST(IntSMUtils005, "StringToNumber agrees with SpiderMonkey") {
+  EnsureRuntimeAndContext();
+  JSContext* cx {GetJSContextForThread()};
+
+  JSAutoRequest ar(cx);
+  JS::RootedObject global(cx, NewGlobal(cx));
+  V8MONKEY_CHECK(global, "Global created");
+  JSAutoCompartment ac(cx, global);
+
+  for (const char* s : numericStrings) {
+    JS::RootedString str(cx, JS_NewStringCopyN(cx, s, std::strlen(s)));
+    V8MONKEY_CHECK(str, "String created");
+
+    double expected;
+    JS::RootedValue value(cx, JS::StringValue(str));
+    V8MONKEY_CHECK(JS::ToNumber(cx, value, &expected), "SpiderMonkey conversion succeeded");
+
+    double result;
+    V8MONKEY_CHECK(StringToNumber(cx, str, &result), "Conversion succeeded");
+
+    // Compare bit patterns, to distinguish 0 and -0, and so that NaN compares equal to itself
+    V8MONKEY_CHECK(std::memcmp(&result, &expected, sizeof(result)) == 0 || (result != result && expected != expected),
+                   "Result matches SpiderMonkey");
+
+    // Whenever the fast path claims a string, it must agree with SpiderMonkey
+    double fast;
+    if (v8::V8Monkey::Conversions::StringToDouble(s, std::strlen(s), &fast)) {
+      V8MONKEY_CHECK(std::memcmp(&fast, &expected, sizeof(fast)) == 0, "Fast path matches SpiderMonkey");
+    }
+  }
+}
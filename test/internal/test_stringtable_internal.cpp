@@ -0,0 +1,153 @@
+// string, to_string
+#include <string>
+
+// vector
+#include <vector>
+
+// JS_InternStringN, JS_InternUCStringN, JS_StringEqualsAscii
+#include "jsapi.h"
+
+// Isolate
+#include "runtime/isolate.h"
+
+// Thread
+#include "platform/platform.h"
+
+// The class under test
+#include "types/string_table.h"
+
+// InCompartment
+#include "SpiderMonkeyTestUtils.h"
+
+// Unit-testing support
+#include "V8MonkeyTest.h"
+
+
+using namespace v8::internal;
+using namespace v8::TestUtils;
+using namespace v8::V8Platform;
+
+
+namespace {
+  bool equalsAscii(JSContext* cx, JSString* s, const char* expected) {
+    bool match {false};
+    return JS_StringEqualsAscii(cx, s, expected, &match) && match;
+  }
+
+
+  // Intern a string through the given table from a new thread, which has its own runtime. Returns the table if the
+  // result was the runtime's own atom, and nullptr otherwise.
+  extern "C"
+  void* internOnThread(void* arg) {
+    InternedStringTable* table {reinterpret_cast<InternedStringTable*>(arg)};
+    InCompartment c;
+
+    JSString* atom {table->Intern(c.cx, "length", 6)};
+    bool correct {atom && atom == JS_InternStringN(c.cx, "length", 6) && equalsAscii(c.cx, atom, "length")};
+    return correct ? arg : nullptr;
+  }
+}
+
+
+V8MONKEY_TEST(IntStringTable001, "Repeated internalization returns the same atom") {
+  InCompartment c;
+  InternedStringTable table;
+
+  JSString* first {table.Intern(c.cx, "length", 6)};
+  V8MONKEY_CHECK(first, "Atom created");
+  V8MONKEY_CHECK(equalsAscii(c.cx, first, "length"), "Contents correct");
+  V8MONKEY_CHECK(table.Intern(c.cx, "length", 6) == first, "Same atom returned");
+  V8MONKEY_CHECK(table.Size() == 1, "Only one entry");
+}
+
+
+V8MONKEY_TEST(IntStringTable002, "Atoms match SpiderMonkey's own") {
+  InCompartment c;
+  InternedStringTable table;
+
+  V8MONKEY_CHECK(table.Intern(c.cx, "prototype", 9) == JS_InternStringN(c.cx, "prototype", 9), "ASCII atom correct");
+
+  const char16_t expected[] {u'c', 0xe9, 0x20ac};
+  V8MONKEY_CHECK(table.Intern(c.cx, "c\xc3\xa9\xe2\x82\xac", 6) == JS_InternUCStringN(c.cx, expected, 3),
+                 "Non-ASCII atom correct");
+  V8MONKEY_CHECK(table.Intern(c.cx, "", 0) == JS_InternStringN(c.cx, "", 0), "Empty atom correct");
+}
+
+
+V8MONKEY_TEST(IntStringTable003, "Distinct strings are distinct entries") {
+  InCompartment c;
+  InternedStringTable table;
+
+  std::vector<std::string> names;
+  std::vector<JSString*> atoms;
+  for (int i = 0; i < 1000; i++) {
+    names.push_back("property" + std::to_string(i));
+    atoms.push_back(table.Intern(c.cx, names.back().data(), names.back().size()));
+  }
+
+  V8MONKEY_CHECK(table.Size() == 1000, "All strings entered");
+
+  bool correct {true};
+  for (size_t i = 0; i < names.size(); i++) {
+    correct = correct && table.Intern(c.cx, names[i].data(), names[i].size()) == atoms[i];
+    correct = correct && equalsAscii(c.cx, atoms[i], names[i].c_str());
+  }
+
+  V8MONKEY_CHECK(correct, "Atoms correct after growth");
+  V8MONKEY_CHECK(table.Size() == 1000, "No further entries");
+}
+
+
+V8MONKEY_TEST(IntStringTable004, "Long strings bypass the table") {
+  InCompartment c;
+  InternedStringTable table;
+
+  std::string name(1000, 'a');
+  JSString* atom {table.Intern(c.cx, name.data(), name.size())};
+  V8MONKEY_CHECK(atom, "Atom created");
+  V8MONKEY_CHECK(table.Size() == 0, "Table empty");
+  V8MONKEY_CHECK(table.Intern(c.cx, name.data(), name.size()) == atom, "Same atom returned");
+}
+
+
+V8MONKEY_TEST(IntStringTable005, "Trimming empties the table, but preserves the atoms") {
+  InCompartment c;
+  InternedStringTable table;
+
+  JSString* atom {table.Intern(c.cx, "length", 6)};
+  table.Intern(c.cx, "name", 4);
+  table.Trim();
+  V8MONKEY_CHECK(table.Size() == 0, "Table empty");
+
+  JS_GC(JS_GetRuntime(c.cx));
+  V8MONKEY_CHECK(table.Intern(c.cx, "length", 6) == atom, "Same atom returned");
+}
+
+
+V8MONKEY_TEST(IntStringTable006, "Low memory notifications trim the isolate's table") {
+  InCompartment c;
+  Isolate* isolate {new Isolate};
+
+  isolate->GetInternedStrings().Intern(c.cx, "length", 6);
+  V8MONKEY_CHECK(isolate->GetInternedStrings().Size() == 1, "String entered");
+
+  isolate->LowMemoryNotification();
+  V8MONKEY_CHECK(isolate->GetInternedStrings().Size() == 0, "Table trimmed");
+
+  isolate->Dispose();
+}
+
+
+V8MONKEY_TEST(IntStringTable007, "Table forgets atoms once the runtime that filled it is torn down") {
+  InternedStringTable table;
+
+  // Each thread's runtime is destroyed when it exits, so the second may well be allocated at the same address
+  Thread first {internOnThread};
+  first.Run(&table);
+  V8MONKEY_CHECK(first.Join() == &table, "First thread's atom correct");
+
+  Thread second {internOnThread};
+  second.Run(&table);
+  V8MONKEY_CHECK(second.Join() == &table, "Second thread's atom correct");
+  V8MONKEY_CHECK(table.Size() == 1, "Table refilled from the second runtime");
+}
@@ -0,0 +1,234 @@
+// std::numeric_limits
+#include <limits>
+
+// std::mt19937_64
+#include <random>
+
+// snprintf
+#include <cstdio>
+
+// strtod
+#include <cstdlib>
+
+// memcmp, strlen
+#include <cstring>
+
+// string
+#include <string>
+
+// The function under test
+#include "utils/StringToNumber.h"
+
+// Int type definitions
+#include "v8stdint.h"
+
+// Unit-testing support
+#include "V8MonkeyTest.h"
+
+
+using namespace v8::V8Monkey::Conversions;
+
+
+namespace {
+  bool sameDouble(double a, double b) {
+    // Distinguishes 0 and -0
+    return std::memcmp(&a, &b, sizeof(a)) == 0;
+  }
+
+
+  bool parse(const std::string& s, double* result) {
+    return StringToDouble(s.data(), s.length(), result);
+  }
+
+
+  // Check the fast path agrees with strtod, which for decimal literals is correctly rounded, as is ECMAScript
+  void checkAgainstStrtod(const std::string& s) {
+    double result;
+    if (!parse(s, &result)) {
+      return;
+    }
+
+    V8MONKEY_CHECK(sameDouble(result, std::strtod(s.c_str(), nullptr)), "Fast path agrees with strtod");
+  }
+
+
+  // Decimal literals, in the various shapes in which they appear in query strings and headers
+  std::string randomLiteral(std::mt19937_64& generator) {
+    std::string result;
+
+    switch (generator() % 4) {
+      case 0:
+        result += '-';
+        break;
+
+      case 1:
+        result += '+';
+        break;
+
+      default:
+        break;
+    }
+
+    size_t intDigits {static_cast<size_t>(generator() % 20)};
+    for (size_t i = 0; i < intDigits; i++) {
+      result += static_cast<char>('0' + generator() % 10);
+    }
+
+    size_t fractionDigits {static_cast<size_t>(generator() % 20)};
+    if (intDigits == 0 && fractionDigits == 0) {
+      fractionDigits = 1;
+    }
+
+    if (fractionDigits > 0 || generator() % 2) {
+      result += '.';
+      for (size_t i = 0; i < fractionDigits; i++) {
+        result += static_cast<char>('0' + generator() % 10);
+      }
+    }
+
+    if (generator() % 2) {
+      result += generator() % 2 ? 'e' : 'E';
+      char buffer[8];
+      std::snprintf(buffer, sizeof(buffer), "%d", static_cast<int>(generator() % 301) - 150);
+      result += buffer;
+    }
+
+    return result;
+  }
+}
+
+
+V8MONKEY_TEST(IntStringToNumber001, "Empty string converts to zero") {
+  double result {1.0};
+  V8MONKEY_CHECK(StringToDouble("", 0, &result), "Fast path handled empty string");
+  V8MONKEY_CHECK(sameDouble(result, 0.0), "Result correct");
+}
+
+
+V8MONKEY_TEST(IntStringToNumber002, "Integers convert correctly") {
+  const struct {
+    const char* input;
+    double expected;
+  } cases[] {
+    {"0", 0.0},
+    {"-0", -0.0},
+    {"+0", 0.0},
+    {"1", 1.0},
+    {"-1", -1.0},
+    {"007", 7.0},
+    {"12345678", 12345678.0},
+    {"123456789", 123456789.0},
+    {"2147483647", 2147483647.0},
+    {"-2147483648", -2147483648.0},
+    {"4294967296", 4294967296.0},
+    {"1234567812345678", 1234567812345678.0},
+    {"9007199254740993", 9007199254740992.0},
+    {"1844674407370955161", 1844674407370955161.0},
+    {"0000000000000000000000000000001", 1.0}
+  };
+
+  for (const auto& c : cases) {
+    double result;
+    V8MONKEY_CHECK(StringToDouble(c.input, std::strlen(c.input), &result), "Fast path handled integer");
+    V8MONKEY_CHECK(sameDouble(result, c.expected), "Result correct");
+  }
+}
+
+
+V8MONKEY_TEST(IntStringToNumber003, "Decimals convert correctly") {
+  const struct {
+    const char* input;
+    double expected;
+  } cases[] {
+    {"0.5", 0.5},
+    {".5", 0.5},
+    {"5.", 5.0},
+    {"-.5", -0.5},
+    {"0.1", 0.1},
+    {"0.3", 0.3},
+    {"3.14159", 3.14159},
+    {"1e3", 1000.0},
+    {"1E3", 1000.0},
+    {"1e+3", 1000.0},
+    {"1e-3", 0.001},
+    {"-1.5e-7", -1.5e-7},
+    {"2.2250738585072014e-100", 2.2250738585072014e-100},
+    {"1.7976931348623157e108", 1.7976931348623157e108},
+    {"9007199254740993.0", 9007199254740992.0},
+    {"9007199254740995", 9007199254740996.0},
+    {"0.000000000000000000000000000001", 1e-30},
+    {"0e500", 0.0},
+    {"-0.0e-500", -0.0}
+  };
+
+  for (const auto& c : cases) {
+    double result;
+    V8MONKEY_CHECK(StringToDouble(c.input, std::strlen(c.input), &result), "Fast path handled decimal");
+    V8MONKEY_CHECK(sameDouble(result, c.expected), "Result correct");
+  }
+}
+
+
+V8MONKEY_TEST(IntStringToNumber004, "Unusual inputs are left to SpiderMonkey") {
+  const char* cases[] {
+    " 1", "1 ", "\t1", "1\n", "0x10", "0X10", "0o7", "0b1", "Infinity", "-Infinity", "NaN", "abc", "1a", ".", "+", "-",
+    "e5", "1e", "1e+", "1..2", "1.2.3", "--1", "+-1", "1e400", "1e-400", "12345678901234567890", "1,000", "\xa0" "1"
+  };
+
+  for (const char* c : cases) {
+    double result {42.0};
+    V8MONKEY_CHECK(!StringToDouble(c, std::strlen(c), &result), "Fast path declined");
+    V8MONKEY_CHECK(result == 42.0, "Result unchanged");
+  }
+}
+
+
+V8MONKEY_TEST(IntStringToNumber005, "Length is respected") {
+  double result;
+  V8MONKEY_CHECK(StringToDouble("12345678901", 9, &result), "Fast path handled prefix");
+  V8MONKEY_CHECK(result == 123456789.0, "Only the given length was parsed");
+}
+
+
+V8MONKEY_TEST(IntStringToNumber006, "Round-tripped doubles convert correctly") {
+  std::mt19937_64 generator {0xfeed};
+
+  for (int i = 0; i < 100000; i++) {
+    uint64_t bits {generator()};
+    double d;
+    std::memcpy(&d, &bits, sizeof(d));
+    if (d != d || d == std::numeric_limits<double>::infinity() || d == -std::numeric_limits<double>::infinity()) {
+      continue;
+    }
+
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.17g", d);
+
+    double result;
+    if (StringToDouble(buffer, std::strlen(buffer), &result)) {
+      V8MONKEY_CHECK(sameDouble(result, d), "Value round-trips");
+    }
+  }
+}
+
+
+V8MONKEY_TEST(IntStringToNumber007, "Random literals agree with strtod") {
+  std::mt19937_64 generator {0xbeef};
+
+  for (int i = 0; i < 200000; i++) {
+    checkAgainstStrtod(randomLiteral(generator));
+  }
+}
+
+
+V8MONKEY_TEST(IntStringToNumber008, "Halfway cases round to even") {
+  // 2^53 + 1 and 2^53 + 3 are exactly halfway between adjacent doubles
+  checkAgainstStrtod("9007199254740993");
+  checkAgainstStrtod("9007199254740995");
+  checkAgainstStrtod("9007199254740993e3");
+  checkAgainstStrtod("900719925474099.3e1");
+  checkAgainstStrtod("1.00000000000000011102230246251565404e0");
+  checkAgainstStrtod("4503599627370496.5");
+  checkAgainstStrtod("4503599627370497.5");
+  checkAgainstStrtod("2.47032822920623272e-100");
+}
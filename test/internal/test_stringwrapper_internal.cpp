@@ -0,0 +1,624 @@
+// memcmp, memset, strcmp, strlen
+#include <cstring>
+
+// unique_ptr
+#include <memory>
+
+// string, u16string
+#include <string>
+
+// JS_FlattenString JS_GC JS_GetFlatStringCharAt JS_GetStringLength JS_InternStringN JSID_IS_INT JSID_IS_STRING
+// JSID_TO_INT JSID_TO_STRING
+#include "jsapi.h"
+
+// Isolate
+#include "runtime/isolate.h"
+
+// InternedStringTable
+#include "types/string_table.h"
+
+// The class under test
+#include "types/string_wrapper.h"
+
+// InCompartment
+#include "SpiderMonkeyTestUtils.h"
+
+// Unit-testing support
+#include "V8MonkeyTest.h"
+
+
+using namespace v8::internal;
+using namespace v8::TestUtils;
+
+
+namespace {
+  int disposeCount {0};
+
+
+  class TwoByteResource : public ExternalStringResource {
+    public:
+      TwoByteResource(const char16_t* s, size_t len) : chars {reinterpret_cast<const uint16_t*>(s)}, size {len} {}
+
+      const uint16_t* data() const override { return chars; }
+      size_t length() const override { return size; }
+
+    protected:
+      void Dispose() override {
+        disposeCount++;
+        delete this;
+      }
+
+    private:
+      const uint16_t* chars;
+      size_t size;
+  };
+
+
+  class OneByteResource : public ExternalAsciiStringResource {
+    public:
+      explicit OneByteResource(const char* s) : chars {s} {}
+
+      const char* data() const override { return chars; }
+      size_t length() const override { return std::strlen(chars); }
+
+    protected:
+      void Dispose() override {
+        disposeCount++;
+        delete this;
+      }
+
+    private:
+      const char* chars;
+  };
+
+
+  class CountingVisitor : public ExternalResourceVisitor {
+    public:
+      explicit CountingVisitor(ExternalStringResource* r) : resource {r} {}
+
+      void VisitExternalString(ExternalStringResource* r) override {
+        if (r == resource) {
+          seen++;
+        }
+      }
+
+      ExternalStringResource* resource;
+      int seen {0};
+  };
+
+
+  // Compare the contents of str against the given UTF-16 code units
+  bool hasContents(JSContext* cx, JSString* str, const char16_t* expected, size_t length) {
+    JS::RootedString rooted(cx, str);
+    JSFlatString* flat {JS_FlattenString(cx, rooted)};
+    if (!flat || JS_GetStringLength(rooted) != length) {
+      return false;
+    }
+
+    for (size_t i = 0; i < length; i++) {
+      if (JS_GetFlatStringCharAt(flat, i) != expected[i]) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+}
+
+
+V8MONKEY_TEST(IntStringWrapper001, "ASCII UTF-8 creates a one-byte string") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+
+  std::unique_ptr<StringWrapper> s {StringWrapper::NewFromUtf8(cx, "hello")};
+  V8MONKEY_CHECK(s, "String created");
+  V8MONKEY_CHECK(s->IsOneByte(), "String is one-byte");
+  V8MONKEY_CHECK(s->Length() == 5, "Length correct");
+  V8MONKEY_CHECK(hasContents(cx, s->Get(), u"hello", 5), "Contents correct");
+}
+
+
+V8MONKEY_TEST(IntStringWrapper002, "Latin1 representable UTF-8 creates a one-byte string") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+
+  std::unique_ptr<StringWrapper> s {StringWrapper::NewFromUtf8(cx, "caf\xc3\xa9")};
+  V8MONKEY_CHECK(s, "String created");
+  V8MONKEY_CHECK(s->IsOneByte(), "String is one-byte");
+  V8MONKEY_CHECK(hasContents(cx, s->Get(), u"caf\u00e9", 4), "Contents correct");
+}
+
+
+V8MONKEY_TEST(IntStringWrapper003, "Non-Latin1 UTF-8 creates a two-byte string") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+
+  std::unique_ptr<StringWrapper> s {StringWrapper::NewFromUtf8(cx, "caf\xc3\xa9 \xe2\x82\xac")};
+  V8MONKEY_CHECK(s, "String created");
+  V8MONKEY_CHECK(!s->IsOneByte(), "String is two-byte");
+  V8MONKEY_CHECK(hasContents(cx, s->Get(), u"caf\u00e9 \u20ac", 6), "Contents correct");
+}
+
+
+V8MONKEY_TEST(IntStringWrapper004, "Explicit lengths are respected, including embedded nulls") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+
+  std::unique_ptr<StringWrapper> s {StringWrapper::NewFromUtf8(cx, "a\0bc", 3)};
+  V8MONKEY_CHECK(s, "String created");
+  V8MONKEY_CHECK(hasContents(cx, s->Get(), u"a\0b", 3), "Contents correct");
+}
+
+
+V8MONKEY_TEST(IntStringWrapper005, "One-byte data creates a one-byte string") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+
+  const uint8_t data[] {'a', 0xe9u, 0xffu, 0};
+  std::unique_ptr<StringWrapper> s {StringWrapper::NewFromOneByte(cx, data)};
+  V8MONKEY_CHECK(s, "String created");
+  V8MONKEY_CHECK(s->IsOneByte(), "String is one-byte");
+  V8MONKEY_CHECK(hasContents(cx, s->Get(), u"a\u00e9\u00ff", 3), "Contents correct");
+}
+
+
+V8MONKEY_TEST(IntStringWrapper006, "Two-byte data is narrowed when possible") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+
+  const uint16_t narrow[] {'a', 0xe9u, 0};
+  std::unique_ptr<StringWrapper> n {StringWrapper::NewFromTwoByte(cx, narrow)};
+  V8MONKEY_CHECK(n && n->IsOneByte(), "String is one-byte");
+
+  const uint16_t wide[] {'a', 0x20acu, 0};
+  std::unique_ptr<StringWrapper> w {StringWrapper::NewFromTwoByte(cx, wide)};
+  V8MONKEY_CHECK(w && !w->IsOneByte(), "String is two-byte");
+  V8MONKEY_CHECK(hasContents(cx, w->Get(), u"a\u20ac", 2), "Contents correct");
+}
+
+
+V8MONKEY_TEST(IntStringWrapper007, "WriteOneByte copies and terminates") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+
+  std::unique_ptr<StringWrapper> s {StringWrapper::NewFromUtf8(cx, "hello")};
+  uint8_t buffer[8];
+  std::memset(buffer, 0xff, sizeof(buffer));
+
+  V8MONKEY_CHECK(s->WriteOneByte(cx, buffer) == 5, "Correct number of chars written");
+  V8MONKEY_CHECK(std::memcmp(buffer, "hello", 6) == 0, "Contents and terminator written");
+
+  std::memset(buffer, 0xff, sizeof(buffer));
+  V8MONKEY_CHECK(s->WriteOneByte(cx, buffer, 1, 3) == 3, "Correct number of chars written");
+  V8MONKEY_CHECK(std::memcmp(buffer, "ell", 3) == 0 && buffer[3] == 0xffu, "No terminator when buffer is filled");
+
+  std::memset(buffer, 0xff, sizeof(buffer));
+  V8MONKEY_CHECK(s->WriteOneByte(cx, buffer, 3, 10, StringWrapper::NO_NULL_TERMINATION) == 2,
+                 "Write clamped to string length");
+  V8MONKEY_CHECK(std::memcmp(buffer, "lo", 2) == 0 && buffer[2] == 0xffu, "No terminator when requested");
+}
+
+
+V8MONKEY_TEST(IntStringWrapper008, "WriteOneByte truncates two-byte strings") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+
+  std::unique_ptr<StringWrapper> s {StringWrapper::NewFromUtf8(cx, "a\xe2\x82\xac")};
+  uint8_t buffer[3];
+  V8MONKEY_CHECK(s->WriteOneByte(cx, buffer) == 2, "Correct number of chars written");
+  V8MONKEY_CHECK(buffer[0] == 'a' && buffer[1] == 0xacu && buffer[2] == 0, "Chars truncated");
+}
+
+
+V8MONKEY_TEST(IntStringWrapper009, "Two-byte external strings use the resource") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+
+  TwoByteResource* resource {new TwoByteResource(u"external", 8)};
+  std::unique_ptr<StringWrapper> s {StringWrapper::NewExternal(cx, resource)};
+  V8MONKEY_CHECK(s, "String created");
+  V8MONKEY_CHECK(s->IsExternal(), "String is external");
+  V8MONKEY_CHECK(s->GetExternalStringResource() == resource, "Resource correct");
+  V8MONKEY_CHECK(hasContents(cx, s->Get(), u"external", 8), "Contents correct");
+}
+
+
+V8MONKEY_TEST(IntStringWrapper010, "External resources are visited, and disposed on finalization") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+
+  // Ensure strings from earlier tests are not finalized during this one
+  JS_GC(JS_GetRuntime(cx));
+  disposeCount = 0;
+
+  TwoByteResource* resource {new TwoByteResource(u"external", 8)};
+  std::unique_ptr<StringWrapper> s {StringWrapper::NewExternal(cx, resource)};
+
+  CountingVisitor before {resource};
+  StringWrapper::VisitExternalResources(&before);
+  V8MONKEY_CHECK(before.seen == 1, "Resource visited");
+
+  // Nothing roots the string once the wrapper is gone
+  s.reset();
+  JS_GC(JS_GetRuntime(cx));
+  V8MONKEY_CHECK(disposeCount == 1, "Resource disposed");
+
+  CountingVisitor after {resource};
+  StringWrapper::VisitExternalResources(&after);
+  V8MONKEY_CHECK(after.seen == 0, "Disposed resource not visited");
+}
+
+
+V8MONKEY_TEST(IntStringWrapper011, "One-byte external resources are copied to Latin1 strings") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+
+  // Ensure strings from earlier tests are not finalized during this one
+  JS_GC(JS_GetRuntime(cx));
+  disposeCount = 0;
+
+  std::unique_ptr<StringWrapper> s {StringWrapper::NewExternal(cx, new OneByteResource("external"))};
+  V8MONKEY_CHECK(s, "String created");
+  V8MONKEY_CHECK(s->IsOneByte(), "String is one-byte");
+  V8MONKEY_CHECK(!s->IsExternal(), "String is not external");
+  V8MONKEY_CHECK(disposeCount == 1, "Resource disposed");
+  V8MONKEY_CHECK(hasContents(cx, s->Get(), u"external", 8), "Contents correct");
+}
+
+
+V8MONKEY_TEST(IntStringWrapper012, "MakeExternal repoints the wrapper") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+
+  std::unique_ptr<StringWrapper> s {StringWrapper::NewFromUtf8(cx, "external")};
+  V8MONKEY_CHECK(!s->IsExternal(), "String not initially external");
+
+  OneByteResource oneByte {"external"};
+  V8MONKEY_CHECK(!s->MakeExternal(cx, &oneByte), "One-byte resource declined");
+
+  TwoByteResource* resource {new TwoByteResource(u"external", 8)};
+  V8MONKEY_CHECK(s->MakeExternal(cx, resource), "String made external");
+  V8MONKEY_CHECK(s->GetExternalStringResource() == resource, "Resource correct");
+  V8MONKEY_CHECK(hasContents(cx, s->Get(), u"external", 8), "Contents correct");
+
+  TwoByteResource other {u"external", 8};
+  V8MONKEY_CHECK(!s->MakeExternal(cx, &other), "External string cannot be made external again");
+}
+
+
+V8MONKEY_TEST(IntStringWrapper013, "Write copies and widens") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+
+  std::unique_ptr<StringWrapper> s {StringWrapper::NewFromUtf8(cx, "abc\xc3\xa9")};
+  uint16_t buffer[6] {0xffff, 0xffff, 0xffff, 0xffff, 0xffff, 0xffff};
+  V8MONKEY_CHECK(s->Write(cx, buffer) == 4, "Correct number of characters written");
+  const uint16_t expected[] {'a', 'b', 'c', 0xe9, 0, 0xffff};
+  V8MONKEY_CHECK(std::memcmp(buffer, expected, sizeof(expected)) == 0, "Buffer contents correct");
+
+  std::unique_ptr<StringWrapper> t {StringWrapper::NewFromUtf8(cx, "a\xe2\x82\xac" "b")};
+  uint16_t partial[3] {0xffff, 0xffff, 0xffff};
+  V8MONKEY_CHECK(t->Write(cx, partial, 1, 2) == 2, "Correct number of characters written");
+  const uint16_t expectedPartial[] {0x20ac, 'b', 0xffff};
+  V8MONKEY_CHECK(std::memcmp(partial, expectedPartial, sizeof(expectedPartial)) == 0, "No terminator written");
+}
+
+
+V8MONKEY_TEST(IntStringWrapper014, "Utf8Length is correct") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+
+  std::unique_ptr<StringWrapper> ascii {StringWrapper::NewFromUtf8(cx, "abc")};
+  V8MONKEY_CHECK(ascii->Utf8Length(cx) == 3, "ASCII length correct");
+
+  std::unique_ptr<StringWrapper> latin1 {StringWrapper::NewFromUtf8(cx, "\xc3\xa9t\xc3\xa9")};
+  V8MONKEY_CHECK(latin1->Utf8Length(cx) == 5, "Latin1 length correct");
+
+  const char16_t pair[] {u'a', 0xd83d, 0xde00, 0x20ac};
+  std::unique_ptr<StringWrapper> twoByte {
+    StringWrapper::NewFromTwoByte(cx, reinterpret_cast<const uint16_t*>(pair), 4)};
+  V8MONKEY_CHECK(twoByte->Utf8Length(cx) == 8, "Two-byte length correct");
+  V8MONKEY_CHECK(twoByte->Utf8Length(cx) == 8, "Cached length correct");
+}
+
+
+V8MONKEY_TEST(IntStringWrapper015, "WriteUtf8 writes whole characters and terminates") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+
+  std::unique_ptr<StringWrapper> s {StringWrapper::NewFromUtf8(cx, "a\xe2\x82\xac" "b")};
+  char buffer[8];
+  int nchars {-1};
+  std::memset(buffer, 'x', sizeof(buffer));
+  V8MONKEY_CHECK(s->WriteUtf8(cx, buffer, -1, &nchars) == 6, "Correct number of bytes written");
+  V8MONKEY_CHECK(nchars == 3, "Correct number of characters written");
+  V8MONKEY_CHECK(std::memcmp(buffer, "a\xe2\x82\xac" "b", 6) == 0, "Buffer contents correct");
+
+  std::memset(buffer, 'x', sizeof(buffer));
+  V8MONKEY_CHECK(s->WriteUtf8(cx, buffer, 3, &nchars) == 1, "Partial character not written");
+  V8MONKEY_CHECK(nchars == 1, "Correct number of characters written");
+  V8MONKEY_CHECK(buffer[1] == 'x', "No terminator written");
+
+  std::memset(buffer, 'x', sizeof(buffer));
+  V8MONKEY_CHECK(s->WriteUtf8(cx, buffer, 5, &nchars) == 5, "No room for terminator");
+  V8MONKEY_CHECK(nchars == 3, "Correct number of characters written");
+
+  std::memset(buffer, 'x', sizeof(buffer));
+  V8MONKEY_CHECK(s->WriteUtf8(cx, buffer, -1, nullptr, StringWrapper::NO_NULL_TERMINATION) == 5,
+                 "Correct number of bytes written");
+  V8MONKEY_CHECK(buffer[5] == 'x', "No terminator written");
+}
+
+
+V8MONKEY_TEST(IntStringWrapper016, "WriteUtf8 optionally replaces lone surrogates") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+
+  const char16_t lone[] {u'a', 0xd800};
+  std::unique_ptr<StringWrapper> s {StringWrapper::NewFromTwoByte(cx, reinterpret_cast<const uint16_t*>(lone), 2)};
+  char buffer[5];
+
+  V8MONKEY_CHECK(s->WriteUtf8(cx, buffer) == 5, "Correct number of bytes written");
+  V8MONKEY_CHECK(std::memcmp(buffer, "a\xed\xa0\x80", 5) == 0, "Surrogate encoded");
+
+  V8MONKEY_CHECK(s->WriteUtf8(cx, buffer, -1, nullptr, StringWrapper::REPLACE_INVALID_UTF8) == 5,
+                 "Correct number of bytes written");
+  V8MONKEY_CHECK(std::memcmp(buffer, "a\xef\xbf\xbd", 5) == 0, "Surrogate replaced");
+  V8MONKEY_CHECK(s->Utf8Length(cx) == 4, "Length correct");
+}
+
+
+V8MONKEY_TEST(IntStringWrapper017, "Short strings are copied into the view") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+
+  std::unique_ptr<StringWrapper> s {StringWrapper::NewFromUtf8(cx, "content-type")};
+  Utf8View utf8 {cx, *s};
+  V8MONKEY_CHECK(!utf8.IsDirect(), "UTF-8 view copied");
+  V8MONKEY_CHECK(utf8.length() == 12, "UTF-8 length correct");
+  V8MONKEY_CHECK(std::strcmp(*utf8, "content-type") == 0, "UTF-8 contents correct");
+
+  TwoByteView twoByte {cx, *s};
+  V8MONKEY_CHECK(!twoByte.IsDirect(), "Two-byte view copied");
+  V8MONKEY_CHECK(twoByte.length() == 12, "Two-byte length correct");
+  V8MONKEY_CHECK(std::memcmp(*twoByte, u"content-type", 13 * sizeof(char16_t)) == 0, "Two-byte contents correct");
+}
+
+
+V8MONKEY_TEST(IntStringWrapper018, "Long strings in the matching encoding are read in place") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+
+  std::string ascii(100, 'a');
+  std::unique_ptr<StringWrapper> s {StringWrapper::NewFromUtf8(cx, ascii.c_str())};
+  Utf8View utf8 {cx, *s};
+  V8MONKEY_CHECK(utf8.IsDirect(), "UTF-8 view direct");
+  V8MONKEY_CHECK(utf8.length() == 100, "UTF-8 length correct");
+  V8MONKEY_CHECK(std::memcmp(*utf8, ascii.data(), 100) == 0, "UTF-8 contents correct");
+
+  std::u16string wide(100, 0x20ac);
+  std::unique_ptr<StringWrapper> t {
+    StringWrapper::NewFromTwoByte(cx, reinterpret_cast<const uint16_t*>(wide.data()), 100)};
+  TwoByteView twoByte {cx, *t};
+  V8MONKEY_CHECK(twoByte.IsDirect(), "Two-byte view direct");
+  V8MONKEY_CHECK(twoByte.length() == 100, "Two-byte length correct");
+  V8MONKEY_CHECK(std::memcmp(*twoByte, wide.data(), 100 * sizeof(char16_t)) == 0, "Two-byte contents correct");
+}
+
+
+V8MONKEY_TEST(IntStringWrapper019, "Long strings in another encoding are converted") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+
+  std::string latin1;
+  for (int i = 0; i < 50; i++) {
+    latin1 += "\xc3\xa9";
+  }
+
+  std::unique_ptr<StringWrapper> s {StringWrapper::NewFromUtf8(cx, latin1.c_str())};
+  Utf8View utf8 {cx, *s};
+  V8MONKEY_CHECK(!utf8.IsDirect(), "UTF-8 view copied");
+  V8MONKEY_CHECK(utf8.length() == 100, "UTF-8 length correct");
+  V8MONKEY_CHECK(std::strcmp(*utf8, latin1.c_str()) == 0, "UTF-8 contents correct");
+
+  TwoByteView twoByte {cx, *s};
+  V8MONKEY_CHECK(!twoByte.IsDirect(), "Two-byte view copied");
+  V8MONKEY_CHECK(twoByte.length() == 50, "Two-byte length correct");
+  bool correct {true};
+  for (int i = 0; i < 50; i++) {
+    correct = correct && (*twoByte)[i] == 0xe9;
+  }
+
+  V8MONKEY_CHECK(correct && (*twoByte)[50] == 0, "Two-byte contents correct");
+}
+
+
+V8MONKEY_TEST(IntStringWrapper020, "Internalized strings are atoms") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+  InternedStringTable table;
+
+  std::unique_ptr<StringWrapper> s {StringWrapper::NewInternalizedFromUtf8(cx, table, "content-type")};
+  std::unique_ptr<StringWrapper> t {StringWrapper::NewInternalizedFromUtf8(cx, table, "content-type", 12)};
+  V8MONKEY_CHECK(s && t, "Strings created");
+  V8MONKEY_CHECK(s->Get() == t->Get(), "Same atom used");
+  V8MONKEY_CHECK(s->Get() == JS_InternStringN(cx, "content-type", 12), "Atom correct");
+}
+
+
+V8MONKEY_TEST(IntStringWrapper021, "Property keys are correct") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+
+  std::unique_ptr<StringWrapper> s {StringWrapper::NewFromUtf8(cx, "content-type")};
+  JS::RootedId id(cx);
+  V8MONKEY_CHECK(s->ToId(cx, &id), "Conversion succeeded");
+  V8MONKEY_CHECK(JSID_IS_STRING(id), "Key is a string");
+  V8MONKEY_CHECK(JSID_TO_STRING(id) == JS_InternStringN(cx, "content-type", 12), "Key is the atom");
+
+  std::unique_ptr<StringWrapper> t {StringWrapper::NewFromUtf8(cx, "42")};
+  V8MONKEY_CHECK(t->ToId(cx, &id), "Conversion succeeded");
+  V8MONKEY_CHECK(JSID_IS_INT(id) && JSID_TO_INT(id) == 42, "Index key is an integer");
+}
+
+
+V8MONKEY_TEST(IntStringWrapper022, "Property keys are cached") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+
+  std::unique_ptr<StringWrapper> s {StringWrapper::NewFromUtf8(cx, "content-length")};
+  JS::RootedId first(cx);
+  JS::RootedId second(cx);
+  V8MONKEY_CHECK(s->ToId(cx, &first), "Conversion succeeded");
+  V8MONKEY_CHECK(s->ToId(cx, &second), "Conversion succeeded");
+  V8MONKEY_CHECK(JSID_TO_STRING(first) == JSID_TO_STRING(second), "Same key returned");
+}
+
+
+V8MONKEY_TEST(IntStringWrapper023, "Concat builds ropes, flattened when read") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+
+  std::string a(50, 'a');
+  std::string b(50, 'b');
+  std::unique_ptr<StringWrapper> left {StringWrapper::NewFromUtf8(cx, a.c_str())};
+  std::unique_ptr<StringWrapper> right {StringWrapper::NewFromUtf8(cx, b.c_str())};
+
+  std::unique_ptr<StringWrapper> once {StringWrapper::Concat(cx, *left, *right)};
+  V8MONKEY_CHECK(once, "String created");
+  V8MONKEY_CHECK(once->RopeDepth() == 1, "Rope depth correct");
+  V8MONKEY_CHECK(once->Length() == 100, "Length correct without flattening");
+
+  std::unique_ptr<StringWrapper> twice {StringWrapper::Concat(cx, *once, *left)};
+  V8MONKEY_CHECK(twice->RopeDepth() == 2, "Rope depth correct");
+
+  Utf8View view {cx, *twice};
+  V8MONKEY_CHECK(view.length() == 150 && std::memcmp(*view, (a + b + a).data(), 150) == 0, "Contents correct");
+  V8MONKEY_CHECK(twice->RopeDepth() == 0, "String flattened");
+}
+
+
+namespace {
+  int concatCount {0};
+  int flattenCount {0};
+  int maxRopeDepth {0};
+
+
+  int* lookupCounter(const char* name) {
+    if (std::strcmp(name, "c:V8Monkey.StringConcats") == 0) {
+      return &concatCount;
+    }
+
+    if (std::strcmp(name, "c:V8Monkey.StringFlattens") == 0) {
+      return &flattenCount;
+    }
+
+    if (std::strcmp(name, "c:V8Monkey.MaxRopeDepth") == 0) {
+      return &maxRopeDepth;
+    }
+
+    return nullptr;
+  }
+}
+
+
+V8MONKEY_TEST(IntStringWrapper024, "Concatenations and flattens are counted") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+  Isolate* isolate {new Isolate};
+  isolate->Enter();
+  isolate->SetCounterFunction(lookupCounter);
+
+  std::string a(50, 'a');
+  std::unique_ptr<StringWrapper> s {StringWrapper::NewFromUtf8(cx, a.c_str())};
+  std::unique_ptr<StringWrapper> once {StringWrapper::Concat(cx, *s, *s)};
+  std::unique_ptr<StringWrapper> twice {StringWrapper::Concat(cx, *once, *s)};
+  V8MONKEY_CHECK(concatCount == 2, "Concatenations counted");
+  V8MONKEY_CHECK(maxRopeDepth == 2, "Rope depth reported");
+
+  twice->Utf8Length(cx);
+  twice->Utf8Length(cx);
+  V8MONKEY_CHECK(flattenCount == 1, "Flatten counted once");
+
+  isolate->Exit();
+  isolate->Dispose();
+}
+
+
+V8MONKEY_TEST(IntStringWrapper025, "Equality compares contents, flattening ropes") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+  Isolate* isolate {new Isolate};
+  isolate->Enter();
+  isolate->SetCounterFunction(lookupCounter);
+  flattenCount = 0;
+
+  std::string a(50, 'a');
+  std::unique_ptr<StringWrapper> s {StringWrapper::NewFromUtf8(cx, a.c_str())};
+  std::unique_ptr<StringWrapper> rope {StringWrapper::Concat(cx, *s, *s)};
+  std::unique_ptr<StringWrapper> flat {StringWrapper::NewFromUtf8(cx, (a + a).c_str())};
+  std::unique_ptr<StringWrapper> other {StringWrapper::NewFromUtf8(cx, (a + std::string(50, 'b')).c_str())};
+
+  bool result {false};
+  V8MONKEY_CHECK(s->Equals(cx, *rope, &result) && !result, "Strings of different lengths are unequal");
+  V8MONKEY_CHECK(flattenCount == 0, "Lengths compared without flattening");
+
+  V8MONKEY_CHECK(rope->Equals(cx, *flat, &result) && result, "Rope equals flat string with the same contents");
+  V8MONKEY_CHECK(flattenCount == 1, "Rope flatten counted");
+  V8MONKEY_CHECK(rope->RopeDepth() == 0, "Rope flattened");
+
+  V8MONKEY_CHECK(flat->StrictEquals(cx, *other, &result) && !result, "Different contents are unequal");
+  V8MONKEY_CHECK(flat->StrictEquals(cx, *flat, &result) && result, "String equals itself");
+
+  isolate->Exit();
+  isolate->Dispose();
+}
+
+
+V8MONKEY_TEST(IntStringWrapper026, "Builders assemble strings from chunks") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+
+  StringBuilder builder;
+  builder.Append("caf\xc3", 4);
+  builder.Append("\xa9 \xe2\x82", 4);
+  builder.Append("\xac", 1);
+
+  std::unique_ptr<StringWrapper> s {builder.Finish(cx)};
+  V8MONKEY_CHECK(s, "String created");
+  V8MONKEY_CHECK(!s->IsOneByte(), "String is two-byte");
+  V8MONKEY_CHECK(hasContents(cx, s->Get(), u"caf\u00e9 \u20ac", 6), "Contents correct");
+
+  builder.Append("caf\xc3", 4);
+  builder.Append("\xa9", 1);
+  std::unique_ptr<StringWrapper> t {builder.Finish(cx)};
+  V8MONKEY_CHECK(t->IsOneByte(), "Latin1 string is one-byte");
+  V8MONKEY_CHECK(hasContents(cx, t->Get(), u"caf\u00e9", 4), "Builder was reset");
+}
+
+
+V8MONKEY_TEST(IntStringWrapper027, "Strings either side of the inline encoding limit are created correctly") {
+  InCompartment c;
+  JSContext* cx {c.cx};
+
+  // Lengths in UTF-8 code units, which is what the limit applies to
+  for (size_t length : {63u, 64u, 65u}) {
+    std::string latin1(length - 2, 'a');
+    latin1 += "\xc3\xa9";
+    std::u16string expectedLatin1(length - 2, u'a');
+    expectedLatin1 += u'\u00e9';
+
+    std::unique_ptr<StringWrapper> s {StringWrapper::NewFromUtf8(cx, latin1.c_str())};
+    V8MONKEY_CHECK(s->IsOneByte(), "String is one-byte");
+    V8MONKEY_CHECK(hasContents(cx, s->Get(), expectedLatin1.data(), length - 1), "Contents correct");
+
+    std::string twoByte(length - 3, 'a');
+    twoByte += "\xe2\x82\xac";
+    std::u16string expectedTwoByte(length - 3, u'a');
+    expectedTwoByte += u'\u20ac';
+
+    std::unique_ptr<StringWrapper> t {StringWrapper::NewFromUtf8(cx, twoByte.c_str())};
+    V8MONKEY_CHECK(!t->IsOneByte(), "String is two-byte");
+    V8MONKEY_CHECK(hasContents(cx, t->Get(), expectedTwoByte.data(), length - 2), "Contents correct");
+  }
+}
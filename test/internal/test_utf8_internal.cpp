@@ -1,13 +1,21 @@
-/*
 // std::equal, std::transform
 #include <algorithm>
 
 // initializer_list
 #include <initializer_list>
 
+// std::ptrdiff_t
+#include <cstddef>
+
+// std::deque
+#include <deque>
+
 // std::begin, std::end, std::distance
 #include <iterator>
 
+// std::string
+#include <string>
+
 // std::vector
 #include <vector>
 
@@ -579,9 +587,7 @@ V8MONKEY_TEST(IntUtf8_031, "Ill-formed UTF-8 sequences have their contents encod
   V8MONKEY_CHECK(std::distance(utfIter, utfEnd) == std::distance(encodedIter, encodedEnd),
                  "Length mismatch in encodable invalid utf arrays");
 
-*/
-  //for ( /* utfIter and encodedIter are initialized above */; utfIter != utfEnd; ++utfIter, ++encodedIter) {
-/*
+  for ( /* utfIter and encodedIter are initialized above */; utfIter != utfEnd; ++utfIter, ++encodedIter) {
     UTF8::UTF16Encoded expected(*encodedIter);
 
     const std::vector<char> testCase(*utfIter);
@@ -652,6 +658,374 @@ V8MONKEY_TEST(IntUtf8_037, "Nullptrs handled correctly (6)") {
 }
 
 
+namespace {
+  const UTF8::EncodingImplementation encodingImplementations[] {UTF8::EncodingImplementation::Scalar,
+                                                                UTF8::EncodingImplementation::SSE2,
+                                                                UTF8::EncodingImplementation::AVX2};
+
+
+  // Samples of the text we expect to see: each is repeated to form inputs long enough to exercise the vector paths
+  const char* corpora[] {
+    "The quick brown fox jumps over the lazy dog. ",
+    "Voil\xc3\xa0 une r\xc3\xa9sum\xc3\xa9 na\xc3\xafve, tr\xc3\xa8s \xc3\xa0 la mode. ",
+    "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e\xe3\x81\xae\xe3\x83\x86\xe3\x82\xad\xe3\x82\xb9\xe3\x83\x88 ",
+    "Emoji \xf0\x9f\x98\x80\xf0\x9f\x8e\x89 everywhere \xf0\x9f\x9a\x80! ",
+    "Broken \xc3 bytes \xed\xa0\x80 and \xf0\x9f stray \xbf continuations "
+  };
+}
+
+
+V8MONKEY_TEST(IntUtf8_038, "WidenASCII stops at the first non-ASCII code unit") {
+  for (auto impl : encodingImplementations) {
+    if (!UTF8::ForceEncodingImplementation(impl)) {
+      continue;
+    }
+
+    for (size_t position = 0; position < 80; position++) {
+      std::vector<unsigned char> input(80, 'a');
+      input[position] = 0x80u;
+      std::vector<char16_t> output(input.size(), 0xffffu);
+
+      const size_t widened {UTF8::WidenASCII(input.data(), input.size(), output.data())};
+      V8MONKEY_CHECK(widened == position, "Correct number of code units widened");
+      V8MONKEY_CHECK(std::all_of(output.begin(), output.begin() + static_cast<std::ptrdiff_t>(position),
+                                 [](char16_t c) { return c == u'a'; }), "ASCII widened correctly");
+      V8MONKEY_CHECK(output[position] == 0xffffu, "Output not written beyond ASCII run");
+    }
+  }
+
+  UTF8::ResetEncodingImplementation();
+}
+
+
+V8MONKEY_TEST(IntUtf8_039, "WidenASCII respects the length") {
+  for (auto impl : encodingImplementations) {
+    if (!UTF8::ForceEncodingImplementation(impl)) {
+      continue;
+    }
+
+    for (size_t length = 0; length < 70; length++) {
+      std::vector<unsigned char> input(80, 'z');
+      std::vector<char16_t> output(80, 0xffffu);
+
+      V8MONKEY_CHECK(UTF8::WidenASCII(input.data(), length, output.data()) == length, "All code units widened");
+      V8MONKEY_CHECK(output[length] == 0xffffu, "Output not written beyond length");
+    }
+  }
+
+  UTF8::ResetEncodingImplementation();
+}
+
+
+V8MONKEY_TEST(IntUtf8_040, "Multi-code-unit and invalid UTF-8 within long ASCII runs encodes correctly") {
+  const std::string sequences[] {"\xc3\xa9", "\xe6\x97\xa5", "\xf0\x9f\x98\x80", "\xbf", "\xc3", "\xf0\x9f"};
+  const UTF8::UTF16Encoded expectedSequences[] {{0x00e9u}, {0x65e5u}, {0xd83du, 0xde00u}, {0xfffdu}, {0xfffdu},
+                                                {0xfffdu, 0xfffdu}};
+
+  for (auto impl : encodingImplementations) {
+    if (!UTF8::ForceEncodingImplementation(impl)) {
+      continue;
+    }
+
+    for (size_t i = 0; i < sizeof(expectedSequences) / sizeof(expectedSequences[0]); i++) {
+      for (size_t position = 0; position < 70; position++) {
+        std::string input(position, 'x');
+        input += sequences[i];
+        input += std::string(70 - position, 'y');
+
+        UTF8::UTF16Encoded expected(position, u'x');
+        expected.insert(expected.end(), expectedSequences[i].begin(), expectedSequences[i].end());
+        expected.insert(expected.end(), 70 - position, u'y');
+        expected.push_back(0x0000u);
+
+        const UTF8::UTF16Encoded actual {UTF8::EncodeToUTF16(input.begin(), input.end())};
+        V8MONKEY_CHECK(actual == expected, "Data correctly encoded");
+      }
+    }
+  }
+
+  UTF8::ResetEncodingImplementation();
+}
+
+
+V8MONKEY_TEST(IntUtf8_041, "All ASCII implementations agree with the code-unit at a time encoder") {
+  for (auto corpus : corpora) {
+    std::string input;
+    for (int i = 0; i < 20; i++) {
+      input += corpus;
+    }
+
+    // std::deque is not contiguous, so is encoded one code unit at a time
+    const std::deque<char> reference {input.begin(), input.end()};
+
+    for (auto impl : encodingImplementations) {
+      if (!UTF8::ForceEncodingImplementation(impl)) {
+        continue;
+      }
+
+      // Start at each offset to vary the alignment of the runs
+      for (size_t offset = 0; offset < 32; offset++) {
+        const auto referenceBegin = reference.begin() + static_cast<std::ptrdiff_t>(offset);
+        const UTF8::UTF16Encoded expected {UTF8::EncodeToUTF16(referenceBegin, reference.end())};
+        const UTF8::UTF16Encoded actual {UTF8::EncodeToUTF16(input.c_str() + offset, input.c_str() + input.size())};
+        V8MONKEY_CHECK(actual == expected, "Data correctly encoded");
+      }
+    }
+  }
+
+  UTF8::ResetEncodingImplementation();
+}
+
+
+V8MONKEY_TEST(IntUtf8_042, "CopyASCII stops at the first non-ASCII code unit") {
+  for (auto impl : encodingImplementations) {
+    if (!UTF8::ForceEncodingImplementation(impl)) {
+      continue;
+    }
+
+    for (size_t position = 0; position < 80; position++) {
+      std::vector<unsigned char> input(80, 'a');
+      input[position] = 0xc3u;
+      std::vector<unsigned char> output(input.size(), 0xffu);
+
+      const size_t copied {UTF8::CopyASCII(input.data(), input.size(), output.data())};
+      V8MONKEY_CHECK(copied == position, "Correct number of code units copied");
+      V8MONKEY_CHECK(std::equal(input.begin(), input.begin() + static_cast<std::ptrdiff_t>(position), output.begin()),
+                     "ASCII copied correctly");
+      V8MONKEY_CHECK(output[position] == 0xffu, "Output not written beyond ASCII run");
+    }
+  }
+
+  UTF8::ResetEncodingImplementation();
+}
+
+
+V8MONKEY_TEST(IntUtf8_043, "Latin1 representable UTF-8 encodes to one byte") {
+  const std::string input {"caf\xc3\xa9 \xc2\xa3" "5 \xc3\xbf"};
+  const UTF8::Latin1Encoded expected {'c', 'a', 'f', 0xe9u, ' ', 0xa3u, '5', ' ', 0xffu};
+
+  const UTF8::NarrowestEncoded actual {UTF8::EncodeToNarrowest(input.begin(), input.end())};
+  V8MONKEY_CHECK(actual.isOneByte, "One-byte encoding chosen");
+  V8MONKEY_CHECK(actual.oneByte == expected, "Data correctly encoded");
+  V8MONKEY_CHECK(actual.twoByte.empty(), "Two-byte encoding empty");
+}
+
+
+V8MONKEY_TEST(IntUtf8_044, "Empty input encodes to empty one-byte string") {
+  const char* degenerate {nullptr};
+  const UTF8::NarrowestEncoded actual {UTF8::EncodeToNarrowest(degenerate, degenerate)};
+
+  V8MONKEY_CHECK(actual.isOneByte, "One-byte encoding chosen");
+  V8MONKEY_CHECK(actual.oneByte.empty(), "No data encoded");
+}
+
+
+V8MONKEY_TEST(IntUtf8_045, "Narrowest encoding of non-Latin1 UTF-8 agrees with EncodeToUTF16") {
+  for (auto corpus : corpora) {
+    std::string input;
+    for (int i = 0; i < 20; i++) {
+      input += corpus;
+    }
+
+    for (size_t offset = 0; offset < 32; offset++) {
+      UTF8::UTF16Encoded expected {UTF8::EncodeToUTF16(input.c_str() + offset, input.c_str() + input.size())};
+      expected.pop_back();
+
+      const UTF8::NarrowestEncoded actual {UTF8::EncodeToNarrowest(input.c_str() + offset,
+                                                                   input.c_str() + input.size())};
+      if (actual.isOneByte) {
+        V8MONKEY_CHECK(std::equal(expected.begin(), expected.end(), actual.oneByte.begin()) &&
+                       expected.size() == actual.oneByte.size(), "Data correctly encoded");
+        V8MONKEY_CHECK(std::all_of(expected.begin(), expected.end(), [](char16_t c) { return c <= 0xffu; }),
+                       "One-byte encoding only chosen when possible");
+      } else {
+        V8MONKEY_CHECK(actual.twoByte == expected, "Data correctly encoded");
+        V8MONKEY_CHECK(actual.oneByte.empty(), "One-byte encoding empty");
+      }
+    }
+  }
+}
+
+
+V8MONKEY_TEST(IntUtf8_046, "Ill-formed UTF-8 after a Latin1 prefix switches to two bytes") {
+  const std::string input {"\xc3\xa9t\xc3\xa9\xbf!"};
+  const UTF8::UTF16Encoded expected {0x00e9u, 't', 0x00e9u, 0xfffdu, '!'};
+
+  const UTF8::NarrowestEncoded actual {UTF8::EncodeToNarrowest(input.begin(), input.end())};
+  V8MONKEY_CHECK(!actual.isOneByte, "Two-byte encoding chosen");
+  V8MONKEY_CHECK(actual.twoByte == expected, "Data correctly encoded");
+}
+
+
+V8MONKEY_TEST(IntUtf8_047, "Two-byte input is narrowed when possible") {
+  const std::vector<char16_t> narrow {'a', 0x00e9u, 0x00ffu};
+  const UTF8::NarrowestEncoded narrowed {UTF8::EncodeToNarrowest(narrow.begin(), narrow.end())};
+  V8MONKEY_CHECK(narrowed.isOneByte, "One-byte encoding chosen");
+  V8MONKEY_CHECK((narrowed.oneByte == UTF8::Latin1Encoded {'a', 0xe9u, 0xffu}), "Data correctly encoded");
+
+  const std::vector<char16_t> wide {'a', 0x00e9u, 0x0100u, 'b'};
+  const UTF8::NarrowestEncoded widened {UTF8::EncodeToNarrowest(wide.begin(), wide.end())};
+  V8MONKEY_CHECK(!widened.isOneByte, "Two-byte encoding chosen");
+  V8MONKEY_CHECK(widened.twoByte == wide, "Data correctly encoded");
+}
+
+
+V8MONKEY_TEST(IntUtf8_048, "UTF-8 lengths are computed correctly") {
+  const std::u16string twoByte {u"a\u00e9\u20ac\U0001f600\xd800x\xdc00"};
+  const unsigned char oneByte[] {'a', 0xe9u, 'b', 0xffu};
+
+  for (auto impl : encodingImplementations) {
+    if (!UTF8::ForceEncodingImplementation(impl)) {
+      continue;
+    }
+
+    V8MONKEY_CHECK(UTF8::UTF8Length(twoByte.data(), twoByte.size()) == 1 + 2 + 3 + 4 + 3 + 1 + 3,
+                   "Two-byte length correct");
+    V8MONKEY_CHECK(UTF8::UTF8Length(oneByte, sizeof(oneByte)) == 6, "One-byte length correct");
+
+    // Long enough to be counted by the vector routines, with a surrogate pair straddling each block boundary
+    std::u16string repeated;
+    for (int i = 0; i < 100; i++) {
+      repeated += u"abcdefg\U0001f600";
+    }
+
+    V8MONKEY_CHECK(UTF8::UTF8Length(repeated.data(), repeated.size()) == 100 * (7 + 4), "Repeated length correct");
+  }
+
+  UTF8::ResetEncodingImplementation();
+}
+
+
+V8MONKEY_TEST(IntUtf8_049, "Encoding to UTF-8 never splits a code-point") {
+  const std::u16string input {u"ab\u00e9\U0001f600"};
+  const std::string expected {"ab\xc3\xa9\xf0\x9f\x98\x80"};
+
+  const struct {
+    size_t capacity;
+    size_t bytes;
+    size_t codeUnits;
+  } cases[] {{0, 0, 0}, {2, 2, 2}, {3, 2, 2}, {4, 4, 3}, {7, 4, 3}, {8, 8, 5}, {100, 8, 5}};
+
+  for (const auto& c : cases) {
+    char buffer[16];
+    UTF8::UTF8Written written {UTF8::EncodeToUTF8(input.data(), input.size(), buffer, c.capacity, false)};
+    V8MONKEY_CHECK(written.bytes == c.bytes && written.codeUnits == c.codeUnits, "Correct amount written");
+    V8MONKEY_CHECK(expected.compare(0, written.bytes, buffer, written.bytes) == 0, "Data correctly encoded");
+  }
+}
+
+
+V8MONKEY_TEST(IntUtf8_050, "Lone surrogates are replaced only on request") {
+  const std::u16string input {u"\xd800" u"a" u"\xdc00"};
+  char buffer[16];
+
+  UTF8::UTF8Written asIs {UTF8::EncodeToUTF8(input.data(), input.size(), buffer, sizeof(buffer), false)};
+  V8MONKEY_CHECK(std::string(buffer, asIs.bytes) == "\xed\xa0\x80" "a" "\xed\xb0\x80", "Surrogates encoded as-is");
+
+  UTF8::UTF8Written replaced {UTF8::EncodeToUTF8(input.data(), input.size(), buffer, sizeof(buffer), true)};
+  V8MONKEY_CHECK(std::string(buffer, replaced.bytes) == "\xef\xbf\xbd" "a" "\xef\xbf\xbd", "Surrogates replaced");
+}
+
+
+V8MONKEY_TEST(IntUtf8_051, "Latin1 encodes to UTF-8 correctly") {
+  std::vector<unsigned char> input(64, 'x');
+  input[40] = 0xe9u;
+  std::string expected(40, 'x');
+  expected += "\xc3\xa9";
+  expected += std::string(23, 'x');
+
+  for (auto impl : encodingImplementations) {
+    if (!UTF8::ForceEncodingImplementation(impl)) {
+      continue;
+    }
+
+    char buffer[80];
+    UTF8::UTF8Written all {UTF8::EncodeToUTF8(input.data(), input.size(), buffer, sizeof(buffer))};
+    V8MONKEY_CHECK(all.codeUnits == input.size() && std::string(buffer, all.bytes) == expected, "Data encoded");
+
+    UTF8::UTF8Written partial {UTF8::EncodeToUTF8(input.data(), input.size(), buffer, 41)};
+    V8MONKEY_CHECK(partial.bytes == 40 && partial.codeUnits == 40, "Sequence not split");
+  }
+
+  UTF8::ResetEncodingImplementation();
+}
+
+
+
+namespace {
+  // The output of EncodeToUTF16, less the terminator it adds
+  UTF8::UTF16Encoded decodeInOneGo(const std::string& input) {
+    UTF8::UTF16Encoded result {UTF8::EncodeToUTF16(input.begin(), input.end())};
+    if (input.empty() || input.back() != '\0') {
+      result.pop_back();
+    }
+
+    return result;
+  }
+}
+
+
+V8MONKEY_TEST(IntUtf8_052, "Streaming decoding matches decoding in one go, wherever the input is split") {
+  std::vector<std::string> inputs {"ab\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80z", "\xe2\x82" "a\xf0\x9f\x98" "b\xc3"};
+  for (const auto& invalid : invalidUTF8) {
+    inputs.emplace_back(invalid.begin(), invalid.end());
+    inputs.back() += "\xe2\x82\xac";
+  }
+
+  for (const auto& input : inputs) {
+    UTF8::UTF16Encoded expected {decodeInOneGo(input)};
+
+    for (size_t i = 0; i <= input.size(); i++) {
+      for (size_t j = i; j <= input.size(); j++) {
+        UTF8::StreamDecoder decoder;
+        decoder.Append(input.data(), i);
+        decoder.Append(input.data() + i, j - i);
+        decoder.Append(input.data() + j, input.size() - j);
+        decoder.Finish();
+        V8MONKEY_CHECK(decoder.Output() == expected, "Output correct");
+      }
+    }
+  }
+}
+
+
+V8MONKEY_TEST(IntUtf8_053, "Streaming decoding replaces a sequence left incomplete at the end") {
+  const std::string input {"a\xf0\x9f\x98"};
+  UTF8::StreamDecoder decoder;
+
+  for (char c : input) {
+    decoder.Append(&c, 1);
+  }
+
+  V8MONKEY_CHECK(decoder.Output() == UTF8::UTF16Encoded {u'a'}, "Incomplete sequence held back");
+
+  decoder.Finish();
+  V8MONKEY_CHECK(decoder.Output() == decodeInOneGo(input), "Incomplete sequence replaced");
+
+  decoder.Reset();
+  V8MONKEY_CHECK(decoder.Output().empty(), "Output discarded");
+}
+
+
+V8MONKEY_TEST(IntUtf8_054, "Encoding to the narrowest representation in place matches encoding to vectors") {
+  const std::string inputs[] {"", "abc", "caf\xc3\xa9", "caf\xc3\xa9 \xe2\x82\xac", "\xff" "abc", "\xc3"};
+
+  for (const auto& input : inputs) {
+    UTF8::NarrowestEncoded expected {UTF8::EncodeToNarrowest(input.data(), input.data() + input.size())};
+
+    unsigned char oneByte[16];
+    char16_t twoByte[16];
+    UTF8::NarrowestWritten written {
+      UTF8::EncodeToNarrowestInto(input.data(), input.data() + input.size(), oneByte, twoByte)};
+
+    V8MONKEY_CHECK(written.isOneByte == expected.isOneByte, "Representation correct");
+    if (written.isOneByte) {
+      V8MONKEY_CHECK(UTF8::Latin1Encoded(oneByte, oneByte + written.length) == expected.oneByte, "Latin1 correct");
+    } else {
+      V8MONKEY_CHECK(UTF8::UTF16Encoded(twoByte, twoByte + written.length) == expected.twoByte, "UTF-16 correct");
+    }
+  }
+}
+
 // XXX Reversed surrogates
 // XXX Verify everything against V8
-*/
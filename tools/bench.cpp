@@ -0,0 +1,1124 @@
+// find min
+#include <algorithm>
+
+// atomic
+#include <atomic>
+
+// steady_clock
+#include <chrono>
+
+// uint8_t uint32_t
+#include <cstdint>
+
+// fclose fopen fread fseek ftell
+#include <cstdio>
+
+// atoi mkdtemp
+#include <cstdlib>
+
+// memcmp strcmp
+#include <cstring>
+
+// function
+#include <functional>
+
+// setw
+#include <iomanip>
+
+// cout, cerr
+#include <iostream>
+
+// numeric_limits
+#include <limits>
+
+// unique_ptr
+#include <memory>
+
+// string, to_string, u16string
+#include <string>
+
+// this_thread::yield
+#include <thread>
+
+// vector
+#include <vector>
+
+// getrusage
+#include <sys/resource.h>
+
+// waitpid
+#include <sys/wait.h>
+
+// close fork pipe read rmdir write _exit
+#include <unistd.h>
+
+// JSAutoCompartment JSAutoRequest JSContext JS_GetPropertyById JS_NewObject JS_NewStringCopyN JS_NewUCStringCopyN
+// JS_ParseJSON JS_SetPropertyById JS_Stringify JS_StringToId
+#include "jsapi.h"
+
+// BiasedRefCounted
+#include "data_structures/biased_refcount.h"
+
+// FileSystem Thread
+#include "platform/platform.h"
+
+// CompilationCache
+#include "runtime/compilation_cache.h"
+
+// Snapshot
+#include "runtime/snapshot.h"
+
+// JSONParser
+#include "types/json_parser.h"
+
+// JSONOutputStream JSONStringifier
+#include "types/json_stringifier.h"
+
+// CachedData CompileTask ScriptOrigin ScriptSource ScriptWrapper UnboundScriptWrapper
+#include "types/script_wrapper.h"
+
+// MappedStringResource StringWrapper Utf8View
+#include "types/string_wrapper.h"
+
+// EncodeToNarrowest EncodeToNarrowestInto WidenASCII
+#include "utils/Encoding.h"
+
+// EnsureRuntimeAndContext GetJSContextForThread NewGlobal
+#include "utils/SpiderMonkeyUtils.h"
+
+
+/*
+ * Times the library's fast paths against the code they replace:
+ *
+ *   bench [repetitions] [group...]
+ *
+ * Each case reports the best of the given number of repetitions (10 by default), as timings are noisy, and how much
+ * quicker the fast path was. Naming groups runs only those; groups that do not need SpiderMonkey never start it.
+ *
+ * The library objects are linked as built, so the figures are only meaningful for an optimised build: compare ratios
+ * rather than absolute times.
+ *
+ */
+
+
+using namespace v8::DataStructures;
+using namespace v8::internal;
+using namespace v8::V8Monkey;
+using namespace v8::SpiderMonkey;
+using namespace v8::V8Platform;
+
+
+namespace {
+  int repetitions {10};
+  bool failed {false};
+
+
+  // Best time in microseconds over the repetitions. Returns a negative time if an attempt failed.
+  double best(const std::function<bool()>& attempt, const std::function<void()>& prepare = [] {}) {
+    double fastest {std::numeric_limits<double>::max()};
+
+    for (int i = 0; i < repetitions; i++) {
+      prepare();
+
+      std::chrono::steady_clock::time_point start {std::chrono::steady_clock::now()};
+      bool succeeded {attempt()};
+      std::chrono::duration<double, std::micro> elapsed {std::chrono::steady_clock::now() - start};
+
+      if (!succeeded) {
+        return -1.0;
+      }
+
+      fastest = std::min(fastest, elapsed.count());
+    }
+
+    return fastest;
+  }
+
+
+  void report(const std::string& name, double baseline, double candidate) {
+    std::cout << std::left << std::setw(40) << name << std::right << std::fixed << std::setprecision(1);
+
+    if (baseline < 0 || candidate < 0) {
+      std::cout << "   failed" << std::endl;
+      failed = true;
+      return;
+    }
+
+    std::cout << std::setw(12) << baseline << " us" << std::setw(12) << candidate << " us" << std::setw(8)
+              << std::setprecision(2) << baseline / candidate << "x" << std::endl;
+  }
+
+
+  // Run the given function within the given global
+  bool inGlobal(JSContext* cx, JS::HandleObject global, const std::function<bool()>& f) {
+    JSAutoCompartment ac(cx, global);
+    return f();
+  }
+
+
+  void heading(const char* baseline, const char* candidate, const char* ratio = "speedup") {
+    std::cout << std::endl << std::left << std::setw(40) << "" << std::right << std::setw(15) << baseline
+              << std::setw(15) << candidate << std::setw(9) << ratio << std::endl;
+  }
+
+
+  /*
+   * Reference counting
+   *
+   */
+
+  // The plain atomic count internal objects carried before biased counting
+  class AtomicCounted {
+    public:
+      void AddRef() {
+        count.fetch_add(1, std::memory_order_relaxed);
+      }
+
+      void Release() {
+        if (count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+          delete this;
+        }
+      }
+
+    private:
+      std::atomic<int> count {0};
+  };
+
+
+  class BiasedCounted : public BiasedRefCounted {};
+
+
+  constexpr int refCountIterations {1000000};
+  constexpr int contendingThreads {3};
+
+
+  template <typename T>
+  void addRefAndRelease(T* obj, int iterations) {
+    for (int i = 0; i < iterations; i++) {
+      obj->AddRef();
+      obj->Release();
+    }
+  }
+
+
+  extern "C"
+  void* contendAtomic(void* arg) {
+    addRefAndRelease(reinterpret_cast<AtomicCounted*>(arg), refCountIterations / 10);
+    return nullptr;
+  }
+
+
+  extern "C"
+  void* contendBiased(void* arg) {
+    addRefAndRelease(reinterpret_cast<BiasedCounted*>(arg), refCountIterations / 10);
+    return nullptr;
+  }
+
+
+  // The owner counts as it always does, while other threads occasionally take and release references of their own
+  template <typename T>
+  bool countWithContention(ThreadFunction contend, bool contended) {
+    T* obj {new T};
+    obj->AddRef();
+
+    bool started {true};
+    std::vector<std::unique_ptr<Thread>> threads;
+    for (int i = 0; contended && started && i < contendingThreads; i++) {
+      threads.emplace_back(new Thread(contend));
+      started = threads.back()->Run(obj);
+      if (!started) {
+        threads.pop_back();
+      }
+    }
+
+    addRefAndRelease(obj, refCountIterations);
+
+    for (auto& t : threads) {
+      t->Join();
+    }
+
+    obj->Release();
+    return started;
+  }
+
+
+  void benchRefCounting(JSContext*) {
+    heading("atomic", "biased");
+
+    double baseline {best([] { return countWithContention<AtomicCounted>(contendAtomic, false); })};
+    double candidate {best([] { return countWithContention<BiasedCounted>(contendBiased, false); })};
+    report("Refcount: owner only", baseline, candidate);
+
+    baseline = best([] { return countWithContention<AtomicCounted>(contendAtomic, true); });
+    candidate = best([] { return countWithContention<BiasedCounted>(contendBiased, true); });
+    report("Refcount: owner and 3 other threads", baseline, candidate);
+  }
+
+
+  /*
+   * UTF-8 decoding
+   *
+   */
+
+  // What the encoder did for ASCII before WidenASCII: check and widen one code unit at a time
+  size_t widenOneAtATime(const unsigned char* source, size_t length, char16_t* dest) {
+    size_t i {0};
+    for (; i < length && source[i] < 0x80u; i++) {
+      dest[i] = source[i];
+    }
+
+    return i;
+  }
+
+
+  void benchUTF8(JSContext*) {
+    heading("per unit", "widened");
+
+    // Source text and markup are overwhelmingly ASCII
+    std::string text;
+    while (text.size() < (1u << 20)) {
+      text += "function add(a, b) { return a + b; } // <p class=\"note\">Lorem ipsum dolor sit amet</p>\n";
+    }
+
+    const unsigned char* source {reinterpret_cast<const unsigned char*>(text.data())};
+    std::vector<char16_t> dest(text.size());
+
+    double baseline {best([&] { return widenOneAtATime(source, text.size(), dest.data()) == text.size(); })};
+    double candidate {best([&] { return UTF8::WidenASCII(source, text.size(), dest.data()) == text.size(); })};
+    report("UTF-8: widen 1 MiB of ASCII", baseline, candidate);
+  }
+
+
+  /*
+   * Short string encoding
+   *
+   */
+
+  const std::vector<std::string> identifiers {"id", "length", "prototype", "addEventListener", "caf\xc3\xa9",
+                                              "na\xc3\xafve", "\xe6\x9d\xb1\xe4\xba\xac", "x"};
+
+
+  // What string creation did before encoding into stack buffers: allocate the encoding
+  bool encodeAllToVectors(int times) {
+    size_t total {0};
+    for (int i = 0; i < times; i++) {
+      for (const std::string& s : identifiers) {
+        UTF8::NarrowestEncoded encoded {UTF8::EncodeToNarrowest(s.begin(), s.end())};
+        total += encoded.isOneByte ? encoded.oneByte.size() : encoded.twoByte.size();
+      }
+    }
+
+    return total > 0;
+  }
+
+
+  bool encodeAllIntoBuffers(int times) {
+    size_t total {0};
+    for (int i = 0; i < times; i++) {
+      for (const std::string& s : identifiers) {
+        unsigned char oneByte[64];
+        char16_t twoByte[64];
+        total += UTF8::EncodeToNarrowestInto(s.begin(), s.end(), oneByte, twoByte).length;
+      }
+    }
+
+    return total > 0;
+  }
+
+
+  void benchShortStrings(JSContext*) {
+    heading("vectors", "stack");
+
+    double baseline {best([] { return encodeAllToVectors(100000); })};
+    double candidate {best([] { return encodeAllIntoBuffers(100000); })};
+    report("Encode 800k short identifiers", baseline, candidate);
+  }
+
+
+  /*
+   * String views
+   *
+   */
+
+  // What String::Utf8Value does in V8: a heap copy for every view
+  bool matchesWithCopy(JSContext* cx, StringWrapper& string, const std::string& expected) {
+    int length {string.Utf8Length(cx)};
+    std::unique_ptr<char[]> copy {new char[static_cast<size_t>(length) + 1]};
+    string.WriteUtf8(cx, copy.get(), length + 1);
+    return static_cast<size_t>(length) == expected.size() &&
+           std::memcmp(copy.get(), expected.data(), expected.size()) == 0;
+  }
+
+
+  bool matchesWithView(JSContext* cx, StringWrapper& string, const std::string& expected) {
+    Utf8View view(cx, string);
+    return static_cast<size_t>(view.length()) == expected.size() &&
+           std::memcmp(*view, expected.data(), expected.size()) == 0;
+  }
+
+
+  // Compare each string against its expected contents a number of times, as a server matching header names would
+  bool compareAll(JSContext* cx, std::vector<std::unique_ptr<StringWrapper>>& strings,
+                  const std::vector<std::string>& expected, int times,
+                  bool (*matches)(JSContext*, StringWrapper&, const std::string&)) {
+    for (int i = 0; i < times; i++) {
+      for (size_t j = 0; j < strings.size(); j++) {
+        if (!matches(cx, *strings[j], expected[j])) {
+          return false;
+        }
+      }
+    }
+
+    return true;
+  }
+
+
+  void benchViews(JSContext* cx) {
+    heading("copy", "view");
+
+    std::vector<std::string> names {"accept", "accept-encoding", "authorization", "cache-control", "content-length",
+                                    "content-type", "cookie", "host", "if-none-match", "user-agent"};
+    std::vector<std::string> documents {std::string(64 * 1024, 'x')};
+
+    std::vector<std::unique_ptr<StringWrapper>> nameStrings;
+    for (const std::string& name : names) {
+      nameStrings.emplace_back(StringWrapper::NewFromUtf8(cx, name.c_str()));
+    }
+
+    std::vector<std::unique_ptr<StringWrapper>> documentStrings;
+    documentStrings.emplace_back(StringWrapper::NewFromUtf8(cx, documents[0].c_str()));
+
+    if (!documentStrings[0] || std::find(nameStrings.begin(), nameStrings.end(), nullptr) != nameStrings.end()) {
+      std::cerr << "Cannot create strings" << std::endl;
+      failed = true;
+      return;
+    }
+
+    double baseline {best([&] { return compareAll(cx, nameStrings, names, 1000, matchesWithCopy); })};
+    double candidate {best([&] { return compareAll(cx, nameStrings, names, 1000, matchesWithView); })};
+    report("Views: 10k header names", baseline, candidate);
+
+    baseline = best([&] { return compareAll(cx, documentStrings, documents, 100, matchesWithCopy); });
+    candidate = best([&] { return compareAll(cx, documentStrings, documents, 100, matchesWithView); });
+    report("Views: 100 x 64 KiB ASCII", baseline, candidate);
+  }
+
+
+  /*
+   * Property keys
+   *
+   */
+
+  // Each access converts the key afresh, as it would without the cached id
+  bool getAndSetConverting(JSContext* cx, JS::HandleObject obj, StringWrapper& key) {
+    JS::RootedString string(cx, key.Get());
+    JS::RootedId id(cx);
+    JS::RootedValue value(cx);
+    return JS_StringToId(cx, string, &id) && JS_GetPropertyById(cx, obj, id, &value) &&
+           JS_StringToId(cx, string, &id) && JS_SetPropertyById(cx, obj, id, value);
+  }
+
+
+  bool getAndSetCached(JSContext* cx, JS::HandleObject obj, StringWrapper& key) {
+    JS::RootedId id(cx);
+    JS::RootedValue value(cx);
+    return key.ToId(cx, &id) && JS_GetPropertyById(cx, obj, id, &value) &&
+           key.ToId(cx, &id) && JS_SetPropertyById(cx, obj, id, value);
+  }
+
+
+  void benchPropertyKeys(JSContext* cx) {
+    heading("convert", "cached");
+
+    JS::RootedObject obj(cx, JS_NewObject(cx, nullptr, JS::NullPtr(), JS::NullPtr()));
+    std::vector<std::unique_ptr<StringWrapper>> keys;
+    for (const char* name : {"id", "name", "price", "quantity", "createdAt", "updatedAt", "owner", "status"}) {
+      keys.emplace_back(StringWrapper::NewFromUtf8(cx, name));
+
+      JS::RootedValue value(cx, JS::Int32Value(0));
+      JS::RootedId id(cx);
+      if (!obj || !keys.back() || !keys.back()->ToId(cx, &id) || !JS_SetPropertyById(cx, obj, id, value)) {
+        std::cerr << "Cannot create the object" << std::endl;
+        failed = true;
+        return;
+      }
+    }
+
+    auto access = [&](bool (*getAndSet)(JSContext*, JS::HandleObject, StringWrapper&)) {
+      for (int i = 0; i < 10000; i++) {
+        for (auto& key : keys) {
+          if (!getAndSet(cx, obj, *key)) {
+            return false;
+          }
+        }
+      }
+
+      return true;
+    };
+
+    double baseline {best([&] { return access(getAndSetConverting); })};
+    double candidate {best([&] { return access(getAndSetCached); })};
+    report("Property keys: 80k gets and sets", baseline, candidate);
+  }
+
+
+  /*
+   * Code caches
+   *
+   */
+
+  std::u16string widen(const std::string& s) {
+    return std::u16string(s.begin(), s.end());
+  }
+
+
+  // A script of the size of a typical application bundle's module: many small functions, and a little top-level code
+  std::u16string largeScript() {
+    std::string text {"var x = 0;\n"};
+
+    for (int i = 0; i < 2000; i++) {
+      text += "function g" + std::to_string(i) + "(a) { return a + " + std::to_string(i) + "; }\nx = g" +
+              std::to_string(i) + "(x);\n";
+    }
+
+    return widen(text);
+  }
+
+
+  bool compileCold(JSContext* cx, const std::u16string& text) {
+    ScriptSource source {text.data(), text.size()};
+    std::unique_ptr<ScriptWrapper> script {ScriptWrapper::Compile(cx, source)};
+    return script != nullptr;
+  }
+
+
+  bool compileFromCache(JSContext* cx, const std::u16string& text, const std::vector<uint8_t>& cache) {
+    CachedData* data {new CachedData(cache.data(), static_cast<int>(cache.size()))};
+    ScriptSource source {text.data(), text.size(), ScriptOrigin {}, data};
+    std::unique_ptr<ScriptWrapper> script {ScriptWrapper::Compile(cx, source, ScriptWrapper::kConsumeCodeCache)};
+    return script && !source.GetCachedData()->rejected;
+  }
+
+
+  void benchCodeCache(JSContext* cx) {
+    heading("compile", "cache");
+
+    std::u16string text {largeScript()};
+    std::vector<uint8_t> cache;
+
+    {
+      ScriptSource source {text.data(), text.size()};
+      std::unique_ptr<ScriptWrapper> script {ScriptWrapper::Compile(cx, source, ScriptWrapper::kProduceCodeCache)};
+      const CachedData* produced {source.GetCachedData()};
+      if (script && produced) {
+        cache.assign(produced->data, produced->data + produced->length);
+      }
+    }
+
+    if (cache.empty()) {
+      report("Code cache: 2000 functions", -1.0, -1.0);
+      return;
+    }
+
+    double baseline {best([&] { return compileCold(cx, text); })};
+    double candidate {best([&] { return compileFromCache(cx, text, cache); })};
+    report("Code cache: 2000 functions", baseline, candidate);
+  }
+
+
+  /*
+   * Off-thread compilation
+   *
+   */
+
+  // The main thread's share of an off-thread compile: starting the task, and collecting the script once it is ready
+  double bestOffThreadStall(JSContext* cx, const std::u16string& text) {
+    double fastest {std::numeric_limits<double>::max()};
+
+    for (int i = 0; i < repetitions; i++) {
+      ScriptSource source {text.data(), text.size()};
+
+      std::chrono::steady_clock::time_point start {std::chrono::steady_clock::now()};
+      std::unique_ptr<CompileTask> task {CompileTask::Start(cx, source)};
+      std::chrono::duration<double, std::micro> stall {std::chrono::steady_clock::now() - start};
+
+      if (!task) {
+        return -1.0;
+      }
+
+      while (!task->IsReady()) {
+        std::this_thread::yield();
+      }
+
+      start = std::chrono::steady_clock::now();
+      std::unique_ptr<ScriptWrapper> script {task->Finish(cx)};
+      stall += std::chrono::steady_clock::now() - start;
+
+      if (!script) {
+        return -1.0;
+      }
+
+      fastest = std::min(fastest, stall.count());
+    }
+
+    return fastest;
+  }
+
+
+  void benchOffThread(JSContext* cx) {
+    heading("compile", "stall");
+
+    std::u16string text {largeScript()};
+    double baseline {best([&] { return compileCold(cx, text); })};
+    double candidate {bestOffThreadStall(cx, text)};
+    report("Off-thread: main thread, 2000 functions", baseline, candidate);
+  }
+
+
+  /*
+   * Unbound scripts
+   *
+   */
+
+  bool bind(JSContext* cx, const UnboundScriptWrapper& unbound) {
+    std::unique_ptr<ScriptWrapper> script {unbound.BindToCurrentContext(cx)};
+    return script != nullptr;
+  }
+
+
+  // The cost of bringing a script to one more context, as every context but the first pays it
+  void benchUnbound(JSContext* cx) {
+    heading("compile", "bind");
+
+    std::u16string text {largeScript()};
+    ScriptSource source {text.data(), text.size()};
+    std::unique_ptr<UnboundScriptWrapper> unbound {UnboundScriptWrapper::Compile(cx, source)};
+    JS::RootedObject other(cx, NewGlobal(cx));
+    if (!unbound || !other) {
+      report("Unbound: per context, 2000 functions", -1.0, -1.0);
+      return;
+    }
+
+    JSAutoCompartment ac(cx, other);
+    double baseline {best([&] { return compileCold(cx, text); })};
+    double candidate {best([&] { return bind(cx, *unbound); })};
+    report("Unbound: per context, 2000 functions", baseline, candidate);
+  }
+
+
+  /*
+   * Compilation cache
+   *
+   */
+
+  bool compileWith(JSContext* cx, CompilationCache& cache, const std::u16string& text, bool expectCached) {
+    ScriptSource source {text.data(), text.size()};
+    std::unique_ptr<ScriptWrapper> script {cache.Compile(cx, source)};
+    return script && script->Statistics().cached == expectCached;
+  }
+
+
+  // Repeat compiles of the same source, in the global it was first compiled for and in fresh ones
+  void benchCompilationCache(JSContext* cx) {
+    heading("compile", "cache hit");
+
+    std::u16string text {largeScript()};
+    CompilationCache cache;
+    cache.SetBudget(1 << 26);
+
+    // The cache only keeps the context-independent form once a second global has asked for the script
+    JS::RootedObject global(cx);
+    for (int i = 0; i < 2; i++) {
+      global = NewGlobal(cx);
+      if (!global || !inGlobal(cx, global, [&] { return compileWith(cx, cache, text, false); })) {
+        report("Compilation cache: same global", -1.0, -1.0);
+        return;
+      }
+    }
+
+    double baseline {best([&] { return inGlobal(cx, global, [&] { return compileCold(cx, text); }); })};
+    double candidate {best([&] {
+      return inGlobal(cx, global, [&] { return compileWith(cx, cache, text, true); });
+    })};
+
+    report("Compilation cache: same global", baseline, candidate);
+
+    std::function<void()> newGlobal {[&] { global = NewGlobal(cx); }};
+    baseline = best([&] { return global && inGlobal(cx, global, [&] { return compileCold(cx, text); }); }, newGlobal);
+    candidate = best([&] {
+      return global && inGlobal(cx, global, [&] { return compileWith(cx, cache, text, false); });
+    }, newGlobal);
+
+    report("Compilation cache: new global", baseline, candidate);
+  }
+
+
+  /*
+   * Snapshots
+   *
+   */
+
+  // Bootstrap scripts of the kind an embedder runs in every context: many small functions, and a little setup
+  std::vector<Snapshot::BootstrapScript> bootstrapScripts() {
+    std::vector<Snapshot::BootstrapScript> scripts(4);
+
+    for (size_t i = 0; i < scripts.size(); i++) {
+      std::string text;
+      for (int j = 0; j < 250; j++) {
+        std::string name {"f" + std::to_string(i) + "_" + std::to_string(j)};
+        text += "function " + name + "(a, b) { if (typeof a !== 'number') { throw new TypeError('" + name +
+                "'); } return a * " + std::to_string(j) + " + (b || 0); }\n";
+      }
+      text += "var table" + std::to_string(i) + " = {};\n";
+
+      scripts[i].name = "bootstrap" + std::to_string(i) + ".js";
+      scripts[i].source = widen(text);
+    }
+
+    return scripts;
+  }
+
+
+  bool runScripts(JSContext* cx, const std::vector<Snapshot::BootstrapScript>& scripts) {
+    JS::RootedValue result(cx);
+
+    for (const Snapshot::BootstrapScript& bootstrap : scripts) {
+      ScriptSource source {bootstrap.source.data(), bootstrap.source.size()};
+      std::unique_ptr<ScriptWrapper> script {ScriptWrapper::Compile(cx, source)};
+      if (!script || !script->Run(cx, &result)) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+
+  void benchSnapshot(JSContext* cx) {
+    heading("no snapshot", "snapshot");
+
+    std::vector<Snapshot::BootstrapScript> scripts {bootstrapScripts()};
+    std::vector<uint8_t> blob;
+    std::unique_ptr<Snapshot> snapshot;
+
+    {
+      JS::RootedObject global(cx, NewGlobal(cx));
+      if (global) {
+        JSAutoCompartment ac(cx, global);
+        if (Snapshot::Create(cx, scripts, blob)) {
+          snapshot.reset(Snapshot::FromBlob(reinterpret_cast<const char*>(blob.data()), blob.size()));
+        }
+      }
+    }
+
+    if (!snapshot) {
+      report("Bootstrap a new global", -1.0, -1.0);
+      return;
+    }
+
+    // Each attempt bootstraps a global of its own, created beforehand so that only the bootstrapping is timed
+    JS::RootedObject global(cx);
+    std::function<void()> newGlobal {[&] { global = NewGlobal(cx); }};
+
+    double baseline {best([&] {
+      return global && inGlobal(cx, global, [&] { return runScripts(cx, scripts); });
+    }, newGlobal)};
+
+    double candidate {best([&] {
+      return global && inGlobal(cx, global, [&] { return snapshot->Apply(cx); });
+    }, newGlobal)};
+
+    report("Bootstrap a new global", baseline, candidate);
+  }
+
+
+  /*
+   * JSON
+   *
+   */
+
+  // An array of records, the usual shape of an API response
+  std::string recordsDocument() {
+    std::string json {"["};
+
+    for (int i = 0; i < 2000; i++) {
+      std::string n {std::to_string(i)};
+      json += (i ? "," : "");
+      json += "{\"id\":" + n + ",\"name\":\"record " + n + "\",\"price\":" + n + ".25,\"active\":" +
+              (i % 2 ? "true" : "false") + ",\"tags\":[\"a\",\"b\",\"c\"],\"parent\":null}";
+    }
+
+    return json + "]";
+  }
+
+
+  // Arrays of numbers, as found in geometry and telemetry
+  std::string numbersDocument() {
+    std::string json {"["};
+
+    for (int i = 0; i < 20000; i++) {
+      json += (i ? "," : "");
+      json += std::to_string(i * 7919 % 100003) + "." + std::to_string(i % 1000);
+    }
+
+    return json + "]";
+  }
+
+
+  void benchJSON(JSContext* cx) {
+    heading("JS_ParseJSON", "JSONParser");
+
+    struct Document {
+      const char* name;
+      std::string text;
+    };
+
+    std::vector<Document> documents {
+      {"records", recordsDocument()},
+      {"numbers", numbersDocument()}
+    };
+
+    JS::RootedValue result(cx);
+
+    for (const Document& document : documents) {
+      const std::string& narrow {document.text};
+      std::u16string wide {widen(narrow)};
+
+      JS::RootedString narrowString(cx, JS_NewStringCopyN(cx, narrow.data(), narrow.size()));
+      JS::RootedString wideString(cx, JS_NewUCStringCopyN(cx, wide.data(), wide.size()));
+      if (!narrowString || !wideString) {
+        report(std::string("JSON parse: ") + document.name, -1.0, -1.0);
+        continue;
+      }
+
+      const JS::Latin1Char* narrowChars {reinterpret_cast<const JS::Latin1Char*>(narrow.data())};
+
+      double baseline {best([&] { return JS_ParseJSON(cx, narrowString, &result); })};
+      double candidate {best([&] {
+        return JSONParser::TryParse(cx, narrowChars, narrow.size(), &result) == JSONParser::kParsed;
+      })};
+      report(std::string("JSON parse: ") + document.name + " (Latin1)", baseline, candidate);
+
+      baseline = best([&] { return JS_ParseJSON(cx, wideString, &result); });
+      candidate = best([&] {
+        return JSONParser::TryParse(cx, wide.data(), wide.size(), &result) == JSONParser::kParsed;
+      });
+      report(std::string("JSON parse: ") + document.name + " (UTF-16)", baseline, candidate);
+    }
+  }
+
+
+  /*
+   * JSON serialisation
+   *
+   */
+
+  bool appendUTF16(const char16_t* chars, uint32_t length, void* data) {
+    reinterpret_cast<std::u16string*>(data)->append(chars, length);
+    return true;
+  }
+
+
+  // What an embedder does without the stringifier: JSON.stringify, then WriteUtf8 the resulting string
+  bool stringifyThenWriteUtf8(JSContext* cx, JS::MutableHandleValue value, std::string& output) {
+    std::u16string json;
+    if (!JS_Stringify(cx, value, JS::NullPtr(), JS::NullHandleValue, appendUTF16, &json)) {
+      return false;
+    }
+
+    JS::RootedString string(cx, JS_NewUCStringCopyN(cx, json.data(), json.size()));
+    if (!string) {
+      return false;
+    }
+
+    StringWrapper wrapper {string};
+    output.resize(static_cast<size_t>(wrapper.Utf8Length(cx)));
+    int written {wrapper.WriteUtf8(cx, &output[0], static_cast<int>(output.size()), nullptr,
+                                   StringWrapper::NO_NULL_TERMINATION)};
+    return static_cast<size_t>(written) == output.size();
+  }
+
+
+  class StringStream : public JSONOutputStream {
+    public:
+      explicit StringStream(std::string& o) : output {o} {}
+
+      void EndOfStream() override {}
+
+      WriteResult WriteChunk(const char* data, size_t size) override {
+        output.append(data, size);
+        return kContinue;
+      }
+
+    private:
+      std::string& output;
+  };
+
+
+  bool streamUtf8(JSContext* cx, JS::HandleValue value, std::string& output) {
+    output.clear();
+    StringStream stream {output};
+    return JSONStringifier::Stringify(cx, value, stream) == JSONStringifier::kSerialized;
+  }
+
+
+  void benchStringify(JSContext* cx) {
+    heading("then WriteUtf8", "streamed");
+
+    std::string records {recordsDocument()};
+    JS::RootedString text(cx, JS_NewStringCopyN(cx, records.data(), records.size()));
+    JS::RootedValue value(cx);
+    if (!text || !JS_ParseJSON(cx, text, &value)) {
+      report("JSON stringify: records to UTF-8", -1.0, -1.0);
+      return;
+    }
+
+    std::string output;
+    double baseline {best([&] { return stringifyThenWriteUtf8(cx, &value, output); })};
+    double candidate {best([&] { return streamUtf8(cx, value, output); })};
+    report("JSON stringify: records to UTF-8", baseline, candidate);
+  }
+
+
+  /*
+   * Mapped sources
+   *
+   * Peak resident memory only ever grows, so each case runs in a process of its own. Children are forked before the
+   * parent starts SpiderMonkey, and start it themselves if they need it.
+   *
+   */
+
+  // The peak resident memory, in KiB, of a child process that ran the given function, or negative if it failed
+  double peakResidentKiB(const std::function<bool()>& f) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+      return -1.0;
+    }
+
+    pid_t child {fork()};
+    if (child == 0) {
+      close(fds[0]);
+      long peak {-1};
+      struct rusage usage;
+      if (f() && getrusage(RUSAGE_SELF, &usage) == 0) {
+        peak = usage.ru_maxrss;
+      }
+
+      _exit(write(fds[1], &peak, sizeof(peak)) == sizeof(peak) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    long peak {-1};
+    bool received {child > 0 && read(fds[0], &peak, sizeof(peak)) == sizeof(peak)};
+    close(fds[0]);
+    if (child > 0) {
+      waitpid(child, nullptr, 0);
+    }
+
+    return received ? static_cast<double>(peak) : -1.0;
+  }
+
+
+  void reportMemory(const std::string& name, double baseline, double candidate) {
+    std::cout << std::left << std::setw(40) << name << std::right << std::fixed << std::setprecision(0);
+
+    if (baseline <= 0 || candidate <= 0) {
+      std::cout << "   failed" << std::endl;
+      failed = true;
+      return;
+    }
+
+    std::cout << std::setw(11) << baseline << " KiB" << std::setw(11) << candidate << " KiB" << std::setw(8)
+              << std::setprecision(2) << baseline / candidate << "x" << std::endl;
+  }
+
+
+  // What embedders did before mapped sources: read the file on to the heap, then make a UTF-16 string of it
+  bool readAndWiden(const std::string& path, std::u16string& text) {
+    FILE* file {std::fopen(path.c_str(), "rb")};
+    if (!file) {
+      return false;
+    }
+
+    std::string bytes;
+    bool ok {std::fseek(file, 0, SEEK_END) == 0};
+    long length {ok ? std::ftell(file) : -1};
+    if (length > 0 && std::fseek(file, 0, SEEK_SET) == 0) {
+      bytes.resize(static_cast<size_t>(length));
+      ok = std::fread(&bytes[0], 1, bytes.size(), file) == bytes.size();
+    }
+
+    std::fclose(file);
+    text = widen(bytes);
+    return ok && !text.empty();
+  }
+
+
+  // Start SpiderMonkey in a child, and compile the source in a new global
+  bool compileInChild(ScriptSource& source) {
+    EnsureRuntimeAndContext();
+    JSContext* cx {GetJSContextForThread()};
+    JSAutoRequest ar(cx);
+    JS::RootedObject global(cx, NewGlobal(cx));
+    if (!global) {
+      return false;
+    }
+
+    JSAutoCompartment ac(cx, global);
+    std::unique_ptr<ScriptWrapper> script {ScriptWrapper::Compile(cx, source)};
+    return script != nullptr;
+  }
+
+
+  // Hold the source's text as the engine would for compiling, reading all of it, and compile it if asked
+  bool loadCopied(const std::string& path, bool compile) {
+    std::u16string text;
+    if (!readAndWiden(path, text)) {
+      return false;
+    }
+
+    ScriptSource source {text.data(), text.size()};
+    return source.Hash() != 0 && (!compile || compileInChild(source));
+  }
+
+
+  bool loadMapped(const std::string& path, bool compile) {
+    MappedStringResource* resource {MappedStringResource::New(path.c_str())};
+    if (!resource) {
+      return false;
+    }
+
+    ScriptSource source {resource, ScriptSource::kUTF8};
+    return source.Hash() != 0 && (!compile || compileInChild(source));
+  }
+
+
+  void benchMappedSources(JSContext*) {
+    heading("copied", "mapped", "saving");
+
+    // A bundle of about 50 MB, made of the code cache benchmark's script
+    std::string module;
+    for (char16_t c : largeScript()) {
+      module += static_cast<char>(c);
+    }
+
+    std::string bundle;
+    while (bundle.size() < 50 * 1024 * 1024) {
+      bundle += module;
+    }
+
+    char name[] {"/tmp/v8monkey_bench_XXXXXX"};
+    if (!mkdtemp(name)) {
+      reportMemory("Mapped bundle: 50 MB", -1.0, -1.0);
+      return;
+    }
+
+    std::string directory {name};
+    std::string path {directory + "/bundle.js"};
+    bool written {FileSystem::WriteAtomically(path.c_str(), bundle.data(), bundle.size())};
+    bundle = std::string {};
+
+    double idle {peakResidentKiB([] { return true; })};
+    for (bool compile : {false, true}) {
+      std::string caseName {compile ? "Mapped bundle: 50 MB, compiled" : "Mapped bundle: 50 MB, held"};
+      if (!written || idle < 0) {
+        reportMemory(caseName, -1.0, -1.0);
+        continue;
+      }
+
+      double baseline {peakResidentKiB([&] { return loadCopied(path, compile); })};
+      double candidate {peakResidentKiB([&] { return loadMapped(path, compile); })};
+      reportMemory(caseName, baseline < 0 ? -1.0 : baseline - idle, candidate < 0 ? -1.0 : candidate - idle);
+    }
+
+    FileSystem::Remove(path.c_str());
+    rmdir(directory.c_str());
+  }
+
+
+  /*
+   * Groups
+   *
+   */
+
+  struct Group {
+    const char* name;
+    bool needsSpiderMonkey;
+    void (*run)(JSContext* cx);
+  };
+
+
+  const Group groups[] {
+    {"refcount", false, benchRefCounting},
+    {"utf8", false, benchUTF8},
+    {"views", true, benchViews},
+    {"keys", true, benchPropertyKeys},
+    {"short", false, benchShortStrings},
+    {"codecache", true, benchCodeCache},
+    {"stall", true, benchOffThread},
+    {"unbound", true, benchUnbound},
+    {"compilationcache", true, benchCompilationCache},
+    {"snapshot", true, benchSnapshot},
+    {"json", true, benchJSON},
+    {"stringify", true, benchStringify},
+    {"rss", false, benchMappedSources}
+  };
+
+
+  bool selected(const Group& group, int argc, char** argv) {
+    if (argc < 3) {
+      return true;
+    }
+
+    for (int i = 2; i < argc; i++) {
+      if (std::strcmp(argv[i], group.name) == 0) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+}
+
+
+int main(int argc, char** argv) {
+  if (argc >= 2) {
+    repetitions = std::atoi(argv[1]);
+  }
+
+  if (repetitions < 1) {
+    std::cerr << "Usage: " << argv[0] << " [repetitions] [group...]" << std::endl;
+    return 1;
+  }
+
+  std::vector<const Group*> spiderMonkeyGroups;
+  for (const Group& group : groups) {
+    if (!selected(group, argc, argv)) {
+      continue;
+    }
+
+    if (group.needsSpiderMonkey) {
+      spiderMonkeyGroups.push_back(&group);
+    } else {
+      group.run(nullptr);
+    }
+  }
+
+  if (!spiderMonkeyGroups.empty()) {
+    EnsureRuntimeAndContext();
+    JSContext* cx {GetJSContextForThread()};
+    JSAutoRequest ar(cx);
+    JS::RootedObject global(cx, NewGlobal(cx));
+    if (!global) {
+      std::cerr << "Cannot create a global" << std::endl;
+      return 1;
+    }
+
+    JSAutoCompartment ac(cx, global);
+    for (const Group* group : spiderMonkeyGroups) {
+      group->run(cx);
+    }
+  }
+
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,98 @@
+// iostream
+#include <iostream>
+
+// string, u16string
+#include <string>
+
+// vector
+#include <vector>
+
+// JSAutoCompartment JSAutoRequest
+#include "jsapi.h"
+
+// FileSystem MappedFile
+#include "platform/platform.h"
+
+// Snapshot
+#include "runtime/snapshot.h"
+
+// EncodeToUTF16
+#include "utils/Encoding.h"
+
+// EnsureRuntimeAndContext GetJSContextForThread NewGlobal
+#include "utils/SpiderMonkeyUtils.h"
+
+
+/*
+ * Produces a blob for V8::SetSnapshotDataBlob from the given bootstrap scripts, which are run in order in a fresh
+ * global, exactly as they will be when the snapshot is applied.
+ *
+ *   mksnapshot <output> [script.js...]
+ *
+ * Scripts are expected to be UTF-8. The blob is only usable by a library of the same version as this tool.
+ *
+ */
+
+
+using namespace v8::internal;
+using namespace v8::SpiderMonkey;
+using namespace v8::V8Monkey;
+using namespace v8::V8Platform;
+
+
+namespace {
+  bool readScript(const char* path, Snapshot::BootstrapScript& script) {
+    MappedFile mapped {path};
+    if (!mapped.IsValid()) {
+      return false;
+    }
+
+    const char* text {static_cast<const char*>(mapped.Data())};
+    UTF8::UTF16Encoded encoded {UTF8::EncodeToUTF16(text, text + mapped.Length())};
+
+    // The encoder always adds a terminating zero
+    script.name = path;
+    script.source.assign(encoded.data(), encoded.size() - 1);
+    return true;
+  }
+}
+
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " <output> [script.js...]" << std::endl;
+    return 1;
+  }
+
+  std::vector<Snapshot::BootstrapScript> scripts(static_cast<size_t>(argc - 2));
+  for (int i = 2; i < argc; i++) {
+    if (!readScript(argv[i], scripts[static_cast<size_t>(i - 2)])) {
+      std::cerr << "Cannot read " << argv[i] << std::endl;
+      return 1;
+    }
+  }
+
+  EnsureRuntimeAndContext();
+  JSContext* cx {GetJSContextForThread()};
+  JSAutoRequest ar(cx);
+  JS::RootedObject global(cx, NewGlobal(cx));
+  if (!global) {
+    std::cerr << "Cannot create a global" << std::endl;
+    return 1;
+  }
+
+  JSAutoCompartment ac(cx, global);
+
+  std::vector<uint8_t> blob;
+  if (!Snapshot::Create(cx, scripts, blob)) {
+    std::cerr << "A bootstrap script failed to compile, or threw" << std::endl;
+    return 1;
+  }
+
+  if (!FileSystem::WriteAtomically(argv[1], blob.data(), blob.size())) {
+    std::cerr << "Cannot write " << argv[1] << std::endl;
+    return 1;
+  }
+
+  return 0;
+}